@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2012-2017 Genode Labs GmbH
+ * Copyright (C) 2012-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -31,6 +31,15 @@ namespace Kernel
 
 	/* time slice for the round-robin mode and the idle in CPU scheduling */
 	constexpr time_t cpu_fill_us = 10000;
+
+	/*
+	 * Period of balancing the load among the CPUs, 0 disables balancing
+	 *
+	 * If enabled, ready threads without CPU quota are moved from the CPU
+	 * with the longest run queue to the CPU with the shortest one. Threads
+	 * with CPU quota stay at the CPU they are assigned to.
+	 */
+	constexpr time_t cpu_balance_us = 0;
 }
 
 #endif /* _CORE__KERNEL__CONFIGURATION_H_ */
@@ -6,7 +6,7 @@
  */
 
 /*
- * Copyright (C) 2014-2017 Genode Labs GmbH
+ * Copyright (C) 2014-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -149,6 +149,22 @@ Cpu_job & Cpu::schedule()
 }
 
 
+bool Cpu::migrate_fill(Cpu &cpu)
+{
+	Cpu_share * const share = _scheduler.ready_fill_only([&] (Cpu_share &s) {
+		return static_cast<Job &>(s).migratable(); });
+
+	if (!share) { return false; }
+
+	Job &job = static_cast<Job &>(*share);
+	_scheduler.unready(share);
+	_scheduler.remove(share);
+	job.affinity(cpu);
+	cpu.schedule(&job);
+	return true;
+}
+
+
 Genode::size_t  kernel_stack_size = Cpu::KERNEL_STACK_SIZE;
 Genode::uint8_t kernel_stack[NR_OF_CPUS][Cpu::KERNEL_STACK_SIZE]
 __attribute__((aligned(Genode::get_page_size())));
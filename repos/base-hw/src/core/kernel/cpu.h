@@ -6,7 +6,7 @@
  */
 
 /*
- * Copyright (C) 2014-2017 Genode Labs GmbH
+ * Copyright (C) 2014-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -159,6 +159,13 @@ class Kernel::Cpu : public Genode::Cpu, private Irq::Pool, private Timeout
 		 */
 		Cpu_job& schedule();
 
+		/**
+		 * Move one ready job without CPU quota to CPU 'cpu'
+		 *
+		 * \return true if a job was moved
+		 */
+		bool migrate_fill(Cpu &cpu);
+
 		Timer & timer() { return _timer; }
 
 		addr_t stack_start();
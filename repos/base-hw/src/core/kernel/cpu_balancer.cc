@@ -0,0 +1,80 @@
+/*
+ * \brief   Balancing of the load among the CPUs
+ * \author  Stefan Kalkowski
+ * \date    2019-03-29
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* core includes */
+#include <kernel/cpu_balancer.h>
+#include <kernel/configuration.h>
+
+/* base-internal includes */
+#include <base/internal/unmanaged_singleton.h>
+
+using namespace Kernel;
+
+
+void Cpu_balancer::_balance()
+{
+	Cpu *busiest = nullptr, *idlest = nullptr;
+	time_t max_load = 0, min_load = ~(time_t)0;
+
+	/*
+	 * The load of a CPU is the average length of its run queue during the
+	 * last period, given in microseconds per period.
+	 */
+	_pool.for_each_cpu([&] (Cpu &cpu) {
+
+		time_t const ready_time = cpu.scheduler().statistics().ready_time;
+		time_t const load = cpu.timer().ticks_to_us(ready_time - _ready_time[cpu.id()]);
+		_ready_time[cpu.id()] = ready_time;
+
+		if (!busiest || load > max_load) { busiest = &cpu; max_load = load; }
+		if (!idlest  || load < min_load) { idlest  = &cpu; min_load = load; }
+	});
+
+	if (!busiest || busiest == idlest) { return; }
+
+	/*
+	 * Moving a job pays off only if the busiest CPU had at least two jobs
+	 * more in its run queue than the idlest CPU. Otherwise, the imbalance
+	 * would merely be inverted.
+	 */
+	time_t const period_us = _cpu.timer().ticks_to_us(_period);
+	if (max_load - min_load < 2*period_us) { return; }
+
+	if (busiest->scheduler().statistics().num_ready < 2) { return; }
+
+	busiest->migrate_fill(*idlest);
+}
+
+
+void Cpu_balancer::timeout_triggered()
+{
+	_balance();
+	_cpu.timer().set_timeout(this, _period);
+}
+
+
+Cpu_balancer::Cpu_balancer(Cpu_pool &pool, Cpu &cpu, time_t const period_us)
+:
+	_pool(pool), _cpu(cpu), _period(cpu.timer().us_to_ticks(period_us))
+{
+	_cpu.timer().set_timeout(this, _period);
+}
+
+
+void Kernel::init_cpu_balancer()
+{
+	if (!cpu_balance_us) { return; }
+
+	Cpu_pool &pool = cpu_pool();
+	unmanaged_singleton<Cpu_balancer>(pool, pool.primary_cpu(), cpu_balance_us);
+}
@@ -0,0 +1,60 @@
+/*
+ * \brief   Balancing of the load among the CPUs
+ * \author  Stefan Kalkowski
+ * \date    2019-03-29
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _CORE__KERNEL__CPU_BALANCER_H_
+#define _CORE__KERNEL__CPU_BALANCER_H_
+
+/* core includes */
+#include <kernel/cpu.h>
+
+namespace Kernel
+{
+	/**
+	 * Moves jobs without CPU quota from busy to less busy CPUs
+	 */
+	class Cpu_balancer;
+
+	/**
+	 * Start balancing if enabled by the kernel configuration
+	 */
+	void init_cpu_balancer();
+}
+
+
+class Kernel::Cpu_balancer : private Timeout
+{
+	private:
+
+		Cpu_pool &_pool;
+		Cpu      &_cpu;    /* CPU whose timer triggers the balancing */
+
+		time_t const _period;
+
+		/* run-queue statistics as of the previous balancing */
+		time_t _ready_time[NR_OF_CPUS] { };
+
+		void _balance();
+
+
+		/*************
+		 ** Timeout **
+		 *************/
+
+		void timeout_triggered() override;
+
+	public:
+
+		Cpu_balancer(Cpu_pool &pool, Cpu &cpu, time_t period_us);
+};
+
+#endif /* _CORE__KERNEL__CPU_BALANCER_H_ */
@@ -6,7 +6,7 @@
  */
 
 /*
- * Copyright (C) 2014-2017 Genode Labs GmbH
+ * Copyright (C) 2014-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -87,6 +87,11 @@ class Kernel::Cpu_job : private Cpu_share
 		 */
 		virtual Cpu_job * helping_sink() = 0;
 
+		/**
+		 * Return wether the job may be moved to another CPU
+		 */
+		virtual bool migratable() { return false; }
+
 		/**
 		 * Construct a job with scheduling priority 'p' and time quota 'q'
 		 */
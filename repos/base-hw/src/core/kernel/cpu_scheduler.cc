@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2014-2017 Genode Labs GmbH
+ * Copyright (C) 2014-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -133,6 +133,13 @@ void Cpu_scheduler::update(time_t time)
 	_last_time        = time;
 	_need_to_schedule = false;
 
+	/*
+	 * Account the run-queue length at the end of the period, which
+	 * approximates the average length during the period.
+	 */
+	_stats.ready_time += (time_t)duration * _stats.num_ready;
+	if (_head && _head != _idle) { _stats.busy_time += duration; }
+
 	/* do not detract the quota if the head context was removed even now */
 	if (_head) {
 		unsigned const r = _trim_consumption(duration);
@@ -178,6 +185,7 @@ void Cpu_scheduler::ready(Share * const s)
 
 	s->_ready = 1;
 	s->_fill = _fill;
+	_stats.num_ready++;
 	_fills.insert_tail(s);
 	if (!s->_quota) { return; }
 	_ucl[s->_prio].remove(s);
@@ -193,6 +201,7 @@ void Cpu_scheduler::unready(Share * const s)
 	_need_to_schedule = true;
 
 	s->_ready = 0;
+	_stats.num_ready--;
 	_fills.remove(s);
 	if (!s->_quota) { return; }
 	_rcl[s->_prio].remove(s);
@@ -213,7 +222,7 @@ void Cpu_scheduler::remove(Share * const s)
 
 	_need_to_schedule = true;
 	if (s == _head) _head = nullptr;
-	if (s->_ready) { _fills.remove(s); }
+	if (s->_ready) { _fills.remove(s); _stats.num_ready--; }
 	if (!s->_quota) { return; }
 	if (s->_ready) { _rcl[s->_prio].remove(s); }
 	else { _ucl[s->_prio].remove(s); }
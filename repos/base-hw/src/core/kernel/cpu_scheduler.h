@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2014-2017 Genode Labs GmbH
+ * Copyright (C) 2014-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -112,6 +112,19 @@ class Kernel::Cpu_share : public Cpu_claim, public Cpu_fill
 
 class Kernel::Cpu_scheduler
 {
+	public:
+
+		/**
+		 * Run-queue statistics, times are given in timer ticks
+		 */
+		struct Statistics
+		{
+			time_t   busy_time  = 0; /* time not spent by the idle share */
+			time_t   ready_time = 0; /* number of ready shares integrated
+			                            over time */
+			unsigned num_ready  = 0; /* current number of ready shares */
+		};
+
 	private:
 
 		typedef Cpu_share                Share;
@@ -134,6 +147,7 @@ class Kernel::Cpu_scheduler
 		unsigned const _fill;
 		bool           _need_to_schedule { true };
 		time_t         _last_time { 0 };
+		Statistics     _stats { };
 
 		template <typename F> void _for_each_prio(F f) {
 			for (signed p = Prio::MAX; p > Prio::MIN - 1; p--) { f(p); } }
@@ -224,6 +238,25 @@ class Kernel::Cpu_scheduler
 		 */
 		void quota(Share * const s, unsigned const q);
 
+		/**
+		 * Return first ready share without quota that is not the head
+		 *
+		 * \param fn  predicate 'bool (Share &)' that a share must meet
+		 *
+		 * Shares with quota are never considered because a claim is bound
+		 * to the CPU it was assigned to.
+		 */
+		template <typename FN>
+		Share * ready_fill_only(FN const &fn)
+		{
+			Share * result = nullptr;
+			_fills.for_each([&] (Fill * const f) {
+				Share * const s = _share(f);
+				if (!result && !s->_quota && s != _head && fn(*s))
+					result = s; });
+			return result;
+		}
+
 		/*
 		 * Accessors
 		 */
@@ -233,6 +266,7 @@ class Kernel::Cpu_scheduler
 			return Genode::min(_head_quota, _residual); }
 		unsigned quota() const { return _quota; }
 		unsigned residual() const { return _residual; }
+		Statistics const & statistics() const { return _stats; }
 };
 
 #endif /* _CORE__KERNEL__CPU_SCHEDULER_H_ */
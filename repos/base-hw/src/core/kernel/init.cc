@@ -6,7 +6,7 @@
  */
 
 /*
- * Copyright (C) 2015-2017 Genode Labs GmbH
+ * Copyright (C) 2015-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -15,6 +15,7 @@
 /* core includes */
 #include <kernel/pd.h>
 #include <kernel/cpu.h>
+#include <kernel/cpu_balancer.h>
 #include <kernel/kernel.h>
 #include <kernel/lock.h>
 #include <platform_pd.h>
@@ -76,6 +77,7 @@ extern "C" void kernel_init()
 		Genode::log("kernel initialized");
 
 		Core_thread::singleton();
+		init_cpu_balancer();
 		kernel_ready = true;
 	} else {
 		/* secondary cpus spin until the kernel is initialized */
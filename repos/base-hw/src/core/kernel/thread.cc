@@ -6,7 +6,7 @@
  */
 
 /*
- * Copyright (C) 2013-2017 Genode Labs GmbH
+ * Copyright (C) 2013-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -183,6 +183,24 @@ Cpu_job * Thread::helping_sink() {
 	return static_cast<Thread *>(Ipc_node::helping_sink()); }
 
 
+bool Thread::migratable()
+{
+	/*
+	 * Core threads stay at their CPU. So do threads that use kernel
+	 * timeouts because the timers of different CPUs are not synchronized.
+	 */
+	if (_state != ACTIVE || _paused || _timeout_sigid || _pd == &core_pd()) {
+		return false; }
+
+	/* a helping relation is bound to the CPU of the involved threads */
+	if (helping_sink() != this) { return false; }
+
+	bool helped = false;
+	for_each_helper([&] (Ipc_node &) { helped = true; });
+	return !helped;
+}
+
+
 size_t Thread::_core_to_kernel_quota(size_t const quota) const
 {
 	using Genode::Cpu_session;
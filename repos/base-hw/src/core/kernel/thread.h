@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2012-2017 Genode Labs GmbH
+ * Copyright (C) 2012-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -372,6 +372,7 @@ class Kernel::Thread
 		void exception(Cpu & cpu) override;
 		void proceed(Cpu & cpu)   override;
 		Cpu_job * helping_sink()  override;
+		bool      migratable()    override;
 
 
 		/*************
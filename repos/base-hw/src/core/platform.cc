@@ -6,7 +6,7 @@
  */
 
 /*
- * Copyright (C) 2011-2017 Genode Labs GmbH
+ * Copyright (C) 2011-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -28,6 +28,7 @@
 #include <kernel/kernel.h>
 #include <translation_table.h>
 #include <kernel/cpu.h>
+#include <trace/source_registry.h>
 
 /* base-internal includes */
 #include <base/internal/crt0.h>
@@ -143,6 +144,52 @@ void Platform::_init_platform_info()
 }
 
 
+namespace Genode { struct Cpu_scheduler_trace_source; }
+
+
+/**
+ * Run-queue statistics of one CPU, exported as trace subject
+ *
+ * The execution time of the subject is interpreted as follows:
+ * 'thread_context' is the time in microseconds the CPU was not idle,
+ * 'scheduling_context' is the integral of the number of ready jobs over
+ * time in microseconds, and 'quantum' is the current number of ready jobs.
+ * Hence, the average run-queue length during a sampling interval is the
+ * delta of 'scheduling_context' divided by the length of the interval.
+ *
+ * The statistics are read without taking the kernel lock. This is benign
+ * because they serve informational purposes only.
+ */
+struct Genode::Cpu_scheduler_trace_source : Trace::Source::Info_accessor
+{
+	Kernel::Cpu &cpu;
+
+	Trace::Control control { };
+	Trace::Source  source  { *this, control };
+
+	Cpu_scheduler_trace_source(Kernel::Cpu &cpu) : cpu(cpu) {
+		Trace::sources().insert(&source); }
+
+	/**
+	 * Trace::Source::Info_accessor interface
+	 */
+	Trace::Source::Info trace_source_info() const override
+	{
+		Kernel::Cpu_scheduler::Statistics const &stats =
+			cpu.scheduler().statistics();
+
+		Kernel::Timer &timer = cpu.timer();
+
+		return { Session_label("kernel"),
+		         Trace::Thread_name("cpu", cpu.id(), " scheduler"),
+		         Trace::Execution_time(timer.ticks_to_us(stats.busy_time),
+		                               timer.ticks_to_us(stats.ready_time),
+		                               stats.num_ready, 0),
+		         Affinity::Location(cpu.id(), 0) };
+	}
+};
+
+
 Platform::Platform()
 :
 	_io_mem_alloc(&core_mem_alloc()),
@@ -206,6 +253,10 @@ Platform::Platform()
 		init_core_log(Core_log_range { core_local_addr, log_size } );
 	}
 
+	/* export run-queue statistics of each CPU as trace subjects */
+	Kernel::cpu_pool().for_each_cpu([&] (Kernel::Cpu &cpu) {
+		new (core_mem_alloc()) Cpu_scheduler_trace_source(cpu); });
+
 	log(_rom_fs);
 }
 
@@ -6,7 +6,7 @@
  */
 
 /*
- * Copyright (C) 2007-2017 Genode Labs GmbH
+ * Copyright (C) 2007-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -129,6 +129,12 @@ namespace Genode {
 			 */
 			size_t max_caps() const override { return 10000; }
 
+			/*
+			 * RAM dataspaces are backed by files, which are zero-initialized
+			 * by the Linux kernel.
+			 */
+			size_t cleared_ram_pool_size() const override { return 0; }
+
 			void wait_for_exit() override;
 	};
 }
@@ -21,6 +21,7 @@ SRC_CC        = main.cc \
                 capability_space.cc \
                 rpc_cap_factory_l4.cc \
                 ram_dataspace_factory.cc \
+                cleared_ram_pool.cc \
                 core_rpc_cap_alloc.cc \
                 io_mem_session_component.cc \
                 signal_source_component.cc \
@@ -59,6 +60,7 @@ vpath pd_session_support.cc       $(GEN_CORE_DIR)
 vpath capability_space.cc         $(GEN_CORE_DIR)
 vpath rpc_cap_factory_l4.cc       $(GEN_CORE_DIR)
 vpath ram_dataspace_factory.cc    $(GEN_CORE_DIR)
+vpath cleared_ram_pool.cc         $(GEN_CORE_DIR)
 vpath platform_services.cc        $(GEN_CORE_DIR)
 vpath signal_source_component.cc  $(GEN_CORE_DIR)
 vpath signal_transmitter_proxy.cc $(GEN_CORE_DIR)
@@ -6,7 +6,7 @@
  */
 
 /*
- * Copyright (C) 2009-2017 Genode Labs GmbH
+ * Copyright (C) 2009-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -86,6 +86,13 @@ namespace Genode {
 
 			bool supports_direct_unmap() const override { return true; }
 
+			/*
+			 * Core threads on NOVA are local ECs that execute only when
+			 * called. Furthermore, '_clear_ds' revokes the core-local
+			 * mapping established by '_export_ram_ds'.
+			 */
+			size_t cleared_ram_pool_size() const override { return 0; }
+
 			Address_space &core_pd() { ASSERT_NEVER_CALLED; }
 
 			Affinity::Space affinity_space() const override { return _cpus; }
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2006-2017 Genode Labs GmbH
+ * Copyright (C) 2006-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -35,11 +35,19 @@ namespace Genode {
 	template <typename, unsigned SLAB_BLOCK_SIZE = (1024 - 8)*sizeof(addr_t)>
 	class Allocator_avl_tpl;
 
+	template <typename, unsigned SLAB_BLOCK_SIZE = (1024 - 8)*sizeof(addr_t)>
+	class Allocator_avl_tlsf_tpl;
+
 	/**
 	 * Define AVL-based allocator without any meta data attached to each block
 	 */
 	class Empty { };
 	typedef Allocator_avl_tpl<Empty> Allocator_avl;
+
+	/**
+	 * Define AVL-based allocator with segregated free lists
+	 */
+	typedef Allocator_avl_tlsf_tpl<Empty> Allocator_avl_tlsf;
 }
 
 
@@ -62,6 +70,8 @@ class Genode::Allocator_avl_base : public Range_allocator
 		{
 			private:
 
+				friend class Allocator_avl_base;
+
 				addr_t _addr      { 0 };     /* base address    */
 				size_t _size      { 0 };     /* size of block   */
 				bool   _used      { false }; /* block is in use */
@@ -69,6 +79,9 @@ class Genode::Allocator_avl_base : public Range_allocator
 				size_t _max_avail { 0 };     /* biggest free block size of
 				                                sub tree */
 
+				Block *_list_prev { nullptr }; /* neighbours in segregated */
+				Block *_list_next { nullptr }; /* free list                */
+
 				/**
 				 * Request max_avail value of subtree
 				 */
@@ -165,11 +178,53 @@ class Genode::Allocator_avl_base : public Range_allocator
 				size_t avail_in_subtree(void);
 		};
 
+		/**
+		 * Segregated lists of free blocks
+		 *
+		 * Free blocks are kept in lists of size classes in the style of the
+		 * two-level segregated fit (TLSF) allocator. The first level divides
+		 * sizes into powers of two, the second level divides each power of
+		 * two into 'SL_COUNT' ranges. Bitmaps of non-empty lists allow for
+		 * finding a suitable block in constant time.
+		 */
+		class Free_lists
+		{
+			private:
+
+				enum {
+					SL_LOG2  = 3,
+					SL_COUNT = 1 << SL_LOG2,
+					FL_COUNT = 8*sizeof(size_t) - SL_LOG2 + 1,
+				};
+
+				unsigned long _fl_bitmap { 0 };
+				unsigned char _sl_bitmap[FL_COUNT] { };
+				Block        *_heads[FL_COUNT][SL_COUNT] { };
+
+				static void _index(size_t size, unsigned &fl, unsigned &sl);
+
+				Block *_first(unsigned fl, unsigned sl) const;
+
+			public:
+
+				void insert(Block &block);
+				void remove(Block &block);
+
+				/**
+				 * Find free block that can hold 'size' bytes at 'align'
+				 *
+				 * \return  block or nullptr if no list provides a block
+				 *          that fits for sure
+				 */
+				Block *find(size_t size, unsigned align) const;
+		};
+
 	private:
 
 		Avl_tree<Block> _addr_tree        { };  /* blocks sorted by base address */
 		Allocator      *_md_alloc { nullptr };  /* meta-data allocator           */
 		size_t          _md_entry_size  { 0 };  /* size of block meta-data entry */
+		Free_lists     *_free_lists { nullptr };/* optional allocation front end */
 
 		/**
 		 * Alloc meta-data block
@@ -189,6 +244,8 @@ class Genode::Allocator_avl_base : public Range_allocator
 
 		Block *_find_any_used_block(Block *sub_tree);
 
+		void _insert_free_blocks(Block *sub_tree);
+
 		/**
 		 * Destroy block
 		 */
@@ -207,6 +264,16 @@ class Genode::Allocator_avl_base : public Range_allocator
 
 		Avl_tree<Block> const & _block_tree() const { return _addr_tree; }
 
+		/**
+		 * Use segregated free lists for allocations without address
+		 * constraints
+		 *
+		 * The lists must stay valid until '_disable_free_lists' is called.
+		 */
+		void _enable_free_lists(Free_lists &free_lists);
+
+		void _disable_free_lists() { _free_lists = nullptr; }
+
 		/**
 		 * Clean up the allocator and detect dangling allocations
 		 *
@@ -417,4 +484,44 @@ class Genode::Allocator_avl_tpl : public Allocator_avl_base
 		}
 };
 
+
+/**
+ * AVL-based allocator with segregated free lists as allocation front end
+ *
+ * Allocations without address constraints are served from the segregated
+ * free lists in constant time instead of searching the best-fitting block
+ * in the AVL tree. The lists implement a good-fit strategy. If they cannot
+ * provide a fitting block, the allocator falls back to the tree search.
+ * The free lists add about 4 KiB to the size of the allocator object.
+ *
+ * \param BMDT  block meta-data type
+ */
+template <typename BMDT, unsigned SLAB_BLOCK_SIZE>
+class Genode::Allocator_avl_tlsf_tpl : public Allocator_avl_tpl<BMDT, SLAB_BLOCK_SIZE>
+{
+	private:
+
+		Allocator_avl_base::Free_lists _free_lists { };
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param metadata_chunk_alloc  see 'Allocator_avl_tpl'
+		 */
+		explicit Allocator_avl_tlsf_tpl(Allocator *metadata_chunk_alloc)
+		:
+			Allocator_avl_tpl<BMDT, SLAB_BLOCK_SIZE>(metadata_chunk_alloc)
+		{
+			this->_enable_free_lists(_free_lists);
+		}
+
+		~Allocator_avl_tlsf_tpl()
+		{
+			this->_revert_allocations_and_ranges();
+			this->_disable_free_lists();
+		}
+};
+
 #endif /* _INCLUDE__BASE__ALLOCATOR_AVL_H_ */
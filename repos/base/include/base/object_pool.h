@@ -7,7 +7,7 @@
  */
 
 /*
- * Copyright (C) 2006-2017 Genode Labs GmbH
+ * Copyright (C) 2006-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -31,6 +31,12 @@ namespace Genode { template <typename> class Object_pool; }
  *
  * The local names of a capabilities are used to differentiate multiple server
  * objects managed by one and the same object pool.
+ *
+ * The objects are distributed by their local names over a fixed number of
+ * AVL trees. This way, the lookup of an object on each incoming RPC walks a
+ * tree of only a fraction of the objects, which keeps the dispatching of
+ * servers with thousands of session objects cheap. Because the entries are
+ * part of the objects, the pool gets along without a dynamic allocation.
  */
 template <typename OBJ_TYPE>
 class Genode::Object_pool : Interface, Noncopyable
@@ -94,15 +100,44 @@ class Genode::Object_pool : Interface, Noncopyable
 
 	private:
 
-		Avl_tree<Entry> _tree { };
+		enum { NUM_TREES_LOG2 = 6, NUM_TREES = 1 << NUM_TREES_LOG2 };
+
+		Avl_tree<Entry> _trees[NUM_TREES] { };
 		Lock            _lock { };
 
+		/**
+		 * Return tree holding the object of the specified ID
+		 *
+		 * The higher bits of the ID are folded into the index because the
+		 * local names of capabilities are often aligned.
+		 */
+		Avl_tree<Entry> &_tree(unsigned long obj_id)
+		{
+			unsigned long const index = obj_id
+			                          ^ (obj_id >>   NUM_TREES_LOG2)
+			                          ^ (obj_id >> 2*NUM_TREES_LOG2);
+
+			return _trees[index % NUM_TREES];
+		}
+
+		/**
+		 * Return any object of the pool, must be called with '_lock' held
+		 */
+		Entry *_any()
+		{
+			for (Avl_tree<Entry> &tree : _trees)
+				if (Entry *e = tree.first())
+					return e;
+
+			return nullptr;
+		}
+
 	protected:
 
 		bool empty()
 		{
 			Lock::Guard lock_guard(_lock);
-			return _tree.first() == nullptr;
+			return _any() == nullptr;
 		}
 
 	public:
@@ -110,13 +145,13 @@ class Genode::Object_pool : Interface, Noncopyable
 		void insert(OBJ_TYPE *obj)
 		{
 			Lock::Guard lock_guard(_lock);
-			_tree.insert(obj);
+			_tree(obj->_obj_id()).insert(obj);
 		}
 
 		void remove(OBJ_TYPE *obj)
 		{
 			Lock::Guard lock_guard(_lock);
-			_tree.remove(obj);
+			_tree(obj->_obj_id()).remove(obj);
 		}
 
 		template <typename FUNC>
@@ -133,8 +168,9 @@ class Genode::Object_pool : Interface, Noncopyable
 			{
 				Lock::Guard lock_guard(_lock);
 
-				Entry * entry = _tree.first() ?
-					_tree.first()->find_by_obj_id(capid) : nullptr;
+				Entry * const first = _tree(capid).first();
+				Entry * const entry = first ? first->find_by_obj_id(capid)
+				                            : nullptr;
 
 				if (entry) ptr = entry->_lock.weak_ptr();
 			}
@@ -166,14 +202,14 @@ class Genode::Object_pool : Interface, Noncopyable
 				{
 					Lock::Guard lock_guard(_lock);
 
-					if (!((obj = (OBJ_TYPE*) _tree.first()))) return;
+					if (!((obj = (OBJ_TYPE*) _any()))) return;
 
 					Weak_ptr ptr = obj->_lock.weak_ptr();
 					{
 						Locked_ptr lock_ptr(ptr);
 						if (!lock_ptr.valid()) return;
 
-						_tree.remove(obj);
+						_tree(obj->_obj_id()).remove(obj);
 					}
 				}
 
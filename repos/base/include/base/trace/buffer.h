@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2013-2017 Genode Labs GmbH
+ * Copyright (C) 2013-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -22,19 +22,35 @@ namespace Genode { namespace Trace { class Buffer; } }
 
 /**
  * Buffer shared between CPU client thread and TRACE client
+ *
+ * The buffer is written by the traced thread only and read by the TRACE
+ * client without any synchronization. Each entry carries a sequence number
+ * that is incremented with each committed entry. It enables the TRACE client
+ * to detect entries that got overwritten by the writer before they could be
+ * read, and entries that got overwritten while being read.
  */
 class Genode::Trace::Buffer
 {
+	public:
+
+		/*
+		 * Version of the buffer layout, increased on incompatible changes
+		 */
+		enum { FORMAT_VERSION = 2 };
+
 	private:
 
-		unsigned volatile _head_offset;  /* in bytes, relative to 'entries' */
-		unsigned volatile _size;         /* in bytes */
-		unsigned volatile _wrapped;      /* count of buffer wraps */
+		unsigned      volatile _version;      /* format of the buffer */
+		unsigned      volatile _head_offset;  /* in bytes, relative to 'entries' */
+		unsigned      volatile _size;         /* in bytes */
+		unsigned      volatile _wrapped;      /* count of buffer wraps */
+		unsigned long volatile _num_entries;  /* count of committed entries */
 
 		struct _Entry
 		{
-			size_t len;
-			char   data[0];
+			size_t        volatile len;
+			unsigned long volatile seq;
+			char                   data[0];
 		};
 
 		_Entry _entries[0];
@@ -70,7 +86,9 @@ class Genode::Trace::Buffer
 
 			_size = size - header_size;
 
-			_wrapped = 0;
+			_wrapped     = 0;
+			_num_entries = 0;
+			_version     = FORMAT_VERSION;
 		}
 
 		char *reserve(size_t len)
@@ -93,6 +111,8 @@ class Genode::Trace::Buffer
 			if (len == 0)
 				return;
 
+			/* the sequence number must be valid once the length is set */
+			_head_entry()->seq = _num_entries++;
 			_head_entry()->len = len;
 
 			/* advance head offset, wrap when reaching buffer boundary */
@@ -107,6 +127,18 @@ class Genode::Trace::Buffer
 
 		unsigned wrapped() const { return _wrapped; }
 
+		/**
+		 * Return format version, 0 if the buffer is not initialized yet
+		 */
+		unsigned version() const { return _version; }
+
+		/**
+		 * Return number of entries committed since the initialization
+		 *
+		 * This is also the sequence number of the next committed entry.
+		 */
+		unsigned long num_entries() const { return _num_entries; }
+
 
 		/********************************************
 		 ** Functions called from the TRACE client **
@@ -124,8 +156,9 @@ class Genode::Trace::Buffer
 
 			public:
 
-				size_t      length() const { return _entry->len; }
-				char const *data()   const { return _entry->data; }
+				size_t        length() const { return _entry->len; }
+				char const   *data()   const { return _entry->data; }
+				unsigned long seq()    const { return _entry->seq; }
 
 				/*
 				 * XXX The meaning of this method is irritating.
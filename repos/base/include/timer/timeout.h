@@ -10,7 +10,7 @@
  */
 
 /*
- * Copyright (C) 2016-2017 Genode Labs GmbH
+ * Copyright (C) 2016-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -160,33 +160,33 @@ class Genode::Timeout : private Noncopyable
 
 				typedef uint64_t Time;
 
-				struct Raw
-				{
-					Time deadline;
-					bool deadline_period;
-					Time period;
-
-					bool is_pending_at(uint64_t time, bool time_period) const;
-				};
-
 				Lock                     _dispatch_lock { };
-				Raw                      _raw           { };
-				int                      _active        { 0 };
+				Time                     _deadline      { 0 };
+				Time                     _period        { 0 };
+				Alarm                  **_list          { nullptr };
 				Alarm                   *_next          { nullptr };
+				Alarm                   *_prev          { nullptr };
 				Alarm_timeout_scheduler *_scheduler     { nullptr };
 
 				void _alarm_assign(Time                     period,
 				                   Time                     deadline,
-				                   bool                     deadline_period,
 				                   Alarm_timeout_scheduler *scheduler)
 				{
-					_raw.period          = period;
-					_raw.deadline_period = deadline_period;
-					_raw.deadline        = deadline;
-					_scheduler           = scheduler;
+					_period    = period;
+					_deadline  = deadline;
+					_scheduler = scheduler;
+				}
+
+				void _alarm_reset()
+				{
+					_alarm_assign(0, 0, nullptr);
+					_list = nullptr, _next = nullptr, _prev = nullptr;
 				}
 
-				void _alarm_reset() { _alarm_assign(0, 0, false, 0), _active = 0, _next = 0; }
+				/**
+				 * Return true if the alarm is enqueued at its scheduler
+				 */
+				bool _alarm_active() const { return _list != nullptr; }
 
 				bool _on_alarm(uint64_t);
 
@@ -225,6 +225,15 @@ class Genode::Timeout : private Noncopyable
 
 /**
  * Timeout-scheduler implementation using the Alarm framework
+ *
+ * The alarms are kept in a hierarchical timing wheel. Each level consists of
+ * 'WHEEL_SLOTS' slots and level n is indexed by the n-th group of
+ * 'WHEEL_SLOTS_LOG2' bits of the alarm deadline. An alarm is stored at the
+ * level of the most significant bit group in which its deadline differs
+ * from the current time of the scheduler. Hence, scheduling and discarding
+ * an alarm are O(1) operations. When the time advances, the alarms of all
+ * slots that were passed over are expired while the alarms of the slot
+ * that got reached are redistributed to the lower levels.
  */
 class Genode::Alarm_timeout_scheduler : private Noncopyable,
                                         public  Timeout_scheduler,
@@ -238,18 +247,38 @@ class Genode::Alarm_timeout_scheduler : private Noncopyable,
 
 		using Alarm = Timeout::Alarm;
 
-		Time_source     &_time_source;
-		Lock             _lock              { };
-		Alarm           *_active_head       { nullptr };
-		Alarm           *_pending_head      { nullptr };
-		Alarm::Time      _now               { 0UL };
-		bool             _now_period        { false };
-		Alarm::Raw       _min_handle_period { };
+		enum {
+			WHEEL_SLOTS_LOG2 = 6,
+			WHEEL_SLOTS      = 1 << WHEEL_SLOTS_LOG2,
+			WHEEL_LEVELS     = (64 + WHEEL_SLOTS_LOG2 - 1) / WHEEL_SLOTS_LOG2,
+		};
+
+		Time_source &_time_source;
+		Lock         _lock                { };
+		Alarm       *_wheel[WHEEL_LEVELS][WHEEL_SLOTS] { };
+		uint64_t     _wheel_used[WHEEL_LEVELS] { };      /* bitmap of non-empty slots */
+		Alarm       *_expired_head        { nullptr };  /* ordered by deadline */
+		Alarm       *_pending_head        { nullptr };
+		Alarm::Time  _now                 { 0 };
+		Alarm::Time  _next_timeout        { ~(Alarm::Time)0 };
+		Alarm::Time  _min_handle_period   { 0 };
+		Alarm::Time  _min_handle_deadline { 0 };
+
+		static unsigned _wheel_digit(Alarm::Time time, unsigned level) {
+			return (time >> (level * WHEEL_SLOTS_LOG2)) & (WHEEL_SLOTS - 1); }
+
+		void _wheel_insert(Alarm &alarm);
+
+		void _wheel_expire_slot(unsigned level, unsigned slot);
+
+		void _wheel_advance(Alarm::Time now);
 
 		void _alarm_unsynchronized_enqueue(Alarm *alarm);
 
 		void _alarm_unsynchronized_dequeue(Alarm *alarm);
 
+		void _reprogram_if_needed(Alarm const &alarm);
+
 		Alarm *_alarm_get_pending_alarm();
 
 		void _alarm_setup_alarm(Alarm &alarm, Alarm::Time period, Alarm::Time first_duration);
@@ -284,7 +313,11 @@ class Genode::Alarm_timeout_scheduler : private Noncopyable,
 
 		bool _alarm_next_deadline(Alarm::Time *deadline);
 
-		bool _alarm_head_timeout(const Alarm * alarm) { return _active_head == alarm; }
+		/**
+		 * Return true if the time source must be re-programmed for 'alarm'
+		 */
+		bool _alarm_before_next_timeout(Alarm const &alarm) {
+			return alarm._deadline < _next_timeout; }
 
 		Alarm_timeout_scheduler(Alarm_timeout_scheduler const &);
 		Alarm_timeout_scheduler &operator = (Alarm_timeout_scheduler const &);
@@ -0,0 +1,445 @@
+/*
+ * \brief  Pre-built index of an XML node
+ * \author Norman Feske
+ * \date   2019-03-27
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__UTIL__XML_INDEX_H_
+#define _INCLUDE__UTIL__XML_INDEX_H_
+
+#include <util/xml_node.h>
+#include <util/noncopyable.h>
+#include <base/allocator.h>
+
+namespace Genode { class Xml_index; }
+
+
+/**
+ * Index of the nodes and attributes of an XML node
+ *
+ * Each query of an 'Xml_node' tokenizes the underlying XML data anew. For
+ * large XML data that is queried repeatedly, e.g., a report that is
+ * evaluated for each child of a component, the costs grow quadratically
+ * with the size of the data. The index is built by a single pass over the
+ * XML data. It records the position of each node, its relation to its
+ * parent and siblings, and the position of each attribute. Queries via
+ * 'Xml_index::Node' look up this information instead of tokenizing.
+ *
+ * The index refers to the XML data without copying it. Hence, the data must
+ * stay unmodified during the lifetime of the index. The index is meant to
+ * be rebuilt whenever a new version of the XML data becomes available, e.g.,
+ * after updating a ROM module.
+ */
+class Genode::Xml_index : Noncopyable
+{
+	public:
+
+		class Node;
+
+		typedef Xml_node::Invalid_syntax        Invalid_syntax;
+		typedef Xml_node::Nonexistent_sub_node  Nonexistent_sub_node;
+		typedef Xml_node::Nonexistent_attribute Nonexistent_attribute;
+
+	private:
+
+		typedef Xml_node::Token Token;
+		typedef Xml_node::Tag   Tag;
+
+		enum { NONE = ~0U };
+
+		struct Entry
+		{
+			char const *start;          /* first character of the node */
+			size_t      size;           /* size including start and end tag */
+			char const *content;
+			size_t      content_size;
+			char const *name;
+			size_t      name_len;
+			unsigned    parent;
+			unsigned    first_child;
+			unsigned    last_child;
+			unsigned    next_sibling;
+			unsigned    num_sub_nodes;
+			unsigned    first_attribute;
+			unsigned    num_attributes;
+		};
+
+		struct Attribute
+		{
+			char const *name;
+			size_t      name_len;
+			size_t      max_len;        /* limit for tokenizing the attribute */
+		};
+
+		Allocator &_alloc;
+
+		unsigned _num_entries    = 0;
+		unsigned _num_attributes = 0;
+
+		Entry     *_entries    = nullptr;
+		Attribute *_attributes = nullptr;
+
+		static bool _matches(char const *s, size_t len, char const *type) {
+			return strlen(type) == len && strcmp(type, s, len) == 0; }
+
+		/**
+		 * Traverse all tags of the XML node
+		 *
+		 * The traversal follows the same rules as the 'Xml_node' parser,
+		 * i.e., comments are skipped and the nesting is determined by the
+		 * start and end tags.
+		 *
+		 * \param fill  if false, only count the nodes and attributes
+		 */
+		void _scan(Xml_node const &node, bool fill)
+		{
+			unsigned num_entries    = 0;
+			unsigned num_attributes = 0;
+			unsigned curr           = NONE;
+			unsigned depth          = 0;
+
+			Token t = node._start_tag.token();
+
+			while (t.type() != Token::END) {
+
+				/* eat XML comment */
+				Xml_node::Comment const comment(t);
+				if (comment.valid()) {
+					t = comment.next_token();
+					continue;
+				}
+
+				/* skip all tokens that are no tags */
+				Tag const tag(t);
+				if (tag.type() == Tag::INVALID) {
+					t = t.next();
+					continue;
+				}
+
+				if (tag.node()) {
+
+					unsigned const id = num_entries++;
+
+					unsigned const first_attribute = num_attributes;
+					char const *   const tag_end   = tag.next_token().start();
+
+					try {
+						for (Xml_attribute a = tag.attribute(); ; a = a._next()) {
+							if (fill)
+								_attributes[num_attributes] = Attribute {
+									a._name.start(), a._name.len(),
+									(size_t)(tag_end - a._name.start()) };
+							num_attributes++;
+						}
+					} catch (Nonexistent_attribute) { }
+
+					if (fill) {
+						Entry &e = _entries[id];
+						e = Entry { tag.token().start(), 0, tag_end, 0,
+						            tag.name().start(), tag.name().len(),
+						            curr, NONE, NONE, NONE, 0,
+						            first_attribute, num_attributes - first_attribute };
+
+						if (tag.type() == Tag::EMPTY)
+							e.size = tag_end - e.start;
+
+						if (curr != NONE) {
+							Entry &parent = _entries[curr];
+							if (parent.last_child != NONE)
+								_entries[parent.last_child].next_sibling = id;
+							else
+								parent.first_child = id;
+							parent.last_child = id;
+							parent.num_sub_nodes++;
+						}
+					}
+
+					if (tag.type() == Tag::START) {
+						curr = id;
+						depth++;
+					}
+
+					/* indexed node is an empty-element tag */
+					if (depth == 0)
+						break;
+				}
+
+				if (tag.type() == Tag::END) {
+
+					if (fill) {
+						Entry &e = _entries[curr];
+						e.size         = tag.next_token().start() - e.start;
+						e.content_size = tag.token().start() - e.content;
+						curr           = e.parent;
+					}
+
+					/* end of the indexed node */
+					if (--depth == 0)
+						break;
+				}
+
+				t = tag.next_token();
+			}
+
+			_num_entries    = num_entries;
+			_num_attributes = num_attributes;
+		}
+
+		void _free()
+		{
+			if (_entries)
+				_alloc.free(_entries, _num_entries*sizeof(Entry));
+
+			if (_attributes)
+				_alloc.free(_attributes, _num_attributes*sizeof(Attribute));
+		}
+
+	public:
+
+		/**
+		 * Handle of an indexed XML node
+		 *
+		 * The handle is valid as long as the index exists.
+		 */
+		class Node
+		{
+			private:
+
+				friend class Xml_index;
+
+				Xml_index const *_index;
+				unsigned         _id;
+
+				Node(Xml_index const &index, unsigned id)
+				: _index(&index), _id(id) { }
+
+				Entry const &_entry() const { return _index->_entries[_id]; }
+
+				/**
+				 * Return attribute with the specified name or nullptr
+				 */
+				Attribute const *_attribute(char const *type) const
+				{
+					Entry const &e = _entry();
+					for (unsigned i = 0; i < e.num_attributes; i++) {
+						Attribute const &a = _index->_attributes[e.first_attribute + i];
+						if (_matches(a.name, a.name_len, type))
+							return &a;
+					}
+					return nullptr;
+				}
+
+			public:
+
+				/**
+				 * Return XML node for the indexed node
+				 *
+				 * \throw Invalid_syntax  node is not well formed
+				 */
+				Xml_node xml() const
+				{
+					Entry const &e = _entry();
+					return Xml_node(e.start, e.size);
+				}
+
+				Xml_node::Type type() const
+				{
+					Entry const &e = _entry();
+					return Xml_node::Type(Cstring(e.name, e.name_len));
+				}
+
+				bool has_type(char const *type) const
+				{
+					Entry const &e = _entry();
+					return _matches(e.name, e.name_len, type);
+				}
+
+				size_t num_sub_nodes() const { return _entry().num_sub_nodes; }
+
+				/**
+				 * Call functor 'fn' with the node data '(char const *, size_t)'
+				 */
+				template <typename FN>
+				void with_raw_node(FN const &fn) const
+				{
+					Entry const &e = _entry();
+					fn(e.start, e.size);
+				}
+
+				/**
+				 * Call functor 'fn' with content '(char const *, size_t)'
+				 *
+				 * If the node has no content, the functor 'fn' is not called.
+				 */
+				template <typename FN>
+				void with_raw_content(FN const &fn) const
+				{
+					Entry const &e = _entry();
+
+					/* the content of an empty-element tag follows the node */
+					if (e.content < e.start + e.size)
+						fn(e.content, e.content_size);
+				}
+
+				/**
+				 * Return attribute of specified type
+				 *
+				 * \throw Nonexistent_attribute
+				 */
+				Xml_attribute attribute(char const *type) const
+				{
+					Attribute const *a = _attribute(type);
+					if (!a)
+						throw Nonexistent_attribute();
+
+					return Xml_attribute(Token(a->name, a->max_len));
+				}
+
+				/**
+				 * Read attribute value, see 'Xml_node::attribute_value'
+				 */
+				template <typename T>
+				T attribute_value(char const *type, T const default_value) const
+				{
+					T result = default_value;
+					if (Attribute const *a = _attribute(type))
+						Xml_attribute(Token(a->name, a->max_len)).value(result);
+					return result;
+				}
+
+				bool has_attribute(char const *type) const {
+					return _attribute(type) != nullptr; }
+
+				/**
+				 * Execute functor 'fn' for each attribute
+				 *
+				 * The functor is called with an 'Xml_attribute const &'.
+				 */
+				template <typename FN>
+				void for_each_attribute(FN const &fn) const
+				{
+					Entry const &e = _entry();
+					for (unsigned i = 0; i < e.num_attributes; i++) {
+						Attribute const &a = _index->_attributes[e.first_attribute + i];
+						fn(Xml_attribute(Token(a.name, a.max_len)));
+					}
+				}
+
+				/**
+				 * Execute functor 'fn' for each sub node of specified type
+				 *
+				 * \param type  type of sub nodes, or nullptr for all sub nodes
+				 */
+				template <typename FN>
+				void for_each_sub_node(char const *type, FN const &fn) const
+				{
+					for (unsigned id = _entry().first_child; id != NONE;
+					     id = _index->_entries[id].next_sibling) {
+
+						Node const node(*_index, id);
+						if (!type || node.has_type(type))
+							fn(node);
+					}
+				}
+
+				template <typename FN>
+				void for_each_sub_node(FN const &fn) const {
+					for_each_sub_node(nullptr, fn); }
+
+				/**
+				 * Return sub node with specified index
+				 *
+				 * \throw Nonexistent_sub_node
+				 */
+				Node sub_node(unsigned idx = 0U) const
+				{
+					for (unsigned id = _entry().first_child; id != NONE;
+					     id = _index->_entries[id].next_sibling, idx--)
+						if (idx == 0)
+							return Node(*_index, id);
+
+					throw Nonexistent_sub_node();
+				}
+
+				/**
+				 * Return first sub node of specified type
+				 *
+				 * \throw Nonexistent_sub_node
+				 */
+				Node sub_node(char const *type) const
+				{
+					for (unsigned id = _entry().first_child; id != NONE;
+					     id = _index->_entries[id].next_sibling)
+						if (Node(*_index, id).has_type(type))
+							return Node(*_index, id);
+
+					throw Nonexistent_sub_node();
+				}
+
+				bool has_sub_node(char const *type) const
+				{
+					try { sub_node(type); return true; } catch (...) { }
+					return false;
+				}
+
+				/**
+				 * Apply functor 'fn' to first sub node of specified type
+				 */
+				template <typename FN>
+				void with_sub_node(char const *type, FN const &fn) const
+				{
+					if (has_sub_node(type))
+						fn(sub_node(type));
+				}
+
+				void print(Output &output) const {
+					output.out_string(_entry().start, _entry().size); }
+		};
+
+		/**
+		 * Constructor
+		 *
+		 * \param alloc  allocator used for the index tables
+		 * \param node   XML node to index
+		 *
+		 * \throw Out_of_ram
+		 * \throw Out_of_caps
+		 */
+		Xml_index(Allocator &alloc, Xml_node const &node) : _alloc(alloc)
+		{
+			/* determine size of the index tables */
+			_scan(node, false);
+
+			_entries = (Entry *)_alloc.alloc(_num_entries*sizeof(Entry));
+
+			if (_num_attributes) {
+				try {
+					_attributes = (Attribute *)
+						_alloc.alloc(_num_attributes*sizeof(Attribute));
+				} catch (...) { _free(); throw; }
+			}
+
+			_scan(node, true);
+		}
+
+		~Xml_index() { _free(); }
+
+		/**
+		 * Return indexed top-level node
+		 */
+		Node root() const { return Node(*this, 0); }
+
+		/**
+		 * Return number of indexed nodes
+		 */
+		unsigned num_nodes() const { return _num_entries; }
+};
+
+#endif /* _INCLUDE__UTIL__XML_INDEX_H_ */
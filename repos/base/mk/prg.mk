@@ -135,6 +135,12 @@ else
 #
 LD_OPT += --dynamic-list=$(BASE_DIR)/src/ld/genode_dyn.dl
 
+#
+# Provide the GNU hash table for fast symbol lookup by the dynamic linker
+# along with the ELF hash table
+#
+LD_OPT += --hash-style=both
+
 LD_SCRIPTS := $(LD_SCRIPT_DYN)
 LD_CMD     += -Wl,--dynamic-linker=$(DYNAMIC_LINKER).lib.so \
               -Wl,--eh-frame-hdr -Wl,-rpath-link=.
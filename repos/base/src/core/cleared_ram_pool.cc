@@ -0,0 +1,269 @@
+/*
+ * \brief  Pool of physical memory cleared in the background
+ * \author Norman Feske
+ * \date   2019-04-16
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/log.h>
+
+/* core includes */
+#include <cleared_ram_pool.h>
+#include <ram_dataspace_factory.h>
+#include <platform_generic.h>
+
+using namespace Genode;
+
+
+Cleared_ram_pool &Genode::cleared_ram_pool()
+{
+	/* leave the bulk of the physical memory to the regular allocations */
+	size_t const limit = min(platform().cleared_ram_pool_size(),
+	                         platform().ram_alloc().avail() / 16);
+
+	static Cleared_ram_pool pool(platform().ram_alloc(),
+	                             platform().core_mem_alloc(), limit);
+	return pool;
+}
+
+
+/**
+ * Move range from allocator 'from' to the free memory of allocator 'to'
+ *
+ * The range must be an allocated block of 'from'.
+ */
+static void move_range(Allocator_avl &from, Allocator_avl &to,
+                       addr_t base, size_t size)
+{
+	from.free((void *)base);
+	from.remove_range(base, size);
+	to.add_range(base, size);
+}
+
+
+/**
+ * Take free range of at most 'CHUNK_SIZE' bytes out of allocator 'alloc'
+ */
+static bool take_range(Allocator_avl &alloc, addr_t &base, size_t &size)
+{
+	for (size = Cleared_ram_pool::CHUNK_SIZE; size >= get_page_size(); size >>= 1) {
+
+		void *out = nullptr;
+		if (alloc.alloc_aligned(size, &out, get_page_size_log2()).ok()) {
+			base = (addr_t)out;
+			alloc.free(out);
+			alloc.remove_range(base, size);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void Cleared_ram_pool::_restore_chunk(addr_t base)
+{
+	/*
+	 * Re-add the pages that got removed already. Pages taken by a concurrent
+	 * allocation conflict with the allocated block and are skipped.
+	 */
+	for (addr_t page = base; page < base + CHUNK_SIZE; page += get_page_size())
+		_phys_alloc.add_range(page, get_page_size());
+}
+
+
+bool Cleared_ram_pool::_reserve_chunk()
+{
+	if (_stats.reserved + CHUNK_SIZE > _target)
+		return false;
+
+	/*
+	 * Like RAM dataspaces without physical constraints, the pool preferably
+	 * uses high memory to preserve lower physical regions for DMA.
+	 */
+	addr_t const high_start = (sizeof(void *) == 4 ? 3UL : 4UL) << 30;
+
+	void *base = nullptr;
+	if (_phys_alloc.alloc_aligned(CHUNK_SIZE, &base, CHUNK_SIZE_LOG2,
+	                              high_start, ~0UL).error()
+	 && _phys_alloc.alloc_aligned(CHUNK_SIZE, &base, CHUNK_SIZE_LOG2).error())
+		return false;
+
+	/*
+	 * Turn the allocated block into a removed range, which allows 'flush'
+	 * to hand back arbitrary parts of the chunk. The range may get allocated
+	 * by someone else between both steps, which fails the removal.
+	 */
+	_phys_alloc.free(base);
+	if (_phys_alloc.remove_range((addr_t)base, CHUNK_SIZE)) {
+		_restore_chunk((addr_t)base);
+		return false;
+	}
+
+	_reserved.add_range((addr_t)base, CHUNK_SIZE);
+	_dirty.add_range((addr_t)base, CHUNK_SIZE);
+	_stats.reserved += CHUNK_SIZE;
+	return true;
+}
+
+
+void Cleared_ram_pool::_release(addr_t base, size_t size)
+{
+	_reserved.remove_range(base, size);
+	_phys_alloc.add_range(base, size);
+	_stats.reserved -= size;
+	_stats.flushed  += size;
+}
+
+
+bool Cleared_ram_pool::_clear_step()
+{
+	addr_t base = 0;
+	size_t size = 0;
+
+	{
+		Lock::Guard guard(_lock);
+
+		if (!take_range(_dirty, base, size)) {
+			if (!_reserve_chunk() || !take_range(_dirty, base, size))
+				return false;
+		}
+	}
+
+	/*
+	 * Clear the memory via the platform-specific back end of the RAM
+	 * dataspace factory, which takes care of the core-local mapping.
+	 */
+	{
+		Dataspace_component ds(size, base, CACHED, true, nullptr);
+
+		Ram_dataspace_factory::_export_ram_ds(ds);
+		Ram_dataspace_factory::_clear_ds(ds);
+		Ram_dataspace_factory::_revoke_ram_ds(ds);
+	}
+
+	Lock::Guard guard(_lock);
+
+	_cleared.add_range(base, size);
+	_stats.cleared       += size;
+	_stats.cleared_total += size;
+	return true;
+}
+
+
+void Cleared_ram_pool::Filler::entry()
+{
+	Stats reported { };
+
+	for (;;) {
+		while (_pool._clear_step());
+
+		/*
+		 * Report the statistics whenever the pool got refilled completely
+		 * after it could not satisfy allocations.
+		 */
+		Stats const stats = _pool.stats();
+		if (stats.misses != reported.misses
+		 && stats.cleared_total - reported.cleared_total >= _pool._limit) {
+			log("cleared RAM pool: ", stats);
+			reported = stats;
+		}
+
+		_pool._work.down();
+	}
+}
+
+
+void Cleared_ram_pool::start()
+{
+	if (!enabled() || _filler.constructed())
+		return;
+
+	log("cleared RAM pool of ", _limit >> 20, " MiB");
+
+	_filler.construct(*this);
+}
+
+
+bool Cleared_ram_pool::alloc(size_t size, void **out_addr, addr_t from, addr_t to)
+{
+	if (!enabled())
+		return false;
+
+	size_t const min_align_log2 = (size >= CHUNK_SIZE) ? (size_t)CHUNK_SIZE_LOG2
+	                                                    : get_page_size_log2();
+	bool ok = false;
+	{
+		Lock::Guard guard(_lock);
+
+		for (size_t align_log2 = log2(size); !ok && align_log2 >= min_align_log2; align_log2--)
+			ok = _cleared.alloc_aligned(size, out_addr, align_log2, from, to).ok();
+
+		if (ok) {
+			_stats.cleared   -= size;
+			_stats.hits      += 1;
+			_stats.hit_bytes += size;
+		} else {
+			_stats.misses += 1;
+		}
+	}
+
+	/* refill the pool */
+	_work.up();
+
+	return ok;
+}
+
+
+bool Cleared_ram_pool::free(void *addr, size_t size)
+{
+	if (!enabled())
+		return false;
+
+	{
+		Lock::Guard guard(_lock);
+
+		if (!_reserved.valid_addr((addr_t)addr))
+			return false;
+
+		move_range(_cleared, _dirty, (addr_t)addr, size);
+	}
+
+	_work.up();
+	return true;
+}
+
+
+bool Cleared_ram_pool::flush()
+{
+	Lock::Guard guard(_lock);
+
+	size_t const reserved = _stats.reserved;
+
+	/*
+	 * Memory currently cleared by the filler is neither part of '_cleared'
+	 * nor of '_dirty' and stays in the pool. It is handed back by the next
+	 * call.
+	 */
+	addr_t base = 0;
+	size_t size = 0;
+
+	while (take_range(_cleared, base, size)) {
+		_stats.cleared -= size;
+		_release(base, size);
+	}
+
+	while (take_range(_dirty, base, size))
+		_release(base, size);
+
+	/* stop growing the pool under memory pressure */
+	_target = _stats.reserved;
+
+	return _stats.reserved < reserved;
+}
@@ -0,0 +1,200 @@
+/*
+ * \brief  Pool of physical memory cleared in the background
+ * \author Norman Feske
+ * \date   2019-04-16
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _CORE__INCLUDE__CLEARED_RAM_POOL_H_
+#define _CORE__INCLUDE__CLEARED_RAM_POOL_H_
+
+/* Genode includes */
+#include <base/allocator_avl.h>
+#include <base/thread.h>
+#include <base/semaphore.h>
+#include <util/reconstructible.h>
+
+namespace Genode {
+
+	class Cleared_ram_pool;
+
+	/**
+	 * Return core-global pool of cleared RAM
+	 */
+	Cleared_ram_pool &cleared_ram_pool();
+}
+
+
+/**
+ * Physical memory that is zeroed ahead of its use by RAM dataspaces
+ *
+ * Clearing a dataspace within the allocating RPC stalls the client as well
+ * as core's entrypoint for a time proportional to the dataspace size. The
+ * pool reserves physical memory in chunks of the size of a large page and
+ * lets a core thread clear the memory in the background. RAM dataspaces are
+ * allocated from the cleared memory if possible. Once freed, their memory
+ * is returned to the pool to be cleared again.
+ *
+ * The reserved memory is removed from the physical-memory allocator rather
+ * than allocated from it. So any free part of it, whether cleared or not,
+ * can be handed back via 'flush' if the allocator runs out of memory.
+ * Memory that is still dirty is then cleared by the RAM dataspace factory
+ * along with the dataspace it ends up in.
+ */
+class Genode::Cleared_ram_pool : Noncopyable
+{
+	public:
+
+		enum { CHUNK_SIZE_LOG2 = 21, CHUNK_SIZE = 1UL << CHUNK_SIZE_LOG2 };
+
+		struct Stats
+		{
+			size_t reserved;       /* bytes reserved from physical memory */
+			size_t cleared;        /* bytes ready for allocation */
+			size_t cleared_total;  /* bytes cleared since boot */
+			size_t hits;           /* allocations served by the pool */
+			size_t hit_bytes;
+			size_t misses;         /* cached allocations not served */
+			size_t flushed;        /* bytes returned to physical memory */
+
+			void print(Output &out) const
+			{
+				Genode::print(out, "reserved=",  reserved  >> 20, "M "
+				                   "cleared=",   cleared   >> 20, "M "
+				                   "hits=",      hits, " (", hit_bytes >> 20, "M) "
+				                   "misses=",    misses, " "
+				                   "flushed=",   flushed >> 20, "M "
+				                   "total cleared=", cleared_total >> 20, "M");
+			}
+		};
+
+	private:
+
+		struct Filler : Thread_deprecated<4096*sizeof(long)>
+		{
+			Cleared_ram_pool &_pool;
+
+			Filler(Cleared_ram_pool &pool)
+			: Thread_deprecated("ram_clear"), _pool(pool) { start(); }
+
+			void entry() override;
+		};
+
+		Range_allocator &_phys_alloc;
+		Allocator       &_md_alloc;
+		size_t const     _limit;
+
+		/* amount of memory the filler reserves, shrunk by 'flush' */
+		size_t _target = _limit;
+
+		Lock mutable _lock { };
+
+		/* physical memory owned by the pool, in use or not */
+		Allocator_avl _reserved { &_md_alloc };
+
+		/* free memory ready for allocation, used blocks are in use */
+		Allocator_avl _cleared { &_md_alloc };
+
+		/* free memory waiting to be cleared by the filler */
+		Allocator_avl _dirty { &_md_alloc };
+
+		Stats _stats { };
+
+		Semaphore _work { };
+
+		Constructible<Filler> _filler { };
+
+		/**
+		 * Reserve chunk of physical memory, called with '_lock' held
+		 *
+		 * \return  false if the pool reached its limit or if the physical
+		 *          memory is exhausted
+		 */
+		bool _reserve_chunk();
+
+		/**
+		 * Return chunk to the physical-memory allocator after a failed
+		 * reservation, called with '_lock' held
+		 */
+		void _restore_chunk(addr_t base);
+
+		/**
+		 * Hand back free range to the physical-memory allocator, called
+		 * with '_lock' held
+		 */
+		void _release(addr_t base, size_t size);
+
+		/**
+		 * Clear one range of dirty memory
+		 *
+		 * \return  false if there is nothing left to clear
+		 */
+		bool _clear_step();
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param phys_alloc  allocator of physical memory
+		 * \param md_alloc    meta-data allocator
+		 * \param limit       maximum amount of reserved memory in bytes,
+		 *                    0 disables the pool
+		 */
+		Cleared_ram_pool(Range_allocator &phys_alloc, Allocator &md_alloc,
+		                 size_t limit)
+		:
+			_phys_alloc(phys_alloc), _md_alloc(md_alloc),
+			_limit(align_addr(limit, CHUNK_SIZE_LOG2))
+		{ }
+
+		bool enabled() const { return _limit > 0; }
+
+		/**
+		 * Start clearing memory in the background
+		 */
+		void start();
+
+		/**
+		 * Allocate cleared memory
+		 *
+		 * Allocations of the size of a chunk or larger are aligned at least
+		 * to the chunk size to allow the use of large-page mappings. Smaller
+		 * allocations are naturally aligned if possible.
+		 *
+		 * \return  false if the pool cannot satisfy the allocation
+		 */
+		bool alloc(size_t size, void **out_addr, addr_t from, addr_t to);
+
+		/**
+		 * Return memory allocated via 'alloc' to the pool
+		 *
+		 * \return  false if 'addr' does not belong to the pool
+		 */
+		bool free(void *addr, size_t size);
+
+		/**
+		 * Hand back all free memory to the physical-memory allocator
+		 *
+		 * This covers the cleared as well as the dirty memory of the pool,
+		 * including the free parts of partially used chunks. The pool does
+		 * not grow beyond its remaining size afterwards.
+		 *
+		 * \return  true if any memory got released
+		 */
+		bool flush();
+
+		Stats stats() const
+		{
+			Lock::Guard guard(_lock);
+			return _stats;
+		}
+};
+
+#endif /* _CORE__INCLUDE__CLEARED_RAM_POOL_H_ */
@@ -6,7 +6,7 @@
  */
 
 /*
- * Copyright (C) 2007-2017 Genode Labs GmbH
+ * Copyright (C) 2007-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -103,6 +103,15 @@ namespace Genode {
 			 * Return true if the core component relies on a 'Platform_pd' object
 			 */
 			virtual bool core_needs_platform_pd() const { return true; }
+
+			/**
+			 * Return maximum size of the pool of RAM cleared in the background
+			 *
+			 * Platforms where core cannot execute a thread independently
+			 * from its entrypoints or where RAM dataspaces are not backed by
+			 * physical memory return 0 to disable the pool.
+			 */
+			virtual size_t cleared_ram_pool_size() const { return 64*1024*1024; }
 	};
 
 
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2017 Genode Labs GmbH
+ * Copyright (C) 2017-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -58,10 +58,22 @@ class Genode::Ram_dataspace_factory : public Ram_allocator,
 		Tslab<Dataspace_component, SLAB_BLOCK_SIZE> _ds_slab;
 
 
+		/**
+		 * Release physical memory backing a dataspace
+		 */
+		void _free_phys(void *phys_addr, size_t size);
+
+
 		/********************************************
 		 ** Platform-implemented support functions **
 		 ********************************************/
 
+		/*
+		 * The support functions are also used by the 'Cleared_ram_pool' to
+		 * clear physical memory outside the context of a factory.
+		 */
+		friend class Cleared_ram_pool;
+
 		struct Core_virtual_memory_exhausted : Exception { };
 
 		/**
@@ -69,17 +81,21 @@ class Genode::Ram_dataspace_factory : public Ram_allocator,
 		 *
 		 * \throw Core_virtual_memory_exhausted
 		 */
-		void _export_ram_ds(Dataspace_component &ds);
+		static void _export_ram_ds(Dataspace_component &ds);
 
 		/**
 		 * Revert export of RAM dataspace
 		 */
-		void _revoke_ram_ds(Dataspace_component &ds);
+		static void _revoke_ram_ds(Dataspace_component &ds);
 
 		/**
 		 * Zero-out content of dataspace
+		 *
+		 * Dataspaces backed by memory of the 'Cleared_ram_pool' are not
+		 * passed to this function. Platforms where the function reverts
+		 * state established by '_export_ram_ds' must disable the pool.
 		 */
-		void _clear_ds(Dataspace_component &ds);
+		static void _clear_ds(Dataspace_component &ds);
 
 	public:
 
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2006-2017 Genode Labs GmbH
+ * Copyright (C) 2006-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -39,6 +39,7 @@
 #include <irq_root.h>
 #include <trace/root.h>
 #include <platform_services.h>
+#include <cleared_ram_pool.h>
 
 using namespace Genode;
 
@@ -279,6 +280,9 @@ int main()
 	/* make platform-specific services known to service pool */
 	platform_add_local_services(ep, sliced_heap, services, Trace::sources());
 
+	/* clear RAM for dataspace allocations in the background */
+	cleared_ram_pool().start();
+
 	size_t const avail_ram_quota = core_pd.avail_ram().value;
 	size_t const avail_cap_quota = core_pd.avail_caps().value;
 
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2006-2017 Genode Labs GmbH
+ * Copyright (C) 2006-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -16,6 +16,7 @@
 
 /* core includes */
 #include <ram_dataspace_factory.h>
+#include <cleared_ram_pool.h>
 
 using namespace Genode;
 
@@ -40,13 +41,24 @@ Ram_dataspace_factory::alloc(size_t ds_size, Cache_attribute cached)
 	void *ds_addr = nullptr;
 	bool alloc_succeeded = false;
 
+	/*
+	 * Cached dataspaces are preferably allocated from memory that was cleared
+	 * in the background. Uncached dataspaces are cleared individually because
+	 * their memory must be flushed from the data cache.
+	 */
+	bool const cleared = (cached == CACHED)
+	                  && cleared_ram_pool().alloc(ds_size, &ds_addr,
+	                                              _phys_range.start,
+	                                              _phys_range.end);
+	alloc_succeeded = cleared;
+
 	/*
 	 * If no physical constraint exists, try to allocate physical memory at
 	 * high locations (3G for 32-bit / 4G for 64-bit platforms) in order to
 	 * preserve lower physical regions for device drivers, which may have DMA
 	 * constraints.
 	 */
-	if (_phys_range.start == 0 && _phys_range.end == ~0UL) {
+	if (!alloc_succeeded && _phys_range.start == 0 && _phys_range.end == ~0UL) {
 		addr_t const high_start = (sizeof(void *) == 4 ? 3UL : 4UL) << 30;
 		for (size_t align_log2 = log2(ds_size); align_log2 >= 12; align_log2--) {
 			if (_phys_alloc.alloc_aligned(ds_size, &ds_addr, align_log2,
@@ -57,8 +69,14 @@ Ram_dataspace_factory::alloc(size_t ds_size, Cache_attribute cached)
 		}
 	}
 
-	/* apply constraints or re-try because higher memory allocation failed */
-	if (!alloc_succeeded) {
+	/*
+	 * Apply constraints or re-try because higher memory allocation failed.
+	 * If the physical memory is exhausted, reclaim the free memory of the
+	 * cleared-RAM pool. This also serves uncached and physically constrained
+	 * dataspaces. Reclaimed memory that was not cleared yet is cleared along
+	 * with the dataspace below.
+	 */
+	for (bool retry = true; !alloc_succeeded && retry; ) {
 		for (size_t align_log2 = log2(ds_size); align_log2 >= 12; align_log2--) {
 			if (_phys_alloc.alloc_aligned(ds_size, &ds_addr, align_log2,
 			                              _phys_range.start, _phys_range.end).ok()) {
@@ -66,6 +84,7 @@ Ram_dataspace_factory::alloc(size_t ds_size, Cache_attribute cached)
 				break;
 			}
 		}
+		retry = !alloc_succeeded && cleared_ram_pool().flush();
 	}
 
 	/*
@@ -84,16 +103,18 @@ Ram_dataspace_factory::alloc(size_t ds_size, Cache_attribute cached)
 
 		public:
 
-			Range_allocator &phys_alloc;
+			Ram_dataspace_factory &factory;
 			void * const ds_addr;
+			size_t const ds_size;
 			bool ack = false;
 
-			Phys_alloc_guard(Range_allocator &phys_alloc, void *ds_addr)
-			: phys_alloc(phys_alloc), ds_addr(ds_addr) { }
+			Phys_alloc_guard(Ram_dataspace_factory &factory, void *ds_addr,
+			                 size_t ds_size)
+			: factory(factory), ds_addr(ds_addr), ds_size(ds_size) { }
 
-			~Phys_alloc_guard() { if (!ack) phys_alloc.free(ds_addr); }
+			~Phys_alloc_guard() { if (!ack) factory._free_phys(ds_addr, ds_size); }
 
-	} phys_alloc_guard(_phys_alloc, ds_addr);
+	} phys_alloc_guard(*this, ds_addr, ds_size);
 
 	/*
 	 * Normally, init's quota equals the size of physical memory and this quota
@@ -133,7 +154,8 @@ Ram_dataspace_factory::alloc(size_t ds_size, Cache_attribute cached)
 	 * function must also make sure to flush all cache lines related to the
 	 * address range used by the dataspace.
 	 */
-	_clear_ds(ds);
+	if (!cleared)
+		_clear_ds(ds);
 
 	Dataspace_capability result = _ep.manage(&ds);
 
@@ -165,7 +187,7 @@ void Ram_dataspace_factory::free(Ram_dataspace_capability ds_cap)
 		_revoke_ram_ds(*ds);
 
 		/* free physical memory that was backing the dataspace */
-		_phys_alloc.free((void *)ds->phys_addr(), ds_size);
+		_free_phys((void *)ds->phys_addr(), ds_size);
 	});
 
 	/* call dataspace destructor and free memory */
@@ -174,6 +196,13 @@ void Ram_dataspace_factory::free(Ram_dataspace_capability ds_cap)
 }
 
 
+void Ram_dataspace_factory::_free_phys(void *phys_addr, size_t size)
+{
+	if (!cleared_ram_pool().free(phys_addr, size))
+		_phys_alloc.free(phys_addr, size);
+}
+
+
 size_t Ram_dataspace_factory::dataspace_size(Ram_dataspace_capability ds_cap) const
 {
 	size_t result = 0;
@@ -237,6 +237,88 @@ enum {
 	PF_R = (1 << 2),   /* segment is readable   */
 };
 
+/**
+ * Section header
+ */
+typedef struct
+{
+	Elf32_Word    sh_name;       /* section name (string table index) */
+	Elf32_Word    sh_type;       /* section type                      */
+	Elf32_Word    sh_flags;      /* section flags                     */
+	Elf32_Addr    sh_addr;       /* section virtual address           */
+	Elf32_Off     sh_offset;     /* section file offset               */
+	Elf32_Word    sh_size;       /* section size in bytes             */
+	Elf32_Word    sh_link;       /* link to another section           */
+	Elf32_Word    sh_info;       /* additional section information    */
+	Elf32_Word    sh_addralign;  /* section alignment                 */
+	Elf32_Word    sh_entsize;    /* entry size if section holds table */
+} Elf32_Shdr;
+
+typedef struct
+{
+	Elf64_Word    sh_name;       /* section name (string table index) */
+	Elf64_Word    sh_type;       /* section type                      */
+	Elf64_Xword   sh_flags;      /* section flags                     */
+	Elf64_Addr    sh_addr;       /* section virtual address           */
+	Elf64_Off     sh_offset;     /* section file offset               */
+	Elf64_Xword   sh_size;       /* section size in bytes             */
+	Elf64_Word    sh_link;       /* link to another section           */
+	Elf64_Word    sh_info;       /* additional section information    */
+	Elf64_Xword   sh_addralign;  /* section alignment                 */
+	Elf64_Xword   sh_entsize;    /* entry size if section holds table */
+} Elf64_Shdr;
+
+/**
+ * Legal values for sh_type (section type)
+ */
+enum {
+	SHT_NULL     = 0,   /* section header table entry unused */
+	SHT_PROGBITS = 1,   /* program data                      */
+	SHT_SYMTAB   = 2,   /* symbol table                      */
+	SHT_STRTAB   = 3,   /* string table                      */
+	SHT_NOBITS   = 8,   /* program space with no data (bss)  */
+	SHT_DYNSYM   = 11,  /* dynamic linker symbol table       */
+};
+
+/**
+ * Symbol table entry
+ */
+typedef struct
+{
+	Elf32_Word    st_name;    /* symbol name (string table index) */
+	Elf32_Addr    st_value;   /* symbol value                     */
+	Elf32_Word    st_size;    /* symbol size                      */
+	unsigned char st_info;    /* symbol type and binding          */
+	unsigned char st_other;   /* symbol visibility                */
+	Elf32_Section st_shndx;   /* section index                    */
+} Elf32_Sym;
+
+typedef struct
+{
+	Elf64_Word    st_name;    /* symbol name (string table index) */
+	unsigned char st_info;    /* symbol type and binding          */
+	unsigned char st_other;   /* symbol visibility                */
+	Elf64_Section st_shndx;   /* section index                    */
+	Elf64_Addr    st_value;   /* symbol value                     */
+	Elf64_Xword   st_size;    /* symbol size                      */
+} Elf64_Sym;
+
+/**
+ * Legal values for the type part of st_info (symbol type)
+ */
+enum {
+	STT_NOTYPE = 0,   /* symbol type is unspecified */
+	STT_OBJECT = 1,   /* symbol is a data object    */
+	STT_FUNC   = 2,   /* symbol is a code object    */
+};
+
+/**
+ * Special section indices
+ */
+enum { SHN_UNDEF = 0 };
+
+#define ELF_ST_TYPE(info) ((info) & 0xf)
+
 /**
  * Define bit-width independent types
  */
@@ -244,10 +326,14 @@ enum {
 #ifdef _LP64
 typedef Elf64_Ehdr Elf_Ehdr;
 typedef Elf64_Phdr Elf_Phdr;
+typedef Elf64_Shdr Elf_Shdr;
+typedef Elf64_Sym  Elf_Sym;
 #define ELFCLASS ELFCLASS64
 #else
 typedef Elf32_Ehdr Elf_Ehdr;
 typedef Elf32_Phdr Elf_Phdr;
+typedef Elf32_Shdr Elf_Shdr;
+typedef Elf32_Sym  Elf_Sym;
 #define ELFCLASS ELFCLASS32
 #endif /* _LP64 */
 
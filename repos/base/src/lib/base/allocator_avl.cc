@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2006-2017 Genode Labs GmbH
+ * Copyright (C) 2006-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -91,6 +91,130 @@ void Allocator_avl_base::Block::recompute()
 }
 
 
+/*******************************
+ ** Free_lists implementation **
+ *******************************/
+
+/**
+ * Return index of most significant set bit of non-zero 'value'
+ */
+static inline unsigned _msb(unsigned long value) {
+	return 8*sizeof(value) - 1 - __builtin_clzl(value); }
+
+
+/**
+ * Return index of least significant set bit of non-zero 'value'
+ */
+static inline unsigned _lsb(unsigned long value) {
+	return __builtin_ctzl(value); }
+
+
+void Allocator_avl_base::Free_lists::_index(size_t size, unsigned &fl, unsigned &sl)
+{
+	if (size < SL_COUNT) {
+		fl = 0;
+		sl = size;
+		return;
+	}
+	unsigned const msb = _msb(size);
+	fl = msb - SL_LOG2 + 1;
+	sl = (size >> (msb - SL_LOG2)) - SL_COUNT;
+}
+
+
+Allocator_avl_base::Block *
+Allocator_avl_base::Free_lists::_first(unsigned fl, unsigned sl) const
+{
+	/* look for non-empty list in the same first-level class */
+	unsigned long const sl_map = _sl_bitmap[fl] & (~0UL << sl);
+	if (sl_map)
+		return _heads[fl][_lsb(sl_map)];
+
+	/* look for non-empty list in higher first-level classes */
+	if (fl + 1 >= FL_COUNT)
+		return nullptr;
+
+	unsigned long const fl_map = _fl_bitmap & (~0UL << (fl + 1));
+	if (!fl_map)
+		return nullptr;
+
+	fl = _lsb(fl_map);
+	return _heads[fl][_lsb(_sl_bitmap[fl])];
+}
+
+
+void Allocator_avl_base::Free_lists::insert(Block &block)
+{
+	unsigned fl = 0, sl = 0;
+	_index(block.size(), fl, sl);
+
+	Block *&head = _heads[fl][sl];
+
+	block._list_prev = nullptr;
+	block._list_next = head;
+	if (head)
+		head->_list_prev = &block;
+
+	head = &block;
+	_fl_bitmap     |= 1UL << fl;
+	_sl_bitmap[fl] |= 1U  << sl;
+}
+
+
+void Allocator_avl_base::Free_lists::remove(Block &block)
+{
+	unsigned fl = 0, sl = 0;
+	_index(block.size(), fl, sl);
+
+	if (block._list_prev) block._list_prev->_list_next = block._list_next;
+	else                  _heads[fl][sl]               = block._list_next;
+
+	if (block._list_next)
+		block._list_next->_list_prev = block._list_prev;
+
+	block._list_prev = block._list_next = nullptr;
+
+	if (_heads[fl][sl])
+		return;
+
+	_sl_bitmap[fl] &= ~(1U << sl);
+	if (!_sl_bitmap[fl])
+		_fl_bitmap &= ~(1UL << fl);
+}
+
+
+Allocator_avl_base::Block *
+Allocator_avl_base::Free_lists::find(size_t size, unsigned align) const
+{
+	auto fits = [&] (Block const &b) {
+		addr_t const a = align_addr(b.addr(), align);
+		return a >= b.addr() && a - b.addr() <= b.size() &&
+		       size <= b.size() - (a - b.addr()); };
+
+	unsigned fl = 0, sl = 0;
+
+	/* try the first block of the exact size class */
+	_index(size, fl, sl);
+	if (Block *b = _heads[fl][sl])
+		if (fits(*b))
+			return b;
+
+	/*
+	 * Round up the size to the next size class so that each block of the
+	 * found list fits regardless of its alignment
+	 */
+	size_t needed = size + (align ? (1UL << align) - 1 : 0);
+	if (needed >= SL_COUNT)
+		needed += (1UL << (_msb(needed) - SL_LOG2)) - 1;
+
+	if (needed < size)
+		return nullptr;
+
+	_index(needed, fl, sl);
+	return _first(fl, sl);
+}
+
+
 /**********************************
  ** Allocator_avl implementation **
  **********************************/
@@ -129,6 +253,9 @@ int Allocator_avl_base::_add_block(Block *block_metadata,
 	/* insert block into avl tree */
 	_addr_tree.insert(block_metadata);
 
+	if (_free_lists && !used)
+		_free_lists->insert(*block_metadata);
+
 	return 0;
 }
 
@@ -137,6 +264,9 @@ void Allocator_avl_base::_destroy_block(Block *b)
 {
 	if (!b) return;
 
+	if (_free_lists && !b->used())
+		_free_lists->remove(*b);
+
 	/* remove block from both avl trees */
 	_addr_tree.remove(b);
 	_md_alloc->free(b, _md_entry_size);
@@ -281,9 +411,16 @@ Allocator_avl_base::alloc_aligned(size_t size, void **out_addr, int align,
 	if (!_alloc_two_blocks_metadata(&dst1, &dst2))
 		return Alloc_return(Alloc_return::OUT_OF_METADATA);
 
+	/* look up free lists for allocations without address constraints */
+	Block *b = nullptr;
+	if (_free_lists && from == 0 && to == ~0UL)
+		b = _free_lists->find(size, align);
+
 	/* find best fitting block */
-	Block *b = _addr_tree.first();
-	b = b ? b->find_best_fit(size, align, from, to) : 0;
+	if (!b) {
+		b = _addr_tree.first();
+		b = b ? b->find_best_fit(size, align, from, to) : 0;
+	}
 
 	if (!b) {
 		_md_alloc->free(dst1, sizeof(Block));
@@ -391,6 +528,26 @@ Allocator_avl_base::Block *Allocator_avl_base::_find_any_used_block(Block *sub_t
 }
 
 
+void Allocator_avl_base::_insert_free_blocks(Block *sub_tree)
+{
+	if (!sub_tree)
+		return;
+
+	if (!sub_tree->used())
+		_free_lists->insert(*sub_tree);
+
+	for (unsigned i = 0; i < 2; i++)
+		_insert_free_blocks(sub_tree->child(i));
+}
+
+
+void Allocator_avl_base::_enable_free_lists(Free_lists &free_lists)
+{
+	_free_lists = &free_lists;
+	_insert_free_blocks(_addr_tree.first());
+}
+
+
 bool Allocator_avl_base::any_block_addr(addr_t *out_addr)
 {
 	Block * const b = _find_any_used_block(_addr_tree.first());
@@ -20,6 +20,8 @@
 
 namespace Linker {
 	struct Hash_table;
+	struct Gnu_hash_table;
+	class  Symbol_hash;
 	struct Dynamic;
 }
 
@@ -53,6 +55,113 @@ struct Linker::Hash_table
 };
 
 
+/**
+ * GNU hash table with Bloom filter
+ *
+ * The Bloom filter rejects most names that are not defined by the object
+ * without touching the hash chains. The symbol table is sorted by bucket.
+ * For each symbol starting at 'symoffset', the chain array holds the hash
+ * value with the lowest bit marking the last symbol of the bucket.
+ */
+struct Linker::Gnu_hash_table
+{
+	Elf::Hashelt const nbuckets;
+	Elf::Hashelt const symoffset;
+	Elf::Hashelt const bloom_size;  /* number of 'Elf::Addr' words */
+	Elf::Hashelt const bloom_shift;
+
+	Elf::Addr    const *bloom()   const { return (Elf::Addr const *)(this + 1); }
+	Elf::Hashelt const *buckets() const { return (Elf::Hashelt const *)(bloom() + bloom_size); }
+	Elf::Hashelt const *chains()  const { return buckets() + nbuckets; }
+
+	/**
+	 * GNU hash function (DJB hash)
+	 */
+	static uint32_t hash(char const *name)
+	{
+		uint32_t h = 5381;
+
+		for (unsigned char const *p = (unsigned char const *)name; *p; p++)
+			h = (h << 5) + h + *p;
+
+		return h;
+	}
+
+	/**
+	 * Return false if the object does not define a symbol of 'hash'
+	 */
+	bool may_contain(uint32_t hash) const
+	{
+		enum { BITS = sizeof(Elf::Addr)*8 };
+
+		if (!bloom_size)
+			return false;
+
+		Elf::Addr const word = bloom()[(hash / BITS) % bloom_size];
+		Elf::Addr const mask = ((Elf::Addr)1 << (hash % BITS))
+		                     | ((Elf::Addr)1 << ((hash >> bloom_shift) % BITS));
+
+		return (word & mask) == mask;
+	}
+
+	/**
+	 * Return number of symbols of the symbol table
+	 *
+	 * The GNU hash table has no explicit size. The symbol table ends with
+	 * the chain of the last non-empty bucket.
+	 */
+	unsigned long num_symbols() const
+	{
+		unsigned long last = 0;
+		for (unsigned long i = 0; i < nbuckets; i++)
+			if (buckets()[i] > last)
+				last = buckets()[i];
+
+		if (last < symoffset)
+			return symoffset;
+
+		while (!(chains()[last - symoffset] & 1))
+			last++;
+
+		return last + 1;
+	}
+};
+
+
+/**
+ * Hash values of a symbol name
+ *
+ * The ELF hash value is needed for objects without GNU hash table only and
+ * is therefore computed on demand.
+ */
+class Linker::Symbol_hash
+{
+	private:
+
+		char const   *_name;
+		uint32_t const _gnu;
+
+		mutable unsigned long _elf       = 0;
+		mutable bool          _elf_valid = false;
+
+	public:
+
+		Symbol_hash(char const *name)
+		: _name(name), _gnu(Gnu_hash_table::hash(name)) { }
+
+		uint32_t gnu() const { return _gnu; }
+
+		unsigned long elf() const
+		{
+			if (!_elf_valid) {
+				_elf       = Hash_table::hash(_name);
+				_elf_valid = true;
+			}
+			return _elf;
+		}
+};
+
+
 /**
  * .dynamic section entries
  */
@@ -93,7 +202,17 @@ class Linker::Dynamic
 
 		Allocator           *_md_alloc      = nullptr;
 
-		Hash_table          *_hash_table    = nullptr;
+		Hash_table          *_hash_table     = nullptr;
+		Gnu_hash_table      *_gnu_hash_table = nullptr;
+		unsigned long        _num_symbols    = 0;
+
+		/*
+		 * Symbols resolved for the symbol-table indices of this object,
+		 * present during relocation only
+		 */
+		struct Resolved { Elf::Sym const *sym; Elf::Addr base; };
+
+		Resolved mutable    *_resolved      = nullptr;
 
 		Elf::Rela           *_reloca        = nullptr;
 		unsigned long        _reloca_size   = 0;
@@ -158,6 +277,7 @@ class Linker::Dynamic
 				case DT_PLTRELSZ: _pltrel_size = d->un.val;                             break;
 				case DT_PLTGOT  : _section<typeof(_pltgot)>(&_pltgot, d);               break;
 				case DT_HASH    : _section<typeof(_hash_table)>(&_hash_table, d);       break;
+				case DT_GNU_HASH: _section<typeof(_gnu_hash_table)>(&_gnu_hash_table, d); break;
 				case DT_RELA    : _section<typeof(_reloca)>(&_reloca, d);               break;
 				case DT_RELASZ  : _reloca_size = d->un.val;                             break;
 				case DT_SYMTAB  : _section<typeof(_symtab)>(&_symtab, d);               break;
@@ -173,6 +293,89 @@ class Linker::Dynamic
 					break;
 				}
 			}
+
+			if (_hash_table)
+				_num_symbols = _hash_table->nchains();
+			else if (_gnu_hash_table)
+				_num_symbols = _gnu_hash_table->num_symbols();
+		}
+
+		/**
+		 * Return true if 'sym' is a definition of the symbol 'name'
+		 */
+		bool _matches(Elf::Sym const &sym, char const *name) const
+		{
+			/* this omitts everything but 'NOTYPE', 'OBJECT', and 'FUNC' */
+			if (sym.type() > STT_FUNC)
+				return false;
+
+			if (sym.st_value == 0)
+				return false;
+
+			char const *sym_name = symbol_name(sym);
+
+			return name[0] == sym_name[0] && !strcmp(name, sym_name);
+		}
+
+		Elf::Sym const *_lookup_elf_hash(char const *name, unsigned long hash) const
+		{
+			Hash_table *h = _hash_table;
+
+			if (!h->buckets())
+				return nullptr;
+
+			unsigned long sym_index = h->buckets()[hash % h->nbuckets()];
+
+			/* traverse hash chain */
+			for (; sym_index != STN_UNDEF; sym_index = h->chains()[sym_index])
+			{
+				Elf::Sym const *sym = symbol(sym_index);
+
+				/* bad object */
+				if (!sym)
+					return nullptr;
+
+				if (_matches(*sym, name))
+					return sym;
+			}
+
+			return nullptr;
+		}
+
+		Elf::Sym const *_lookup_gnu_hash(char const *name, uint32_t hash) const
+		{
+			Gnu_hash_table const &h = *_gnu_hash_table;
+
+			if (!h.nbuckets || !h.may_contain(hash))
+				return nullptr;
+
+			unsigned long sym_index = h.buckets()[hash % h.nbuckets];
+
+			/* empty bucket */
+			if (sym_index < h.symoffset)
+				return nullptr;
+
+			/* traverse the chain of the bucket */
+			for (;; sym_index++) {
+
+				Elf::Hashelt const chain_hash = h.chains()[sym_index - h.symoffset];
+
+				/* compare hash values except for the end-of-chain bit */
+				if (((chain_hash ^ hash) >> 1) == 0) {
+
+					Elf::Sym const *sym = symbol(sym_index);
+
+					/* bad object */
+					if (!sym)
+						return nullptr;
+
+					if (_matches(*sym, name))
+						return sym;
+				}
+
+				if (chain_hash & 1)
+					return nullptr;
+			}
 		}
 
 	public:
@@ -199,6 +402,9 @@ class Linker::Dynamic
 			if (!_md_alloc)
 				return;
 
+			if (_resolved)
+				_md_alloc->free(_resolved, _num_symbols*sizeof(Resolved));
+
 			_needed.dequeue_all([&] (Needed &n) {
 				destroy(*_md_alloc, &n); });
 		}
@@ -214,9 +420,9 @@ class Linker::Dynamic
 			_init_function();
 		}
 
-		Elf::Sym const *symbol(unsigned sym_index) const
+		Elf::Sym const *symbol(unsigned long sym_index) const
 		{
-			if (sym_index > _hash_table->nchains())
+			if (sym_index >= _num_symbols)
 				return nullptr;
 
 			return _symtab + sym_index;
@@ -234,48 +440,52 @@ class Linker::Dynamic
 		Dependency const &dep() const { return *_dep; }
 
 		/*
-		 * Use DT_HASH table address for linker, assuming that it will always be at
+		 * Use hash table address for linker, assuming that it will always be at
 		 * the beginning of the file
 		 */
-		Elf::Addr link_map_addr() const { return trunc_page((Elf::Addr)_hash_table); }
+		Elf::Addr link_map_addr() const
+		{
+			return trunc_page(_hash_table ? (Elf::Addr)_hash_table
+			                              : (Elf::Addr)_gnu_hash_table);
+		}
 
 		/**
 		 * Lookup symbol name in this ELF
+		 *
+		 * The GNU hash table is preferred over the ELF hash table if present.
 		 */
-		Elf::Sym const *lookup_symbol(char const *name, unsigned long hash) const
+		Elf::Sym const *lookup_symbol(char const *name, Symbol_hash const &hash) const
 		{
-			Hash_table *h = _hash_table;
+			if (_gnu_hash_table)
+				return _lookup_gnu_hash(name, hash.gnu());
 
-			if (!h->buckets())
-				return nullptr;
-
-			unsigned long sym_index = h->buckets()[hash % h->nbuckets()];
-
-			/* traverse hash chain */
-			for (; sym_index != STN_UNDEF; sym_index = h->chains()[sym_index])
-			{
-				/* bad object */
-				if (sym_index > h->nchains())
-					return nullptr;
+			if (_hash_table)
+				return _lookup_elf_hash(name, hash.elf());
 
-				Elf::Sym const *sym      = symbol(sym_index);
-				char const     *sym_name = symbol_name(*sym);
-
-				/* this omitts everything but 'NOTYPE', 'OBJECT', and 'FUNC' */
-				if (sym->type() > STT_FUNC)
-					continue;
-
-				if (sym->st_value == 0)
-					continue;
+			return nullptr;
+		}
 
-				/* check for symbol name */
-				if (name[0] != sym_name[0] || strcmp(name, sym_name))
-					continue;
+		/**
+		 * Return symbol resolved for symbol-table index of this object
+		 *
+		 * During relocation, the same symbol is typically referenced by
+		 * several relocations. Hence, the resolved symbols are cached by
+		 * their index. If not cached, the symbol is resolved by calling
+		 * 'fn(Elf::Addr *base)'.
+		 */
+		template <typename FN>
+		Elf::Sym const *resolved_symbol(unsigned long sym_index, Elf::Addr *base,
+		                                FN const &fn) const
+		{
+			if (!_resolved || sym_index >= _num_symbols)
+				return fn(base);
 
-				return sym;
-			}
+			Resolved &r = _resolved[sym_index];
+			if (!r.sym)
+				r.sym = fn(&r.base);
 
-			return nullptr;
+			*base = r.base;
+			return r.sym;
 		}
 
 		/**
@@ -285,7 +495,7 @@ class Linker::Dynamic
 		{
 			addr_t const reloc_base = _obj.reloc_base();
 
-			for (unsigned long i = 0; i < _hash_table->nchains(); i++)
+			for (unsigned long i = 0; i < _num_symbols; i++)
 			{
 				Elf::Sym const *sym = symbol(i);
 				if (!sym)
@@ -316,6 +526,19 @@ class Linker::Dynamic
 
 		void relocate(Bind bind) SELF_RELOC
 		{
+			/*
+			 * Cache the resolved symbols during relocation, which is not
+			 * available for the linker as it has no meta-data allocator
+			 */
+			size_t const resolved_size = _num_symbols*sizeof(Resolved);
+			if (_md_alloc && resolved_size) {
+				try { _md_alloc->alloc(resolved_size, (void **)&_resolved); }
+				catch (...) { }
+
+				if (_resolved)
+					memset(_resolved, 0, resolved_size);
+			}
+
 			plt_setup();
 
 			if (_pltrel_size) {
@@ -331,6 +554,11 @@ class Linker::Dynamic
 			}
 
 			relocate_non_plt(bind, FIRST_PASS);
+
+			if (_resolved) {
+				_md_alloc->free(_resolved, resolved_size);
+				_resolved = nullptr;
+			}
 		}
 
 		void plt_setup()
@@ -173,7 +173,7 @@ class Linker::Elf_object : public Object, private Fifo<Elf_object>::Element
 			return _dyn.symbol_name(sym);
 		}
 
-		Elf::Sym const *lookup_symbol(char const *name, unsigned long hash) const
+		Elf::Sym const *lookup_symbol(char const *name, Symbol_hash const &hash) const
 		{
 			return _dyn.lookup_symbol(name, hash);
 		}
@@ -479,8 +479,7 @@ struct Linker::Binary : private Root_object, public Elf_object
 
 Elf::Addr Linker::Object::_symbol_address(char const *name)
 {
-	unsigned long   hash = Hash_table::hash(name);
-	Elf::Sym const *sym  = dynamic().lookup_symbol(name, hash);
+	Elf::Sym const *sym = dynamic().lookup_symbol(name, Symbol_hash(name));
 
 	if (sym)
 		return reloc_base() + sym->st_value;
@@ -545,7 +544,14 @@ Elf::Sym const *Linker::lookup_symbol(unsigned sym_index, Dependency const &dep,
 		return symbol;
 	}
 
-	return lookup_symbol(elf.symbol_name(*symbol), dep, base, undef, other);
+	char const *name = elf.symbol_name(*symbol);
+
+	/* lookups of undefined symbols and copy relocations are rare */
+	if (undef || other)
+		return lookup_symbol(name, dep, base, undef, other);
+
+	return elf.dynamic().resolved_symbol(sym_index, base, [&] (Elf::Addr *resolved_base) {
+		return lookup_symbol(name, dep, resolved_base, undef, other); });
 }
 
 
@@ -553,7 +559,7 @@ Elf::Sym const *Linker::lookup_symbol(char const *name, Dependency const &dep,
                                       Elf::Addr *base, bool undef, bool other)
 {
 	Dependency const *curr        = &dep.first();
-	unsigned long     hash        = Hash_table::hash(name);
+	Symbol_hash const hash(name);
 	Elf::Sym   const *weak_symbol = 0;
 	Elf::Addr        weak_base    = 0;
 	Elf::Sym   const *symbol      = 0;
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2016-2017 Genode Labs GmbH
+ * Copyright (C) 2016-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -68,19 +68,32 @@ Timeout::Alarm::~Alarm()
 }
 
 
-bool Timeout::Alarm::Raw::is_pending_at(uint64_t time, bool time_period) const
-{
-	return (time_period == deadline_period &&
-	        time        >= deadline) ||
-	       (time_period != deadline_period &&
-	        time        <  deadline);
-}
-
-
 /*****************************
  ** Alarm_timeout_scheduler **
  *****************************/
 
+/**
+ * Return index of the most significant set bit of a non-zero value
+ */
+static inline unsigned msb(uint64_t value) { return 63 - __builtin_clzll(value); }
+
+
+/**
+ * Return index of the least significant set bit of a non-zero value
+ */
+static inline unsigned lsb(uint64_t value) { return __builtin_ctzll(value); }
+
+
+/**
+ * Add 'duration' to 'time' and saturate at the maximum time value
+ */
+static uint64_t saturated_add(uint64_t time, uint64_t duration)
+{
+	uint64_t const result = time + duration;
+	return result < time ? ~(uint64_t)0 : result;
+}
+
+
 void Alarm_timeout_scheduler::handle_timeout(Duration duration)
 {
 	uint64_t const curr_time_us = duration.trunc_to_plain_us().value;
@@ -91,7 +104,7 @@ void Alarm_timeout_scheduler::handle_timeout(Duration duration)
 	uint64_t sleep_time_us;
 	Alarm::Time deadline_us;
 	if (_alarm_next_deadline(&deadline_us)) {
-		sleep_time_us = deadline_us - curr_time_us;
+		sleep_time_us = deadline_us > curr_time_us ? deadline_us - curr_time_us : 0;
 	} else {
 		sleep_time_us = _time_source.max_timeout().value; }
 
@@ -101,6 +114,10 @@ void Alarm_timeout_scheduler::handle_timeout(Duration duration)
 	} else if (sleep_time_us == 0) {
 		sleep_time_us = 1; }
 
+	{
+		Lock::Guard lock_guard(_lock);
+		_next_timeout = curr_time_us + sleep_time_us;
+	}
 	_time_source.schedule_timeout(Microseconds(sleep_time_us), *this);
 }
 
@@ -108,24 +125,27 @@ void Alarm_timeout_scheduler::handle_timeout(Duration duration)
 Alarm_timeout_scheduler::Alarm_timeout_scheduler(Time_source  &time_source,
                                                  Microseconds  min_handle_period)
 :
-	_time_source(time_source)
-{
-	Alarm::Time const deadline         = _now + min_handle_period.value;
-	_min_handle_period.period          = min_handle_period.value;
-	_min_handle_period.deadline        = deadline;
-	_min_handle_period.deadline_period = _now > deadline ?
-	                                     !_now_period : _now_period;
-}
+	_time_source(time_source),
+	_min_handle_period(min_handle_period.value),
+	_min_handle_deadline(saturated_add(_now, min_handle_period.value))
+{ }
 
 
 Alarm_timeout_scheduler::~Alarm_timeout_scheduler()
 {
 	Lock::Guard lock_guard(_lock);
-	while (_active_head) {
-		Alarm *next = _active_head->_next;
-		_active_head->_alarm_reset();
-		_active_head = next;
-	}
+
+	auto reset = [] (Alarm *&head) {
+		while (Alarm *alarm = head) {
+			head = alarm->_next;
+			alarm->_alarm_reset();
+		}
+	};
+	for (unsigned level = 0; level < WHEEL_LEVELS; level++)
+		for (unsigned slot = 0; slot < WHEEL_SLOTS; slot++)
+			reset(_wheel[level][slot]);
+
+	reset(_expired_head);
 }
 
 
@@ -139,20 +159,15 @@ void Alarm_timeout_scheduler::_schedule_one_shot(Timeout      &timeout,
                                                  Microseconds  duration)
 {
 	/* raise timeout duration by the age of the local time value */
-	uint64_t us = _time_source.curr_time().trunc_to_plain_us().value;
-	if (us >= _now) {
-		us = duration.value + (us - _now); }
-	else {
-		us = duration.value + (~0UL - _now) + us; }
-	if (us >= duration.value) {
-		duration.value = us; }
+	uint64_t const us = _time_source.curr_time().trunc_to_plain_us().value;
+	if (us > _now) {
+		duration.value = saturated_add(duration.value, us - _now); }
 
 	/* insert timeout into scheduling queue */
 	_alarm_schedule_absolute(&timeout._alarm, duration.value);
 
 	/* if new timeout is the closest to now, update the time-source timeout */
-	if (_alarm_head_timeout(&timeout._alarm)) {
-		_time_source.schedule_timeout(Microseconds(0), *this); }
+	_reprogram_if_needed(timeout._alarm);
 }
 
 
@@ -161,73 +176,150 @@ void Alarm_timeout_scheduler::_schedule_periodic(Timeout      &timeout,
 {
 	_alarm_schedule(&timeout._alarm, duration.value);
 
-	if (_alarm_head_timeout(&timeout._alarm)) {
-		_time_source.schedule_timeout(Microseconds(0), *this); }
+	_reprogram_if_needed(timeout._alarm);
 }
 
 
-void Alarm_timeout_scheduler::_alarm_unsynchronized_enqueue(Alarm *alarm)
+void Alarm_timeout_scheduler::_reprogram_if_needed(Alarm const &alarm)
 {
-	if (alarm->_active) {
-		error("trying to insert the same alarm twice!");
-		return;
+	{
+		Lock::Guard lock_guard(_lock);
+
+		if (!alarm._alarm_active() || !_alarm_before_next_timeout(alarm))
+			return;
+
+		/* suppress further re-programming until the timeout got handled */
+		_next_timeout = _now;
 	}
+	_time_source.schedule_timeout(Microseconds(0), *this);
+}
 
-	alarm->_active++;
 
-	/* if active alarm list is empty add first element */
-	if (!_active_head) {
-		alarm->_next = 0;
-		_active_head = alarm;
+void Alarm_timeout_scheduler::_wheel_insert(Alarm &alarm)
+{
+	Alarm::Time const deadline = alarm._deadline;
+
+	if (deadline <= _now) {
+
+		/* keep the expired alarms ordered by their deadlines */
+		Alarm **list = &_expired_head;
+		Alarm  *prev = nullptr;
+		while (*list && (*list)->_deadline <= deadline) {
+			prev = *list;
+			list = &prev->_next;
+		}
+		alarm._next  = *list;
+		alarm._prev  = prev;
+		alarm._list  = &_expired_head;
+		if (alarm._next)
+			alarm._next->_prev = &alarm;
+		*list = &alarm;
 		return;
 	}
 
-	/* if deadline is smaller than any other deadline, put it on the head */
-	if (alarm->_raw.is_pending_at(_active_head->_raw.deadline, _active_head->_raw.deadline_period)) {
-		alarm->_next = _active_head;
-		_active_head = alarm;
+	/* select level by the most significant bit that differs from now */
+	unsigned const level = msb(deadline ^ _now) / WHEEL_SLOTS_LOG2;
+	unsigned const slot  = _wheel_digit(deadline, level);
+
+	Alarm *&head = _wheel[level][slot];
+
+	alarm._next = head;
+	alarm._prev = nullptr;
+	alarm._list = &head;
+	if (head)
+		head->_prev = &alarm;
+	head = &alarm;
+
+	_wheel_used[level] |= (uint64_t)1 << slot;
+}
+
+
+void Alarm_timeout_scheduler::_wheel_expire_slot(unsigned level, unsigned slot)
+{
+	Alarm *&head = _wheel[level][slot];
+
+	while (Alarm *alarm = head) {
+		head = alarm->_next;
+		if (head)
+			head->_prev = nullptr;
+
+		/* '_now' is already past the deadline */
+		_wheel_insert(*alarm);
+	}
+	_wheel_used[level] &= ~((uint64_t)1 << slot);
+}
+
+
+void Alarm_timeout_scheduler::_wheel_advance(Alarm::Time now)
+{
+	if (now <= _now)
 		return;
+
+	/* highest level whose digit changes with the new time */
+	unsigned const high = msb(now ^ _now) / WHEEL_SLOTS_LOG2;
+
+	unsigned const from = _wheel_digit(_now, high);
+	unsigned const to   = _wheel_digit(now,  high);
+
+	/*
+	 * All alarms at the levels below 'high' as well as the alarms in the
+	 * slots of level 'high' that were passed over are expired. The alarms
+	 * of the slot reached at level 'high' must be redistributed relative to
+	 * the new time.
+	 */
+	Alarm *reached = _wheel[high][to];
+	_wheel[high][to] = nullptr;
+	_wheel_used[high] &= ~((uint64_t)1 << to);
+
+	_now = now;
+
+	for (unsigned level = 0; level < high; level++) {
+		while (uint64_t const used = _wheel_used[level])
+			_wheel_expire_slot(level, lsb(used));
 	}
 
-	/* find list element with a higher deadline */
-	Alarm *curr = _active_head;
-	while (curr->_next &&
-	       curr->_next->_raw.is_pending_at(alarm->_raw.deadline, alarm->_raw.deadline_period))
-	{
-		curr = curr->_next;
+	/* slots between 'from' and 'to', both exclusive */
+	uint64_t const passed = (((uint64_t)1 << to) - 1) & ~(((uint64_t)2 << from) - 1);
+	while (uint64_t const used = _wheel_used[high] & passed)
+		_wheel_expire_slot(high, lsb(used));
+
+	while (Alarm *alarm = reached) {
+		reached = alarm->_next;
+		_wheel_insert(*alarm);
 	}
+}
+
 
-	/* if end of list is reached, append new element */
-	if (curr->_next == 0) {
-		curr->_next = alarm;
+void Alarm_timeout_scheduler::_alarm_unsynchronized_enqueue(Alarm *alarm)
+{
+	if (alarm->_alarm_active()) {
+		error("trying to insert the same alarm twice!");
 		return;
 	}
 
-	/* insert element in middle of list */
-	alarm->_next = curr->_next;
-	curr->_next  = alarm;
+	_wheel_insert(*alarm);
 }
 
 
 void Alarm_timeout_scheduler::_alarm_unsynchronized_dequeue(Alarm *alarm)
 {
-	if (!_active_head) return;
+	/* alarm is not enqueued */
+	if (!alarm->_alarm_active()) return;
 
-	if (_active_head == alarm) {
-		_active_head = alarm->_next;
-		alarm->_alarm_reset();
-		return;
-	}
+	if (alarm->_prev)
+		alarm->_prev->_next = alarm->_next;
+	else
+		*alarm->_list = alarm->_next;
 
-	/* find predecessor in alarm queue */
-	Alarm *curr;
-	for (curr = _active_head; curr && (curr->_next != alarm); curr = curr->_next);
+	if (alarm->_next)
+		alarm->_next->_prev = alarm->_prev;
 
-	/* alarm is not enqueued */
-	if (!curr) return;
+	/* update bitmap of non-empty slots if the alarm was stored in the wheel */
+	if (!*alarm->_list && alarm->_list != &_expired_head) {
+		unsigned long const index = alarm->_list - &_wheel[0][0];
+		_wheel_used[index / WHEEL_SLOTS] &= ~((uint64_t)1 << (index % WHEEL_SLOTS));
+	}
 
-	/* remove alarm from alarm queue */
-	curr->_next = alarm->_next;
 	alarm->_alarm_reset();
 }
 
@@ -236,12 +328,14 @@ Timeout::Alarm *Alarm_timeout_scheduler::_alarm_get_pending_alarm()
 {
 	Lock::Guard lock_guard(_lock);
 
-	if (!_active_head || !_active_head->_raw.is_pending_at(_now, _now_period)) {
+	if (!_expired_head) {
 		return nullptr; }
 
 	/* remove alarm from head of the list */
-	Alarm *pending_alarm = _active_head;
-	_active_head = _active_head->_next;
+	Alarm *pending_alarm = _expired_head;
+	_expired_head = pending_alarm->_next;
+	if (_expired_head)
+		_expired_head->_prev = nullptr;
 
 	/*
 	 * Acquire dispatch lock to defer destruction until the call of '_on_alarm'
@@ -251,7 +345,8 @@ Timeout::Alarm *Alarm_timeout_scheduler::_alarm_get_pending_alarm()
 
 	/* reset alarm object */
 	pending_alarm->_next = nullptr;
-	pending_alarm->_active--;
+	pending_alarm->_prev = nullptr;
+	pending_alarm->_list = nullptr;
 
 	return pending_alarm;
 }
@@ -260,33 +355,31 @@ Timeout::Alarm *Alarm_timeout_scheduler::_alarm_get_pending_alarm()
 void Alarm_timeout_scheduler::_alarm_handle(Alarm::Time curr_time)
 {
 	/*
-	 * Raise the time counter and if it wraps, update also in which
-	 * period of the time counter we are.
+	 * The time of the scheduler never goes backwards. Deadlines that
+	 * would lie beyond the maximum time value are saturated.
 	 */
-	if (_now > curr_time) {
-		_now_period = !_now_period;
-	}
-	_now = curr_time;
+	{
+		Lock::Guard lock_guard(_lock);
 
-	if (!_min_handle_period.is_pending_at(_now, _now_period)) {
-		return;
+		if (curr_time < _min_handle_deadline)
+			return;
+
+		_min_handle_deadline = saturated_add(curr_time, _min_handle_period);
+
+		_wheel_advance(curr_time);
 	}
-	Alarm::Time const deadline         = _now + _min_handle_period.period;
-	_min_handle_period.deadline        = deadline;
-	_min_handle_period.deadline_period = _now > deadline ?
-	                                     !_now_period : _now_period;
 
 	/*
 	 * Dequeue all pending alarms before starting to re-schedule. Otherwise,
-	 * a long-lasting alarm that has a deadline in the next now_period might
-	 * get scheduled as head of this now_period falsely because the code
-	 * thinks that it belongs to the last now_period.
+	 * a periodic alarm with a short period might get dispatched repeatedly
+	 * within one call of this function.
 	 */
+	Alarm **pending_tail = &_pending_head;
 	while (Alarm *curr = _alarm_get_pending_alarm()) {
 
-		/* enqueue alarm into list of pending alarms */
-		curr->_next = _pending_head;
-		_pending_head = curr;
+		/* append alarm to the list of pending alarms to keep their order */
+		*pending_tail = curr;
+		pending_tail  = &curr->_next;
 	}
 	while (Alarm *curr = _pending_head) {
 
@@ -296,14 +389,15 @@ void Alarm_timeout_scheduler::_alarm_handle(Alarm::Time curr_time)
 
 		uint64_t triggered = 1;
 
-		if (curr->_raw.period) {
-			Alarm::Time deadline = curr->_raw.deadline;
+		if (curr->_period) {
+			Alarm::Time deadline = curr->_deadline;
 
 			/* schedule next event */
 			if (deadline == 0)
 				 deadline = curr_time;
 
-			triggered += (curr_time - deadline) / curr->_raw.period;
+			if (curr_time > deadline)
+				triggered += (curr_time - deadline) / curr->_period;
 		}
 
 		/* do not reschedule if alarm function returns 0 */
@@ -316,21 +410,16 @@ void Alarm_timeout_scheduler::_alarm_handle(Alarm::Time curr_time)
 			 * the current time but If the alarm had no deadline by now,
 			 * initialize it with the current time.
 			 */
-			if (curr->_raw.deadline == 0) {
-				curr->_raw.deadline        = _now;
-				curr->_raw.deadline_period = _now_period;
-			}
+			if (curr->_deadline == 0)
+				curr->_deadline = _now;
+
 			/*
-			 * Raise the deadline value by one period of the alarm and
-			 * if the deadline value wraps thereby, update also in which
-			 * period it is located.
+			 * Raise the deadline value by the number of periods that
+			 * passed, which places it in the future
 			 */
-			Alarm::Time const deadline = curr->_raw.deadline +
-			                             triggered * curr->_raw.period;
-			if (curr->_raw.deadline > deadline) {
-				curr->_raw.deadline_period = !curr->_raw.deadline_period;
-			}
-			curr->_raw.deadline = deadline;
+			uint64_t const periods = curr->_period > ~(uint64_t)0 / triggered
+			                       ? ~(uint64_t)0 : triggered * curr->_period;
+			curr->_deadline = saturated_add(curr->_deadline, periods);
 
 			/* synchronize enqueue operation */
 			Lock::Guard lock_guard(_lock);
@@ -350,11 +439,10 @@ void Alarm_timeout_scheduler::_alarm_setup_alarm(Alarm &alarm, Alarm::Time perio
 	 * position because its deadline might have changed. I.e., if an alarm is
 	 * rescheduled with a new timeout before the original timeout triggered.
 	 */
-	if (alarm._active)
+	if (alarm._alarm_active())
 		_alarm_unsynchronized_dequeue(&alarm);
 
-	Alarm::Time deadline = _now + first_duration;
-	alarm._alarm_assign(period, deadline, _now > deadline ? !_now_period : _now_period, this);
+	alarm._alarm_assign(period, saturated_add(_now, first_duration), this);
 
 	_alarm_unsynchronized_enqueue(&alarm);
 }
@@ -412,13 +500,39 @@ bool Alarm_timeout_scheduler::_alarm_next_deadline(Alarm::Time *deadline)
 {
 	Lock::Guard alarm_list_lock_guard(_lock);
 
-	if (!_active_head) return false;
+	Alarm::Time result = 0;
 
-	if (deadline)
-		*deadline = _active_head->_raw.deadline;
+	if (_expired_head) {
+		result = _now;
+	} else {
+
+		/*
+		 * The lowest non-empty slot of the lowest non-empty level holds the
+		 * earliest deadline. For levels above zero, we return the begin of
+		 * the time range covered by the slot, at which the slot gets
+		 * redistributed to the lower levels.
+		 */
+		unsigned level = 0;
+		for (; level < WHEEL_LEVELS && !_wheel_used[level]; level++);
+
+		if (level == WHEEL_LEVELS)
+			return false;
+
+		uint64_t const used  = _wheel_used[level];
+		unsigned const slot  = lsb(used);
+		unsigned const shift = level * WHEEL_SLOTS_LOG2;
+		unsigned const upper = shift + WHEEL_SLOTS_LOG2;
 
-	if (*deadline < _min_handle_period.deadline) {
-		*deadline = _min_handle_period.deadline;
+		Alarm::Time const upper_mask = upper < 64 ? ~(Alarm::Time)0 << upper : 0;
+
+		result = (_now & upper_mask) | ((Alarm::Time)slot << shift);
 	}
+
+	if (result < _min_handle_deadline)
+		result = _min_handle_deadline;
+
+	if (deadline)
+		*deadline = result;
+
 	return true;
 }
@@ -0,0 +1,170 @@
+/*
+ * \brief  Benchmark of the AVL allocator with and without free lists
+ * \author Norman Feske
+ * \date   2019-03-11
+ *
+ * The benchmark applies the same random sequence of allocations and frees
+ * to an 'Allocator_avl' and an 'Allocator_avl_tlsf'. It reports the average
+ * latency of the operations and the fragmentation in terms of the extent of
+ * the managed range that was touched at most, compared to the amount of
+ * memory allocated at the end of the run.
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/heap.h>
+#include <base/log.h>
+#include <base/allocator_avl.h>
+#include <timer_session/connection.h>
+
+namespace Test {
+
+	using namespace Genode;
+
+	struct Workload;
+	struct Main;
+
+	enum {
+		RANGE_BASE = 0x10000000,
+		RANGE_SIZE = 1024*1024*1024,
+		NUM_SLOTS  = 8*1024,
+		NUM_OPS    = 400*1000,
+	};
+}
+
+
+struct Test::Workload
+{
+	char const *name;
+	size_t      min_size;
+	size_t      max_size;
+	unsigned    align_log2;
+};
+
+
+struct Test::Main
+{
+	Env &_env;
+
+	Heap _heap { _env.ram(), _env.rm() };
+
+	Timer::Connection _timer { _env };
+
+	struct Slot { addr_t addr; size_t size; };
+
+	Slot _slots[NUM_SLOTS];
+
+	uint32_t _seed = 0;
+
+	uint32_t _random()
+	{
+		/* xorshift32 */
+		_seed ^= _seed << 13;
+		_seed ^= _seed >> 17;
+		_seed ^= _seed << 5;
+		return _seed;
+	}
+
+	/**
+	 * Return random size with a logarithmic distribution
+	 */
+	size_t _random_size(Workload const &w)
+	{
+		unsigned const min_log2 = log2(w.min_size);
+		unsigned const max_log2 = log2(w.max_size);
+		unsigned const log2     = min_log2 + _random() % (max_log2 - min_log2 + 1);
+
+		return max(w.min_size, min(w.max_size, (size_t)(1UL << log2) +
+		                                       _random() % (1UL << log2)));
+	}
+
+	uint64_t _now_us() { return _timer.curr_time().trunc_to_plain_us().value; }
+
+	template <typename ALLOC>
+	void _run(char const *alloc_name, Workload const &w)
+	{
+		ALLOC &alloc = *new (_heap) ALLOC(&_heap);
+		alloc.add_range(RANGE_BASE, RANGE_SIZE);
+
+		for (Slot &slot : _slots)
+			slot = Slot { 0, 0 };
+
+		_seed = 0x1234567;
+
+		addr_t   max_end  = RANGE_BASE;
+		unsigned failed   = 0;
+		uint64_t start_us = _now_us();
+
+		for (unsigned i = 0; i < NUM_OPS; i++) {
+
+			Slot &slot = _slots[_random() % NUM_SLOTS];
+
+			if (slot.size) {
+				alloc.free((void *)slot.addr);
+				slot = Slot { 0, 0 };
+				continue;
+			}
+
+			size_t const size = _random_size(w);
+			void *out = nullptr;
+			if (alloc.alloc_aligned(size, &out, w.align_log2).error()) {
+				failed++;
+				continue;
+			}
+			slot = Slot { (addr_t)out, size };
+			max_end = max(max_end, (addr_t)out + size);
+		}
+
+		uint64_t const duration_us = max(_now_us() - start_us, (uint64_t)1);
+
+		/* release remaining allocations */
+		size_t live_bytes = 0;
+		for (Slot &slot : _slots) {
+			if (!slot.size)
+				continue;
+
+			live_bytes += slot.size;
+			alloc.free((void *)slot.addr);
+		}
+
+		if (alloc.avail() != RANGE_SIZE)
+			error(alloc_name, ": leaked ", RANGE_SIZE - alloc.avail(), " bytes");
+
+		log(w.name, " ", alloc_name, ": "
+		    "ns/op=", (duration_us*1000)/NUM_OPS, " "
+		    "extent=", (max_end - RANGE_BASE)/1024, " KiB "
+		    "live at end=", live_bytes/1024, " KiB "
+		    "failed=", failed);
+
+		destroy(_heap, &alloc);
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		log("--- allocator-avl benchmark started ---");
+
+		static Workload const workloads[] = {
+			{ "small",   16,    512, 3 },
+			{ "heap",    16,   4096, 4 },
+			{ "mixed",   16, 65536, 3 },
+			{ "pages", 4096, 1024*1024, 12 },
+		};
+
+		for (Workload const &w : workloads) {
+			_run<Allocator_avl>     ("avl     ", w);
+			_run<Allocator_avl_tlsf>("avl_tlsf", w);
+		}
+
+		log("--- allocator-avl benchmark finished ---");
+	}
+};
+
+
+void Component::construct(Genode::Env &env) { static Test::Main main(env); }
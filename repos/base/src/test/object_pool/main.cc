@@ -0,0 +1,153 @@
+/*
+ * \brief  Benchmark of the object lookup of RPC entrypoints
+ * \author Norman Feske
+ * \date   2019-04-23
+ *
+ * The benchmark populates an RPC entrypoint with an increasing number of RPC
+ * objects. For each pool size, it reports the average duration of RPC round
+ * trips to randomly chosen objects and the average duration of the plain
+ * object lookup via 'Object_pool::apply'.
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/heap.h>
+#include <base/log.h>
+#include <base/rpc_server.h>
+#include <base/rpc_client.h>
+#include <timer_session/connection.h>
+
+namespace Test {
+
+	using namespace Genode;
+
+	struct Ping;
+	struct Ping_client;
+	struct Ping_object;
+	struct Main;
+
+	enum {
+		MAX_OBJECTS = 8*1024,
+		NUM_CALLS   = 50*1000,
+		NUM_LOOKUPS = 1000*1000,
+	};
+}
+
+
+struct Test::Ping : Interface
+{
+	virtual unsigned ping(unsigned) = 0;
+
+	GENODE_RPC(Rpc_ping, unsigned, ping, unsigned);
+	GENODE_RPC_INTERFACE(Rpc_ping);
+};
+
+
+struct Test::Ping_client : Rpc_client<Ping>
+{
+	Ping_client(Capability<Ping> cap) : Rpc_client<Ping>(cap) { }
+
+	unsigned ping(unsigned value) override { return call<Rpc_ping>(value); }
+};
+
+
+struct Test::Ping_object : Rpc_object<Ping, Ping_object>
+{
+	unsigned ping(unsigned value) override { return value + 1; }
+};
+
+
+struct Test::Main
+{
+	Env &_env;
+
+	Heap _heap { _env.ram(), _env.rm() };
+
+	Timer::Connection _timer { _env };
+
+	enum { STACK_SIZE = 2*1024*sizeof(long) };
+
+	Rpc_entrypoint _ep { &_env.pd(), STACK_SIZE, "pool_ep" };
+
+	Capability<Ping> _caps[MAX_OBJECTS];
+
+	unsigned _num_objects = 0;
+
+	uint32_t _seed = 0;
+
+	uint32_t _random()
+	{
+		/* xorshift32 */
+		_seed ^= _seed << 13;
+		_seed ^= _seed >> 17;
+		_seed ^= _seed << 5;
+		return _seed;
+	}
+
+	uint64_t _now_us() { return _timer.curr_time().trunc_to_plain_us().value; }
+
+	void _populate(unsigned num_objects)
+	{
+		for (; _num_objects < num_objects; _num_objects++)
+			_caps[_num_objects] = _ep.manage(new (_heap) Ping_object());
+	}
+
+	void _run(unsigned num_objects)
+	{
+		_populate(num_objects);
+
+		_seed = 0x1234567;
+
+		/* RPC round trips */
+		unsigned failed   = 0;
+		uint64_t start_us = _now_us();
+
+		for (unsigned i = 0; i < NUM_CALLS; i++) {
+			if (Ping_client(_caps[_random() % num_objects]).ping(i) != i + 1)
+				failed++;
+		}
+
+		uint64_t const rpc_us = max(_now_us() - start_us, (uint64_t)1);
+
+		/* lookup of the objects without IPC */
+		unsigned found = 0;
+		start_us = _now_us();
+
+		for (unsigned i = 0; i < NUM_LOOKUPS; i++) {
+			_ep.apply(_caps[_random() % num_objects], [&] (Ping_object *obj) {
+				if (obj) found++; });
+		}
+
+		uint64_t const lookup_us = max(_now_us() - start_us, (uint64_t)1);
+
+		if (failed || found != NUM_LOOKUPS)
+			error("objects=", num_objects, ": ", failed, " failed calls, ",
+			      NUM_LOOKUPS - found, " failed lookups");
+
+		log("objects=", num_objects, " "
+		    "ns/rpc=",    (rpc_us*1000)/NUM_CALLS, " "
+		    "ns/lookup=", (lookup_us*1000)/NUM_LOOKUPS);
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		log("--- object-pool benchmark started ---");
+
+		static unsigned const sizes[] = { 1, 16, 256, 1024, 4096, MAX_OBJECTS };
+
+		for (unsigned const num_objects : sizes)
+			_run(num_objects);
+
+		log("--- object-pool benchmark finished ---");
+	}
+};
+
+
+void Component::construct(Genode::Env &env) { static Test::Main main(env); }
@@ -6,7 +6,7 @@
  */
 
 /*
- * Copyright (C) 2015-2017 Genode Labs GmbH
+ * Copyright (C) 2015-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -14,8 +14,10 @@
 
 /* Genode includes */
 #include <util/xml_node.h>
+#include <util/xml_index.h>
 #include <base/attached_ram_dataspace.h>
 #include <base/component.h>
+#include <base/heap.h>
 #include <base/log.h>
 
 using namespace Genode;
@@ -287,6 +289,43 @@ struct Formatted_xml_node
 };
 
 
+/**
+ * Print information about indexed XML node and its sub nodes
+ *
+ * The output corresponds to the one of 'Formatted_xml_node'.
+ */
+struct Formatted_indexed_node
+{
+	Xml_index::Node const _node;
+	unsigned        const _indent;
+
+	Formatted_indexed_node(Xml_index::Node node, unsigned indent = 0)
+	: _node(node), _indent(indent) { }
+
+	void print(Output &output) const
+	{
+		using Genode::print;
+
+		print(output, Indentation(_indent),
+		      "XML node: name = \"", _node.type(), "\"");
+		if (_node.num_sub_nodes() == 0) {
+			_node.with_raw_content([&] (char const *start, size_t length) {
+				print(output, ", leaf content = \"", Cstring(start, length), "\""); });
+		} else {
+			print(output, ", number of subnodes = ", _node.num_sub_nodes());
+		}
+
+		print(output, "\n");
+
+		_node.for_each_attribute([&] (Xml_attribute const &a) {
+			print(output, Formatted_xml_attribute(a, _indent + 2), "\n"); });
+
+		_node.for_each_sub_node([&] (Xml_index::Node const &sub_node) {
+			print(output, Formatted_indexed_node(sub_node, _indent + 2)); });
+	}
+};
+
+
 /**
  * Print content of sub node with specified type
  */
@@ -413,6 +452,31 @@ void Component::construct(Genode::Env &env)
 	test_decoded_content<0   >(env, 5, xml_test_comments, 8, 119);
 	log("");
 
+	log("-- Test indexed access to XML nodes --");
+	{
+		Heap heap(env.ram(), env.rm());
+
+		Xml_index const attributes(heap, Xml_node(xml_test_attributes));
+		log(Formatted_indexed_node(attributes.root()));
+
+		Xml_index const comments(heap, Xml_node(xml_test_comments));
+		log(Formatted_indexed_node(comments.root()));
+
+		Xml_index::Node const tag =
+			attributes.root().sub_node("single-tag-with-attr");
+
+		log("indexed nodes: ", attributes.num_nodes(), ", "
+		    "name=", tag.attribute_value("name", String<32>()), ", "
+		    "quantum=", (size_t)tag.attribute_value("quantum", Number_of_bytes()), ", "
+		    "priolevels=", attributes.root().attribute_value("priolevels", 0U));
+
+		try {
+			attributes.root().sub_node("nonexistent");
+			error("lookup of nonexistent indexed node succeeded");
+		} catch (Xml_index::Nonexistent_sub_node) { }
+	}
+	log("");
+
 	log("-- Test iterating over invalid node --");
 	{
 		/* this must not raise a 'Nonexistent_sub_node' exception */
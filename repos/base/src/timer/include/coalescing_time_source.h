@@ -0,0 +1,157 @@
+/*
+ * \brief  Time source that coalesces nearby wakeups
+ * \author Martin Stein
+ * \date   2019-03-20
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _COALESCING_TIME_SOURCE_H_
+#define _COALESCING_TIME_SOURCE_H_
+
+/* Genode includes */
+#include <timer/timeout.h>
+
+namespace Timer {
+
+	using Genode::uint64_t;
+	using Microseconds = Genode::Microseconds;
+	using Duration     = Genode::Duration;
+
+	struct Wakeup_statistics;
+	class Coalescing_time_source;
+}
+
+
+/**
+ * Counters of the timer service, all values are accumulated since startup
+ */
+struct Timer::Wakeup_statistics
+{
+	unsigned long requests   = 0; /* timeouts requested by the scheduler */
+	unsigned long programmed = 0; /* timeouts programmed at the device */
+	unsigned long immediate  = 0; /* requests handled without a device timeout */
+	unsigned long wakeups    = 0; /* timeouts signalled by the device */
+	unsigned long signals    = 0; /* timeout signals delivered to sessions */
+};
+
+
+/**
+ * Wrapper of the device-specific time source that coalesces wakeups
+ *
+ * Each timeout is deferred to the end of the slack window that contains its
+ * deadline. Thus, deadlines of different sessions that fall into the same
+ * window result in one device timeout only, and re-programming the device
+ * for an already armed window is skipped. Timeouts are never signalled early
+ * but up to 'slack' microseconds late.
+ *
+ * The timeout scheduler requests a zero timeout whenever a new timeout
+ * precedes all others. Instead of raising an immediate device interrupt,
+ * such requests are handled synchronously, which lets the scheduler program
+ * the actual deadline right away.
+ *
+ * With a slack of zero, all requests are passed to the device unmodified.
+ */
+class Timer::Coalescing_time_source : public  Genode::Time_source,
+                                      private Genode::Time_source::Timeout_handler
+{
+	private:
+
+		using Timeout_handler = Genode::Time_source::Timeout_handler;
+
+		Genode::Time_source &_source;
+		uint64_t      const  _slack_us;
+		Wakeup_statistics   &_stats;
+		Timeout_handler     *_handler   = nullptr;
+		bool                 _armed     = false;
+		uint64_t             _wakeup_us = 0;
+
+		/**
+		 * Return end of the slack window that contains 'us'
+		 */
+		uint64_t _window_end(uint64_t us) const
+		{
+			if (us > ~(uint64_t)0 - _slack_us)
+				return us;
+
+			return ((us + _slack_us - 1) / _slack_us) * _slack_us;
+		}
+
+
+		/*********************
+		 ** Timeout_handler **
+		 *********************/
+
+		void handle_timeout(Duration curr_time) override
+		{
+			_armed = false;
+			_stats.wakeups++;
+
+			if (_handler)
+				_handler->handle_timeout(curr_time);
+		}
+
+	public:
+
+		Coalescing_time_source(Genode::Time_source &source, Microseconds slack,
+		                       Wakeup_statistics &stats)
+		: _source(source), _slack_us(slack.value), _stats(stats) { }
+
+		uint64_t slack_us() const { return _slack_us; }
+
+
+		/*************************
+		 ** Genode::Time_source **
+		 *************************/
+
+		Duration curr_time() override { return _source.curr_time(); }
+
+		Microseconds max_timeout() const override {
+			return _source.max_timeout(); }
+
+		void schedule_timeout(Microseconds     duration,
+		                      Timeout_handler &handler) override
+		{
+			_handler = &handler;
+			_stats.requests++;
+
+			if (!_slack_us) {
+				_stats.programmed++;
+				_source.schedule_timeout(duration, *this);
+				return;
+			}
+
+			Duration const curr_time = _source.curr_time();
+
+			if (!duration.value) {
+				_stats.immediate++;
+				handler.handle_timeout(curr_time);
+				return;
+			}
+
+			uint64_t const now_us      = curr_time.trunc_to_plain_us().value;
+			uint64_t const max_us      = _source.max_timeout().value;
+			uint64_t const deadline_us = now_us + duration.value;
+			uint64_t const wakeup_us   = duration.value + _slack_us < max_us
+			                           ? _window_end(deadline_us) : deadline_us;
+
+			/* the device is already armed for the window of the deadline */
+			if (_armed && _wakeup_us == wakeup_us && wakeup_us > now_us)
+				return;
+
+			_armed     = true;
+			_wakeup_us = wakeup_us;
+			_stats.programmed++;
+			_source.schedule_timeout(Microseconds(wakeup_us - now_us), *this);
+		}
+
+		void scheduler(Genode::Timeout_scheduler &scheduler) override {
+			_source.scheduler(scheduler); }
+};
+
+#endif /* _COALESCING_TIME_SOURCE_H_ */
@@ -6,7 +6,7 @@
  */
 
 /*
- * Copyright (C) 2006-2017 Genode Labs GmbH
+ * Copyright (C) 2006-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -17,22 +17,52 @@
 
 /* Genode includes */
 #include <root/component.h>
+#include <base/log.h>
 
 /* local includes */
 #include <time_source.h>
+#include <coalescing_time_source.h>
 #include <session_component.h>
 
 namespace Timer { class Root_component; }
 
 
-class Timer::Root_component : public Genode::Root_component<Session_component>
+class Timer::Root_component : public  Genode::Root_component<Session_component>,
+                              private Genode::Timeout::Handler
 {
 	private:
 
 		enum { MIN_TIMEOUT_US = 1000 };
 
+		Wakeup_statistics               _stats { };
+		Wakeup_statistics               _reported_stats { };
 		Time_source                     _time_source;
+		Coalescing_time_source          _coalescing_time_source;
 		Genode::Alarm_timeout_scheduler _timeout_scheduler;
+		Genode::Timeout                 _statistics_timeout { _timeout_scheduler };
+
+
+		/*********************
+		 ** Timeout_handler **
+		 *********************/
+
+		void handle_timeout(Duration) override
+		{
+			Wakeup_statistics const &curr = _stats, &last = _reported_stats;
+
+			unsigned long const wakeups = curr.wakeups - last.wakeups;
+			unsigned long const signals = curr.signals - last.signals;
+
+			Genode::log("wakeups=",    wakeups, " "
+			            "signals=",    signals, " "
+			            "programmed=", curr.programmed - last.programmed, " "
+			            "immediate=",  curr.immediate  - last.immediate,  " "
+			            "requests=",   curr.requests   - last.requests,   " "
+			            "signals/100 wakeups=",
+			            wakeups ? (signals*100)/wakeups : 0);
+
+			_reported_stats = _stats;
+		}
 
 
 		/********************
@@ -49,18 +79,34 @@ class Timer::Root_component : public Genode::Root_component<Session_component>
 				throw Insufficient_ram_quota(); }
 
 			return new (md_alloc())
-				Session_component(_timeout_scheduler);
+				Session_component(_timeout_scheduler, _stats);
 		}
 
 	public:
 
-		Root_component(Genode::Env &env, Genode::Allocator &md_alloc)
+		/**
+		 * Constructor
+		 *
+		 * \param slack              window in which deadlines are coalesced
+		 *                           into one wakeup, zero disables coalescing
+		 * \param statistics_period  interval of logging wakeup statistics,
+		 *                           zero disables the statistics output
+		 */
+		Root_component(Genode::Env &env, Genode::Allocator &md_alloc,
+		               Microseconds slack, Microseconds statistics_period)
 		:
 			Genode::Root_component<Session_component>(&env.ep().rpc_ep(), &md_alloc),
 			_time_source(env),
-			_timeout_scheduler(_time_source, Microseconds(MIN_TIMEOUT_US))
+			_coalescing_time_source(_time_source, slack, _stats),
+			_timeout_scheduler(_coalescing_time_source, Microseconds(MIN_TIMEOUT_US))
 		{
 			_timeout_scheduler._enable();
+
+			if (slack.value)
+				Genode::log("coalescing wakeups within ", slack.value, " us");
+
+			if (statistics_period.value)
+				_statistics_timeout.schedule_periodic(statistics_period, *this);
 		}
 };
 
@@ -7,7 +7,7 @@
  */
 
 /*
- * Copyright (C) 2006-2017 Genode Labs GmbH
+ * Copyright (C) 2006-2019 Genode Labs GmbH
  * Copyright (C) 2012 Intel Corporation
  *
  * This file is part of the Genode OS framework, which is distributed
@@ -23,6 +23,9 @@
 #include <base/rpc_server.h>
 #include <timer/timeout.h>
 
+/* local includes */
+#include <coalescing_time_source.h>
+
 namespace Timer {
 
 	using Genode::uint64_t;
@@ -43,17 +46,25 @@ class Timer::Session_component : public  Genode::Rpc_object<Session>,
 		Genode::Timeout                    _timeout;
 		Genode::Timeout_scheduler         &_timeout_scheduler;
 		Genode::Signal_context_capability  _sigh { };
+		Wakeup_statistics                 &_stats;
 
 		uint64_t const _init_time_us =
 			_timeout_scheduler.curr_time().trunc_to_plain_us().value;
 
-		void handle_timeout(Duration) override {
-			Genode::Signal_transmitter(_sigh).submit(); }
+		void handle_timeout(Duration) override
+		{
+			_stats.signals++;
+			Genode::Signal_transmitter(_sigh).submit();
+		}
 
 	public:
 
-		Session_component(Genode::Timeout_scheduler &timeout_scheduler)
-		: _timeout(timeout_scheduler), _timeout_scheduler(timeout_scheduler) { }
+		Session_component(Genode::Timeout_scheduler &timeout_scheduler,
+		                  Wakeup_statistics         &stats)
+		:
+			_timeout(timeout_scheduler), _timeout_scheduler(timeout_scheduler),
+			_stats(stats)
+		{ }
 
 
 		/********************
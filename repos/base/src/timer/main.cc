@@ -6,7 +6,7 @@
  */
 
 /*
- * Copyright (C) 2006-2017 Genode Labs GmbH
+ * Copyright (C) 2006-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -15,6 +15,7 @@
 /* Genode includes */
 #include <base/heap.h>
 #include <base/component.h>
+#include <base/attached_rom_dataspace.h>
 
 /* local includes */
 #include <root_component.h>
@@ -26,13 +27,37 @@ class Main
 {
 	private:
 
+		/**
+		 * Configuration of the optional wakeup coalescing
+		 *
+		 * The timer is commonly started without a config, in which case
+		 * the defaults apply.
+		 */
+		struct Config
+		{
+			uint64_t slack_us      = 0;
+			uint64_t statistics_ms = 0;
+
+			Config(Env &env)
+			{
+				try {
+					Attached_rom_dataspace config { env, "config" };
+					slack_us      = config.xml().attribute_value("slack_us",      slack_us);
+					statistics_ms = config.xml().attribute_value("statistics_ms", statistics_ms);
+				} catch (...) { }
+			}
+		};
+
+		Config const          _config;
 		Sliced_heap           _sliced_heap;
 		Timer::Root_component _root;
 
 	public:
 
-		Main(Env &env) : _sliced_heap(env.ram(), env.rm()),
-		                 _root(env, _sliced_heap)
+		Main(Env &env) : _config(env), _sliced_heap(env.ram(), env.rm()),
+		                 _root(env, _sliced_heap,
+		                       Microseconds(_config.slack_us),
+		                       Microseconds(_config.statistics_ms*1000))
 		{
 			env.parent().announce(env.ep().manage(_root));
 		}
@@ -0,0 +1,5 @@
+SRC_CC = vfs_cache.cc
+
+vpath %.cc $(REP_DIR)/src/lib/vfs/cache
+
+SHARED_LIB = yes
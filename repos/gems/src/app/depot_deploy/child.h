@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2018 Genode Labs GmbH
+ * Copyright (C) 2018-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -16,6 +16,7 @@
 
 /* Genode includes */
 #include <util/list_model.h>
+#include <util/xml_index.h>
 #include <base/service.h>
 #include <os/reporter.h>
 #include <os/buffered_xml.h>
@@ -169,15 +170,20 @@ class Depot_deploy::Child : public List_model<Child>::Element
 			}
 		}
 
-		void apply_blueprint(Xml_node pkg)
+		/**
+		 * Apply blueprint of the pkg with the specified 'path'
+		 *
+		 * \param pkg  indexed '<pkg>' node of the blueprint
+		 */
+		void apply_blueprint(Archive::Path const &path, Xml_index::Node const &pkg)
 		{
-			if (pkg.attribute_value("path", Archive::Path()) != _blueprint_pkg_path)
+			if (path != _blueprint_pkg_path)
 				return;
 
 			/* package was missing but is installed now */
 			_pkg_incomplete = false;
 
-			Xml_node const runtime = pkg.sub_node("runtime");
+			Xml_index::Node const runtime = pkg.sub_node("runtime");
 
 			_pkg_ram_quota = runtime.attribute_value("ram", Number_of_bytes());
 			_pkg_cap_quota = runtime.attribute_value("caps", 0UL);
@@ -186,7 +192,7 @@ class Depot_deploy::Child : public List_model<Child>::Element
 			_config_name = runtime.attribute_value("config", Config_name());
 
 			/* keep copy of the blueprint info */
-			_pkg_xml.construct(_alloc, pkg);
+			_pkg_xml.construct(_alloc, pkg.xml());
 		}
 
 		void apply_launcher(Launcher_name const &name, Xml_node launcher)
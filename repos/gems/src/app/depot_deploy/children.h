@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2018 Genode Labs GmbH
+ * Copyright (C) 2018-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -75,9 +75,16 @@ class Depot_deploy::Children
 
 		void apply_blueprint(Xml_node blueprint)
 		{
-			blueprint.for_each_sub_node("pkg", [&] (Xml_node pkg) {
+			/*
+			 * The blueprint is matched against each child. Index it once
+			 * instead of re-parsing it for each child.
+			 */
+			Xml_index const index(_alloc, blueprint);
+
+			index.root().for_each_sub_node("pkg", [&] (Xml_index::Node const &pkg) {
+				Archive::Path const path = pkg.attribute_value("path", Archive::Path());
 				_children.for_each([&] (Child &child) {
-					child.apply_blueprint(pkg); }); });
+					child.apply_blueprint(path, pkg); }); });
 
 			blueprint.for_each_sub_node("missing", [&] (Xml_node missing) {
 				_children.for_each([&] (Child &child) {
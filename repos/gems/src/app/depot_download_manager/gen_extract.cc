@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2017 Genode Labs GmbH
+ * Copyright (C) 2017-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -15,12 +15,19 @@
 
 void Depot_download_manager::gen_extract_start_content(Xml_generator       &xml,
                                                        Import        const &import,
+                                                       unsigned      const  job,
+                                                       Extract_version      version,
                                                        Path          const &user_path,
                                                        Archive::User const &user)
 {
-	gen_common_start_content(xml, "extract",
+	xml.attribute("version", version.value);
+
+	gen_common_start_content(xml, extract_child_name(job),
 	                         Cap_quota{200}, Ram_quota{12*1024*1024});
 
+	xml.node("binary", [&] () {
+		xml.attribute("name", "extract"); });
+
 	xml.node("config", [&] () {
 		xml.attribute("verbose", "yes");
 
@@ -51,7 +58,7 @@ void Depot_download_manager::gen_extract_start_content(Xml_generator       &xml,
 			});
 		});
 
-		import.for_each_verified_archive([&] (Archive::Path const &path) {
+		import.for_each_archive_of_extraction_job(job, [&] (Archive::Path const &path) {
 
 			typedef String<160> Path;
 
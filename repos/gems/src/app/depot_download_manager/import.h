@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2017 Genode Labs GmbH
+ * Copyright (C) 2017-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -69,16 +69,22 @@ class Depot_download_manager::Import
 			             VERIFICATION_IN_PROGRESS,
 			             VERIFIED,
 			             VERIFICATION_FAILED,
+			             EXTRACTION_IN_PROGRESS,
+			             EXTRACTION_FAILED,
 			             UNPACKED };
 
 			State state = DOWNLOAD_IN_PROGRESS;
 
+			/* extraction job the item is assigned to */
+			unsigned job = 0;
+
 			bool in_progress() const
 			{
 				return state == DOWNLOAD_IN_PROGRESS
 				    || state == DOWNLOAD_COMPLETE
 				    || state == VERIFICATION_IN_PROGRESS
-				    || state == VERIFIED;
+				    || state == VERIFIED
+				    || state == EXTRACTION_IN_PROGRESS;
 			}
 
 			Item(Registry<Item> &registry, Archive::Path const &path)
@@ -93,8 +99,10 @@ class Depot_download_manager::Import
 				case DOWNLOAD_COMPLETE:        return "fetched";
 				case DOWNLOAD_UNAVAILABLE:     return "unavailable";
 				case VERIFICATION_IN_PROGRESS: return "verify";
-				case VERIFIED:                 return "extract";
+				case VERIFIED:                 return "verified";
 				case VERIFICATION_FAILED:      return "corrupted";
+				case EXTRACTION_IN_PROGRESS:   return "extract";
+				case EXTRACTION_FAILED:        return "failed";
 				case UNPACKED:                 return "done";
 				};
 				return "";
@@ -125,8 +133,45 @@ class Depot_download_manager::Import
 			return result;
 		}
 
+		unsigned _count(Item::State state) const
+		{
+			unsigned result = 0;
+			_items.for_each([&] (Item const &item) {
+				if (item.state == state)
+					result++; });
+			return result;
+		}
+
+		template <typename FN>
+		void _for_each_item_of_job(unsigned job, FN const &fn)
+		{
+			_items.for_each([&] (Item &item) {
+				if (item.state == Item::EXTRACTION_IN_PROGRESS && item.job == job)
+					fn(item); });
+		}
+
 	public:
 
+		/**
+		 * Number of archives per processing stage
+		 */
+		struct Stats
+		{
+			unsigned downloading, fetched, verifying, verified,
+			         extracting, done, failed;
+
+			void generate(Xml_generator &xml) const
+			{
+				xml.attribute("download", downloading);
+				xml.attribute("fetched",  fetched);
+				xml.attribute("verify",   verifying);
+				xml.attribute("verified", verified);
+				xml.attribute("extract",  extracting);
+				xml.attribute("done",     done);
+				xml.attribute("failed",   failed);
+			}
+		};
+
 		/**
 		 * Constructor
 		 *
@@ -186,6 +231,25 @@ class Depot_download_manager::Import
 			return _item_state_exists(Item::VERIFIED);
 		}
 
+		bool extraction_in_progress() const
+		{
+			return _item_state_exists(Item::EXTRACTION_IN_PROGRESS);
+		}
+
+		bool extraction_job_busy(unsigned job) const
+		{
+			bool result = false;
+			_items.for_each([&] (Item const &item) {
+				if (item.state == Item::EXTRACTION_IN_PROGRESS && item.job == job)
+					result = true; });
+			return result;
+		}
+
+		unsigned num_verified_archives() const
+		{
+			return _count(Item::VERIFIED);
+		}
+
 		template <typename FN>
 		void for_each_download(FN const &fn) const
 		{
@@ -199,9 +263,11 @@ class Depot_download_manager::Import
 		}
 
 		template <typename FN>
-		void for_each_verified_archive(FN const &fn) const
+		void for_each_archive_of_extraction_job(unsigned job, FN const &fn) const
 		{
-			_for_each_item(Item::VERIFIED, fn);
+			_items.for_each([&] (Item const &item) {
+				if (item.state == Item::EXTRACTION_IN_PROGRESS && item.job == job)
+					fn(item.path); });
 		}
 
 		template <typename FN>
@@ -215,6 +281,7 @@ class Depot_download_manager::Import
 		{
 			_for_each_item(Item::DOWNLOAD_UNAVAILABLE, fn);
 			_for_each_item(Item::VERIFICATION_FAILED, fn);
+			_for_each_item(Item::EXTRACTION_FAILED, fn);
 		}
 
 		void all_downloads_completed()
@@ -224,11 +291,17 @@ class Depot_download_manager::Import
 					item.state =  Item::DOWNLOAD_COMPLETE; });
 		}
 
-		void verify_all_downloaded_archives()
+		/**
+		 * Pass up to 'max' downloaded archives to the verification
+		 */
+		void verify_downloaded_archives(unsigned max)
 		{
 			_items.for_each([&] (Item &item) {
-				if (item.state == Item::DOWNLOAD_COMPLETE)
-					item.state =  Item::VERIFICATION_IN_PROGRESS; });
+				if (max && item.state == Item::DOWNLOAD_COMPLETE) {
+					item.state = Item::VERIFICATION_IN_PROGRESS;
+					max--;
+				}
+			});
 		}
 
 		void apply_download_progress(Download_progress const &progress)
@@ -266,11 +339,43 @@ class Depot_download_manager::Import
 						item.state = Item::VERIFICATION_FAILED; });
 		}
 
-		void all_verified_archives_extracted()
+		/**
+		 * Assign up to 'max' verified archives to the extraction job 'job'
+		 */
+		void assign_extraction_job(unsigned job, unsigned max)
 		{
 			_items.for_each([&] (Item &item) {
-				if (item.state == Item::VERIFIED)
-					item.state = Item::UNPACKED; });
+				if (max && item.state == Item::VERIFIED) {
+					item.state = Item::EXTRACTION_IN_PROGRESS;
+					item.job   = job;
+					max--;
+				}
+			});
+		}
+
+		void extraction_job_completed(unsigned job)
+		{
+			_for_each_item_of_job(job, [&] (Item &item) {
+				item.state = Item::UNPACKED; });
+		}
+
+		void extraction_job_failed(unsigned job)
+		{
+			_for_each_item_of_job(job, [&] (Item &item) {
+				item.state = Item::EXTRACTION_FAILED; });
+		}
+
+		Stats stats() const
+		{
+			return { .downloading = _count(Item::DOWNLOAD_IN_PROGRESS),
+			         .fetched     = _count(Item::DOWNLOAD_COMPLETE),
+			         .verifying   = _count(Item::VERIFICATION_IN_PROGRESS),
+			         .verified    = _count(Item::VERIFIED),
+			         .extracting  = _count(Item::EXTRACTION_IN_PROGRESS),
+			         .done        = _count(Item::UNPACKED),
+			         .failed      = _count(Item::DOWNLOAD_UNAVAILABLE)
+			                      + _count(Item::VERIFICATION_FAILED)
+			                      + _count(Item::EXTRACTION_FAILED) };
 		}
 
 		void report(Xml_generator &xml, Download_progress const &progress) const
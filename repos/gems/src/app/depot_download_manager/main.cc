@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2017 Genode Labs GmbH
+ * Copyright (C) 2017-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -35,12 +35,16 @@ struct Depot_download_manager::Child_exit_state
 	int  code   = 0;
 
 	typedef String<64> Name;
+	typedef String<16> Version;
+
+	Version version { };
 
 	Child_exit_state(Xml_node init_state, Name const &name)
 	{
 		init_state.for_each_sub_node("child", [&] (Xml_node child) {
 			if (child.attribute_value("name", Name()) == name) {
-				exists = true;
+				exists  = true;
+				version = child.attribute_value("version", Version());
 				if (child.has_attribute("exited")) {
 					exited = true;
 					code = child.attribute_value("exited", 0L);
@@ -57,6 +61,9 @@ struct Depot_download_manager::Main : Import::Download_progress
 
 	Heap _heap { _env.ram(), _env.rm() };
 
+	Timer::Connection _timer { _env };
+
+	Attached_rom_dataspace _config            { _env, "config"            };
 	Attached_rom_dataspace _installation      { _env, "installation"      };
 	Attached_rom_dataspace _dependencies      { _env, "dependencies"      };
 	Attached_rom_dataspace _index             { _env, "index"             };
@@ -101,6 +108,65 @@ struct Depot_download_manager::Main : Import::Download_progress
 	Depot_query_version _depot_query_count { 1 };
 	Fetchurl_version    _fetchurl_count    { 1 };
 
+	enum { MAX_EXTRACT_JOBS = 8, MAX_EXTRACT_BATCH = 8 };
+
+	Extract_version _extract_count[MAX_EXTRACT_JOBS] { };
+
+	/*
+	 * Verified archives are extracted by up to '_extract_jobs' instances of
+	 * the extract tool in parallel while the next batch of at most
+	 * '_verify_batch' archives is being verified. Each extract instance
+	 * consumes 12 MiB of RAM of the dynamic init.
+	 */
+	unsigned _extract_jobs = 1;
+	unsigned _verify_batch = 4;
+
+	void _handle_config()
+	{
+		_config.update();
+
+		Xml_node const config = _config.xml();
+
+		_extract_jobs = max(1U, min((unsigned)MAX_EXTRACT_JOBS,
+		                            config.attribute_value("extract_jobs", 1U)));
+		_verify_batch = max(1U, config.attribute_value("verify_batch", 4U));
+	}
+
+	Signal_handler<Main> _config_handler {
+		_env.ep(), *this, &Main::_handle_config };
+
+	/**
+	 * Assign verified archives to idle extraction jobs
+	 *
+	 * \return  true if at least one extraction job got started
+	 */
+	bool _schedule_extraction_jobs(Import &);
+
+	/* time of the start of the current import, used to report throughput */
+	uint64_t _import_start_ms = 0;
+
+	void _gen_import_progress(Xml_generator &xml, Import const &import)
+	{
+		Import::Stats const stats = import.stats();
+
+		unsigned busy_jobs = 0;
+		for (unsigned job = 0; job < MAX_EXTRACT_JOBS; job++)
+			if (import.extraction_job_busy(job))
+				busy_jobs++;
+
+		uint64_t const elapsed_ms = _timer.elapsed_ms() - _import_start_ms;
+
+		xml.node("progress", [&] () {
+			stats.generate(xml);
+			xml.attribute("extract_jobs", busy_jobs);
+			xml.attribute("elapsed_ms",   elapsed_ms);
+
+			/* number of archives imported per minute */
+			xml.attribute("throughput",
+			              (stats.done*60*1000ULL)/max(elapsed_ms, 1ULL));
+		});
+	}
+
 	unsigned const _fetchurl_max_attempts = 3;
 	unsigned       _fetchurl_attempt      = 0;
 
@@ -137,6 +203,7 @@ struct Depot_download_manager::Main : Import::Download_progress
 			if (_import.constructed()) {
 				xml.attribute("progress", "yes");
 				_import->report(xml, *this);
+				_gen_import_progress(xml, *_import);
 			}
 
 			/* once all imports have settled, present the final results */
@@ -257,6 +324,7 @@ struct Depot_download_manager::Main : Import::Download_progress
 
 	Main(Env &env) : _env(env)
 	{
+		_config           .sigh(_config_handler);
 		_dependencies     .sigh(_query_result_handler);
 		_index            .sigh(_query_result_handler);
 		_current_user     .sigh(_query_result_handler);
@@ -265,6 +333,7 @@ struct Depot_download_manager::Main : Import::Download_progress
 		_installation     .sigh(_installation_handler);
 		_fetchurl_progress.sigh(_fetchurl_progress_handler);
 
+		_handle_config();
 		_handle_installation();
 		_generate_init_config();
 	}
@@ -331,14 +400,18 @@ void Depot_download_manager::Main::_generate_init_config(Xml_generator &xml)
 		xml.node("start", [&] () {
 			gen_verify_start_content(xml, *_import, _current_user_path()); });
 
-	if (_import.constructed() && _import->verified_archives_available()) {
+	if (_import.constructed() && _import->extraction_in_progress()) {
 
 		xml.node("start", [&] () {
 			gen_chroot_start_content(xml, _current_user_name());  });
 
-		xml.node("start", [&] () {
-			gen_extract_start_content(xml, *_import, _current_user_path(),
-			                          _current_user_name()); });
+		for (unsigned job = 0; job < MAX_EXTRACT_JOBS; job++)
+			if (_import->extraction_job_busy(job))
+				xml.node("start", [&] () {
+					gen_extract_start_content(xml, *_import, job,
+					                          _extract_count[job],
+					                          _current_user_path(),
+					                          _current_user_name()); });
 	}
 
 	_fetchurl_watchdog.conditional(fetchurl_running, *this);
@@ -444,6 +517,7 @@ void Depot_download_manager::Main::_handle_query_result()
 				job.started = true; }); });
 
 	_fetchurl_attempt = 0;
+	_import_start_ms  = _timer.elapsed_ms();
 	_update_state_report();
 
 	/* spawn fetchurl */
@@ -451,6 +525,39 @@ void Depot_download_manager::Main::_handle_query_result()
 }
 
 
+bool Depot_download_manager::Main::_schedule_extraction_jobs(Import &import)
+{
+	unsigned idle_jobs = 0;
+	for (unsigned job = 0; job < _extract_jobs; job++)
+		if (!import.extraction_job_busy(job))
+			idle_jobs++;
+
+	bool scheduled = false;
+
+	for (unsigned job = 0; job < _extract_jobs && idle_jobs; job++) {
+
+		if (import.extraction_job_busy(job))
+			continue;
+
+		unsigned const num_verified = import.num_verified_archives();
+		if (num_verified == 0)
+			break;
+
+		/* spread the verified archives evenly across the idle jobs */
+		unsigned const batch = min((unsigned)MAX_EXTRACT_BATCH,
+		                           (num_verified + idle_jobs - 1)/idle_jobs);
+
+		/* restart the extract tool by incrementing the version attribute */
+		_extract_count[job].value++;
+
+		import.assign_extraction_job(job, batch);
+		idle_jobs--;
+		scheduled = true;
+	}
+	return scheduled;
+}
+
+
 void Depot_download_manager::Main::_handle_init_state()
 {
 	_init_state.update();
@@ -489,11 +596,6 @@ void Depot_download_manager::Main::_handle_init_state()
 		}
 	}
 
-	if (!import.downloads_in_progress() && import.completed_downloads_available()) {
-		import.verify_all_downloaded_archives();
-		reconfigure_init = true;
-	}
-
 	if (import.unverified_archives_available()) {
 
 		_verified.xml().for_each_sub_node([&] (Xml_node node) {
@@ -521,17 +623,43 @@ void Depot_download_manager::Main::_handle_init_state()
 		});
 	}
 
-	if (import.verified_archives_available()) {
+	/*
+	 * Verify the downloaded archives batch by batch so that the extraction
+	 * of the already verified archives can proceed in parallel.
+	 */
+	if (!import.downloads_in_progress()
+	 && !import.unverified_archives_available()
+	 && import.completed_downloads_available()) {
+		import.verify_downloaded_archives(_verify_batch);
+		reconfigure_init = true;
+	}
+
+	for (unsigned job = 0; job < MAX_EXTRACT_JOBS; job++) {
 
-		Child_exit_state const extract_state(_init_state.xml(), "extract");
+		if (!import.extraction_job_busy(job))
+			continue;
 
-		if (extract_state.exited && extract_state.code != 0)
-			error("extract failed with exit code ", extract_state.code);
+		Child_exit_state const extract_state(_init_state.xml(),
+		                                     extract_child_name(job));
 
-		if (extract_state.exited && extract_state.code == 0)
-			import.all_verified_archives_extracted();
+		/* skip stale state of a previous instance of the job */
+		if (!extract_state.exited
+		 || extract_state.version != Child_exit_state::Version(_extract_count[job].value))
+			continue;
+
+		if (extract_state.code == 0) {
+			import.extraction_job_completed(job);
+		} else {
+			error(extract_child_name(job), " failed with exit code ", extract_state.code);
+			import.extraction_job_failed(job);
+		}
+
+		reconfigure_init = true;
 	}
 
+	if (_schedule_extraction_jobs(import))
+		reconfigure_init = true;
+
 	/* flag failed jobs to prevent re-attempts in subsequent import iterations */
 	import.for_each_failed_archive([&] (Archive::Path const &path) {
 		_jobs.for_each([&] (Job &job) {
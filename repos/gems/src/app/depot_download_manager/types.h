@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2017 Genode Labs GmbH
+ * Copyright (C) 2017-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -28,6 +28,7 @@ namespace Depot_download_manager {
 
 	struct Depot_query_version { unsigned value; };
 	struct Fetchurl_version    { unsigned value; };
+	struct Extract_version     { unsigned value; };
 }
 
 namespace Genode {
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2017 Genode Labs GmbH
+ * Copyright (C) 2017-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -95,8 +95,17 @@ namespace Depot_download_manager {
 
 	void gen_chroot_start_content(Xml_generator &, Archive::User const &);
 
-	void gen_extract_start_content(Xml_generator &, Import const &,
-	                               Path const &, Archive::User const &);
+	/**
+	 * Return name of the extract component used for the extraction job 'job'
+	 */
+	static inline Rom_name extract_child_name(unsigned job)
+	{
+		return Rom_name("extract.", job + 1);
+	}
+
+	void gen_extract_start_content(Xml_generator &, Import const &, unsigned job,
+	                               Extract_version, Path const &,
+	                               Archive::User const &);
 }
 
 #endif /* _GENERATE_XML_H_ */
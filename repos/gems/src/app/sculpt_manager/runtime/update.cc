@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2018 Genode Labs GmbH
+ * Copyright (C) 2018-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -15,7 +15,7 @@
 
 void Sculpt::gen_update_start_content(Xml_generator &xml)
 {
-	gen_common_start_content(xml, "update", Cap_quota{2000}, Ram_quota{64*1024*1024});
+	gen_common_start_content(xml, "update", Cap_quota{2000}, Ram_quota{88*1024*1024});
 
 	gen_named_node(xml, "binary", "init");
 
@@ -71,7 +71,13 @@ void Sculpt::gen_update_start_content(Xml_generator &xml)
 		/* shorten LOG-session labels to reduce the debug-output noise */
 		gen_relabeled_log("dynamic -> fetchurl", "fetchurl");
 		gen_relabeled_log("dynamic -> verify",   "verify");
-		gen_relabeled_log("dynamic -> extract",  "extract");
+
+		/* the extract instances are named 'extract.1', 'extract.2', ... */
+		gen_service_node<Log_session>(xml, [&] () {
+			xml.attribute("label_prefix", "dynamic -> extract");
+			xml.node("parent", [&] () {
+				xml.attribute("label", "extract"); }); });
+
 		gen_parent_route<Log_session>(xml);
 
 		gen_service_node<Nic::Session>(xml, [&] () {
@@ -96,10 +96,25 @@ class Vfs_audit::File_system : public Vfs::File_system
 			       char const *path)
 			: Vfs_handle(fs, fs, alloc, flags), path(path) { };
 
+			/*
+			 * Responses of the audited handle are reported for this handle,
+			 * which is the one known to the application
+			 */
+			struct Response_forwarder : Io_response_handler
+			{
+				Vfs_handle &handle;
+
+				Response_forwarder(Vfs_handle &handle) : handle(handle) { }
+
+				void read_ready_response()  override { handle.read_ready_response(); }
+				void io_progress_response() override { handle.io_progress_response(); }
+
+			} response_forwarder { *this };
+
 			void handler(Io_response_handler *rh) override
 			{
 				Vfs_handle::handler(rh);
-				if (audit) audit->handler(rh);
+				if (audit) audit->handler(rh ? &response_forwarder : nullptr);
 			}
 		};
 
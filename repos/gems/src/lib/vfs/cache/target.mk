@@ -0,0 +1,2 @@
+TARGET = dummy-vfs_cache
+LIBS = vfs_cache
@@ -0,0 +1,1237 @@
+/*
+ * \brief  VFS page-cache plugin
+ * \author Emery Hemingway
+ * \date   2019-03-18
+ *
+ * The plugin wraps a subtree of the VFS given by the 'path' attribute and
+ * caches the content of the files opened through the plugin in a bounded
+ * LRU cache of pages. The cache is shared by all handles of a file.
+ *
+ * Read misses are served by reading the missing pages plus a number of
+ * read-ahead pages from the backend. Writes to cached pages or writes
+ * covering whole pages are kept in the cache and written back once the
+ * number of dirty pages of the file exceeds the write-behind limit, or when
+ * the handle gets synced or closed. Other writes are passed through.
+ *
+ * Modifications of the subtree that bypass the plugin are not observed.
+ *
+ * Example configuration:
+ *
+ * ! <dir name="cached">
+ * !   <cache path="/data" capacity="4M" read_ahead="8" write_behind="16"
+ * !          stats=".stats"/>
+ * ! </dir>
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#include <vfs/file_system_factory.h>
+#include <vfs/types.h>
+#include <util/avl_tree.h>
+#include <util/avl_string.h>
+
+namespace Vfs_cache {
+
+	using namespace Vfs;
+	using Genode::size_t;
+	using Genode::min;
+	using Genode::max;
+
+	enum { PAGE_SIZE = 4096, MAX_FILL_PAGES = 32 };
+
+	struct Page;
+	struct File;
+	struct Lru;
+	struct Stats;
+	class File_system;
+
+	typedef Vfs::File_io_service::Insufficient_buffer Insufficient_buffer;
+}
+
+
+struct Vfs_cache::Page : Genode::Avl_node<Page>
+{
+	/*
+	 * Noncopyable
+	 */
+	Page(Page const &);
+	Page &operator = (Page const &);
+
+	File           &file;
+	file_size const index;
+
+	size_t size  = 0;     /* number of valid bytes */
+	bool   dirty = false;
+
+	Page *lru_prev = nullptr;
+	Page *lru_next = nullptr;
+
+	char data[PAGE_SIZE];
+
+	Page(File &file, file_size index) : file(file), index(index) { }
+
+	file_size offset() const { return index*PAGE_SIZE; }
+
+	bool higher(Page *p) { return p->index > index; }
+
+	Page *find(file_size i)
+	{
+		if (i == index) return this;
+		Page *p = child(i > index);
+		return p ? p->find(i) : nullptr;
+	}
+
+	Page *last()
+	{
+		Page *p = child(true);
+		return p ? p->last() : this;
+	}
+
+	template <typename FN>
+	void for_each(FN const &fn)
+	{
+		if (Page *p = child(false)) p->for_each(fn);
+		fn(*this);
+		if (Page *p = child(true))  p->for_each(fn);
+	}
+};
+
+
+/**
+ * Cached state of a file, shared by all handles that opened the file
+ */
+struct Vfs_cache::File : Genode::Avl_string<MAX_PATH_LEN>
+{
+	Genode::Avl_tree<Page> pages { };
+
+	/* last page of the file if known and not completely filled */
+	Page *partial = nullptr;
+
+	unsigned users = 0;
+	unsigned dirty = 0;
+
+	/*
+	 * Backend handle used for writing back dirty pages, the handle
+	 * is owned by the file if 'deferred' is set
+	 */
+	Vfs_handle *writer   = nullptr;
+	bool        deferred = false;
+
+	/* file was renamed or unlinked, pass through further requests */
+	bool detached = false;
+
+	File(char const *path) : Avl_string(path) { }
+
+	Page *lookup(file_size index) {
+		return pages.first() ? pages.first()->find(index) : nullptr; }
+
+	/**
+	 * Return end of the dirty content
+	 */
+	file_size dirty_end()
+	{
+		file_size end = 0;
+		if (dirty && pages.first())
+			pages.first()->for_each([&] (Page &p) {
+				if (p.dirty) end = max(end, p.offset() + p.size); });
+		return end;
+	}
+};
+
+
+/**
+ * List of pages ordered from least to most recently used
+ */
+struct Vfs_cache::Lru
+{
+	Page *head = nullptr;
+	Page *tail = nullptr;
+
+	void remove(Page &p)
+	{
+		if (p.lru_prev) p.lru_prev->lru_next = p.lru_next;
+		else            head                 = p.lru_next;
+
+		if (p.lru_next) p.lru_next->lru_prev = p.lru_prev;
+		else            tail                 = p.lru_prev;
+
+		p.lru_prev = p.lru_next = nullptr;
+	}
+
+	void append(Page &p)
+	{
+		p.lru_prev = tail;
+		p.lru_next = nullptr;
+
+		if (tail) tail->lru_next = &p;
+		else      head           = &p;
+
+		tail = &p;
+	}
+
+	void touch(Page &p)
+	{
+		if (tail == &p) return;
+		remove(p);
+		append(p);
+	}
+};
+
+
+struct Vfs_cache::Stats
+{
+	unsigned long hits          = 0; /* reads served from the cache */
+	unsigned long misses        = 0; /* reads that needed the backend */
+	unsigned long read_ahead    = 0; /* pages read beyond the request */
+	unsigned long evictions     = 0;
+	unsigned long write_back    = 0; /* dirty pages written to the backend */
+	unsigned long write_through = 0; /* writes passed to the backend */
+
+	void print(Genode::Output &out) const
+	{
+		Genode::print(out, "hits: ",          hits,          "\n",
+		                   "misses: ",        misses,        "\n",
+		                   "read_ahead: ",    read_ahead,    "\n",
+		                   "evictions: ",     evictions,     "\n",
+		                   "write_back: ",    write_back,    "\n",
+		                   "write_through: ", write_through, "\n");
+	}
+};
+
+
+class Vfs_cache::File_system : public Vfs::File_system
+{
+	private:
+
+		/*
+		 * Noncopyable
+		 */
+		File_system(File_system const &);
+		File_system &operator = (File_system const &);
+
+		typedef Genode::String<64> Name;
+
+		Genode::Allocator &_alloc;
+
+		Vfs::File_system &_root_dir;
+
+		Absolute_path const _cache_path;
+
+		Name const _stats_name;
+
+		unsigned const _capacity;
+		unsigned const _read_ahead;
+		unsigned const _write_behind;
+
+		Genode::Avl_tree<Genode::Avl_string_base> _files { };
+
+		Lru      _lru       { };
+		unsigned _num_pages = 0;
+		unsigned _deferred  = 0;
+		Stats    _stats     { };
+
+		/**
+		 * Expand a path to lay within the cached subtree
+		 */
+		inline Absolute_path _expand(char const *path) {
+			return Absolute_path(path+1, _cache_path.string()); }
+
+		bool _stats_path(char const *path) const
+		{
+			return _stats_name.valid() && path[0] == '/'
+			    && !strcmp(path + 1, _stats_name.string());
+		}
+
+		struct Handle final : Vfs_handle
+		{
+			/*
+			 * Noncopyable
+			 */
+			Handle(Handle const &);
+			Handle &operator = (Handle const &);
+
+			Vfs_handle *backend = nullptr;
+			File       *file    = nullptr;
+			bool const  stats;
+
+			/* state of the current read request */
+			file_size read_done       = 0;
+			file_size fill_offset     = 0;
+			file_size fill_len        = 0;
+			file_size fill_avail      = 0;
+			bool      fill_pending    = false;
+			bool      filled          = false;
+			char     *staging         = nullptr;
+
+			bool sync_queued = false;
+
+			Handle(Vfs_cache::File_system &fs, Genode::Allocator &alloc,
+			       int flags, bool stats)
+			: Vfs_handle(fs, fs, alloc, flags), stats(stats) { }
+
+			~Handle()
+			{
+				if (staging)
+					alloc().free(staging, MAX_FILL_PAGES*PAGE_SIZE);
+			}
+
+			void sync_state()
+			{
+				if (backend)
+					backend->seek(Vfs_handle::seek());
+			}
+
+			bool writeable() const
+			{
+				return (status_flags() & Directory_service::OPEN_MODE_ACCMODE)
+				       != Directory_service::OPEN_MODE_RDONLY;
+			}
+
+			/*
+			 * Responses of the backend handle are reported for this handle,
+			 * which is the one known to the application
+			 */
+			struct Response_forwarder : Io_response_handler
+			{
+				Vfs_handle &handle;
+
+				Response_forwarder(Vfs_handle &handle) : handle(handle) { }
+
+				void read_ready_response()  override { handle.read_ready_response(); }
+				void io_progress_response() override { handle.io_progress_response(); }
+
+			} response_forwarder { *this };
+
+			void handler(Io_response_handler *rh) override
+			{
+				Vfs_handle::handler(rh);
+				if (backend) backend->handler(rh ? &response_forwarder : nullptr);
+			}
+		};
+
+		File *_lookup_file(char const *path)
+		{
+			Genode::Avl_string_base *f =
+				_files.first() ? _files.first()->find_by_name(path) : nullptr;
+			return static_cast<File *>(f);
+		}
+
+		void _destroy_page(Page &page)
+		{
+			File &file = page.file;
+
+			if (page.dirty)
+				file.dirty--;
+
+			if (file.partial == &page)
+				file.partial = nullptr;
+
+			_lru.remove(page);
+			file.pages.remove(&page);
+			_num_pages--;
+			destroy(_alloc, &page);
+		}
+
+		void _release_file(File &file)
+		{
+			if (file.users || file.deferred || file.pages.first())
+				return;
+
+			if (!file.detached)
+				_files.remove(&file);
+
+			destroy(_alloc, &file);
+		}
+
+		/**
+		 * Evict clean pages until there is room for a new page
+		 */
+		void _make_room()
+		{
+			Page *p = _lru.head;
+			while (p && _num_pages >= _capacity) {
+				Page *next = p->lru_next;
+				if (!p->dirty) {
+					File &file = p->file;
+					_destroy_page(*p);
+					_stats.evictions++;
+					if (!file.pages.first())
+						_release_file(file);
+				}
+				p = next;
+			}
+		}
+
+		/**
+		 * Allocate page, return nullptr if the cache is exhausted
+		 */
+		Page *_alloc_page(File &file, file_size index)
+		{
+			_make_room();
+			if (_num_pages >= _capacity)
+				return nullptr;
+
+			Page *page = nullptr;
+			try { page = new (_alloc) Page(file, index); }
+			catch (Genode::Out_of_ram)  { return nullptr; }
+			catch (Genode::Out_of_caps) { return nullptr; }
+
+			file.pages.insert(page);
+			_lru.append(*page);
+			_num_pages++;
+			return page;
+		}
+
+		/**
+		 * Account for the file to extend up to 'offset'
+		 *
+		 * The content between the known end of the file and 'offset'
+		 * reads as zeros.
+		 */
+		void _extend(File &file, file_size offset)
+		{
+			Page * const p = file.partial;
+			if (!p || offset <= p->offset() + p->size)
+				return;
+
+			size_t const new_size = min((file_size)PAGE_SIZE, offset - p->offset());
+			Genode::memset(p->data + p->size, 0, new_size - p->size);
+			p->size = new_size;
+
+			if (new_size == PAGE_SIZE)
+				file.partial = nullptr;
+		}
+
+		/**
+		 * Insert content read from the backend into the cache
+		 */
+		void _insert(File &file, file_size offset, char const *src, file_size len)
+		{
+			file_size const first = offset / PAGE_SIZE;
+
+			for (file_size i = 0; i*PAGE_SIZE < len; i++) {
+
+				size_t const size = min((file_size)PAGE_SIZE, len - i*PAGE_SIZE);
+
+				Page *page = file.lookup(first + i);
+
+				/* dirty pages are more recent than the backend content */
+				if (page && page->dirty)
+					continue;
+
+				if (!page)
+					page = _alloc_page(file, first + i);
+
+				if (!page)
+					return;
+
+				Genode::memcpy(page->data, src + i*PAGE_SIZE, size);
+				page->size = size;
+
+				if (size < PAGE_SIZE)
+					file.partial = page;
+				else if (file.partial == page)
+					file.partial = nullptr;
+			}
+		}
+
+		/**
+		 * Copy cached content to 'dst'
+		 *
+		 * \param eof  set if the end of the file was reached
+		 * \return     number of bytes copied until the first missing page
+		 */
+		file_size _copy(File &file, char *dst, file_size len, file_size offset,
+		                bool &eof)
+		{
+			file_size copied = 0;
+			eof = false;
+
+			while (copied < len) {
+
+				Page *page = file.lookup((offset + copied) / PAGE_SIZE);
+				if (!page)
+					break;
+
+				_lru.touch(*page);
+
+				size_t const local = (offset + copied) % PAGE_SIZE;
+				if (local >= page->size) {
+					eof = true;
+					break;
+				}
+
+				size_t const n = min(len - copied, (file_size)(page->size - local));
+				Genode::memcpy(dst + copied, page->data + local, n);
+				copied += n;
+
+				if (page->size < PAGE_SIZE && local + n == page->size) {
+					eof = true;
+					break;
+				}
+			}
+			return copied;
+		}
+
+		/**
+		 * Return true if a failed write may succeed when retried later
+		 */
+		static bool _transient(Write_result result)
+		{
+			return result == WRITE_ERR_AGAIN
+			    || result == WRITE_ERR_WOULD_BLOCK
+			    || result == WRITE_ERR_INTERRUPT;
+		}
+
+		/**
+		 * Write 'len' bytes at 'offset' to the backend
+		 *
+		 * \param written  number of bytes written to the backend
+		 * \return         'WRITE_OK' if all bytes were written, or the
+		 *                 error of the backend, or 'WRITE_ERR_WOULD_BLOCK'
+		 *                 if the backend did not make progress
+		 *
+		 * \throw Insufficient_buffer
+		 */
+		static Write_result _write_backend(Vfs_handle &backend, char const *src,
+		                                   file_size len, file_size offset,
+		                                   file_size &written)
+		{
+			written = 0;
+
+			while (len) {
+				file_size out = 0;
+				backend.seek(offset);
+
+				Write_result const result =
+					backend.fs().write(&backend, src, len, out);
+
+				if (result != WRITE_OK)
+					return result;
+
+				if (!out)
+					return WRITE_ERR_WOULD_BLOCK;
+
+				src     += out;
+				len     -= out;
+				offset  += out;
+				written += out;
+			}
+			return WRITE_OK;
+		}
+
+		/**
+		 * Write dirty pages of 'file' back
+		 *
+		 * A page stays dirty unless it got written completely.
+		 *
+		 * \return  'WRITE_OK' if all dirty pages were written back, or the
+		 *          error of the first page that could not be written
+		 *
+		 * \throw Insufficient_buffer
+		 */
+		Write_result _flush(File &file)
+		{
+			if (!file.dirty || !file.writer)
+				return WRITE_OK;
+
+			Write_result result = WRITE_OK;
+
+			file.pages.first()->for_each([&] (Page &p) {
+				if (!p.dirty || result != WRITE_OK)
+					return;
+
+				file_size written = 0;
+				result = _write_backend(*file.writer, p.data, p.size,
+				                        p.offset(), written);
+				if (result != WRITE_OK)
+					return;
+
+				p.dirty = false;
+				file.dirty--;
+				_stats.write_back++;
+			});
+
+			return result;
+		}
+
+		/**
+		 * Discard dirty pages that cannot be written back
+		 */
+		void _discard_dirty(File &file, char const *path)
+		{
+			if (!file.dirty)
+				return;
+
+			Genode::warning("cache: dropping unwritten content of ", path);
+
+			file.pages.first()->for_each([&] (Page &p) {
+				if (p.dirty) {
+					p.dirty = false;
+					file.dirty--;
+				}
+			});
+		}
+
+		/**
+		 * Close backend handle kept for the write back of a closed writer
+		 */
+		void _close_deferred_writer(File &file)
+		{
+			if (!file.deferred)
+				return;
+
+			file.writer->ds().close(file.writer);
+			file.writer   = nullptr;
+			file.deferred = false;
+			_deferred--;
+		}
+
+		/**
+		 * Retry the write back of files whose writer was closed
+		 */
+		void _flush_deferred()
+		{
+			for (File *done = nullptr; _deferred; ) {
+
+				done = nullptr;
+				_files.first()->for_each([&] (Genode::Avl_string_base const &f) {
+					File &file = static_cast<File &>(const_cast<Genode::Avl_string_base &>(f));
+					if (done || !file.deferred)
+						return;
+
+					try {
+						Write_result const result = _flush(file);
+						if (_transient(result))
+							return;
+
+						/* the writer is gone, nobody can handle the error */
+						if (result != WRITE_OK)
+							_discard_dirty(file, file.name());
+					}
+					catch (Insufficient_buffer) { return; }
+
+					done = &file;
+				});
+
+				if (!done)
+					break;
+
+				_close_deferred_writer(*done);
+				_release_file(*done);
+			}
+		}
+
+		/**
+		 * Drop cached content of a file, e.g., when renamed or unlinked
+		 */
+		void _detach(char const *path)
+		{
+			File *file = _lookup_file(path);
+			if (!file)
+				return;
+
+			try {
+				if (_flush(*file) != WRITE_OK)
+					_discard_dirty(*file, path);
+			}
+			catch (Insufficient_buffer) { _discard_dirty(*file, path); }
+
+			while (Page *p = file->pages.first())
+				_destroy_page(*p);
+
+			_files.remove(file);
+			file->detached = true;
+
+			_close_deferred_writer(*file);
+
+			_release_file(*file);
+		}
+
+		/**
+		 * Truncate the cached content of a file to 'len' bytes
+		 */
+		void _truncate(File &file, file_size len)
+		{
+			_extend(file, len);
+
+			while (Page *p = file.pages.first() ? file.pages.first()->last() : nullptr) {
+
+				if (p->offset() >= len) {
+					_destroy_page(*p);
+					continue;
+				}
+
+				if (p->offset() + p->size > len) {
+					p->size      = len - p->offset();
+					file.partial = p;
+				}
+				break;
+			}
+		}
+
+		Read_result _read_stats(Handle &h, char *dst, file_size len, file_size &out)
+		{
+			Genode::String<256> const text(_stats,
+			                               "pages: ", _num_pages, "\n");
+			file_size const size = text.length() - 1;
+
+			out = 0;
+			if (h.seek() < size) {
+				out = min(len, size - h.seek());
+				Genode::memcpy(dst, text.string() + h.seek(), out);
+			}
+			return READ_OK;
+		}
+
+		static void _reset_read(Handle &h)
+		{
+			h.read_done     = 0;
+			h.fill_avail    = 0;
+			h.filled        = false;
+		}
+
+	public:
+
+		File_system(Vfs::Env &env, Genode::Xml_node config)
+		:
+			_alloc(env.alloc()),
+			_root_dir(env.root_dir()),
+			_cache_path(config.attribute_value(
+				"path", Genode::String<Absolute_path::capacity()>()).string()),
+			_stats_name(config.attribute_value("stats", Name(".stats"))),
+			_capacity(max(1UL, config.attribute_value("capacity",
+				Genode::Number_of_bytes(1024*1024)) / PAGE_SIZE)),
+			_read_ahead(min(config.attribute_value("read_ahead", 8U),
+			                (unsigned)MAX_FILL_PAGES/2)),
+			_write_behind(config.attribute_value("write_behind", 16U))
+		{ }
+
+		const char* type() override { return "cache"; }
+
+
+		/***********************
+		 ** Directory service **
+		 ***********************/
+
+		Genode::Dataspace_capability dataspace(const char *path) override
+		{
+			if (File *file = _lookup_file(_expand(path).string())) {
+				try { _flush(*file); }
+				catch (Insufficient_buffer) { }
+			}
+			return _root_dir.dataspace(_expand(path).string());
+		}
+
+		void release(char const *path, Dataspace_capability ds) override
+		{
+			return _root_dir.release(_expand(path).string(), ds);
+		}
+
+		Open_result open(const char *path, unsigned int mode,
+		                 Vfs::Vfs_handle **out, Genode::Allocator &alloc) override
+		{
+			_flush_deferred();
+
+			bool const stats = _stats_path(path);
+
+			if (stats && (mode & (OPEN_MODE_ACCMODE | OPEN_MODE_CREATE)))
+				return OPEN_ERR_NO_PERM;
+
+			Handle *handle;
+			try { handle = new (alloc) Handle(*this, alloc, mode, stats); }
+			catch (Genode::Out_of_ram)  { return OPEN_ERR_OUT_OF_RAM;  }
+			catch (Genode::Out_of_caps) { return OPEN_ERR_OUT_OF_CAPS; }
+
+			if (stats) {
+				*out = handle;
+				return OPEN_OK;
+			}
+
+			Absolute_path const full_path = _expand(path);
+
+			Open_result r = _root_dir.open(full_path.string(), mode,
+			                               &handle->backend, alloc);
+			if (r != OPEN_OK) {
+				destroy(alloc, handle);
+				return r;
+			}
+
+			File *file = _lookup_file(full_path.string());
+			if (!file) {
+				try { file = new (_alloc) File(full_path.string()); }
+				catch (Genode::Out_of_ram)  { file = nullptr; }
+				catch (Genode::Out_of_caps) { file = nullptr; }
+
+				if (file)
+					_files.insert(file);
+			}
+
+			if (file) {
+				file->users++;
+				handle->file = file;
+			}
+
+			*out = handle;
+			return OPEN_OK;
+		}
+
+		Opendir_result opendir(char const *path, bool create,
+		                       Vfs_handle **out, Allocator &alloc) override
+		{
+			Handle *handle;
+			try { handle = new (alloc) Handle(*this, alloc, 0, false); }
+			catch (Genode::Out_of_ram)  { return OPENDIR_ERR_OUT_OF_RAM;  }
+			catch (Genode::Out_of_caps) { return OPENDIR_ERR_OUT_OF_CAPS; }
+
+			Opendir_result r = _root_dir.opendir(
+				_expand(path).string(), create, &handle->backend, alloc);
+
+			if (r == OPENDIR_OK)
+				*out = handle;
+			else
+				destroy(alloc, handle);
+			return r;
+		}
+
+		void close(Vfs::Vfs_handle *vfs_handle) override
+		{
+			Handle *h = static_cast<Handle*>(vfs_handle);
+			if (!h) return;
+
+			bool backend_owned_by_file = false;
+
+			if (File *file = h->file) {
+
+				if (file->writer == h->backend) {
+
+					bool retry = false;
+					try {
+						Write_result const result = _flush(*file);
+						retry = _transient(result);
+
+						/* the closed writer cannot handle the error */
+						if (result != WRITE_OK && !retry)
+							_discard_dirty(*file, file->name());
+					}
+					catch (Insufficient_buffer) { retry = true; }
+
+					if (retry) {
+						/* keep the backend handle for writing back later */
+						file->deferred = true;
+						backend_owned_by_file = true;
+						_deferred++;
+					}
+					if (!backend_owned_by_file)
+						file->writer = nullptr;
+				}
+
+				file->users--;
+				_release_file(*file);
+			}
+
+			if (h->backend && !backend_owned_by_file)
+				h->backend->ds().close(h->backend);
+
+			destroy(h->alloc(), h);
+
+			_flush_deferred();
+		}
+
+		Stat_result stat(const char *path, Vfs::Directory_service::Stat &buf) override
+		{
+			if (_stats_path(path)) {
+				buf = Stat { };
+				buf.mode = STAT_MODE_FILE | 0444;
+				buf.size = Genode::String<256>(_stats, "pages: ",
+				                               _num_pages, "\n").length() - 1;
+				return STAT_OK;
+			}
+
+			Absolute_path const full_path = _expand(path);
+
+			Stat_result const r = _root_dir.stat(full_path.string(), buf);
+
+			/* account for content not yet written back */
+			if (r == STAT_OK)
+				if (File *file = _lookup_file(full_path.string()))
+					buf.size = max(buf.size, file->dirty_end());
+
+			return r;
+		}
+
+		Unlink_result unlink(const char *path) override
+		{
+			Absolute_path const full_path = _expand(path);
+			_detach(full_path.string());
+			return _root_dir.unlink(full_path.string());
+		}
+
+		Rename_result rename(const char *from , const char *to) override
+		{
+			Absolute_path const from_path = _expand(from);
+			Absolute_path const   to_path = _expand(to);
+
+			_detach(from_path.string());
+			_detach(to_path.string());
+
+			return _root_dir.rename(from_path.string(), to_path.string());
+		}
+
+		file_size num_dirent(const char *path) override
+		{
+			return _root_dir.num_dirent(_expand(path).string());
+		}
+
+		bool directory(char const *path) override
+		{
+			return _root_dir.directory(_expand(path).string());
+		}
+
+		const char* leaf_path(const char *path) override
+		{
+			if (_stats_path(path))
+				return path;
+
+			return _root_dir.leaf_path(_expand(path).string());
+		}
+
+
+		/**********************
+		 ** File I/O service **
+		 **********************/
+
+		Write_result write(Vfs_handle *vfs_handle,
+		                   const char *buf, file_size len,
+		                   file_size &out) override
+		{
+			Handle &h = *static_cast<Handle*>(vfs_handle);
+
+			if (h.stats)
+				return WRITE_ERR_INVALID;
+
+			h.sync_state();
+
+			File * const file = h.file;
+			if (!file || file->detached || !h.writeable())
+				return h.backend->fs().write(h.backend, buf, len, out);
+
+			_flush_deferred();
+
+			/* write back dirty pages of a previous writer of the file */
+			if (file->writer && file->writer != h.backend) {
+				Write_result const result = _flush(*file);
+				if (result != WRITE_OK)
+					return result;
+
+				_close_deferred_writer(*file);
+			}
+
+			if (file->dirty >= _write_behind) {
+				Write_result const result = _flush(*file);
+				if (result != WRITE_OK)
+					return result;
+			}
+
+			file->writer = h.backend;
+
+			file_size const offset = h.seek();
+
+			for (file_size done = 0; done < len; ) {
+
+				file_size const pos   = offset + done;
+				size_t    const local = pos % PAGE_SIZE;
+				file_size const n     = min(len - done, (file_size)(PAGE_SIZE - local));
+
+				Page *page = file->lookup(pos / PAGE_SIZE);
+
+				_extend(*file, pos);
+
+				if (!page && n == PAGE_SIZE)
+					page = _alloc_page(*file, pos / PAGE_SIZE);
+
+				if (page) {
+					if (local > page->size)
+						Genode::memset(page->data + page->size, 0, local - page->size);
+
+					Genode::memcpy(page->data + local, buf + done, n);
+					page->size = max(page->size, (size_t)(local + n));
+
+					if (!page->dirty) {
+						page->dirty = true;
+						file->dirty++;
+					}
+
+					if (page->size == PAGE_SIZE && file->partial == page)
+						file->partial = nullptr;
+
+					_lru.touch(*page);
+				} else {
+					file_size written = 0;
+					Write_result const result =
+						_write_backend(*h.backend, buf + done, n, pos, written);
+
+					_stats.write_through++;
+
+					/* report the bytes written so far, or the error */
+					if (result != WRITE_OK) {
+						out = done + written;
+						return out ? WRITE_OK : result;
+					}
+				}
+
+				done += n;
+			}
+
+			out = len;
+			return WRITE_OK;
+		}
+
+		bool queue_read(Vfs_handle *vfs_handle, file_size len) override
+		{
+			Handle &h = *static_cast<Handle*>(vfs_handle);
+
+			if (h.stats)
+				return true;
+
+			h.sync_state();
+
+			if (!h.file || h.file->detached)
+				return h.backend->fs().queue_read(h.backend, len);
+
+			/* the request state is kept while a fill is pending */
+			if (!h.fill_pending)
+				_reset_read(h);
+
+			return true;
+		}
+
+		Read_result complete_read(Vfs_handle *vfs_handle,
+		                          char *dst, file_size len,
+		                          file_size &out) override
+		{
+			Handle &h = *static_cast<Handle*>(vfs_handle);
+
+			if (h.stats)
+				return _read_stats(h, dst, len, out);
+
+			h.sync_state();
+
+			File * const file = h.file;
+			if (!file || file->detached)
+				return h.backend->fs().complete_read(h.backend, dst, len, out);
+
+			file_size const offset = h.seek();
+
+			for (;;) {
+
+				if (h.fill_pending) {
+					file_size n = 0;
+					h.backend->seek(h.fill_offset);
+					Read_result const r = h.backend->fs().complete_read(
+						h.backend, h.staging, h.fill_len, n);
+
+					switch (r) {
+					case READ_OK:
+						break;
+
+					case READ_QUEUED:
+					case READ_ERR_WOULD_BLOCK:
+					case READ_ERR_AGAIN:
+					case READ_ERR_INTERRUPT:
+						return r;
+
+					case READ_ERR_IO:
+					case READ_ERR_INVALID:
+						h.fill_pending = false;
+						_reset_read(h);
+						return r;
+					}
+
+					h.fill_pending = false;
+
+					/*
+					 * Content not yet written back may extend the file
+					 * beyond the end known to the backend, the gap
+					 * reads as zeros
+					 */
+					file_size const end =
+						min(h.fill_offset + h.fill_len,
+						    max(h.fill_offset + n, file->dirty_end()));
+
+					h.fill_avail = end - h.fill_offset;
+
+					Genode::memset(h.staging + n, 0, h.fill_avail - n);
+					_insert(*file, h.fill_offset, h.staging, h.fill_avail);
+				}
+
+				bool eof = false;
+				h.read_done += _copy(*file, dst + h.read_done, len - h.read_done,
+				                     offset + h.read_done, eof);
+
+				file_size const pos = offset + h.read_done;
+
+				if (h.read_done == len || eof)
+					break;
+
+				bool const within_fill = h.filled && pos >= h.fill_offset
+				                      && pos <  h.fill_offset + h.fill_len;
+
+				/*
+				 * Serve pages of the last fill that were evicted by the
+				 * fill itself, e.g., if the cache is mostly dirty
+				 */
+				if (within_fill && pos < h.fill_offset + h.fill_avail) {
+					file_size const n =
+						min(min(len - h.read_done, h.fill_offset + h.fill_avail - pos),
+						    (file_size)(PAGE_SIZE - pos % PAGE_SIZE));
+
+					Genode::memcpy(dst + h.read_done,
+					               h.staging + (pos - h.fill_offset), n);
+					h.read_done += n;
+					continue;
+				}
+
+				/* the backend reported the end of the file */
+				if (within_fill)
+					break;
+
+				if (!h.staging) {
+					try { h.staging = (char *)h.alloc().alloc(MAX_FILL_PAGES*PAGE_SIZE); }
+					catch (Genode::Out_of_ram)  { return READ_ERR_INVALID; }
+					catch (Genode::Out_of_caps) { return READ_ERR_INVALID; }
+				}
+
+				/* fill the missing pages plus the read-ahead pages */
+				file_size const start = pos & ~((file_size)PAGE_SIZE - 1);
+				file_size const requested =
+					(offset + len - start + PAGE_SIZE - 1) / PAGE_SIZE;
+				file_size const pages =
+					min((file_size)MAX_FILL_PAGES, requested + _read_ahead);
+
+				h.backend->seek(start);
+				if (!h.backend->fs().queue_read(h.backend, pages*PAGE_SIZE))
+					return READ_QUEUED;
+
+				if (!h.filled)
+					_stats.misses++;
+
+				_stats.read_ahead += pages > requested ? pages - requested : 0;
+
+				h.fill_pending  = true;
+				h.filled        = true;
+				h.fill_offset   = start;
+				h.fill_len      = pages*PAGE_SIZE;
+				h.fill_avail    = 0;
+			}
+
+			if (!h.filled)
+				_stats.hits++;
+
+			out = h.read_done;
+			_reset_read(h);
+			return READ_OK;
+		}
+
+		bool read_ready(Vfs_handle *vfs_handle) override
+		{
+			Handle &h = *static_cast<Handle*>(vfs_handle);
+			if (h.stats) return true;
+
+			h.sync_state();
+			return h.backend->fs().read_ready(h.backend);
+		}
+
+		bool notify_read_ready(Vfs_handle *vfs_handle) override
+		{
+			Handle &h = *static_cast<Handle*>(vfs_handle);
+			if (h.stats) return false;
+
+			h.sync_state();
+			return h.backend->fs().notify_read_ready(h.backend);
+		}
+
+		Ftruncate_result ftruncate(Vfs_handle *vfs_handle,
+		                           file_size len) override
+		{
+			Handle &h = *static_cast<Handle*>(vfs_handle);
+			if (h.stats) return FTRUNCATE_ERR_NO_PERM;
+
+			h.sync_state();
+
+			if (h.file && !h.file->detached)
+				_truncate(*h.file, len);
+
+			return h.backend->fs().ftruncate(h.backend, len);
+		}
+
+		bool check_unblock(Vfs_handle *vfs_handle, bool rd, bool wr, bool ex) override
+		{
+			Handle &h = *static_cast<Handle*>(vfs_handle);
+			if (h.stats) return true;
+
+			h.sync_state();
+			return h.backend->fs().check_unblock(h.backend, rd, wr, ex);
+		}
+
+		void register_read_ready_sigh(Vfs_handle *vfs_handle, Signal_context_capability sigh) override
+		{
+			Handle &h = *static_cast<Handle*>(vfs_handle);
+			if (h.stats) return;
+
+			h.sync_state();
+			return h.backend->fs().register_read_ready_sigh(h.backend, sigh);
+		}
+
+		Sync_result complete_sync(Vfs_handle *vfs_handle) override
+		{
+			Handle &h = *static_cast<Handle*>(vfs_handle);
+			if (h.stats) return SYNC_OK;
+
+			h.sync_state();
+
+			if (h.file && !h.file->detached) {
+				try {
+					Write_result const result = _flush(*h.file);
+					if (_transient(result))
+						return SYNC_QUEUED;
+					if (result != WRITE_OK)
+						return SYNC_ERR_INVALID;
+				}
+				catch (Insufficient_buffer) { return SYNC_QUEUED; }
+			}
+
+			if (!h.sync_queued) {
+				if (!h.backend->fs().queue_sync(h.backend))
+					return SYNC_QUEUED;
+				h.sync_queued = true;
+			}
+
+			Sync_result const r = h.backend->fs().complete_sync(h.backend);
+			if (r != SYNC_QUEUED)
+				h.sync_queued = false;
+
+			return r;
+		}
+};
+
+
+extern "C" Vfs::File_system_factory *vfs_file_system_factory(void)
+{
+	struct Factory : Vfs::File_system_factory
+	{
+		Vfs::File_system *create(Vfs::Env &env, Genode::Xml_node config) override
+		{
+			return new (env.alloc())
+				Vfs_cache::File_system(env, config);
+		}
+	};
+
+	static Factory f;
+	return &f;
+}
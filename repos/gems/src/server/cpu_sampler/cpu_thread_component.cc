@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2016-2017 Genode Labs GmbH
+ * Copyright (C) 2016-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -104,14 +104,8 @@ void Cpu_sampler::Cpu_thread_component::reset()
 }
 
 
-void Cpu_sampler::Cpu_thread_component::flush()
+void Cpu_sampler::Cpu_thread_component::_flush_raw()
 {
-	if (_sample_buf_index == 0)
-		return;
-
-	if (!_log.constructed())
-		_log.construct(_env, _log_session_label);
-
 	/* number of hex characters + newline + '\0' */
 	enum { SAMPLE_STRING_SIZE = 2 * sizeof(addr_t) + 1 + 1 };
 
@@ -129,6 +123,75 @@ void Cpu_sampler::Cpu_thread_component::flush()
 		         _sample_buf[i]);
 		_log->write(sample_string);
 	}
+}
+
+
+void Cpu_sampler::Cpu_thread_component::_flush_flat()
+{
+	/*
+	 * Aggregate the samples per function by replacing each sample with the
+	 * start address of its function and sorting the samples. Samples that
+	 * cannot be resolved are aggregated per address.
+	 */
+	for (unsigned int i = 0; i < _sample_buf_index; i++) {
+
+		Symbol_table::Symbol const *symbol =
+			_symbols ? _symbols->lookup(_sample_buf[i]) : nullptr;
+
+		if (symbol)
+			_sample_buf[i] = symbol->addr;
+	}
+
+	for (unsigned int i = 1; i < _sample_buf_index; i++) {
+		addr_t const key = _sample_buf[i];
+		unsigned int j = i;
+		for (; j > 0 && _sample_buf[j - 1] > key; j--)
+			_sample_buf[j] = _sample_buf[j - 1];
+		_sample_buf[j] = key;
+	}
+
+	/*
+	 * Write one line per function with the function name followed by the
+	 * number of samples. The stack is not unwound, so the profile is flat.
+	 */
+	typedef String<Log_session::MAX_STRING_LEN> Line;
+
+	for (unsigned int i = 0, count; i < _sample_buf_index; i += count) {
+
+		addr_t const key = _sample_buf[i];
+
+		for (count = 1; i + count < _sample_buf_index; count++)
+			if (_sample_buf[i + count] != key)
+				break;
+
+		Symbol_table::Symbol const *symbol =
+			_symbols ? _symbols->lookup(key) : nullptr;
+
+		Line const suffix(" ", count, "\n");
+
+		/* truncate long function names to fit into one line */
+		size_t const max_len = Line::capacity() - suffix.length();
+
+		Line const function = symbol ? Line(Cstring(symbol->name, max_len))
+		                             : Line(Hex(key));
+
+		_log->write(Line(function, suffix).string());
+	}
+}
+
+
+void Cpu_sampler::Cpu_thread_component::flush()
+{
+	if (_sample_buf_index == 0)
+		return;
+
+	if (!_log.constructed())
+		_log.construct(_env, _log_session_label);
+
+	if (_flat)
+		_flush_flat();
+	else
+		_flush_raw();
 
 	_sample_buf_index = 0;
 }
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2016-2017 Genode Labs GmbH
+ * Copyright (C) 2016-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -21,6 +21,7 @@
 
 /* local includes */
 #include "cpu_session_component.h"
+#include "symbol_table.h"
 
 namespace Cpu_sampler {
 	using namespace Genode;
@@ -51,6 +52,12 @@ class Cpu_sampler::Cpu_thread_component : public Rpc_object<Cpu_thread>
 
 		Constructible<Log_connection> _log;
 
+		bool                   _flat    = false;
+		Symbol_table const    *_symbols = nullptr;
+
+		void _flush_raw();
+		void _flush_flat();
+
 	public:
 
 		Cpu_thread_component(Cpu_session_component   &cpu_session_component,
@@ -75,6 +82,20 @@ class Cpu_sampler::Cpu_thread_component : public Rpc_object<Cpu_thread>
 		void reset();
 		void flush();
 
+		/**
+		 * Select the format of the written samples
+		 *
+		 * \param flat     write samples as flat profile, aggregated per
+		 *                 function, instead of raw addresses
+		 * \param symbols  symbol table used to resolve the addresses,
+		 *                 or nullptr
+		 */
+		void output_format(bool flat, Symbol_table const *symbols)
+		{
+			_flat    = flat;
+			_symbols = symbols;
+		}
+
 		/**************************
 		 ** CPU thread interface **
 		 *************************/
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2016-2017 Genode Labs GmbH
+ * Copyright (C) 2016-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -26,6 +26,7 @@
 #include "cpu_root.h"
 #include "cpu_session_component.h"
 #include "cpu_thread_component.h"
+#include "symbol_table.h"
 #include "thread_list_change_handler.h"
 
 namespace Cpu_sampler { struct Main; }
@@ -47,6 +48,7 @@ struct Cpu_sampler::Main : Thread_list_change_handler
 	Timer::Connection       timer { env };
 	Thread_list             thread_list;
 	Thread_list             selected_thread_list;
+	List<Symbol_table>      symbol_tables;
 
 	unsigned int            sample_index;
 	unsigned int            max_sample_index;
@@ -90,12 +92,17 @@ struct Cpu_sampler::Main : Thread_list_change_handler
 		Genode::uint64_t sample_interval_ms =
 			config.xml().attribute_value<Genode::uint64_t>("sample_interval_ms", 1000);
 
+		/* a sample interval in microseconds takes precedence */
+		Genode::uint64_t sample_interval_us =
+			config.xml().attribute_value<Genode::uint64_t>("sample_interval_us",
+			                                               sample_interval_ms * 1000);
+
 		Genode::uint64_t sample_duration_s =
 			config.xml().attribute_value<Genode::uint64_t>("sample_duration_s", 10);
 
-		max_sample_index = ((sample_duration_s * 1000) / sample_interval_ms) - 1;
+		max_sample_index = ((sample_duration_s * 1000 * 1000) / sample_interval_us) - 1;
 
-		timeout_us = sample_interval_ms * 1000;
+		timeout_us = sample_interval_us;
 
 		thread_list_changed();
 
@@ -110,6 +117,35 @@ struct Cpu_sampler::Main : Thread_list_change_handler
 		{ env.ep(), *this, &Main::handle_config_update};
 
 
+	/**
+	 * Return symbol table of the ELF binary with the given ROM name
+	 *
+	 * The symbol tables are kept for the lifetime of the component.
+	 */
+	Symbol_table const *symbol_table(Symbol_table::Rom_name const &rom_name)
+	{
+		for (Symbol_table *t = symbol_tables.first(); t; t = t->next())
+			if (t->rom_name() == rom_name)
+				return t;
+
+		try {
+			Symbol_table *t = new (&alloc) Symbol_table(env, alloc, rom_name);
+			symbol_tables.insert(t);
+
+			if (verbose)
+				Genode::log("loaded ", t->num_symbols(), " symbols from ", rom_name);
+
+			return t;
+		}
+		catch (Symbol_table::Invalid_binary) {
+			Genode::warning("no symbols found in ROM '", rom_name, "'"); }
+		catch (Service_denied) {
+			Genode::warning("ROM '", rom_name, "' is not available"); }
+
+		return nullptr;
+	}
+
+
 	void thread_list_changed() override
 	{
 		/* clear selected_thread_list */
@@ -141,6 +177,17 @@ struct Cpu_sampler::Main : Thread_list_change_handler
 
 				Session_policy policy(cpu_thread->label(), config.xml());
 				cpu_thread->reset();
+
+				typedef String<16> Format;
+				bool const flat =
+					policy.attribute_value("format", Format("raw")) == "flat";
+
+				Symbol_table::Rom_name const binary =
+					policy.attribute_value("binary", Symbol_table::Rom_name());
+
+				cpu_thread->output_format(flat, (flat && binary.valid())
+				                                ? symbol_table(binary) : nullptr);
+
 				selected_thread_list.insert(new (&alloc)
 				                            Thread_element(cpu_thread));
 
@@ -0,0 +1,164 @@
+/*
+ * \brief  Symbol table of an ELF binary obtained from ROM
+ * \author Christian Prochaska
+ * \date   2019-03-29
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <util/string.h>
+
+/* base-internal includes */
+#include <base/internal/elf_format.h>
+
+/* local includes */
+#include "symbol_table.h"
+
+using namespace Genode;
+
+
+Cpu_sampler::Symbol_table::Symbol_table(Env &env, Allocator &alloc,
+                                        Rom_name const &rom_name)
+:
+	_rom_name(rom_name), _alloc(alloc), _rom(env, rom_name.string())
+{
+	char const * const base = _rom.local_addr<char const>();
+	size_t       const size = _rom.size();
+
+	/* return pointer to 'len' bytes at 'offset' within the ROM */
+	auto at = [&] (addr_t offset, size_t len) -> char const *
+	{
+		if (offset > size || len > size - offset)
+			throw Invalid_binary();
+		return base + offset;
+	};
+
+	Elf_Ehdr const &ehdr = *(Elf_Ehdr const *)at(0, sizeof(Elf_Ehdr));
+
+	if (memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0
+	 || ehdr.e_ident[EI_CLASS] != ELFCLASS
+	 || ehdr.e_shentsize != sizeof(Elf_Shdr))
+		throw Invalid_binary();
+
+	Elf_Shdr const * const shdr = (Elf_Shdr const *)
+		at(ehdr.e_shoff, ehdr.e_shnum*sizeof(Elf_Shdr));
+
+	/* prefer the complete symbol table over the dynamic one */
+	Elf_Shdr const *symtab = nullptr;
+	for (unsigned i = 0; i < ehdr.e_shnum; i++) {
+		if (shdr[i].sh_type == SHT_SYMTAB)
+			symtab = &shdr[i];
+		if (shdr[i].sh_type == SHT_DYNSYM && !symtab)
+			symtab = &shdr[i];
+	}
+
+	if (!symtab || symtab->sh_link >= ehdr.e_shnum)
+		throw Invalid_binary();
+
+	Elf_Shdr const &strtab = shdr[symtab->sh_link];
+
+	unsigned const num_syms = symtab->sh_size / sizeof(Elf_Sym);
+	Elf_Sym  const * const syms = (Elf_Sym const *)
+		at(symtab->sh_offset, num_syms*sizeof(Elf_Sym));
+	char const * const strings = at(strtab.sh_offset, strtab.sh_size);
+
+	auto for_each_function = [&] (auto const &fn)
+	{
+		for (unsigned i = 0; i < num_syms; i++) {
+			Elf_Sym const &sym = syms[i];
+			if (ELF_ST_TYPE(sym.st_info) != STT_FUNC || sym.st_shndx == SHN_UNDEF
+			 || !sym.st_value || sym.st_name >= strtab.sh_size)
+				continue;
+
+			/* skip names that are not terminated within the string table */
+			size_t end = sym.st_name;
+			while (end < strtab.sh_size && strings[end])
+				end++;
+
+			if (end < strtab.sh_size)
+				fn(sym, strings + sym.st_name);
+		}
+	};
+
+	for_each_function([&] (Elf_Sym const &, char const *) { _num_symbols++; });
+
+	if (!_num_symbols)
+		throw Invalid_binary();
+
+	_symbols = (Symbol *)_alloc.alloc(_num_symbols*sizeof(Symbol));
+
+	unsigned i = 0;
+	for_each_function([&] (Elf_Sym const &sym, char const *name) {
+		_symbols[i++] = Symbol { (addr_t)sym.st_value, (size_t)sym.st_size, name }; });
+
+	_sort();
+}
+
+
+Cpu_sampler::Symbol_table::~Symbol_table()
+{
+	_alloc.free(_symbols, _num_symbols*sizeof(Symbol));
+}
+
+
+void Cpu_sampler::Symbol_table::_sort()
+{
+	/* heap sort by address */
+	auto sift_down = [&] (unsigned root, unsigned end)
+	{
+		for (unsigned child; (child = 2*root + 1) < end; root = child) {
+
+			if (child + 1 < end && _symbols[child].addr < _symbols[child + 1].addr)
+				child++;
+
+			if (_symbols[root].addr >= _symbols[child].addr)
+				return;
+
+			Symbol const tmp = _symbols[root];
+			_symbols[root]  = _symbols[child];
+			_symbols[child] = tmp;
+		}
+	};
+
+	for (unsigned i = _num_symbols/2; i-- > 0; )
+		sift_down(i, _num_symbols);
+
+	for (unsigned end = _num_symbols; end-- > 1; ) {
+		Symbol const tmp = _symbols[0];
+		_symbols[0]   = _symbols[end];
+		_symbols[end] = tmp;
+		sift_down(0, end);
+	}
+}
+
+
+Cpu_sampler::Symbol_table::Symbol const *
+Cpu_sampler::Symbol_table::lookup(addr_t addr) const
+{
+	/* find last symbol starting at or below 'addr' */
+	unsigned lo = 0, hi = _num_symbols;
+	while (lo < hi) {
+		unsigned const mid = lo + (hi - lo)/2;
+		if (_symbols[mid].addr <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == 0)
+		return nullptr;
+
+	Symbol const &s = _symbols[lo - 1];
+
+	/* symbols without size extend up to the next symbol */
+	if (s.size ? addr - s.addr < s.size : lo < _num_symbols)
+		return &s;
+
+	return nullptr;
+}
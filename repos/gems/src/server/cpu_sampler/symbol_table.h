@@ -0,0 +1,90 @@
+/*
+ * \brief  Symbol table of an ELF binary obtained from ROM
+ * \author Christian Prochaska
+ * \date   2019-03-29
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _SYMBOL_TABLE_H_
+#define _SYMBOL_TABLE_H_
+
+/* Genode includes */
+#include <base/attached_rom_dataspace.h>
+#include <base/allocator.h>
+#include <util/list.h>
+
+namespace Cpu_sampler {
+	using namespace Genode;
+	class Symbol_table;
+}
+
+
+/**
+ * Function symbols of an ELF binary, sorted by address
+ *
+ * The symbols are taken from the '.symtab' section, or from the '.dynsym'
+ * section if the binary is stripped. The addresses are not relocated.
+ * Hence, only the symbols of binaries loaded at their link address, i.e.,
+ * the program binary but not the shared libraries, are resolved correctly.
+ */
+class Cpu_sampler::Symbol_table : public List<Symbol_table>::Element
+{
+	public:
+
+		typedef String<64> Rom_name;
+
+		struct Symbol
+		{
+			addr_t      addr;
+			size_t      size;
+			char const *name;   /* null-terminated, points into the ROM */
+		};
+
+		struct Invalid_binary : Exception { };
+
+	private:
+
+		Rom_name const         _rom_name;
+		Allocator             &_alloc;
+		Attached_rom_dataspace _rom;
+		unsigned               _num_symbols = 0;
+		Symbol                *_symbols     = nullptr;
+
+		void _sort();
+
+		/*
+		 * Noncopyable
+		 */
+		Symbol_table(Symbol_table const &);
+		Symbol_table &operator = (Symbol_table const &);
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \throw Invalid_binary
+		 * \throw Out_of_ram
+		 * \throw Out_of_caps
+		 */
+		Symbol_table(Env &env, Allocator &alloc, Rom_name const &rom_name);
+
+		~Symbol_table();
+
+		Rom_name const &rom_name() const { return _rom_name; }
+
+		unsigned num_symbols() const { return _num_symbols; }
+
+		/**
+		 * Return symbol containing the address or nullptr
+		 */
+		Symbol const *lookup(addr_t addr) const;
+};
+
+#endif /* _SYMBOL_TABLE_H_ */
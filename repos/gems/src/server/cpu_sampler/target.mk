@@ -2,7 +2,8 @@ TARGET  = cpu_sampler
 
 SRC_CC += main.cc \
           cpu_session_component.cc \
-          cpu_thread_component.cc
+          cpu_thread_component.cc \
+          symbol_table.cc
 
 INC_DIR = $(REP_DIR)/src/server/cpu_sampler
 
@@ -0,0 +1,38 @@
+/*
+ * \brief  Introspection of the libc's malloc implementation
+ * \author Norman Feske
+ * \date   2019-03-26
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _LIBC__INCLUDE__MALLOC_STATS_H_
+#define _LIBC__INCLUDE__MALLOC_STATS_H_
+
+#include <sys/cdefs.h>
+#include <stdio.h>
+
+__BEGIN_DECLS
+
+/**
+ * Print allocation statistics to the log
+ */
+void malloc_stats(void);
+
+/**
+ * Write allocation statistics as XML to 'stream'
+ *
+ * \param options  must be 0
+ *
+ * \return  0 on success, or -1 with errno set to EINVAL
+ */
+int malloc_info(int options, FILE *stream);
+
+__END_DECLS
+
+#endif /* _LIBC__INCLUDE__MALLOC_STATS_H_ */
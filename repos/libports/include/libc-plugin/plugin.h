@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2010-2017 Genode Labs GmbH
+ * Copyright (C) 2010-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -25,6 +25,7 @@
 #include <sys/poll.h>   /* for 'struct pollfd' */
 
 namespace Genode { class Env; }
+namespace Vfs    { class Vfs_handle; }
 
 namespace Libc {
 
@@ -79,6 +80,17 @@ namespace Libc {
 			 */
 			virtual void init(Genode::Env &env) { }
 
+			/**
+			 * Return VFS handle that signals the read readiness of 'fd'
+			 *
+			 * The handle is used to wait for the read readiness of the file
+			 * descriptor without polling the plugin. Plugins that cannot
+			 * provide such a handle return nullptr, which makes 'select',
+			 * 'poll', and 'kevent' fall back to polling.
+			 */
+			virtual Vfs::Vfs_handle *read_ready_handle(File_descriptor *fd) {
+				return nullptr; }
+
 			virtual File_descriptor *accept(File_descriptor *,
 			                                struct ::sockaddr *addr,
 			                                socklen_t *addrlen);
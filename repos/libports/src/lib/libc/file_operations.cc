@@ -43,6 +43,7 @@ extern "C" {
 #include "libc_mem_alloc.h"
 #include "libc_mmap_registry.h"
 #include "libc_errno.h"
+#include "readiness.h"
 
 using namespace Libc;
 
@@ -239,9 +240,11 @@ __SYS_(int, close, (int libc_fd),
 {
 	Libc::File_descriptor *fd =
 		Libc::file_descriptor_allocator()->find_by_libc_fd(libc_fd);
-	return (!fd || !fd->plugin)
-		? Libc::Errno(EBADF)
-		: fd->plugin->close(fd);
+	if (!fd || !fd->plugin)
+		return Libc::Errno(EBADF);
+
+	Libc::kqueue_fd_closed(libc_fd);
+	return fd->plugin->close(fd);
 })
 
 
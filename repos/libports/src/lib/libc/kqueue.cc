@@ -0,0 +1,551 @@
+/*
+ * \brief  kqueue() and kevent() implementation
+ * \author Christian Helmuth
+ * \date   2019-04-09
+ *
+ * The kqueue supports the 'EVFILT_READ' and 'EVFILT_WRITE' filters for file
+ * descriptors. Read filters of file descriptors with a VFS handle are driven
+ * by readiness notifications, so 'kevent' evaluates only the file
+ * descriptors that signalled their readiness or were reported as ready by
+ * the previous call. All other filters are polled on each call. As on BSD,
+ * closing a file descriptor removes its filters from all kqueues.
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/registry.h>
+#include <util/list.h>
+
+/* Libc includes */
+#include <libc-plugin/fd_alloc.h>
+#include <libc-plugin/plugin.h>
+#include <libc/allocator.h>
+#include <fcntl.h>
+#include <sys/event.h>
+#include <sys/poll.h>
+
+/* internal includes */
+#include "libc_errno.h"
+#include "libc_file.h"
+#include "task.h"
+#include "readiness.h"
+
+
+namespace Libc {
+	class Kqueue;
+	struct Kqueue_plugin;
+}
+
+
+static Libc::Allocator kqueue_alloc;
+
+
+class Libc::Kqueue : public Plugin_context
+{
+	private:
+
+		/*
+		 * Noncopyable
+		 */
+		Kqueue(Kqueue const &);
+		Kqueue &operator = (Kqueue const &);
+
+		struct Knote : Genode::List<Knote>::Element
+		{
+			int            const fd;
+			short          const filter;
+			unsigned short       flags;
+			unsigned             fflags;
+			void                *udata;
+
+			bool enabled = true;
+			bool watched = false;  /* readiness is signalled, not polled */
+			bool active  = false;  /* evaluated by the next 'kevent' */
+
+			Knote *next_active = nullptr;
+
+			Knote(struct kevent const &kev)
+			:
+				fd((int)kev.ident), filter(kev.filter),
+				flags(kev.flags), fflags(kev.fflags), udata(kev.udata)
+			{ }
+		};
+
+		enum { NUM_BUCKETS = 64 };
+
+		Genode::List<Knote> _knotes[NUM_BUCKETS];
+
+		Readiness_waiter _waiter { kqueue_alloc };
+
+		/* queue of knotes to evaluate */
+		Knote    *_first_active = nullptr;
+		Knote    *_last_active  = nullptr;
+		unsigned  _num_active   = 0;
+
+		Genode::List<Knote> &_bucket(int fd) {
+			return _knotes[(unsigned)fd % NUM_BUCKETS]; }
+
+		Knote *_lookup(int fd, short filter)
+		{
+			for (Knote *k = _bucket(fd).first(); k; k = k->next())
+				if (k->fd == fd && k->filter == filter)
+					return k;
+			return nullptr;
+		}
+
+		template <typename FN>
+		void _for_each_knote(FN const &fn)
+		{
+			for (unsigned i = 0; i < NUM_BUCKETS; i++)
+				for (Knote *k = _knotes[i].first(), *next = nullptr; k; k = next) {
+					next = k->next();
+					fn(*k);
+				}
+		}
+
+		void _activate(Knote &k)
+		{
+			if (k.active)
+				return;
+
+			k.active      = true;
+			k.next_active = nullptr;
+
+			if (_last_active)
+				_last_active->next_active = &k;
+			else
+				_first_active = &k;
+
+			_last_active = &k;
+			_num_active++;
+		}
+
+		Knote *_pop_active()
+		{
+			Knote *k = _first_active;
+			if (!k)
+				return nullptr;
+
+			_first_active = k->next_active;
+			if (!_first_active)
+				_last_active = nullptr;
+
+			k->active = false;
+			_num_active--;
+			return k;
+		}
+
+		void _deactivate(Knote &k)
+		{
+			if (!k.active)
+				return;
+
+			Knote *prev = nullptr;
+			for (Knote *a = _first_active; a; prev = a, a = a->next_active) {
+				if (a != &k)
+					continue;
+
+				if (prev) prev->next_active = a->next_active;
+				else      _first_active     = a->next_active;
+
+				if (_last_active == a)
+					_last_active = prev;
+
+				break;
+			}
+			k.active = false;
+			_num_active--;
+		}
+
+		void _destroy(Knote &k)
+		{
+			if (k.watched)
+				_waiter.unwatch((Genode::addr_t)&k);
+
+			_deactivate(k);
+			_bucket(k.fd).remove(&k);
+			destroy(kqueue_alloc, &k);
+		}
+
+		/**
+		 * Evaluate condition of knote via the plugin of its file descriptor
+		 *
+		 * \return  poll events, POLLNVAL if the file descriptor got closed
+		 */
+		static short _poll(Knote const &k)
+		{
+			File_descriptor *fdo =
+				file_descriptor_allocator()->find_by_libc_fd(k.fd);
+
+			if (!fdo || !fdo->plugin)
+				return POLLNVAL;
+
+			short const events = (k.filter == EVFILT_READ) ? POLLIN : POLLOUT;
+
+			pollfd pfd { k.fd, events, 0 };
+			fdo->plugin->poll(*fdo, pfd);
+			return pfd.revents;
+		}
+
+		/**
+		 * Apply one change of the change list
+		 *
+		 * \return  0 on success, or errno value
+		 */
+		int _apply(struct kevent const &kev)
+		{
+			if (kev.filter != EVFILT_READ && kev.filter != EVFILT_WRITE)
+				return EINVAL;
+
+			int const fd = (int)kev.ident;
+			Knote *k = _lookup(fd, kev.filter);
+
+			if (kev.flags & EV_DELETE) {
+				if (!k)
+					return ENOENT;
+
+				_destroy(*k);
+				return 0;
+			}
+
+			if (!k && !(kev.flags & EV_ADD))
+				return ENOENT;
+
+			if (!k) {
+				if (!file_descriptor_allocator()->find_by_libc_fd(fd))
+					return EBADF;
+
+				k = new (kqueue_alloc) Knote(kev);
+				_bucket(fd).insert(k);
+
+				if (kev.filter == EVFILT_READ)
+					k->watched = _waiter.watch(fd, (Genode::addr_t)k);
+			}
+
+			k->flags  = kev.flags & ~(EV_ADD | EV_ENABLE | EV_DISABLE | EV_RECEIPT);
+			k->fflags = kev.fflags;
+			k->udata  = kev.udata;
+
+			if (kev.flags & EV_DISABLE)
+				k->enabled = false;
+
+			if (kev.flags & (EV_ENABLE | EV_ADD) && !(kev.flags & EV_DISABLE))
+				k->enabled = true;
+
+			/* evaluate the condition on the next 'kevent' */
+			if (k->enabled)
+				_activate(*k);
+
+			return 0;
+		}
+
+	public:
+
+		Kqueue() { }
+
+		~Kqueue() { _for_each_knote([&] (Knote &k) { _destroy(k); }); }
+
+		/**
+		 * Remove all knotes of 'fd'
+		 */
+		void remove(int fd)
+		{
+			for (Knote *k = _bucket(fd).first(), *next = nullptr; k; k = next) {
+				next = k->next();
+				if (k->fd == fd)
+					_destroy(*k);
+			}
+		}
+
+		/**
+		 * Apply change list
+		 *
+		 * Errors are reported as 'EV_ERROR' events if there is space in the
+		 * event list, otherwise the call fails.
+		 *
+		 * \return  number of error events, or -1
+		 */
+		int apply(struct kevent const *changes, int nchanges,
+		          struct kevent *events, int nevents)
+		{
+			int n = 0;
+
+			for (int i = 0; i < nchanges; i++) {
+
+				int const error = _apply(changes[i]);
+
+				if (!error && !(changes[i].flags & EV_RECEIPT))
+					continue;
+
+				if (n == nevents) {
+					if (error)
+						return Errno(error);
+					continue;
+				}
+
+				events[n]       = changes[i];
+				events[n].flags = EV_ERROR;
+				events[n].data  = error;
+				n++;
+			}
+			return n;
+		}
+
+		/**
+		 * Collect ready knotes into 'events'
+		 *
+		 * Only the active knotes are evaluated. Knotes stay active as long
+		 * as they are ready, i.e., all filters are level triggered and
+		 * 'EV_CLEAR' is not supported. Watched knotes that are not ready
+		 * are deactivated until they signal their readiness again, polled
+		 * knotes stay active.
+		 *
+		 * \return  number of collected events
+		 */
+		int collect(struct kevent *events, int nevents)
+		{
+			if (_waiter.rescan_requested())
+				_for_each_knote([&] (Knote &k) { if (k.enabled) _activate(k); });
+
+			_waiter.for_each_ready([&] (int, Genode::addr_t tag) {
+				Knote &k = *(Knote *)tag;
+				if (k.enabled)
+					_activate(k);
+			});
+
+			int n = 0;
+
+			for (unsigned i = _num_active; i > 0 && n < nevents; i--) {
+
+				Knote &k = *_pop_active();
+				if (!k.enabled)
+					continue;
+
+				short const revents = _poll(k);
+
+				/* file descriptor got closed */
+				if (revents & POLLNVAL) {
+					_destroy(k);
+					continue;
+				}
+
+				if (!(revents & (POLLIN | POLLOUT | POLLHUP))) {
+					if (!k.watched)
+						_activate(k);
+					continue;
+				}
+
+				struct kevent &ev = events[n++];
+
+				ev.ident  = k.fd;
+				ev.filter = k.filter;
+				ev.flags  = k.flags | ((revents & POLLHUP) ? EV_EOF : 0);
+				ev.fflags = 0;
+				ev.data   = 0;
+				ev.udata  = k.udata;
+
+				if (k.flags & EV_ONESHOT) {
+					_destroy(k);
+					continue;
+				}
+
+				if (k.flags & EV_DISPATCH)
+					k.enabled = false;
+
+				/*
+				 * Keep the knote active until it is found not ready. Only
+				 * then, the notification of its VFS handle is re-armed.
+				 */
+				if (k.enabled)
+					_activate(k);
+			}
+
+			return n;
+		}
+
+		/**
+		 * Return true if 'collect' may find events
+		 */
+		bool pending() const { return _num_active || _waiter.ready(); }
+};
+
+
+typedef Genode::Registered<Libc::Kqueue> Registered_kqueue;
+
+
+/**
+ * All kqueues, consulted on the close of a file descriptor
+ */
+static Genode::Registry<Registered_kqueue> &kqueues()
+{
+	static Genode::Registry<Registered_kqueue> inst;
+	return inst;
+}
+
+
+struct Libc::Kqueue_plugin : Plugin
+{
+	bool supports_poll() override { return true; }
+
+	bool poll(File_descriptor &fdo, struct pollfd &pfd) override
+	{
+		if (fdo.plugin != this) return false;
+
+		Kqueue *kq = dynamic_cast<Kqueue *>(fdo.context);
+		if (!kq) {
+			pfd.revents |= POLLNVAL;
+			return true;
+		}
+
+		/* a kqueue is readable if events may be pending */
+		if ((pfd.events & POLLIN) && kq->pending()) {
+			pfd.revents |= POLLIN;
+			return true;
+		}
+		return false;
+	}
+
+	int fcntl(File_descriptor *fdo, int cmd, long arg) override
+	{
+		switch (cmd) {
+		case F_GETFD: return fdo->cloexec ? FD_CLOEXEC : 0;
+		case F_SETFD: fdo->cloexec = arg == FD_CLOEXEC; return 0;
+		case F_GETFL: return fdo->flags;
+		case F_SETFL: fdo->flags = arg; return 0;
+		default: break;
+		}
+		return Errno(EINVAL);
+	}
+
+	int close(File_descriptor *fdo) override
+	{
+		Registered_kqueue *kq = dynamic_cast<Registered_kqueue *>(fdo->context);
+		if (!kq) return Errno(EBADF);
+
+		Genode::destroy(kqueue_alloc, kq);
+		file_descriptor_allocator()->free(fdo);
+		return 0;
+	}
+};
+
+
+static Libc::Kqueue_plugin &kqueue_plugin()
+{
+	static Libc::Kqueue_plugin inst;
+	return inst;
+}
+
+
+void Libc::kqueue_fd_closed(int fd)
+{
+	kqueues().for_each([&] (Kqueue &kq) { kq.remove(fd); });
+}
+
+
+extern "C" __attribute__((weak))
+int kqueue(void)
+{
+	using namespace Libc;
+
+	Registered_kqueue *kq = new (kqueue_alloc) Registered_kqueue(kqueues());
+
+	File_descriptor *fdo =
+		file_descriptor_allocator()->alloc(&kqueue_plugin(), kq);
+
+	if (!fdo) {
+		Genode::destroy(kqueue_alloc, kq);
+		return Errno(EMFILE);
+	}
+	return fdo->libc_fd;
+}
+
+
+extern "C" __attribute__((weak, alias("kqueue")))
+int __sys_kqueue(void);
+
+
+extern "C" __attribute__((weak, alias("kqueue")))
+int _kqueue(void);
+
+
+extern "C" __attribute__((weak))
+int kevent(int libc_fd,
+           struct kevent const *changelist, int nchanges,
+           struct kevent *eventlist, int nevents,
+           struct timespec const *timeout)
+{
+	using namespace Libc;
+
+	File_descriptor *fdo = libc_fd_to_fd(libc_fd, "kevent");
+	if (!fdo || fdo->plugin != &kqueue_plugin())
+		return Errno(EBADF);
+
+	Kqueue *kq = dynamic_cast<Kqueue *>(fdo->context);
+	if (!kq)
+		return Errno(EBADF);
+
+	if (nchanges < 0 || nevents < 0)
+		return Errno(EINVAL);
+
+	int const nerrors = kq->apply(changelist, nchanges, eventlist, nevents);
+	if (nerrors != 0)
+		return nerrors;
+
+	if (nevents == 0)
+		return 0;
+
+	struct Check : Suspend_functor
+	{
+		Kqueue        &_kq;
+		struct kevent *_events;
+		int     const  _nevents;
+
+		int nready { 0 };
+
+		Check(Kqueue &kq, struct kevent *events, int nevents)
+		: _kq(kq), _events(events), _nevents(nevents) { }
+
+		bool suspend() override
+		{
+			if (_kq.pending())
+				nready = _kq.collect(_events, _nevents);
+
+			return nready == 0;
+		}
+
+	} check (*kq, eventlist, nevents);
+
+	if (!check.suspend())
+		return check.nready;
+
+	if (!timeout) {
+		while (check.nready == 0)
+			Libc::suspend(check, 0);
+		return check.nready;
+	}
+
+	/* round up to milliseconds, a zero timeout must not block */
+	Genode::uint64_t remaining_ms = (Genode::uint64_t)timeout->tv_sec*1000
+	                              + (timeout->tv_nsec + 999999)/1000000;
+
+	while (check.nready == 0 && remaining_ms > 0)
+		remaining_ms = Libc::suspend(check, remaining_ms);
+
+	return check.nready;
+}
+
+
+extern "C" __attribute__((weak, alias("kevent")))
+int __sys_kevent(int, struct kevent const *, int, struct kevent *, int,
+                 struct timespec const *);
+
+
+extern "C" __attribute__((weak, alias("kevent")))
+int _kevent(int, struct kevent const *, int, struct kevent *, int,
+            struct timespec const *);
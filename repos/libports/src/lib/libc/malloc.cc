@@ -6,7 +6,7 @@
  */
 
 /*
- * Copyright (C) 2006-2017 Genode Labs GmbH
+ * Copyright (C) 2006-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -16,6 +16,7 @@
 #include <base/env.h>
 #include <base/log.h>
 #include <base/slab.h>
+#include <base/thread.h>
 #include <util/construct_at.h>
 #include <util/string.h>
 #include <util/misc_math.h>
@@ -24,6 +25,9 @@
 extern "C" {
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <malloc_stats.h>
 }
 
 /* libc-internal includes */
@@ -66,6 +70,18 @@ namespace Genode {
 
 /**
  * Allocator that uses slabs for small objects sizes
+ *
+ * Small allocations are served from slabs of fine-grained size classes.
+ * Each power-of-two range is split into four classes, which limits the
+ * internal fragmentation to 25% instead of 50% with power-of-two slabs.
+ *
+ * To reduce the lock contention of multi-threaded programs, the slabs are
+ * striped across a fixed number of caches, each protected by its own lock.
+ * These are not per-thread caches. A thread allocates from the cache
+ * selected by a hash of its 'Thread' object, so threads whose hashes
+ * collide share a cache and its lock. Because a block has to be returned
+ * to the slab it was allocated from, the cache index is recorded in the
+ * metadata of each allocation.
  */
 class Malloc
 {
@@ -75,25 +91,33 @@ class Malloc
 		typedef Genode::addr_t addr_t;
 
 		enum {
-			SLAB_START = 5,  /* 32 bytes (log2) */
-			SLAB_STOP  = 11, /* 2048 bytes (log2) */
-			NUM_SLABS  = (SLAB_STOP - SLAB_START) + 1
+			SLAB_START  = 5,  /* 32 bytes (log2) */
+			SLAB_STOP   = 11, /* 2048 bytes (log2) */
+			CLASS_STEPS = 4,  /* size classes per power of two */
+			NUM_CLASSES = (SLAB_STOP - SLAB_START) * CLASS_STEPS + 1,
+			CACHE_BITS  = 3,
+			NUM_CACHES  = 1 << CACHE_BITS,
 		};
 
 		struct Metadata
 		{
-			unsigned long long value; /* bits 63..5 size and 4..0 offset */
+			unsigned long long value; /* bits 63..8 size, 7..5 cache and 4..0 offset */
 
 			/**
 			 * Allocation metadata
 			 *
 			 * \param size    allocation size
+			 * \param cache   index of cache that holds the allocation
 			 * \param offset  offset of pointer from allocation
 			 */
-			Metadata(size_t size, unsigned offset)
-			: value(((unsigned long long)size << 5) | (offset & 0x1f)) { }
+			Metadata(size_t size, unsigned cache, unsigned offset)
+			:
+				value(((unsigned long long)size << 8) |
+				      ((cache & (NUM_CACHES - 1)) << 5) | (offset & 0x1f))
+			{ }
 
-			size_t   size()   const { return value >> 5; }
+			size_t   size()   const { return value >> 8; }
+			unsigned cache()  const { return (value >> 5) & (NUM_CACHES - 1); }
 			unsigned offset() const { return value & 0x1f; }
 		};
 
@@ -112,35 +136,110 @@ class Malloc
 		 */
 		static constexpr size_t _room() { return sizeof(Metadata) + 15; }
 
-		Genode::Allocator  &_backing_store;        /* back-end allocator */
-		Genode::Slab_alloc *_allocator[NUM_SLABS]; /* slab allocators */
-		Genode::Lock        _lock;
-
-		unsigned _slab_log2(size_t size) const
+		/**
+		 * Return size class of an allocation of 'size' bytes
+		 *
+		 * Class 0 holds 32 bytes. Each following power-of-two range
+		 * (2^k, 2^(k+1)] is split into 'CLASS_STEPS' classes of equal
+		 * distance.
+		 */
+		static unsigned _size_class(size_t size)
 		{
-			unsigned msb = Genode::log2(size);
+			if (size <= (1U << SLAB_START))
+				return 0;
+
+			unsigned const k    = Genode::log2(size - 1);
+			size_t   const step = 1UL << (k - 2);
 
-			/* size is greater than msb */
-			if (size > (1U << msb))
-				msb++;
+			return (k - SLAB_START) * CLASS_STEPS + (size - 1 - (1UL << k)) / step + 1;
+		}
 
-			/* use smallest slab */
-			if (size < (1U << SLAB_START))
-				msb = SLAB_START;
+		static size_t _class_size(unsigned size_class)
+		{
+			if (size_class == 0)
+				return 1U << SLAB_START;
 
-			return msb;
+			unsigned const k = SLAB_START + (size_class - 1) / CLASS_STEPS;
+			unsigned const i = (size_class - 1) % CLASS_STEPS;
+
+			return (1UL << k) + (i + 1) * (1UL << (k - 2));
 		}
 
-	public:
+		static bool _slab_sized(size_t size) { return size <= (1U << SLAB_STOP); }
 
-		Malloc(Genode::Allocator &backing_store) : _backing_store(backing_store)
+		struct Cache
+		{
+			Genode::Lock        lock { };
+			Genode::Slab_alloc *slabs[NUM_CLASSES] { };
+
+			/* statistics */
+			unsigned long allocs[NUM_CLASSES] { };
+			unsigned long frees[NUM_CLASSES]  { };
+		};
+
+		Genode::Allocator &_backing_store;        /* back-end allocator */
+		Cache              _caches[NUM_CACHES];
+
+		/* statistics of large allocations taken from the backing store */
+		Genode::Lock  _large_lock   { };
+		unsigned long _large_allocs { 0 };
+		unsigned long _large_frees  { 0 };
+		size_t        _large_bytes  { 0 };
+
+		/**
+		 * Return index of the cache stripe selected for the calling thread
+		 */
+		static unsigned _cache_index()
+		{
+			/* Fibonacci hashing of the address of the thread object */
+			Genode::uint64_t const id = (addr_t)Genode::Thread::myself();
+			return (unsigned)((id * 0x9e3779b97f4a7c15ULL) >> (64 - CACHE_BITS));
+		}
+
+		/**
+		 * Return slab of size class, construct it on demand
+		 *
+		 * Must be called with the lock of 'cache' held.
+		 */
+		Genode::Slab_alloc *_slab(Cache &cache, unsigned size_class)
 		{
-			for (unsigned i = SLAB_START; i <= SLAB_STOP; i++) {
-				_allocator[i - SLAB_START] =
-					new (backing_store) Genode::Slab_alloc(1U << i, &backing_store);
+			Genode::Slab_alloc *&slab = cache.slabs[size_class];
+			if (!slab) {
+				try {
+					slab = new (_backing_store)
+						Genode::Slab_alloc(_class_size(size_class), &_backing_store);
+				}
+				catch (Genode::Out_of_ram)  { return nullptr; }
+				catch (Genode::Out_of_caps) { return nullptr; }
 			}
+			return slab;
 		}
 
+		void *_alloc_large(size_t size)
+		{
+			void *alloc_addr = nullptr;
+			if (!_backing_store.alloc(size, &alloc_addr))
+				return nullptr;
+
+			Genode::Lock::Guard lock_guard(_large_lock);
+			_large_allocs++;
+			_large_bytes += size;
+			return alloc_addr;
+		}
+
+		void _free_large(void *alloc_addr, size_t size)
+		{
+			_backing_store.free(alloc_addr, size);
+
+			Genode::Lock::Guard lock_guard(_large_lock);
+			_large_frees++;
+			_large_bytes -= size;
+		}
+
+	public:
+
+		Malloc(Genode::Allocator &backing_store) : _backing_store(backing_store) { }
+
 		~Malloc() { Genode::warning(__func__, " unexpectedly called"); }
 
 		/**
@@ -149,18 +248,28 @@ class Malloc
 
 		void * alloc(size_t size)
 		{
-			Genode::Lock::Guard lock_guard(_lock);
+			size_t const real_size   = size + _room();
+			unsigned     cache_index = 0;
+			void        *alloc_addr  = nullptr;
+
+			/* use backing store if requested memory is larger than largest slab */
+			if (!_slab_sized(real_size)) {
+				alloc_addr = _alloc_large(real_size);
 
-			size_t   const real_size = size + _room();
-			unsigned const msb       = _slab_log2(real_size);
+			} else {
+				unsigned const size_class = _size_class(real_size);
 
-			void *alloc_addr = nullptr;
+				cache_index = _cache_index();
+				Cache &cache = _caches[cache_index];
 
-			/* use backing store if requested memory is larger than largest slab */
-			if (msb > SLAB_STOP)
-				_backing_store.alloc(real_size, &alloc_addr);
-			else
-				alloc_addr = _allocator[msb - SLAB_START]->alloc();
+				Genode::Lock::Guard lock_guard(cache.lock);
+
+				if (Genode::Slab_alloc *slab = _slab(cache, size_class))
+					alloc_addr = slab->alloc();
+
+				if (alloc_addr)
+					cache.allocs[size_class]++;
+			}
 
 			if (!alloc_addr) return nullptr;
 
@@ -170,7 +279,7 @@ class Malloc
 
 			unsigned const offset = (addr_t)aligned_addr - (addr_t)alloc_addr;
 
-			*(aligned_addr - 1) = Metadata(real_size, offset);
+			*(aligned_addr - 1) = Metadata(real_size, cache_index, offset);
 
 			return aligned_addr;
 		}
@@ -200,20 +309,99 @@ class Malloc
 
 		void free(void *ptr)
 		{
-			Genode::Lock::Guard lock_guard(_lock);
-
 			Metadata *md = (Metadata *)ptr - 1;
 
-			size_t   const  real_size  = md->size();
-			unsigned const  msb        = _slab_log2(real_size);
+			size_t const real_size  = md->size();
+			void * const alloc_addr = (void *)((addr_t)ptr - md->offset());
 
-			void *alloc_addr = (void *)((addr_t)ptr - md->offset());
+			if (!_slab_sized(real_size)) {
+				_free_large(alloc_addr, real_size);
+				return;
+			}
 
-			if (msb > SLAB_STOP) {
-				_backing_store.free(alloc_addr, real_size);
-			} else {
-				_allocator[msb - SLAB_START]->free(alloc_addr);
+			unsigned const size_class = _size_class(real_size);
+
+			Cache &cache = _caches[md->cache()];
+
+			Genode::Lock::Guard lock_guard(cache.lock);
+
+			cache.slabs[size_class]->free(alloc_addr);
+			cache.frees[size_class]++;
+		}
+
+		struct Stats
+		{
+			size_t        size;     /* size of size class, 0 for large */
+			unsigned long allocs;
+			unsigned long in_use;
+			size_t        bytes;    /* slab memory or large-block bytes */
+		};
+
+		/**
+		 * Call 'fn' with the statistics of each used size class and,
+		 * finally, with the statistics of the large allocations
+		 *
+		 * The function 'fn' is called without holding any lock. So it may
+		 * allocate memory, e.g., by using stdio.
+		 */
+		template <typename FN>
+		void for_each_stats(FN const &fn)
+		{
+			for (unsigned c = 0; c < NUM_CLASSES; c++) {
+
+				Stats stats { _class_size(c), 0, 0, 0 };
+
+				for (Cache &cache : _caches) {
+					Genode::Lock::Guard lock_guard(cache.lock);
+
+					stats.allocs += cache.allocs[c];
+					stats.in_use += cache.allocs[c] - cache.frees[c];
+					if (cache.slabs[c])
+						stats.bytes += cache.slabs[c]->consumed();
+				}
+
+				if (stats.allocs)
+					fn(stats);
 			}
+
+			Stats large { 0, 0, 0, 0 };
+			{
+				Genode::Lock::Guard lock_guard(_large_lock);
+
+				large.allocs = _large_allocs;
+				large.in_use = _large_allocs - _large_frees;
+				large.bytes  = _large_bytes;
+			}
+			fn(large);
+		}
+
+		/**
+		 * Print allocation statistics to the log
+		 */
+		void print_stats()
+		{
+			Genode::log("malloc statistics:");
+
+			size_t total_consumed = 0;
+
+			for_each_stats([&] (Stats const &stats) {
+
+				if (stats.size == 0) {
+					Genode::log("  large: allocs=", stats.allocs, " "
+					            "in_use=", stats.in_use, " "
+					            "bytes=", stats.bytes);
+					return;
+				}
+
+				total_consumed += stats.bytes;
+
+				Genode::log("  class ", stats.size, ": "
+				            "allocs=",    stats.allocs, " "
+				            "in_use=",    stats.in_use, " "
+				            "consumed=",  stats.bytes);
+			});
+
+			Genode::log("  slab memory consumed: ", total_consumed);
 		}
 };
 
@@ -255,6 +443,58 @@ extern "C" void *realloc(void *ptr, size_t size)
 }
 
 
+/**
+ * Print allocation statistics
+ *
+ * The function is modeled after the GNU libc extension of the same name.
+ */
+extern "C" void malloc_stats(void)
+{
+	if (mallocator) mallocator->print_stats();
+}
+
+
+/**
+ * Write allocation statistics as XML to 'stream'
+ *
+ * The function is modeled after the GNU libc extension of the same name.
+ * It allows for the inspection of the statistics via a file of the VFS.
+ */
+extern "C" int malloc_info(int options, FILE *stream)
+{
+	if (options != 0 || !stream) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	fprintf(stream, "<malloc>\n");
+
+	if (mallocator) {
+		size_t total_consumed = 0;
+
+		mallocator->for_each_stats([&] (Malloc::Stats const &stats) {
+
+			if (stats.size == 0) {
+				fprintf(stream, "\t<large allocs=\"%lu\" in_use=\"%lu\" bytes=\"%zu\"/>\n",
+				        stats.allocs, stats.in_use, stats.bytes);
+				return;
+			}
+
+			total_consumed += stats.bytes;
+
+			fprintf(stream, "\t<class size=\"%zu\" allocs=\"%lu\" in_use=\"%lu\" "
+			        "consumed=\"%zu\"/>\n",
+			        stats.size, stats.allocs, stats.in_use, stats.bytes);
+		});
+
+		fprintf(stream, "\t<slabs consumed=\"%zu\"/>\n", total_consumed);
+	}
+
+	fprintf(stream, "</malloc>\n");
+	return 0;
+}
+
+
 void Libc::init_malloc(Genode::Allocator &heap)
 {
 	mallocator = unmanaged_singleton<Malloc>(heap);
@@ -12,15 +12,24 @@
  * under the terms of the GNU Affero General Public License version 3.
  */
 
+/* Genode includes */
+#include <util/reconstructible.h>
+
 /* Libc includes */
 #include <libc-plugin/plugin_registry.h>
 #include <libc-plugin/plugin.h>
+#include <libc/allocator.h>
 #include <sys/poll.h>
 
 /* internal includes */
 #include "libc_errno.h"
 #include "libc_file.h"
 #include "task.h"
+#include "readiness.h"
+
+
+/** Allocator for the readiness watches of waiting tasks */
+static Libc::Allocator poll_watch_alloc;
 
 
 extern "C" __attribute__((weak))
@@ -37,11 +46,71 @@ int poll(struct pollfd fds[], nfds_t nfds, int timeout_ms)
 
 		int nready { 0 };
 
+		/*
+		 * Watches for the read readiness of the fds, not constructed if
+		 * the fds must be polled
+		 */
+		Genode::Constructible<Readiness_waiter> _waiter { };
+
 		Check(struct pollfd fds[], nfds_t nfds)
 		: _fds(fds), _nfds(nfds) { }
 
+		/**
+		 * Register readiness watches for all fds of interest
+		 *
+		 * Only read readiness is signalled by the VFS. Hence, the fds are
+		 * polled if any other condition is of interest.
+		 */
+		void watch()
+		{
+			enum { POLLIN_MASK = POLLIN | POLLRDNORM | POLLRDBAND | POLLPRI };
+
+			for (unsigned i = 0; i < _nfds; ++i)
+				if (_fds[i].events & ~POLLIN_MASK)
+					return;
+
+			_waiter.construct(poll_watch_alloc);
+
+			for (unsigned i = 0; i < _nfds; ++i) {
+				if (!_fds[i].events)
+					continue;
+
+				if (!_waiter->watch(_fds[i].fd, i)) {
+					_waiter.destruct();
+					return;
+				}
+			}
+		}
+
+		/**
+		 * Evaluate the fds that signalled their read readiness
+		 */
+		bool _suspend_watched()
+		{
+			_waiter->for_each_ready([&] (int, Genode::addr_t i) {
+
+				pollfd &pfd = _fds[i];
+				if (pfd.revents)
+					return;
+
+				File_descriptor *libc_fd = libc_fd_to_fd(pfd.fd, "poll");
+				if (!libc_fd) {
+					pfd.revents |= POLLNVAL;
+					++nready;
+					return;
+				}
+
+				nready += libc_fd->plugin->poll(*libc_fd, pfd);
+			});
+
+			return nready == 0;
+		}
+
 		bool suspend() override
 		{
+			if (_waiter.constructed() && !_waiter->rescan_requested())
+				return _suspend_watched();
+
 			bool polling = false;
 
 			for (unsigned i = 0; i < _nfds; ++i)
@@ -70,10 +139,12 @@ int poll(struct pollfd fds[], nfds_t nfds, int timeout_ms)
 
 	check.suspend();
 
-	if (timeout_ms == 0) {
+	if (timeout_ms == 0 || check.nready) {
 		return check.nready;
 	}
 
+	check.watch();
+
 	if (timeout_ms == -1) {
 		while (check.nready == 0) {
 			Libc::suspend(check, 0);
@@ -0,0 +1,223 @@
+/*
+ * \brief  Read-readiness notification of VFS handles
+ * \author Christian Helmuth
+ * \date   2019-04-09
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/lock.h>
+
+/* libc plugin interface */
+#include <libc-plugin/fd_alloc.h>
+#include <libc-plugin/plugin.h>
+
+/* local includes */
+#include "readiness.h"
+
+using namespace Libc;
+
+typedef Readiness_waiter::Watch Watch;
+
+
+namespace {
+
+	/**
+	 * Watches of all waiters, hashed by the VFS handle
+	 */
+	struct Registry
+	{
+		enum { NUM_BUCKETS = 256 };
+
+		Genode::Lock        lock { };
+		Genode::List<Watch> buckets[NUM_BUCKETS];
+		unsigned            rescan_epoch = 0;
+
+		Genode::List<Watch> &bucket(void const *handle)
+		{
+			Genode::addr_t const a = (Genode::addr_t)handle;
+			return buckets[((a >> 4) ^ (a >> 12)) % NUM_BUCKETS];
+		}
+	};
+}
+
+
+static Registry registry;
+
+
+void Libc::readiness_notify(Vfs::Vfs_handle &handle)
+{
+	Genode::Lock::Guard guard(registry.lock);
+
+	bool matched = false;
+	for (Watch *w = registry.bucket(&handle).first(); w; w = w->next()) {
+		if (w->handle == &handle) {
+			w->waiter._enqueue(*w);
+			matched = true;
+		}
+	}
+
+	/*
+	 * The handle may not be the one obtained via 'read_ready_handle', e.g.,
+	 * if a file system does not report the readiness of a wrapped handle at
+	 * the handle it hands out. Rescan to not lose the wakeup.
+	 */
+	if (!matched)
+		registry.rescan_epoch++;
+}
+
+
+void Libc::readiness_rescan()
+{
+	Genode::Lock::Guard guard(registry.lock);
+
+	registry.rescan_epoch++;
+}
+
+
+Vfs::Vfs_handle *Libc::read_ready_handle(File_descriptor *fd)
+{
+	return (fd && fd->plugin) ? fd->plugin->read_ready_handle(fd) : nullptr;
+}
+
+
+void Readiness_waiter::_enqueue(Watch &watch)
+{
+	if (watch.queued)
+		return;
+
+	watch.queued     = true;
+	watch.next_ready = nullptr;
+
+	if (_last_ready)
+		_last_ready->next_ready = &watch;
+	else
+		_first_ready = &watch;
+
+	_last_ready = &watch;
+	_num_ready++;
+}
+
+
+bool Readiness_waiter::_dequeue(int &fd, Genode::addr_t &tag)
+{
+	Genode::Lock::Guard guard(registry.lock);
+
+	Watch *w = _first_ready;
+	if (!w)
+		return false;
+
+	_first_ready = w->next_ready;
+	if (!_first_ready)
+		_last_ready = nullptr;
+
+	w->queued = false;
+	_num_ready--;
+
+	fd  = w->fd;
+	tag = w->tag;
+	return true;
+}
+
+
+/*
+ * A readiness response that occurs after the caller evaluated the file
+ * descriptors but before the watches are registered is not queued at the
+ * waiter. Hence, the first evaluation after the registration is a rescan.
+ */
+Readiness_waiter::Readiness_waiter(Genode::Allocator &alloc)
+:
+	_alloc(alloc), _rescan_epoch(registry.rescan_epoch - 1)
+{ }
+
+
+Readiness_waiter::~Readiness_waiter()
+{
+	Genode::Lock::Guard guard(registry.lock);
+
+	while (Watch *w = _watches) {
+		_watches = w->next_of_waiter;
+		registry.bucket(w->handle).remove(w);
+		destroy(_alloc, w);
+	}
+}
+
+
+bool Readiness_waiter::watch(int fd, Genode::addr_t tag)
+{
+	Vfs::Vfs_handle const *handle =
+		read_ready_handle(file_descriptor_allocator()->find_by_libc_fd(fd));
+
+	if (!handle)
+		return false;
+
+	Watch *w = new (_alloc) Watch(*this, handle, fd, tag);
+
+	Genode::Lock::Guard guard(registry.lock);
+
+	registry.bucket(handle).insert(w);
+	w->next_of_waiter = _watches;
+	_watches = w;
+
+	return true;
+}
+
+
+void Readiness_waiter::unwatch(Genode::addr_t tag)
+{
+	Genode::Lock::Guard guard(registry.lock);
+
+	for (Watch **w = &_watches; *w; ) {
+
+		Watch &watch = **w;
+		if (watch.tag != tag) {
+			w = &watch.next_of_waiter;
+			continue;
+		}
+
+		*w = watch.next_of_waiter;
+		registry.bucket(watch.handle).remove(&watch);
+
+		/* remove watch from ready list */
+		if (watch.queued) {
+			Watch *prev = nullptr;
+			for (Watch *r = _first_ready; r; prev = r, r = r->next_ready) {
+				if (r != &watch)
+					continue;
+
+				if (prev) prev->next_ready = r->next_ready;
+				else      _first_ready     = r->next_ready;
+
+				if (_last_ready == r)
+					_last_ready = prev;
+
+				_num_ready--;
+				break;
+			}
+		}
+
+		destroy(_alloc, &watch);
+	}
+}
+
+
+bool Readiness_waiter::ready() const
+{
+	return _num_ready || _rescan_epoch != registry.rescan_epoch;
+}
+
+
+bool Readiness_waiter::rescan_requested()
+{
+	Genode::Lock::Guard guard(registry.lock);
+
+	bool const requested = (_rescan_epoch != registry.rescan_epoch);
+	_rescan_epoch = registry.rescan_epoch;
+	return requested;
+}
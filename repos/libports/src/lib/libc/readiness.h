@@ -0,0 +1,168 @@
+/*
+ * \brief  Read-readiness notification of VFS handles
+ * \author Christian Helmuth
+ * \date   2019-04-09
+ *
+ * The waiting 'select', 'poll', and 'kevent' calls register a watch for each
+ * file descriptor of interest. When a VFS plugin signals the read readiness
+ * of a handle, the watches of the handle are queued at their waiters. Hence,
+ * a woken-up waiter evaluates only the file descriptors that became ready
+ * instead of polling all plugins for all file descriptors.
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _LIBC__READINESS_H_
+#define _LIBC__READINESS_H_
+
+/* Genode includes */
+#include <util/list.h>
+#include <util/noncopyable.h>
+#include <base/allocator.h>
+
+namespace Vfs { class Vfs_handle; }
+
+namespace Libc {
+
+	class File_descriptor;
+	class Readiness_waiter;
+
+	/**
+	 * Queue the watches of 'handle' at their waiters
+	 *
+	 * Called by the libc kernel on the read-ready response of a VFS handle.
+	 * If no watch matches the handle, all watches are re-evaluated.
+	 */
+	void readiness_notify(Vfs::Vfs_handle &handle);
+
+	/**
+	 * Request the re-evaluation of all watched file descriptors
+	 *
+	 * This is the fallback for read-ready responses that cannot be
+	 * attributed to a handle and for failed notification requests.
+	 */
+	void readiness_rescan();
+
+	/**
+	 * Return VFS handle signalling the read readiness of 'fd' or nullptr
+	 */
+	Vfs::Vfs_handle *read_ready_handle(File_descriptor *fd);
+
+	/**
+	 * Remove the kqueue filters of 'fd'
+	 *
+	 * Called by 'close' before the file descriptor gets released. So a
+	 * filter never refers to a closed or re-used file descriptor.
+	 */
+	void kqueue_fd_closed(int fd);
+}
+
+
+class Libc::Readiness_waiter : Genode::Noncopyable
+{
+	public:
+
+		/**
+		 * Watch for the read readiness of one file descriptor
+		 */
+		struct Watch : Genode::List<Watch>::Element
+		{
+			Readiness_waiter     &waiter;
+			void           const *handle;  /* key only, never dereferenced */
+			int            const  fd;
+			Genode::addr_t const  tag;     /* defined by the user of the waiter */
+
+			Watch *next_of_waiter = nullptr;
+			Watch *next_ready     = nullptr;
+			bool   queued         = false;
+
+			Watch(Readiness_waiter &waiter, void const *handle,
+			      int fd, Genode::addr_t tag)
+			: waiter(waiter), handle(handle), fd(fd), tag(tag) { }
+		};
+
+	private:
+
+		Genode::Allocator &_alloc;
+
+		Watch *_watches     = nullptr;
+		Watch *_first_ready = nullptr;
+		Watch *_last_ready  = nullptr;
+
+		unsigned _num_ready = 0;
+		unsigned _rescan_epoch;
+
+		friend void Libc::readiness_notify(Vfs::Vfs_handle &);
+
+		/**
+		 * Append watch to the ready list, must be called with registry lock
+		 */
+		void _enqueue(Watch &watch);
+
+		/**
+		 * Take first watch from the ready list
+		 *
+		 * \return  false if the ready list is empty
+		 */
+		bool _dequeue(int &fd, Genode::addr_t &tag);
+
+	public:
+
+		Readiness_waiter(Genode::Allocator &alloc);
+
+		~Readiness_waiter();
+
+		/**
+		 * Register watch for the read readiness of 'fd'
+		 *
+		 * \param tag  value passed to the 'for_each_ready' functor
+		 *
+		 * \return     false if 'fd' has no VFS handle for readiness
+		 *             notifications, the caller must poll 'fd' then
+		 */
+		bool watch(int fd, Genode::addr_t tag);
+
+		/**
+		 * Remove the watches registered with 'tag'
+		 */
+		void unwatch(Genode::addr_t tag);
+
+		/**
+		 * Return true if watched file descriptors may have become ready
+		 */
+		bool ready() const;
+
+		/**
+		 * Return true if all watched file descriptors must be re-evaluated
+		 *
+		 * The request is acknowledged by the call. Initially, a rescan is
+		 * requested to catch readiness signalled before the registration.
+		 */
+		bool rescan_requested();
+
+		/**
+		 * Call 'fn(int fd, addr_t tag)' for each queued watch
+		 *
+		 * The watches are removed from the ready list. Should a file
+		 * descriptor turn out to be not ready, the caller is expected to
+		 * re-arm the notification of the handle by evaluating the file
+		 * descriptor via its plugin. Watches queued while 'fn' is executed
+		 * are left for the next call.
+		 */
+		template <typename FN>
+		void for_each_ready(FN const &fn)
+		{
+			int            fd  = -1;
+			Genode::addr_t tag = 0;
+
+			for (unsigned n = _num_ready; n && _dequeue(fd, tag); n--)
+				fn(fd, tag);
+		}
+};
+
+#endif /* _LIBC__READINESS_H_ */
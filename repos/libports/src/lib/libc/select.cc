@@ -14,7 +14,7 @@
  */
 
 /*
- * Copyright (C) 2010-2017 Genode Labs GmbH
+ * Copyright (C) 2010-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -25,14 +25,18 @@
 #include <util/reconstructible.h>
 
 /* Libc includes */
+#include <libc-plugin/fd_alloc.h>
 #include <libc-plugin/plugin_registry.h>
 #include <libc-plugin/plugin.h>
+#include <libc/allocator.h>
 #include <libc/select.h>
 #include <stdlib.h>
+#include <sys/poll.h>
 #include <sys/select.h>
 #include <signal.h>
 
 #include "task.h"
+#include "readiness.h"
 
 
 namespace Libc {
@@ -55,10 +59,38 @@ struct Libc::Select_cb
 	fd_set    writefds;
 	fd_set    exceptfds;
 
+	/*
+	 * Watches for the read readiness of 'readfds', not constructed if the
+	 * fds must be polled
+	 */
+	Genode::Constructible<Readiness_waiter> waiter { };
+
 	Select_cb(int nfds, fd_set const &readfds, fd_set const &writefds, fd_set const &exceptfds)
 	:
 		nfds(nfds), readfds(readfds), writefds(writefds), exceptfds(exceptfds)
 	{ }
+
+	/**
+	 * Register readiness watches for all fds of interest
+	 *
+	 * Write and exception conditions are not signalled by the VFS. Hence,
+	 * the fds are polled if any of those is of interest.
+	 */
+	void watch(Genode::Allocator &alloc)
+	{
+		for (int fd = 0; fd < nfds; fd++)
+			if (FD_ISSET(fd, &writefds) || FD_ISSET(fd, &exceptfds))
+				return;
+
+		waiter.construct(alloc);
+
+		for (int fd = 0; fd < nfds; fd++) {
+			if (FD_ISSET(fd, &readfds) && !waiter->watch(fd, fd)) {
+				waiter.destruct();
+				return;
+			}
+		}
+	}
 };
 
 
@@ -112,6 +144,9 @@ Select_cb_list *l;
 /** The global list of tasks waiting for select */
 static Libc::Select_cb_list select_cb_list;
 
+/** Allocator for the readiness watches of waiting tasks */
+static Libc::Allocator select_watch_alloc;
+
 
 /**
  * Poll plugin select() functions
@@ -174,6 +209,46 @@ static int selscan(int nfds,
 }
 
 
+/**
+ * Evaluate the watched fds of 'scb' that signalled their read readiness
+ *
+ * In contrast to 'selscan', the costs depend on the number of signalled fds
+ * only. Fds that turn out to be not ready are re-armed by the plugin.
+ */
+static int selscan_ready(Libc::Select_cb &scb)
+{
+	int    nready = 0;
+	fd_set out_readfds;
+
+	FD_ZERO(&out_readfds);
+
+	scb.waiter->for_each_ready([&] (int libc_fd, Genode::addr_t) {
+
+		if (FD_ISSET(libc_fd, &out_readfds))
+			return;
+
+		Libc::File_descriptor *fdo =
+			Libc::file_descriptor_allocator()->find_by_libc_fd(libc_fd);
+
+		if (!fdo || !fdo->plugin)
+			return;
+
+		pollfd pfd { libc_fd, POLLIN, 0 };
+		if (fdo->plugin->poll(*fdo, pfd) && (pfd.revents & POLLIN)) {
+			FD_SET(libc_fd, &out_readfds);
+			nready++;
+		}
+	});
+
+	if (nready) {
+		scb.readfds = out_readfds;
+		FD_ZERO(&scb.writefds);
+		FD_ZERO(&scb.exceptfds);
+	}
+	return nready;
+}
+
+
 /* this function gets called by plugin backends when file descripors become ready */
 static void select_notify()
 {
@@ -184,6 +259,22 @@ static void select_notify()
 	 * and if so, wake all up */
 
 	select_cb_list.for_each([&] (Libc::Select_cb &scb) {
+
+		/* results not yet consumed */
+		if (scb.nready > 0)
+			return;
+
+		if (scb.waiter.constructed() && !scb.waiter->rescan_requested()) {
+
+			if (scb.waiter->ready())
+				scb.nready = selscan_ready(scb);
+
+			if (scb.nready > 0)
+				resume_all = true;
+
+			return;
+		}
+
 		scb.nready = selscan(scb.nfds,
 		                     &scb.readfds, &scb.writefds, &scb.exceptfds,
 		                     &tmp_readfds,  &tmp_writefds,  &tmp_exceptfds);
@@ -253,6 +344,7 @@ int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
 		/* suspend as we don't have any immediate events */
 
 		select_cb.construct(nfds, in_readfds, in_writefds, in_exceptfds);
+		select_cb->watch(select_watch_alloc);
 
 		select_cb_list.unsynchronized_insert(&(*select_cb));
 	}
@@ -372,6 +464,7 @@ int Libc::Select_handler_base::select(int nfds, fd_set &readfds,
 		/* suspend as we don't have any immediate events */
 
 		_select_cb->construct(nfds, in_readfds, in_writefds, in_exceptfds);
+		(*_select_cb)->watch(select_watch_alloc);
 
 		select_cb_list.unsynchronized_insert(&(**_select_cb));
 	}
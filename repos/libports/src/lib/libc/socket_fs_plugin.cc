@@ -222,6 +222,20 @@ struct Socket_fs::Context : Libc::Plugin_context
 			return (_state == ACCEPT_ONLY) ? accept_read_ready() : data_read_ready();
 		}
 
+		/**
+		 * Return file that determines the read readiness of the socket
+		 */
+		Libc::File_descriptor *read_ready_file()
+		{
+			if (_state == ACCEPT_ONLY) {
+				accept_fd();
+				return _fd[Fd::ACCEPT].file;
+			}
+
+			data_fd();
+			return _fd[Fd::DATA].file;
+		}
+
 		bool write_ready()
 		{
 			if (_state == CONNECTING)
@@ -306,6 +320,7 @@ struct Socket_fs::Plugin : Libc::Plugin
 	int close(Libc::File_descriptor *) override;
 	bool poll(Libc::File_descriptor &fd, struct pollfd &pfd) override;
 	int select(int, fd_set *, fd_set *, fd_set *, timeval *) override;
+	Vfs::Vfs_handle *read_ready_handle(Libc::File_descriptor *) override;
 	int ioctl(Libc::File_descriptor *, int, char *) override;
 };
 
@@ -1128,6 +1143,23 @@ int Socket_fs::Plugin::select(int nfds,
 }
 
 
+Vfs::Vfs_handle *Socket_fs::Plugin::read_ready_handle(Libc::File_descriptor *fdo)
+{
+	Socket_fs::Context *context = dynamic_cast<Socket_fs::Context *>(fdo->context);
+	if (!context) return nullptr;
+
+	try {
+		Libc::File_descriptor *file = context->read_ready_file();
+
+		/* the readiness of the socket is signalled by its VFS file */
+		if (file && file->plugin)
+			return file->plugin->read_ready_handle(file);
+	} catch (Socket_fs::Context::Inaccessible) { }
+
+	return nullptr;
+}
+
+
 int Socket_fs::Plugin::close(Libc::File_descriptor *fd)
 {
 	Socket_fs::Context *context = dynamic_cast<Socket_fs::Context *>(fd->context);
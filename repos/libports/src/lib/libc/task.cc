@@ -34,6 +34,7 @@
 #include "vfs_plugin.h"
 #include "libc_init.h"
 #include "task.h"
+#include "readiness.h"
 
 extern char **environ;
 
@@ -772,8 +773,18 @@ struct Libc::Kernel final : Vfs::Io_response_handler,
 		 ** Vfs::Io_response_handler interface **
 		 ****************************************/
 
-		void read_ready_response() override {
-			_io_ready = true; }
+		void read_ready_response() override
+		{
+			/* the response cannot be attributed to a handle */
+			Libc::readiness_rescan();
+			_io_ready = true;
+		}
+
+		void handle_read_ready(Vfs::Vfs_handle &handle) override
+		{
+			Libc::readiness_notify(handle);
+			_io_ready = true;
+		}
 
 		void io_progress_response() override {
 			_io_ready = true; }
@@ -7,7 +7,7 @@
  */
 
 /*
- * Copyright (C) 2014-2017 Genode Labs GmbH
+ * Copyright (C) 2014-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -40,6 +40,7 @@
 #include "libc_mem_alloc.h"
 #include "libc_errno.h"
 #include "task.h"
+#include "readiness.h"
 
 static Genode::Lock &vfs_lock()
 {
@@ -167,9 +168,11 @@ namespace Libc {
 		 * If this call fails, the VFS plugin is expected to call the IO
 		 * handler when the notification request can be processed. The
 		 * libc IO handler will then call 'notify_read_ready()' again
-		 * via 'select_notify()'.
+		 * via 'select_notify()'. Until then, the readiness of the handle
+		 * cannot be signalled and waiters have to poll.
 		 */
-		VFS_THREAD_SAFE(handle->fs().notify_read_ready(handle));
+		if (!VFS_THREAD_SAFE(handle->fs().notify_read_ready(handle)))
+			readiness_rescan();
 	}
 
 	bool read_ready(Libc::File_descriptor *fd)
@@ -1260,11 +1263,13 @@ bool Libc::Vfs_plugin::poll(File_descriptor &fd, struct pollfd &pfd)
 
 	bool res { false };
 
-	if ((pfd.events & POLLIN_MASK)
-	 && VFS_THREAD_SAFE(handle->fs().read_ready(handle)))
-	{
-		pfd.revents |= pfd.events & POLLIN_MASK;
-		res = true;
+	if (pfd.events & POLLIN_MASK) {
+		if (VFS_THREAD_SAFE(handle->fs().read_ready(handle))) {
+			pfd.revents |= pfd.events & POLLIN_MASK;
+			res = true;
+		} else {
+			Libc::notify_read_ready(handle);
+		}
 	}
 
 	if ((pfd.events & POLLOUT_MASK) /* XXX always writeable */)
@@ -1277,6 +1282,12 @@ bool Libc::Vfs_plugin::poll(File_descriptor &fd, struct pollfd &pfd)
 }
 
 
+Vfs::Vfs_handle *Libc::Vfs_plugin::read_ready_handle(File_descriptor *fd)
+{
+	return (fd->plugin == this) ? vfs_handle(fd) : nullptr;
+}
+
+
 bool Libc::Vfs_plugin::supports_select(int nfds,
                                        fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
                                        struct timeval *timeout)
@@ -193,6 +193,8 @@ class Libc::Vfs_plugin : public Libc::Plugin
 		                     fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
 		                     struct timeval *timeout) override;
 
+		Vfs::Vfs_handle *read_ready_handle(File_descriptor *) override;
+
 		Libc::File_descriptor *open(const char *, int, int libc_fd);
 
 		Libc::File_descriptor *open(const char *path, int flags) override
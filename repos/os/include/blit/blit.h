@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2007-2017 Genode Labs GmbH
+ * Copyright (C) 2007-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -31,4 +31,85 @@
 extern "C" void blit(void const *src, unsigned src_w,
                      void *dst, unsigned dst_w, int w, int h);
 
+
+/*
+ * Pixel kernels
+ *
+ * The following functions process one line of 'n' pixels. RGB565 pixels
+ * are passed as 'unsigned short', RGB888 pixels as 'unsigned'. The results
+ * are bit-exact with the corresponding 'Pixel_rgb565' and 'Pixel_rgb888'
+ * operations.
+ *
+ * The kernels, including 'blit', are implemented for several instruction-set
+ * extensions. At the first use, the blit library selects the best variant
+ * supported by the CPU.
+ */
+
+/**
+ * Fill line with 16-bit value
+ */
+extern "C" void blit_fill_16(unsigned short *dst, unsigned short value, int n);
+
+/**
+ * Fill line with 32-bit value
+ */
+extern "C" void blit_fill_32(unsigned *dst, unsigned value, int n);
+
+/**
+ * Blend RGB565 source pixels onto destination pixels
+ *
+ * Equivalent to 'dst = Pixel_rgb565::mix(dst, src, alpha + 1)' for each
+ * pixel with a non-zero 'alpha' value.
+ */
+extern "C" void blit_blend_rgb565(unsigned short *dst, unsigned short const *src,
+                                  unsigned char const *alpha, int n);
+
+/**
+ * Replace destination pixels by the average of source and 'mix' pixel
+ *
+ * Equivalent to 'dst = Pixel_rgb565::avr(mix, src)'.
+ */
+extern "C" void blit_avr_rgb565(unsigned short *dst, unsigned short const *src,
+                                unsigned short mix, int n);
+
+/**
+ * Convert RGB888 pixels to RGB565
+ */
+extern "C" void blit_rgb888_to_rgb565(unsigned short *dst, unsigned const *src, int n);
+
+/**
+ * Convert RGB565 pixels to RGB888
+ */
+extern "C" void blit_rgb565_to_rgb888(unsigned *dst, unsigned short const *src, int n);
+
+
+/**
+ * Instruction-set extensions used by the blit kernels
+ */
+enum Blit_isa { BLIT_ISA_GENERIC, BLIT_ISA_SSE2, BLIT_ISA_AVX2, BLIT_ISA_NEON,
+                BLIT_ISA_MAX = BLIT_ISA_NEON };
+
+/**
+ * Return instruction-set extension of the currently used kernels
+ */
+extern "C" Blit_isa blit_isa(void);
+
+/**
+ * Return true if the kernels for 'isa' are available on the CPU
+ */
+extern "C" bool blit_isa_supported(Blit_isa isa);
+
+/**
+ * Select kernels, e.g., for benchmarking
+ *
+ * \return false if 'isa' is not supported, the selection is kept in
+ *         this case
+ */
+extern "C" bool blit_select_isa(Blit_isa isa);
+
+/**
+ * Return name of instruction-set extension
+ */
+extern "C" char const *blit_isa_name(Blit_isa isa);
+
 #endif /* _INCLUDE__BLIT__BLIT_H_ */
@@ -20,7 +20,11 @@
 
 namespace Genode { class Output; }
 
-namespace Net { class Icmp_packet; }
+namespace Net
+{
+	class Internet_checksum_diff;
+	class Icmp_packet;
+}
 
 
 class Net::Icmp_packet
@@ -57,6 +61,11 @@ class Net::Icmp_packet
 
 		void update_checksum(Genode::size_t data_sz);
 
+		/**
+		 * Apply modification of header fields incrementally to the checksum
+		 */
+		void update_checksum(Internet_checksum_diff const &diff);
+
 		bool checksum_error(Genode::size_t data_sz) const;
 
 
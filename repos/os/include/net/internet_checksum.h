@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2018 Genode Labs GmbH
+ * Copyright (C) 2018-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -20,6 +20,8 @@
 
 namespace Net {
 
+	class Internet_checksum_diff;
+
 	Genode::uint16_t internet_checksum(Genode::uint16_t const *addr,
 	                                   Genode::size_t          size,
 	                                   Genode::addr_t          init_sum = 0);
@@ -32,4 +34,41 @@ namespace Net {
 	                                             Ipv4_address           &ip_dst);
 }
 
+
+/**
+ * Accumulated difference of modified data covered by an Internet Checksum
+ *
+ * Instead of re-computing the checksum over the whole data after modifying
+ * single fields, the difference between the old and the new field values is
+ * added up and applied to the checksum afterwards (conforms to RFC 1624,
+ * equation 3). Data is added up in memory byte order, like it is done by
+ * 'internet_checksum'.
+ */
+class Net::Internet_checksum_diff
+{
+	private:
+
+		Genode::uint64_t _value { 0 };
+
+	public:
+
+		/**
+		 * Add up difference between 'new_data' and 'old_data'
+		 *
+		 * \param size  size of both data regions in bytes, must be even
+		 */
+		void add_up_diff(void           const *new_data,
+		                 void           const *old_data,
+		                 Genode::size_t        size);
+
+		void add_up_diff(Internet_checksum_diff const &diff);
+
+		/**
+		 * Return checksum with the accumulated difference applied
+		 *
+		 * The checksum is expected in the byte order of the packet.
+		 */
+		Genode::uint16_t apply_to(Genode::uint16_t checksum) const;
+};
+
 #endif /* _NET__INTERNET_CHECKSUM_H_ */
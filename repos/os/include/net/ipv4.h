@@ -30,6 +30,7 @@ namespace Net
 	enum { IPV4_ADDR_LEN = 4 };
 
 	class Ipv4_address;
+	class Internet_checksum_diff;
 
 	class Ipv4_packet;
 }
@@ -93,6 +94,11 @@ class Net::Ipv4_packet
 
 		void update_checksum();
 
+		/**
+		 * Apply modification of header fields incrementally to the checksum
+		 */
+		void update_checksum(Internet_checksum_diff const &diff);
+
 		bool checksum_error() const;
 
 	private:
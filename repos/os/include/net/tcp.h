@@ -25,6 +25,7 @@
 
 namespace Net
 {
+	class Internet_checksum_diff;
 	class Tcp_state;
 	class Tcp_packet;
 }
@@ -74,6 +75,12 @@ class Net::Tcp_packet
 		                     Ipv4_address ip_dst,
 		                     size_t       tcp_size);
 
+		/**
+		 * Apply modification of header or pseudo-header fields
+		 * incrementally to the checksum
+		 */
+		void update_checksum(Internet_checksum_diff const &diff);
+
 
 		/***************
 		 ** Accessors **
@@ -22,7 +22,11 @@
 #include <net/ethernet.h>
 #include <net/ipv4.h>
 
-namespace Net { class Udp_packet; }
+namespace Net
+{
+	class Internet_checksum_diff;
+	class Udp_packet;
+}
 
 
 /**
@@ -75,6 +79,15 @@ class Net::Udp_packet
 		void update_checksum(Ipv4_address ip_src,
 		                     Ipv4_address ip_dst);
 
+		/**
+		 * Apply modification of header or pseudo-header fields
+		 * incrementally to the checksum
+		 *
+		 * A checksum of zero denotes that the sender did not compute a
+		 * checksum and is left untouched.
+		 */
+		void update_checksum(Internet_checksum_diff const &diff);
+
 		bool checksum_error(Ipv4_address ip_src,
 		                    Ipv4_address ip_dst) const;
 
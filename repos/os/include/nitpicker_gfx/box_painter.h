@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2006-2017 Genode Labs GmbH
+ * Copyright (C) 2006-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -14,13 +14,59 @@
 #ifndef _INCLUDE__NITPICKER_GFX__BOX_PAINTER_H_
 #define _INCLUDE__NITPICKER_GFX__BOX_PAINTER_H_
 
+#include <blit/blit.h>
 #include <os/surface.h>
+#include <os/pixel_rgb565.h>
+#include <os/pixel_rgb888.h>
 
 
 struct Box_painter
 {
 	typedef Genode::Surface_base::Rect Rect;
 
+	typedef Genode::Pixel_rgb565 Pixel_rgb565;
+	typedef Genode::Pixel_rgb888 Pixel_rgb888;
+
+
+	/*
+	 * Line operations
+	 *
+	 * The generic versions operate pixel by pixel. For RGB565 and RGB888,
+	 * filling is performed by the SIMD kernels of the blit library.
+	 */
+
+	template <typename PT>
+	static inline void _fill_line(PT *dst, PT pix, int n)
+	{
+		for (; n--; dst++)
+			*dst = pix;
+	}
+
+	static inline void _fill_line(Pixel_rgb565 *dst, Pixel_rgb565 pix, int n) {
+		blit_fill_16((Genode::uint16_t *)dst, pix.pixel, n); }
+
+	static inline void _fill_line(Pixel_rgb888 *dst, Pixel_rgb888 pix, int n) {
+		blit_fill_32((Genode::uint32_t *)dst, pix.pixel, n); }
+
+	template <typename PT>
+	static inline void _mix_line(PT *dst, PT pix, int alpha, int n)
+	{
+		for (; n--; dst++)
+			*dst = PT::mix(*dst, pix, alpha);
+	}
+
+	/*
+	 * The color of the box is the same for all pixels. So its contribution
+	 * to 'Pixel_rgb565::mix' is computed only once.
+	 */
+	static inline void _mix_line(Pixel_rgb565 *dst, Pixel_rgb565 pix, int alpha, int n)
+	{
+		Genode::uint16_t const pix_blended = Pixel_rgb565::blend(pix, alpha).pixel;
+
+		for (; n--; dst++)
+			dst->pixel = Pixel_rgb565::blend(*dst, 264 - alpha).pixel + pix_blended;
+	}
+
 	/**
 	 * Draw filled box
 	 *
@@ -37,19 +83,17 @@ struct Box_painter
 		if (!clipped.valid()) return;
 
 		PT pix(color.r, color.g, color.b);
-		PT *dst, *dst_line = surface.addr() + surface.size().w()*clipped.y1() + clipped.x1();
+		PT *dst_line = surface.addr() + surface.size().w()*clipped.y1() + clipped.x1();
 
 		int const alpha = color.a;
 
 		if (color.opaque())
-			for (int w, h = clipped.h() ; h--; dst_line += surface.size().w())
-				for (dst = dst_line, w = clipped.w(); w--; dst++)
-					*dst = pix;
+			for (int h = clipped.h() ; h--; dst_line += surface.size().w())
+				_fill_line(dst_line, pix, clipped.w());
 
 		else if (!color.transparent())
-			for (int w, h = clipped.h() ; h--; dst_line += surface.size().w())
-				for (dst = dst_line, w = clipped.w(); w--; dst++)
-					*dst = PT::mix(*dst, pix, alpha);
+			for (int h = clipped.h() ; h--; dst_line += surface.size().w())
+				_mix_line(dst_line, pix, alpha, clipped.w());
 
 		surface.flush_pixels(clipped);
 	}
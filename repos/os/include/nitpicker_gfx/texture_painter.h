@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2006-2017 Genode Labs GmbH
+ * Copyright (C) 2006-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -16,6 +16,7 @@
 
 #include <blit/blit.h>
 #include <os/texture.h>
+#include <os/pixel_rgb565.h>
 
 
 struct Texture_painter
@@ -42,6 +43,46 @@ struct Texture_painter
 	typedef Genode::Surface_base::Point Point;
 	typedef Genode::Surface_base::Rect  Rect;
 
+	typedef Genode::Pixel_rgb565 Pixel_rgb565;
+
+
+	/*
+	 * Line operations
+	 *
+	 * The generic versions operate pixel by pixel. For RGB565, the lines
+	 * are processed by the SIMD kernels of the blit library.
+	 */
+
+	template <typename PT>
+	static inline void _blend_line(PT *d, PT const *s, unsigned char const *a, int n)
+	{
+		for (; n--; s++, d++, a++) {
+			unsigned char const alpha_value = *a;
+			if (__builtin_expect(alpha_value != 0, true))
+				*d = PT::mix(*d, *s, alpha_value + 1);
+		}
+	}
+
+	static inline void _blend_line(Pixel_rgb565 *d, Pixel_rgb565 const *s,
+	                               unsigned char const *a, int n)
+	{
+		blit_blend_rgb565((Genode::uint16_t *)d, (Genode::uint16_t const *)s, a, n);
+	}
+
+	template <typename PT>
+	static inline void _avr_line(PT *d, PT const *s, PT mix_pixel, int n)
+	{
+		for (; n--; s++, d++)
+			*d = PT::avr(mix_pixel, *s);
+	}
+
+	static inline void _avr_line(Pixel_rgb565 *d, Pixel_rgb565 const *s,
+	                             Pixel_rgb565 mix_pixel, int n)
+	{
+		blit_avr_rgb565((Genode::uint16_t *)d, (Genode::uint16_t const *)s, mix_pixel.pixel, n);
+	}
+
+
 
 	template <typename PT>
 	static inline void paint(Genode::Surface<PT>       &surface,
@@ -74,10 +115,7 @@ struct Texture_painter
 
 		PT const mix_pixel(mix_color.r, mix_color.g, mix_color.b);
 
-		int i, j;
-		PT            const *s;
-		PT                  *d;
-		unsigned char const *a;
+		int j;
 
 		switch (mode) {
 
@@ -98,25 +136,23 @@ struct Texture_painter
 			 * Copy texture with alpha blending
 			 */
 			for (j = clipped.h(); j--; src += src_w, alpha += src_w, dst += dst_w)
-				for (i = clipped.w(), s = src, a = alpha, d = dst; i--; s++, d++, a++) {
-					unsigned char const alpha_value = *a;
-					if (__builtin_expect(alpha_value != 0, true))
-						*d = PT::mix(*d, *s, alpha_value + 1);
-				}
+				_blend_line(dst, src, alpha, clipped.w());
 			break;
 
 		case MIXED:
 
 			for (j = clipped.h(); j--; src += src_w, dst += dst_w)
-				for (i = clipped.w(), s = src, d = dst; i--; s++, d++)
-					*d = PT::avr(mix_pixel, *s);
+				_avr_line(dst, src, mix_pixel, clipped.w());
 			break;
 
 		case MASKED:
 
-			for (j = clipped.h(); j--; src += src_w, dst += dst_w)
-				for (i = clipped.w(), s = src, d = dst; i--; s++, d++)
+			for (j = clipped.h(); j--; src += src_w, dst += dst_w) {
+				PT const *s = src;
+				PT       *d = dst;
+				for (int i = clipped.w(); i--; s++, d++)
 					if (s->pixel) *d = *s;
+			}
 			break;
 		}
 
@@ -61,6 +61,12 @@
  * acknowledge buffers using the methods 'packet_avail',
  * 'ready_to_submit', 'ready_to_ack', and 'ack_avail'.
  *
+ * Both sides can transfer batches of packets using the non-blocking methods
+ * 'try_submit_packets', 'try_get_packets', 'try_ack_packets', and
+ * 'try_get_acked_packets'. Each batch is published to the other side by a
+ * single update of the queue index. The other side gets woken up at most
+ * once per batch by calling 'wakeup' after the batch transfer.
+ *
  * If bidirectional data exchange between two processes is desired, two pairs
  * of 'Packet_stream_source' and 'Packet_stream_sink' should be instantiated.
  */
@@ -211,6 +217,28 @@ class Genode::Packet_descriptor_queue
 			return true;
 		}
 
+		/**
+		 * Place up to 'count' packet descriptors into queue
+		 *
+		 * The head index is updated only once after all descriptors are
+		 * written to the queue.
+		 *
+		 * \return number of packet descriptors placed into the queue
+		 */
+		unsigned add(PACKET_DESCRIPTOR const *packets, unsigned count)
+		{
+			unsigned const n    = Genode::min(count, slots_free());
+			unsigned       head = _head;
+
+			for (unsigned i = 0; i < n; i++) {
+				_queue[head] = packets[i];
+				head = (head + 1)%QUEUE_SIZE;
+			}
+
+			_head = head;
+			return n;
+		}
+
 		/**
 		 * Take packet descriptor from queue
 		 *
@@ -223,6 +251,28 @@ class Genode::Packet_descriptor_queue
 			return packet;
 		}
 
+		/**
+		 * Take up to 'max' packet descriptors from queue
+		 *
+		 * The tail index is updated only once after all descriptors are
+		 * read from the queue.
+		 *
+		 * \return number of packet descriptors written to 'packets'
+		 */
+		unsigned get(PACKET_DESCRIPTOR *packets, unsigned max)
+		{
+			unsigned const n    = Genode::min(max, count());
+			unsigned       tail = _tail;
+
+			for (unsigned i = 0; i < n; i++) {
+				packets[i] = _queue[tail];
+				tail = (tail + 1)%QUEUE_SIZE;
+			}
+
+			_tail = tail;
+			return n;
+		}
+
 		/**
 		 * Return current packet descriptor
 		 */
@@ -258,6 +308,11 @@ class Genode::Packet_descriptor_queue
 		unsigned slots_free() {
 			return ((_tail > _head) ? _tail - _head
 			                        : QUEUE_SIZE - _head + _tail) - 1; }
+
+		/**
+		 * Return number of packet descriptors stored in the queue
+		 */
+		unsigned count() { return (_head + QUEUE_SIZE - _tail)%QUEUE_SIZE; }
 };
 
 
@@ -365,6 +420,25 @@ class Genode::Packet_descriptor_transmitter
 			return true;
 		}
 
+		/**
+		 * Place up to 'count' packets into the tx queue
+		 *
+		 * \return number of packets placed into the queue
+		 */
+		unsigned try_tx(typename TX_QUEUE::Packet_descriptor const *packets,
+		                unsigned count)
+		{
+			Genode::Lock::Guard lock_guard(_tx_queue_lock);
+
+			unsigned const n = _tx_queue->add(packets, count);
+
+			/* the receiver may have drained the queue before */
+			if (n && _tx_queue->count() <= n)
+				_tx_wakeup_needed = true;
+
+			return n;
+		}
+
 		bool tx_wakeup()
 		{
 			Genode::Lock::Guard lock_guard(_tx_queue_lock);
@@ -483,6 +557,25 @@ class Genode::Packet_descriptor_receiver
 			return packet;
 		}
 
+		/**
+		 * Take up to 'max' packets from the rx queue
+		 *
+		 * \return number of packets written to 'packets'
+		 */
+		unsigned try_rx(typename RX_QUEUE::Packet_descriptor *packets,
+		                unsigned max)
+		{
+			Genode::Lock::Guard lock_guard(_rx_queue_lock);
+
+			unsigned const n = _rx_queue->get(packets, max);
+
+			/* the transmitter may have encountered a full queue before */
+			if (n && _rx_queue->slots_free() <= n)
+				_rx_wakeup_needed = true;
+
+			return n;
+		}
+
 		bool rx_wakeup()
 		{
 			Genode::Lock::Guard lock_guard(_rx_queue_lock);
@@ -811,16 +904,36 @@ class Genode::Packet_stream_source : private Packet_stream_base
 			return _submit_transmitter.try_tx(packet);
 		}
 
+		/**
+		 * Submit up to 'count' packets to the sink
+		 *
+		 * In contrast to calling 'try_submit_packet' for each packet, the
+		 * whole batch is made visible to the sink at once. The sink must be
+		 * woken up via 'wakeup' afterwards.
+		 *
+		 * \return number of submitted packets, which is lower than 'count'
+		 *         if the submit queue is congested
+		 *
+		 * This method never blocks.
+		 */
+		unsigned try_submit_packets(Packet_descriptor const *packets,
+		                            unsigned count)
+		{
+			return _submit_transmitter.try_tx(packets, count);
+		}
+
 		/**
 		 * Wake up the packet sink if needed
 		 *
 		 * This method assumes that the same signal handler is used for
 		 * the submit transmitter and the ack receiver.
+		 *
+		 * \return true if a signal was submitted to the sink
 		 */
-		void wakeup()
+		bool wakeup()
 		{
 			/* submit only one signal */
-			_submit_transmitter.tx_wakeup() || _ack_receiver.rx_wakeup();
+			return _submit_transmitter.tx_wakeup() || _ack_receiver.rx_wakeup();
 		}
 
 		/**
@@ -848,6 +961,18 @@ class Genode::Packet_stream_source : private Packet_stream_base
 			return _ack_receiver.try_rx();
 		}
 
+		/**
+		 * Take up to 'max' acknowledgements from sink
+		 *
+		 * \return number of packets written to 'packets'
+		 *
+		 * This method never blocks.
+		 */
+		unsigned try_get_acked_packets(Packet_descriptor *packets, unsigned max)
+		{
+			return _ack_receiver.try_rx(packets, max);
+		}
+
 		/**
 		 * Release bulk-buffer space consumed by the packet
 		 */
@@ -971,16 +1096,30 @@ class Genode::Packet_stream_sink : private Packet_stream_base
 			return _submit_receiver.try_rx();
 		}
 
+		/**
+		 * Take up to 'max' packets from source
+		 *
+		 * \return number of packets written to 'packets'
+		 *
+		 * This method never blocks.
+		 */
+		unsigned try_get_packets(Packet_descriptor *packets, unsigned max)
+		{
+			return _submit_receiver.try_rx(packets, max);
+		}
+
 		/**
 		 * Wake up the packet source if needed
 		 *
 		 * This method assumes that the same signal handler is used for
 		 * the submit receiver and the ack transmitter.
+		 *
+		 * \return true if a signal was submitted to the source
 		 */
-		void wakeup()
+		bool wakeup()
 		{
 			/* submit only one signal */
-			_submit_receiver.rx_wakeup() || _ack_transmitter.tx_wakeup();
+			return _submit_receiver.rx_wakeup() || _ack_transmitter.tx_wakeup();
 		}
 
 		/**
@@ -1035,6 +1174,21 @@ class Genode::Packet_stream_sink : private Packet_stream_base
 			return _ack_transmitter.try_tx(packet);
 		}
 
+		/**
+		 * Acknowledge up to 'count' packets to the source
+		 *
+		 * The source must be woken up via 'wakeup' afterwards.
+		 *
+		 * \return number of acknowledged packets, which is lower than
+		 *         'count' if the acknowledgement queue is congested
+		 *
+		 * This method never blocks.
+		 */
+		unsigned try_ack_packets(Packet_descriptor const *packets, unsigned count)
+		{
+			return _ack_transmitter.try_tx(packets, count);
+		}
+
 		void debug_print_buffers() {
 			Packet_stream_base::_debug_print_buffers(); }
 
@@ -0,0 +1,291 @@
+/*
+ * \brief  Extent-based data structure for storing sparse files in RAM
+ * \author Norman Feske
+ * \date   2019-03-12
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__RAM_FS__EXTENT_H_
+#define _INCLUDE__RAM_FS__EXTENT_H_
+
+/* Genode includes */
+#include <util/noncopyable.h>
+#include <util/avl_tree.h>
+#include <util/misc_math.h>
+#include <util/string.h>
+#include <base/allocator.h>
+#include <file_system_session/file_system_session.h>
+
+namespace File_system {
+
+	using namespace Genode;
+
+	class Extent_map;
+}
+
+
+/**
+ * Sparse file content stored as a set of non-overlapping extents
+ *
+ * Each extent is a contiguous range of file content backed by a single
+ * allocation. Ranges that were never written to are not backed by memory
+ * and read as zeros. The extents are kept in an AVL tree ordered by their
+ * offsets. Hence, the lookup of a file position costs O(log n) with n
+ * being the number of extents, and contiguous ranges are copied with a
+ * single 'memcpy' per extent.
+ *
+ * The size of newly allocated extents grows with the amount of data stored
+ * in the file, starting at 'MIN_EXTENT_SIZE' up to 'MAX_EXTENT_SIZE'. The
+ * latter corresponds to the size of a large page. In contrast to the
+ * 'Chunk' structure, the file size is not limited by the data structure.
+ */
+class File_system::Extent_map : Noncopyable
+{
+	public:
+
+		enum {
+			MIN_EXTENT_SIZE = 4*1024,
+			MAX_EXTENT_SIZE = 2*1024*1024,
+		};
+
+	private:
+
+		class Extent : public Avl_node<Extent>
+		{
+			private:
+
+				/*
+				 * Noncopyable
+				 */
+				Extent(Extent const &);
+				Extent &operator = (Extent const &);
+
+			public:
+
+				seek_off_t const offset;
+				size_t     const size;
+
+				Extent(seek_off_t offset, size_t size)
+				: offset(offset), size(size)
+				{
+					memset(data(), 0, size);
+				}
+
+				char *data() { return (char *)(this + 1); }
+
+				char const *data() const { return (char const *)(this + 1); }
+
+				seek_off_t end() const { return offset + size; }
+
+				/**
+				 * Avl_node interface
+				 */
+				bool higher(Extent *e) { return e->offset > offset; }
+
+				/**
+				 * Return first extent that ends after 'pos'
+				 */
+				Extent *lookup(seek_off_t pos)
+				{
+					if (pos >= end()) {
+						Extent * const e = child(true);
+						return e ? e->lookup(pos) : nullptr;
+					}
+
+					/* this extent ends after 'pos', a lower one may as well */
+					Extent * const e = child(false);
+					Extent * const lower = e ? e->lookup(pos) : nullptr;
+					return lower ? lower : this;
+				}
+		};
+
+		Allocator        &_alloc;
+		Avl_tree<Extent>  _extents   { };
+		file_size_t       _used_size { 0 };
+		file_size_t       _allocated { 0 };
+
+		Extent *_lookup(seek_off_t pos) const
+		{
+			Extent * const root = _extents.first();
+			return root ? root->lookup(pos) : nullptr;
+		}
+
+		/**
+		 * Return extent that ends before 'pos' or nullptr
+		 */
+		Extent *_predecessor(seek_off_t pos) const
+		{
+			Extent *result = nullptr;
+			for (Extent *e = _extents.first(); e; ) {
+				if (e->end() <= pos) {
+					result = e;
+					e = e->child(true);
+				} else {
+					e = e->child(false);
+				}
+			}
+			return result;
+		}
+
+		/**
+		 * Create extent that covers position 'pos'
+		 *
+		 * \param pos   position not covered by any extent
+		 * \param len   number of bytes to be written starting at 'pos'
+		 * \param next  next extent after 'pos' or nullptr
+		 *
+		 * \throw Out_of_memory
+		 */
+		Extent &_create(seek_off_t pos, size_t len, Extent const *next)
+		{
+			Extent const * const prev = _predecessor(pos);
+
+			seek_off_t const prev_end = prev ? prev->end() : 0;
+			seek_off_t const next_beg = next ? next->offset : ~(seek_off_t)0;
+
+			/* let extents grow with the amount of stored data */
+			size_t const preferred =
+				max((size_t)MIN_EXTENT_SIZE,
+				    min((size_t)MAX_EXTENT_SIZE, (size_t)_allocated));
+
+			seek_off_t const start = max(prev_end, pos & ~(seek_off_t)(MIN_EXTENT_SIZE - 1));
+			seek_off_t const end   = min(next_beg,
+			                             align_addr(max(start + preferred, pos + len),
+			                                        log2((size_t)MIN_EXTENT_SIZE)));
+
+			size_t const size = min((size_t)(end - start), (size_t)MAX_EXTENT_SIZE);
+
+			void * const ptr = _alloc.alloc(sizeof(Extent) + size);
+
+			Extent &extent = *construct_at<Extent>(ptr, start, size);
+			_extents.insert(&extent);
+			_allocated += size;
+			return extent;
+		}
+
+		void _destroy(Extent &extent)
+		{
+			size_t const size = extent.size;
+
+			_extents.remove(&extent);
+			_allocated -= size;
+			extent.~Extent();
+			_alloc.free(&extent, sizeof(Extent) + size);
+		}
+
+	public:
+
+		Extent_map(Allocator &alloc) : _alloc(alloc) { }
+
+		~Extent_map()
+		{
+			while (Extent *e = _extents.first())
+				_destroy(*e);
+		}
+
+		/**
+		 * Return position after the highest offset written to
+		 */
+		file_size_t used_size() const { return _used_size; }
+
+		/**
+		 * Return number of bytes of memory allocated for file content
+		 */
+		file_size_t allocated() const { return _allocated; }
+
+		/**
+		 * Write data
+		 *
+		 * \throw Out_of_memory  not all data could be stored
+		 */
+		void write(char const *src, size_t len, seek_off_t seek_offset)
+		{
+			while (len > 0) {
+
+				Extent *extent = _lookup(seek_offset);
+
+				if (!extent || extent->offset > seek_offset)
+					extent = &_create(seek_offset, len, extent);
+
+				size_t const local_offset = seek_offset - extent->offset;
+				size_t const curr_len     = min(len, extent->size - local_offset);
+
+				memcpy(extent->data() + local_offset, src, curr_len);
+
+				src         += curr_len;
+				len         -= curr_len;
+				seek_offset += curr_len;
+
+				_used_size = max(_used_size, seek_offset);
+			}
+		}
+
+		/**
+		 * Read data, ranges not backed by extents are read as zeros
+		 */
+		void read(char *dst, size_t len, seek_off_t seek_offset) const
+		{
+			while (len > 0) {
+
+				Extent const * const extent = _lookup(seek_offset);
+
+				/* fill gap in front of next extent with zeros */
+				size_t const gap = !extent ? len
+				                 : (size_t)min((seek_off_t)len,
+				                               extent->offset > seek_offset
+				                               ? extent->offset - seek_offset : 0);
+				if (gap) {
+					memset(dst, 0, gap);
+					dst         += gap;
+					len         -= gap;
+					seek_offset += gap;
+					continue;
+				}
+
+				size_t const local_offset = seek_offset - extent->offset;
+				size_t const curr_len     = min(len, extent->size - local_offset);
+
+				memcpy(dst, extent->data() + local_offset, curr_len);
+
+				dst         += curr_len;
+				len         -= curr_len;
+				seek_offset += curr_len;
+			}
+		}
+
+		/**
+		 * Truncate content to 'size' bytes
+		 *
+		 * Extents beyond 'size' are released. The remainder of the extent
+		 * containing 'size' is cleared so that extending the file
+		 * afterwards yields zeros.
+		 */
+		void truncate(file_size_t size)
+		{
+			if (size >= _used_size)
+				return;
+
+			for (seek_off_t pos = size; Extent *e = _lookup(pos); ) {
+
+				if (e->offset >= size) {
+					_destroy(*e);
+					continue;
+				}
+
+				size_t const local_offset = size - e->offset;
+				memset(e->data() + local_offset, 0, e->size - local_offset);
+
+				/* continue with the extents behind the cleared one */
+				pos = e->end();
+			}
+			_used_size = size;
+		}
+};
+
+#endif /* _INCLUDE__RAM_FS__EXTENT_H_ */
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2014-2017 Genode Labs GmbH
+ * Copyright (C) 2014-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -18,6 +18,8 @@
 #include <util/reconstructible.h>
 #include <os/session_policy.h>
 #include <base/attached_ram_dataspace.h>
+#include <rm_session/rm_session.h>
+#include <region_map/client.h>
 
 namespace Rom {
 	using Genode::size_t;
@@ -31,10 +33,12 @@ namespace Rom {
 	class Writer;
 	class Reader;
 	class Buffer;
+	class Buffer_view_factory;
 
 	typedef Genode::List<Module> Module_list;
 	typedef Genode::List<Reader> Reader_list;
 	typedef Genode::List<Writer> Writer_list;
+	typedef Genode::List<Buffer> Buffer_list;
 }
 
 
@@ -54,6 +58,115 @@ struct Rom::Reader : private Reader_list::Element, Interface
 
 	virtual void notify_module_changed()     = 0;
 	virtual void notify_module_invalidated() = 0;
+
+	private:
+
+		friend class Module;
+
+		/*
+		 * Permission to read the module content as of the most recent
+		 * notification, used to suppress notifications about unchanged
+		 * content
+		 */
+		bool _permitted = false;
+};
+
+
+/**
+ * Interface for obtaining the RM session used to create read-only views of
+ * buffers mapped by readers in shared mode
+ */
+struct Rom::Buffer_view_factory : Interface
+{
+	/**
+	 * Return RM session, or nullptr if no RM session is available
+	 */
+	virtual Genode::Rm_session *rm_session() = 0;
+};
+
+
+/**
+ * Backing store of a module's content
+ *
+ * Readers in shared mode map the buffer instead of copying its content. A
+ * buffer mapped by readers is never modified. When new content arrives,
+ * the module allocates a new buffer and keeps the old one until the last
+ * reader releases it.
+ *
+ * Readers do not obtain the RAM dataspace of the buffer but a managed
+ * dataspace that contains the buffer as read-only attachment. So a reader
+ * cannot modify the content seen by the server and the other readers.
+ */
+class Rom::Buffer : private Buffer_list::Element
+{
+	private:
+
+		/*
+		 * Noncopyable
+		 */
+		Buffer(Buffer const &);
+		Buffer &operator = (Buffer const &);
+
+		friend class Genode::List<Buffer>;
+		friend class Module;
+
+		Attached_ram_dataspace _ds;
+
+		unsigned _users = 0;
+
+		/* read-only view of '_ds', created on the first use */
+		Genode::Rm_session                    *_rm_session = nullptr;
+		Genode::Capability<Genode::Region_map> _view       { };
+		Genode::Dataspace_capability           _view_ds    { };
+
+		Buffer(Genode::Ram_allocator &ram, Genode::Region_map &rm, size_t size)
+		: _ds(ram, rm, size) { }
+
+		char *_local_addr() { return _ds.local_addr<char>(); }
+
+		/**
+		 * Create read-only view of the buffer
+		 *
+		 * \return  false if the view could not be created
+		 */
+		bool _create_view(Genode::Rm_session &rm_session)
+		{
+			using namespace Genode;
+
+			if (_view_ds.valid())
+				return true;
+
+			try {
+				_view       = rm_session.create(_ds.size());
+				_rm_session = &rm_session;
+
+				enum { OFFSET = 0, LOCAL_ADDR = false, EXEC = false, WRITE = false };
+				Region_map_client view(_view);
+				view.attach(_ds.cap(), _ds.size(), OFFSET,
+				            LOCAL_ADDR, (addr_t)0, EXEC, WRITE);
+				_view_ds = view.dataspace();
+			}
+			catch (Out_of_ram)  { }
+			catch (Out_of_caps) { }
+			catch (Region_map::Region_conflict) { }
+
+			return _view_ds.valid();
+		}
+
+	public:
+
+		~Buffer()
+		{
+			if (_view.valid())
+				_rm_session->destroy(_view);
+		}
+
+		/**
+		 * Return read-only dataspace to be mapped by readers
+		 */
+		Genode::Dataspace_capability cap() const { return _view_ds; }
+
+		size_t capacity() const { return _ds.size(); }
 };
 
 
@@ -75,6 +188,28 @@ struct Rom::Readable_module : Interface
 	                            size_t dst_len) const = 0;
 
 	virtual size_t size() const = 0;
+
+	/**
+	 * Return version of the content, which changes with each new content
+	 */
+	virtual unsigned long version() const = 0;
+
+	/**
+	 * Return true if the reader is permitted to read the current content
+	 */
+	virtual bool readable(Reader const &reader) const = 0;
+
+	/**
+	 * Obtain buffer holding the current content for mapping it
+	 *
+	 * \return  buffer, or nullptr if the module has no content readable by
+	 *          'reader' or if the buffer cannot be mapped read-only
+	 *
+	 * The buffer must be released via 'release_buffer'.
+	 */
+	virtual Buffer *acquire_buffer(Reader const &reader) = 0;
+
+	virtual void release_buffer(Buffer &buffer) = 0;
 };
 
 
@@ -138,10 +273,13 @@ struct Rom::Module : private Module_list::Element, Readable_module
 
 		Genode::Ram_allocator &_ram;
 		Genode::Region_map    &_rm;
+		Genode::Allocator     &_alloc;
 
 		Read_policy  const &_read_policy;
 		Write_policy const &_write_policy;
 
+		Buffer_view_factory *_buffer_view_factory;
+
 		Reader_list mutable _readers { };
 		Writer_list mutable _writers { };
 
@@ -151,19 +289,46 @@ struct Rom::Module : private Module_list::Element, Readable_module
 		Writer const *_last_writer = nullptr;
 
 		/**
-		 * Dataspace used as backing store
+		 * Buffer used as backing store
 		 *
-		 * The buffer for the content is not allocated from the heap to
-		 * allow for the immediate release of the underlying backing store when
-		 * the module gets destructed.
+		 * The content is not stored at the heap to allow for the immediate
+		 * release of the underlying backing store when the module gets
+		 * destructed.
+		 */
+		Buffer *_buffer = nullptr;
+
+		/**
+		 * Buffers of outdated content still mapped by readers
 		 */
-		Constructible<Attached_ram_dataspace> _ds { };
+		Buffer_list _stale_buffers { };
 
 		/**
-		 * Content size, which may less than the capacilty of '_ds'.
+		 * Content size, which may less than the capacilty of '_buffer'.
 		 */
 		size_t _size = 0;
 
+		unsigned long _version = 0;
+
+		/**
+		 * Make sure that the current buffer is not mapped by any reader
+		 *
+		 * \return true if the current buffer can be modified
+		 */
+		bool _detach_shared_buffer()
+		{
+			if (_buffer && _buffer->_users) {
+				_stale_buffers.insert(_buffer);
+				_buffer = nullptr;
+			}
+			return _buffer != nullptr;
+		}
+
+		void _destroy_buffer(Buffer *buffer)
+		{
+			if (buffer)
+				Genode::destroy(_alloc, buffer);
+		}
+
 
 		/********************************
 		 ** Interface used by registry **
@@ -177,20 +342,28 @@ struct Rom::Module : private Module_list::Element, Readable_module
 		 * \param ram           allocator for the module's backing store
 		 * \param rm            region map of the local address space, needed
 		 *                      to access the allocated backing store
+		 * \param alloc         allocator for the meta data of the backing
+		 *                      store
 		 * \param name          module name
 		 * \param read_policy   policy hook function that is evaluated each
 		 *                      time when the module content is obtained
 		 * \param write_policy  policy hook function that is evaluated each
 		 *                      time when the module content is changed
+		 * \param view_factory  factory of the read-only views of buffers
+		 *                      handed out in shared mode, without factory
+		 *                      the module supports private copies only
 		 */
 		Module(Genode::Ram_allocator &ram,
 		       Genode::Region_map    &rm,
+		       Genode::Allocator     &alloc,
 		       Name            const &name,
 		       Read_policy     const &read_policy,
-		       Write_policy    const &write_policy)
+		       Write_policy    const &write_policy,
+		       Buffer_view_factory   *view_factory = nullptr)
 		:
-			_name(name), _ram(ram), _rm(rm),
-			_read_policy(read_policy), _write_policy(write_policy)
+			_name(name), _ram(ram), _rm(rm), _alloc(alloc),
+			_read_policy(read_policy), _write_policy(write_policy),
+			_buffer_view_factory(view_factory)
 		{ }
 
 
@@ -222,9 +395,11 @@ struct Rom::Module : private Module_list::Element, Readable_module
 
 			/* clear content if its origin disappears */
 			if (_last_writer == &writer) {
-				Genode::memset(_ds->local_addr<char>(), 0, _size);
+				if (_detach_shared_buffer())
+					Genode::memset(_buffer->_local_addr(), 0, _size);
 				_size = 0;
 				_last_writer = nullptr;
+				_version++;
 			}
 		}
 
@@ -246,41 +421,79 @@ struct Rom::Module : private Module_list::Element, Readable_module
 
 	public:
 
+		~Module()
+		{
+			_destroy_buffer(_buffer);
+
+			while (Buffer *buffer = _stale_buffers.first()) {
+				_stale_buffers.remove(buffer);
+				_destroy_buffer(buffer);
+			}
+		}
+
 		/**
 		 * Assign new content to the ROM module
 		 *
-		 * Called by report service when a new report comes in.
+		 * Called by report service when a new report comes in. If the
+		 * report equals the current content of the same writer, only the
+		 * readers with a changed read permission are notified.
 		 */
 		void write_content(Writer const &writer, char const * const src, size_t const src_len)
 		{
 			if (!_write_policy.write_permitted(*this, writer))
 				return;
 
-			_size = 0;
+			bool const unchanged = (_last_writer == &writer)
+			                    && _buffer && (src_len == _size)
+			                    && Genode::memcmp(_buffer->_local_addr(), src, src_len) == 0;
 
 			_last_writer = &writer;
 
-			/*
-			 * Realloc backing store if needed
-			 *
-			 * Take a terminating zero into account, which we append to each
-			 * report. This way, we do not need to trust report clients to
-			 * append a zero termination to textual reports.
-			 */
-			if (!_ds.constructed() || _ds->size() < (src_len + 1))
-				_ds.construct(_ram, _rm, (src_len + 1));
-
-			/* copy content into backing store */
-			_size = src_len;
-			Genode::memcpy(_ds->local_addr<char>(), src, _size);
-
-			/* append zero termination */
-			_ds->local_addr<char>()[src_len] = 0;
+			if (!unchanged) {
+
+				/*
+				 * Realloc backing store if needed
+				 *
+				 * Take a terminating zero into account, which we append to
+				 * each report. This way, we do not need to trust report
+				 * clients to append a zero termination to textual reports.
+				 */
+				size_t old_size = _detach_shared_buffer() ? _size : 0;
+
+				if (_buffer && _buffer->capacity() < (src_len + 1)) {
+					_destroy_buffer(_buffer);
+					_buffer  = nullptr;
+					old_size = 0;
+				}
+
+				if (!_buffer)
+					_buffer = new (_alloc) Buffer(_ram, _rm, src_len + 1);
+
+				/* copy content into backing store */
+				char * const dst = _buffer->_local_addr();
+				_size = src_len;
+				Genode::memcpy(dst, src, _size);
+
+				/* append zero termination, clear the rest of the old content */
+				dst[src_len] = 0;
+				if (old_size > src_len)
+					Genode::memset(dst + src_len, 0, old_size - src_len);
+
+				_version++;
+			}
 
 			/* notify ROM clients that access the module */
 			for (Reader *r = _readers.first(); r; r = r->next()) {
 
-				if (_read_policy.read_permitted(*this, *_last_writer, *r))
+				bool const permitted =
+					_read_policy.read_permitted(*this, *_last_writer, *r);
+
+				if (unchanged && permitted == r->_permitted)
+					continue;
+
+				r->_permitted = permitted;
+
+				if (permitted)
 					r->notify_module_changed();
 				else
 					r->notify_module_invalidated();
@@ -292,21 +505,51 @@ struct Rom::Module : private Module_list::Element, Readable_module
 		 */
 		size_t read_content(Reader const &reader, char *dst, size_t dst_len) const override
 		{
-			if (!_ds.constructed() || !_last_writer)
-				return 0;
-
-			if (!_read_policy.read_permitted(*this, *_last_writer, reader))
+			if (!_buffer || !readable(reader))
 				return 0;
 
 			if (dst_len < _size)
 				throw Buffer_too_small();
 
-			Genode::memcpy(dst, _ds->local_addr<char>(), _size);
+			Genode::memcpy(dst, _buffer->_local_addr(), _size);
 			return _size;
 		}
 
 		virtual size_t size() const override { return _size; }
 
+		unsigned long version() const override { return _version; }
+
+		bool readable(Reader const &reader) const override
+		{
+			return _last_writer
+			    && _read_policy.read_permitted(*this, *_last_writer, reader);
+		}
+
+		Buffer *acquire_buffer(Reader const &reader) override
+		{
+			if (!_buffer || !_size || !readable(reader) || !_buffer_view_factory)
+				return nullptr;
+
+			Genode::Rm_session * const rm_session = _buffer_view_factory->rm_session();
+			if (!rm_session || !_buffer->_create_view(*rm_session))
+				return nullptr;
+
+			_buffer->_users++;
+			return _buffer;
+		}
+
+		void release_buffer(Buffer &buffer) override
+		{
+			if (buffer._users)
+				buffer._users--;
+
+			/* destroy outdated buffer once the last reader is gone */
+			if (&buffer != _buffer && !buffer._users) {
+				_stale_buffers.remove(&buffer);
+				_destroy_buffer(&buffer);
+			}
+		}
+
 		Name name() const { return _name; }
 };
 
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2014-2017 Genode Labs GmbH
+ * Copyright (C) 2014-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -38,6 +38,16 @@ struct Rom::Registry_for_reader : Interface
 	                                Module::Name const &rom_label) = 0;
 
 	virtual void release(Reader &reader, Readable_module &module) = 0;
+
+	/**
+	 * Return true if the reader may map the content of the ROM module
+	 *
+	 * Shared mode saves the copying of the content for each reader. The
+	 * readers map a read-only view of the same buffer, so a reader cannot
+	 * modify the content seen by other readers. If no view can be created,
+	 * the reader falls back to a private copy.
+	 */
+	virtual bool shared(Module::Name const &) { return false; }
 };
 
 
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2014-2017 Genode Labs GmbH
+ * Copyright (C) 2014-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -55,6 +55,25 @@ class Rom::Session_component : public Genode::Rpc_object<Genode::Rom_session>,
 
 		size_t _content_size = 0;
 
+		/* version of the module content present in '_ds' */
+		unsigned long _version = 0;
+
+		/*
+		 * In shared mode, the client maps the module's buffer instead of
+		 * a private copy of the content.
+		 */
+		bool const _shared;
+
+		Buffer *_shared_buffer = nullptr;
+
+		void _release_shared_buffer()
+		{
+			if (_shared_buffer)
+				_module.release_buffer(*_shared_buffer);
+
+			_shared_buffer = nullptr;
+		}
+
 		/**
 		 * Keep state of valid content to notify the client only once when
 		 * the ROM module becomes invalid.
@@ -71,16 +90,24 @@ class Rom::Session_component : public Genode::Rpc_object<Genode::Rom_session>,
 
 	public:
 
+		/**
+		 * Constructor
+		 *
+		 * \param shared  hand out the module's buffer instead of a copy
+		 */
 		Session_component(Genode::Ram_allocator &ram, Genode::Region_map &rm,
 		                  Registry_for_reader &registry,
-		                  Genode::Session_label const &label)
+		                  Genode::Session_label const &label,
+		                  bool shared = false)
 		:
 			_ram(ram), _rm(rm),
-			_registry(registry), _label(label), _module(_init_module(label))
+			_registry(registry), _label(label), _module(_init_module(label)),
+			_shared(shared)
 		{ }
 
 		~Session_component()
 		{
+			_release_shared_buffer();
 			_registry.release(*this, _module);
 		}
 
@@ -90,6 +117,22 @@ class Rom::Session_component : public Genode::Rpc_object<Genode::Rom_session>,
 		{
 			using namespace Genode;
 
+				/* map the module's buffer in shared mode */
+				if (_shared) {
+					Buffer * const buffer = _module.acquire_buffer(*this);
+
+					_release_shared_buffer();
+
+					if (buffer) {
+						_shared_buffer = buffer;
+						_ds.destruct();
+						_content_size = _module.size();
+						_valid        = true;
+
+						return static_cap_cast<Rom_dataspace>(buffer->cap());
+					}
+				}
+
 				/* replace dataspace by new one */
 				/* XXX we could keep the old dataspace if the size fits */
 				_ds.construct(_ram, _rm, _module.size());
@@ -98,6 +141,8 @@ class Rom::Session_component : public Genode::Rpc_object<Genode::Rom_session>,
 				_content_size =
 					_module.read_content(*this, _ds->local_addr<char>(), _ds->size());
 
+				_version = _module.version();
+
 				_valid = _content_size > 0;
 
 				/* cast RAM into ROM dataspace capability */
@@ -107,12 +152,33 @@ class Rom::Session_component : public Genode::Rpc_object<Genode::Rom_session>,
 
 		bool update() override
 		{
+			/*
+			 * A mapped buffer is never modified. The update succeeds only
+			 * if the buffer still holds the current content.
+			 */
+			if (_shared) {
+				Buffer * const buffer = _module.acquire_buffer(*this);
+				bool const current = buffer && (buffer == _shared_buffer);
+
+				if (buffer)
+					_module.release_buffer(*buffer);
+
+				if (buffer || _shared_buffer)
+					return current;
+			}
+
 			if (!_ds.constructed() || _module.size() > _ds->size())
 				return false;
 
+			/* skip copying if the client already has the current content */
+			if (_valid && _version == _module.version() && _module.readable(*this))
+				return true;
+
 			size_t const new_content_size =
 				_module.read_content(*this, _ds->local_addr<char>(), _ds->size());
 
+			_version = _module.version();
+
 			/* clear difference between old and new content */
 			if (new_content_size < _content_size)
 				Genode::memset(_ds->local_addr<char>() + new_content_size, 0,
@@ -173,8 +239,11 @@ class Rom::Root : public Genode::Root_component<Session_component>
 		{
 			using namespace Genode;
 
+			Session_label const label = label_from_args(args);
+
 			return new (md_alloc())
-				Session_component(_env.ram(), _env.rm(), _registry, label_from_args(args));
+				Session_component(_env.ram(), _env.rm(), _registry, label,
+				                  _registry.shared(label.string()));
 		}
 
 	public:
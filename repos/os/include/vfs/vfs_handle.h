@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2011-2017 Genode Labs GmbH
+ * Copyright (C) 2011-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -40,6 +40,16 @@ struct Vfs::Io_response_handler : Genode::Interface
 	 */
 	virtual void read_ready_response() = 0;
 
+	/**
+	 * Respond to the specified handle becoming readable
+	 *
+	 * Handlers that keep track of the handles they are interested in may
+	 * override this method to process only the affected handle instead of
+	 * re-evaluating all handles. By default, the response is forwarded to
+	 * 'read_ready_response'.
+	 */
+	virtual void handle_read_ready(Vfs_handle &) { read_ready_response(); }
+
 	/**
 	 * Respond to complete pending I/O
 	 */
@@ -159,7 +169,7 @@ class Vfs::Vfs_handle
 		 * Notify application through response handler
 		 */
 		void read_ready_response() {
-			if (_handler) _handler->read_ready_response(); }
+			if (_handler) _handler->handle_read_ready(*this); }
 
 		/**
 		 * Notify application through response handler
@@ -0,0 +1,6 @@
+SRC_CC  = blit.cc
+REQUIRES = arm_64
+INC_DIR += $(REP_DIR)/src/lib/blit/spec/arm_64 \
+           $(REP_DIR)/src/lib/blit
+
+vpath blit.cc $(REP_DIR)/src/lib/blit
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2014-2017 Genode Labs GmbH
+ * Copyright (C) 2014-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -78,8 +78,8 @@ struct Rom::Registry : Registry_for_reader, Registry_for_writer, Genode::Noncopy
 			/* XXX if we run out of memory, the server will abort */
 
 			Module * const module = new (&_md_alloc)
-				Module(_ram, _rm, session_label.prefix(), _read_write_policy,
-				       _read_write_policy);
+				Module(_ram, _rm, _md_alloc, session_label.prefix(),
+				       _read_write_policy, _read_write_policy);
 
 			_modules.insert(module);
 			return *module;
@@ -1,6 +1,6 @@
 TARGET  = status_bar
 SRC_CC  = main.cc
-LIBS   += base
+LIBS   += base blit
 SRC_BIN = default.tff
 
 vpath %.tff $(REP_DIR)/src/server/nitpicker
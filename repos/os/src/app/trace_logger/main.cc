@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2018 Genode Labs GmbH
+ * Copyright (C) 2018-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -23,6 +23,8 @@
 #include <os/session_policy.h>
 #include <timer_session/connection.h>
 #include <util/construct_at.h>
+#include <util/reconstructible.h>
+#include <vfs/simple_env.h>
 
 using namespace Genode;
 using Thread_name = String<40>;
@@ -64,6 +66,7 @@ class Main
 		unsigned long                  _num_subjects        { 0 };
 		unsigned long                  _num_monitors        { 0 };
 		Trace::Subject_id              _subjects[MAX_SUBJECTS];
+		Constructible<Vfs::Simple_env> _vfs_env             { };
 
 		void _handle_period(Duration)
 		{
@@ -158,7 +161,8 @@ class Main
 					_policies.insert(policy);
 					_trace.trace(id.id, policy.id(), buffer_sz);
 				}
-				monitors.insert(new (_heap) Monitor(_trace, _env.rm(), id));
+				monitors.insert(new (_heap) Monitor(_trace, _env.rm(), id,
+				                                    _vfs_env.constructed() ? &*_vfs_env : nullptr));
 			}
 			catch (Out_of_ram                    ) { warning("Cannot activate tracing: Out_of_ram"             ); return; }
 			catch (Out_of_caps                   ) { warning("Cannot activate tracing: Out_of_caps"            ); return; }
@@ -189,7 +193,14 @@ class Main
 
 	public:
 
-		Main(Env &env) : _env(env) { _policies.insert(_default_policy); }
+		Main(Env &env) : _env(env)
+		{
+			_policies.insert(_default_policy);
+
+			/* export the trace data to files if a VFS is configured */
+			_config.with_sub_node("vfs", [&] (Xml_node vfs) {
+				_vfs_env.construct(_env, _heap, vfs); });
+		}
 };
 
 
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2018 Genode Labs GmbH
+ * Copyright (C) 2018-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -60,12 +60,18 @@ Monitor &Monitor::find_by_subject_id(Trace::Subject_id const subject_id)
 
 Monitor::Monitor(Trace::Connection &trace,
                  Region_map        &rm,
-                 Trace::Subject_id  subject_id)
+                 Trace::Subject_id  subject_id,
+                 Vfs::Env          *vfs_env)
 :
 	Monitor_base(trace, rm, subject_id),
 	_subject_id(subject_id), _buffer(_buffer_raw)
 {
 	_update_info();
+
+	if (vfs_env) {
+		try { _file.construct(*vfs_env, _subject_id, _info); }
+		catch (Trace_file::Open_failed) { }
+	}
 }
 
 
@@ -86,6 +92,30 @@ void Monitor::_update_info()
 }
 
 
+void Monitor::_print_record(Trace_buffer::Record const &record,
+                            bool &printed_entries)
+{
+	/* get readable data length and skip empty entries */
+	size_t length = min((size_t)record.length, (size_t)MAX_ENTRY_LENGTH - 1);
+	if (!length)
+		return;
+
+	/* copy entry data from buffer and add terminating '0' */
+	memcpy(_curr_entry_data, record.data(), length);
+	_curr_entry_data[length] = '\0';
+
+	/* print copied entry data out to log */
+	if (!printed_entries) {
+		log("   <buffer>");
+		printed_entries = true;
+	}
+	if (record.lost)
+		log("   <lost entries=\"", record.lost, "\" />");
+
+	log(Cstring(_curr_entry_data));
+}
+
+
 void Monitor::print(bool activity, bool affinity)
 {
 	_update_info();
@@ -111,26 +141,23 @@ void Monitor::print(bool activity, bool affinity)
 		              "\" ypos=\"", _info.affinity().ypos(),
 		              "\">");
 
-	/* print all buffer entries that we haven't yet printed */
+	/* drain all buffer entries that we haven't yet processed */
 	bool printed_buf_entries = false;
-	_buffer.for_each_new_entry([&] (Trace::Buffer::Entry entry) {
-
-		/* get readable data length and skip empty entries */
-		size_t length = min(entry.length(), (unsigned)MAX_ENTRY_LENGTH - 1);
-		if (!length)
-			return;
-
-		/* copy entry data from buffer and add terminating '0' */
-		memcpy(_curr_entry_data, entry.data(), length);
-		_curr_entry_data[length] = '\0';
-
-		/* print copied entry data out to log */
-		if (!printed_buf_entries) {
-			log("   <buffer>");
-			printed_buf_entries = true;
-		}
-		log(Cstring(_curr_entry_data));
-	});
+	for (;;) {
+		size_t const len = _buffer.drain(_drain_data, sizeof(_drain_data));
+		if (!len)
+			break;
+
+		if (_file.constructed())
+			_file->append(_drain_data, len);
+
+		Trace_buffer::for_each_record(_drain_data, len,
+			[&] (Trace_buffer::Record const &record) {
+				_print_record(record, printed_buf_entries); });
+	}
+	if (_file.constructed())
+		_file->sync();
+
 	/* print end tags */
 	if (printed_buf_entries)
 		log("   </buffer>");
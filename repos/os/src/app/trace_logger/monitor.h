@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2018 Genode Labs GmbH
+ * Copyright (C) 2018-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -17,9 +17,11 @@
 /* local includes */
 #include <avl_tree.h>
 #include <trace_buffer.h>
+#include <trace_file.h>
 
 /* Genode includes */
 #include <base/trace/types.h>
+#include <util/reconstructible.h>
 
 namespace Genode { namespace Trace { class Connection; } }
 
@@ -51,22 +53,34 @@ class Monitor : public Monitor_base,
 {
 	private:
 
-		enum { MAX_ENTRY_LENGTH = 256 };
+		enum { MAX_ENTRY_LENGTH  = 256 };
+		enum { DRAIN_BUFFER_SIZE = 4096 };
 
-		Genode::Trace::Subject_id const  _subject_id;
-		Trace_buffer                     _buffer;
-		unsigned long                    _report_id        { 0 };
-		Genode::Trace::Subject_info      _info             { };
-		unsigned long long               _recent_exec_time { 0 };
-		char                             _curr_entry_data[MAX_ENTRY_LENGTH];
+		Genode::Trace::Subject_id const     _subject_id;
+		Trace_buffer                        _buffer;
+		unsigned long                       _report_id        { 0 };
+		Genode::Trace::Subject_info         _info             { };
+		unsigned long long                  _recent_exec_time { 0 };
+		char                                _curr_entry_data[MAX_ENTRY_LENGTH];
+		char                                _drain_data[DRAIN_BUFFER_SIZE];
+		Genode::Constructible<Trace_file>   _file             { };
 
 		void _update_info();
 
+		void _print_record(Trace_buffer::Record const &, bool &printed_entries);
+
 	public:
 
+		/**
+		 * Constructor
+		 *
+		 * \param vfs_env  if not nullptr, the drained trace data is
+		 *                 exported to a file of this VFS
+		 */
 		Monitor(Genode::Trace::Connection &trace,
 		        Genode::Region_map        &rm,
-		        Genode::Trace::Subject_id  subject_id);
+		        Genode::Trace::Subject_id  subject_id,
+		        Vfs::Env                  *vfs_env);
 
 		void print(bool activity, bool affinity);
 
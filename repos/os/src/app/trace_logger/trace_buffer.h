@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2018 Genode Labs GmbH
+ * Copyright (C) 2018-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -16,58 +16,161 @@
 
 /* Genode includes */
 #include <base/trace/buffer.h>
+#include <util/string.h>
+#include <util/misc_math.h>
 
 
 /**
  * Wrapper for Trace::Buffer that adds some convenient functionality
+ *
+ * The new entries of the buffer are drained in bulk into a sequence of
+ * records. Entries that were overwritten by the traced thread before they
+ * could be drained are counted as lost, using the sequence numbers of the
+ * buffer entries.
  */
 class Trace_buffer
 {
+	public:
+
+		/**
+		 * Header of a drained entry, followed by the entry data
+		 *
+		 * The data is padded such that the next record is 8-byte aligned.
+		 */
+		struct Record
+		{
+			Genode::uint64_t seq;     /* sequence number of the entry */
+			Genode::uint32_t length;  /* length of the entry data */
+			Genode::uint32_t lost;    /* lost entries preceding the entry */
+
+			char const *data() const { return (char const *)(this + 1); }
+		};
+
+		static Genode::size_t record_size(Genode::size_t length) {
+			return Genode::align_addr(sizeof(Record) + length, 3); }
+
+		/**
+		 * Call functor 'fn' for each record in the drained data
+		 */
+		template <typename FN>
+		static void for_each_record(char const *data, Genode::size_t len, FN const &fn)
+		{
+			for (Genode::size_t offset = 0; offset + sizeof(Record) <= len; ) {
+				Record const &record = *(Record const *)(data + offset);
+				fn(record);
+				offset += record_size(record.length);
+			}
+		}
+
 	private:
 
-		Genode::Trace::Buffer        &_buffer;
-		Genode::Trace::Buffer::Entry  _curr          { _buffer.first() };
-		unsigned                      _wrapped_count { 0 };
+		typedef Genode::Trace::Buffer::Entry Entry;
+
+		Genode::Trace::Buffer &_buffer;
+		Entry                  _prev     { _buffer.first() };  /* last drained */
+		bool                   _started  { false };
+		unsigned long          _next_seq { 0 };
+		unsigned long          _lost     { 0 };  /* lost since last record */
+		unsigned long          _lost_sum { 0 };
+
+		/**
+		 * Return entry with the next sequence number or a newer entry
+		 *
+		 * If the entry with the next sequence number got overwritten, the
+		 * oldest newer entry of the current buffer lap is returned and the
+		 * skipped entries are accounted as lost.
+		 */
+		Entry _next_entry()
+		{
+			/* continue after the last drained entry if still intact */
+			if (_started && _prev.seq() == _next_seq - 1) {
+				Entry const e = _buffer.next(_prev);
+				if (!e.last() && e.seq() == _next_seq)
+					return e;
+			}
+
+			/* the writer wrapped after the last drained entry or overtook us */
+			Entry e = _buffer.first();
+			for (; !e.last(); e = _buffer.next(e)) {
+				if (e.seq() < _next_seq)
+					continue;
+
+				_lost     += e.seq() - _next_seq;
+				_lost_sum += e.seq() - _next_seq;
+				_next_seq  = e.seq();
+				break;
+			}
+			return e;
+		}
 
 	public:
 
 		Trace_buffer(Genode::Trace::Buffer &buffer) : _buffer(buffer) { }
 
 		/**
-		 * Call functor for each entry that wasn't yet processed
+		 * Copy new entries as records to 'dst'
+		 *
+		 * \return  number of bytes written to 'dst', 0 if there are no new
+		 *          entries or if the next entry does not fit
 		 */
-		template <typename FUNC>
-		void for_each_new_entry(FUNC && functor)
+		Genode::size_t drain(char *dst, Genode::size_t const dst_len)
 		{
 			using namespace Genode;
 
-			bool wrapped = _buffer.wrapped() != _wrapped_count;
-			if (wrapped)
-				_wrapped_count = _buffer.wrapped();
-
-			/* initialize _curr if _buffer was empty until now */
-			if (_curr.last())
-				_curr = _buffer.first();
-
-			/* iterate over all entries that were not processed yet */
-			     Trace::Buffer::Entry e1 = _curr;
-			for (Trace::Buffer::Entry e2 = _curr; wrapped || !e2.last();
-			                          e2 = _buffer.next(e2))
-			{
-				/* if buffer wrapped, we pass the last entry once and continue at first entry */
-				if (wrapped && e2.last()) {
-					wrapped = false;
-					e2 = _buffer.first();
-					if (e2.last())
+			if (_buffer.version() != Trace::Buffer::FORMAT_VERSION)
+				return 0;
+
+			/* the buffer got re-initialized by the traced thread */
+			if (_buffer.num_entries() < _next_seq) {
+				_started  = false;
+				_next_seq = 0;
+			}
+
+			size_t used = 0;
+			while (_buffer.num_entries() != _next_seq) {
+
+				Entry const e = _next_entry();
+				if (e.last())
+					break;
+
+				unsigned long const seq    = _next_seq;
+				size_t        const length = e.length();
+				size_t        const size   = record_size(length);
+
+				if (used + size > dst_len) {
+					if (used)
 						break;
+
+					/* entry would never fit, skip it */
+					_lost++;
+					_lost_sum++;
+					_prev     = e;
+					_started  = true;
+					_next_seq = seq + 1;
+					continue;
 				}
 
-				e1 = e2;
-				functor(e1);
+				Record &record = *(Record *)(dst + used);
+				record = Record { seq, (uint32_t)length, (uint32_t)_lost };
+				memcpy(dst + used + sizeof(Record), e.data(), length);
+
+				/* skip entry if it got overwritten while being copied */
+				if (e.seq() != seq || e.length() != length)
+					continue;
+
+				used     += size;
+				_prev     = e;
+				_started  = true;
+				_lost     = 0;
+				_next_seq = seq + 1;
 			}
-			/* remember the last processed entry in _curr */
-			_curr = e1;
+			return used;
 		}
+
+		/**
+		 * Return number of entries lost since the construction
+		 */
+		unsigned long lost() const { return _lost_sum; }
 };
 
 
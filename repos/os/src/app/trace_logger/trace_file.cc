@@ -0,0 +1,112 @@
+/*
+ * \brief  File containing the drained trace data of one subject
+ * \author Martin Stein
+ * \date   2019-03-29
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* local includes */
+#include <trace_file.h>
+
+/* Genode includes */
+#include <base/trace/buffer.h>
+
+using namespace Genode;
+using Vfs::Directory_service;
+
+
+Vfs::Vfs_handle &Trace_file::_open(Vfs::Env &vfs_env, Path const &path)
+{
+	typedef Directory_service::Open_result Open_result;
+
+	Vfs::File_system &vfs = vfs_env.root_dir();
+
+	Vfs::Vfs_handle *handle = nullptr;
+	Open_result res = vfs.open(path.string(), Directory_service::OPEN_MODE_WRONLY,
+	                           &handle, vfs_env.alloc());
+
+	/* discard content of a file of an earlier subject with the same ID */
+	if (res == Open_result::OPEN_OK)
+		handle->fs().ftruncate(handle, 0);
+
+	/* try to create file if not accessible */
+	if (res == Open_result::OPEN_ERR_UNACCESSIBLE)
+		res = vfs.open(path.string(),
+		               Directory_service::OPEN_MODE_WRONLY |
+		               Directory_service::OPEN_MODE_CREATE,
+		               &handle, vfs_env.alloc());
+
+	if (res != Open_result::OPEN_OK) {
+		error("failed to open '", path, "' res=", (int)res);
+		throw Open_failed();
+	}
+	return *handle;
+}
+
+
+Trace_file::Trace_file(Vfs::Env                  &vfs_env,
+                       Trace::Subject_id          subject_id,
+                       Trace::Subject_info const &info)
+:
+	_vfs_env(vfs_env), _path("/", subject_id.id, ".trace"),
+	_handle(&_open(vfs_env, _path))
+{
+	Header header { { 'G', 'T', 'R', 'C' }, VERSION, subject_id.id,
+	                Trace::Buffer::FORMAT_VERSION, { }, { } };
+
+	strncpy(header.label,  info.session_label().string(), sizeof(header.label));
+	strncpy(header.thread, info.thread_name().string(),   sizeof(header.thread));
+
+	append((char const *)&header, sizeof(header));
+}
+
+
+Trace_file::~Trace_file()
+{
+	sync();
+	_handle->close();
+}
+
+
+void Trace_file::append(char const *data, size_t len)
+{
+	typedef Vfs::File_io_service::Write_result Write_result;
+
+	while (len) {
+		Vfs::file_size n = 0;
+
+		_handle->seek(_offset);
+		Write_result res = _handle->fs().write(_handle, data, len, n);
+
+		if (res != Write_result::WRITE_OK || n == 0) {
+
+			/* do not spam the log */
+			if (_success)
+				error("failed to write trace data to '", _path, "'");
+			_success = false;
+			return;
+		}
+		data    += n;
+		len     -= n;
+		_offset += n;
+	}
+	_success = true;
+}
+
+
+void Trace_file::sync()
+{
+	Entrypoint &ep = _vfs_env.env().ep();
+
+	while (!_handle->fs().queue_sync(_handle))
+		ep.wait_and_dispatch_one_io_signal();
+
+	while (_handle->fs().complete_sync(_handle) == Vfs::File_io_service::SYNC_QUEUED)
+		ep.wait_and_dispatch_one_io_signal();
+}
@@ -0,0 +1,85 @@
+/*
+ * \brief  File containing the drained trace data of one subject
+ * \author Martin Stein
+ * \date   2019-03-29
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _TRACE_FILE_H_
+#define _TRACE_FILE_H_
+
+/* Genode includes */
+#include <vfs/simple_env.h>
+#include <base/trace/types.h>
+
+
+/**
+ * File containing the drained trace data of one subject
+ *
+ * The file starts with a 'Header' that identifies the subject, followed by
+ * the records as produced by 'Trace_buffer::drain'.
+ */
+class Trace_file
+{
+	public:
+
+		enum { VERSION = 1 };
+
+		struct Header
+		{
+			char             magic[4];  /* "GTRC" */
+			Genode::uint32_t version;
+			Genode::uint32_t subject_id;
+			Genode::uint32_t buffer_version;
+			char             label[Genode::Session_label::capacity()];
+			char             thread[Genode::Trace::Thread_name::capacity()];
+		};
+
+		typedef Genode::String<32> Path;
+
+		struct Open_failed : Genode::Exception { };
+
+	private:
+
+		Vfs::Env        &_vfs_env;
+		Path      const  _path;
+		Vfs::Vfs_handle *_handle;
+		Vfs::file_size   _offset  { 0 };
+		bool             _success { true };
+
+		static Vfs::Vfs_handle &_open(Vfs::Env &, Path const &);
+
+		/*
+		 * Noncopyable
+		 */
+		Trace_file(Trace_file const &);
+		Trace_file &operator = (Trace_file const &);
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \throw Open_failed
+		 */
+		Trace_file(Vfs::Env                          &vfs_env,
+		           Genode::Trace::Subject_id          subject_id,
+		           Genode::Trace::Subject_info const &info);
+
+		~Trace_file();
+
+		void append(char const *data, Genode::size_t len);
+
+		/**
+		 * Write appended data through to the file system
+		 */
+		void sync();
+};
+
+#endif /* _TRACE_FILE_H_ */
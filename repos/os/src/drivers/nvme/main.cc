@@ -14,15 +14,15 @@
  */
 
 /* Genode includes */
-#include <base/allocator_avl.h>
 #include <base/attached_rom_dataspace.h>
 #include <base/component.h>
 #include <base/heap.h>
 #include <base/log.h>
-#include <block/component.h>
+#include <block/request_stream.h>
 #include <dataspace/client.h>
 #include <os/attached_mmio.h>
 #include <os/reporter.h>
+#include <root/root.h>
 #include <timer_session/connection.h>
 #include <util/bit_array.h>
 #include <util/interface.h>
@@ -40,7 +40,6 @@ using uint32_t          = Genode::uint32_t;
 using uint64_t          = Genode::uint64_t;
 using size_t            = Genode::size_t;
 using addr_t            = Genode::addr_t;
-using Packet_descriptor = Block::Packet_descriptor;
 
 } /* anonymous namespace */
 
@@ -61,7 +60,9 @@ namespace Nvme {
 	struct Sqe;
 	struct Sqe_create_cq;
 	struct Sqe_create_sq;
+	struct Sqe_delete_queue;
 	struct Sqe_identify;
+	struct Sqe_set_features;
 	struct Sqe_io;
 
 	struct Queue;
@@ -73,10 +74,9 @@ namespace Nvme {
 	enum {
 		CQE_LEN                = 16,
 		SQE_LEN                = 64,
-		MAX_IO_QUEUES          = 1,
-		MAX_IO_ENTRIES         = 128,
-		MAX_IO_ENTRIES_MASK    = MAX_IO_ENTRIES - 1,
-		MAX_IO_PENDING         = MAX_IO_ENTRIES - 1, /* tail + 1 == head -> full */
+		MAX_IO_QUEUES          = 8,
+		/* a client cannot have more requests in flight than packets queued */
+		MAX_IO_ENTRIES         = Block::Session::TX_QUEUE_SIZE,
 		MAX_ADMIN_ENTRIES      = 128,
 		MAX_ADMIN_ENTRIES_MASK = MAX_ADMIN_ENTRIES - 1,
 	};
@@ -87,15 +87,15 @@ namespace Nvme {
 		 * page (4K/8 = 512 * 4K) but 1MiB is plenty
 		 */
 		MAX_IO_LEN       =   1u << 20,
-		DMA_DS_SIZE      =   4u << 20,
-		DMA_LIST_DS_SIZE = 256u << 10,
 		MPS              = 4096u,
+		/* PRP list needed to describe a request of 'MAX_IO_LEN' bytes */
+		PRP_LIST_SIZE    = (MAX_IO_LEN / MPS) * sizeof(uint64_t),
 	};
 
 	enum {
 		IO_NSID    = 1u,
 		MAX_NS     = 1u,
-		NUM_QUEUES = 1 + MAX_NS,
+		NUM_QUEUES = 1 + MAX_IO_QUEUES,
 	};
 
 	enum Opcode {
@@ -196,17 +196,18 @@ struct Nvme::Identify_ns_data : public Genode::Mmio
 
 /*
  * Queue doorbell register
+ *
+ * The doorbells of queue y are located at 0x1000 + (2y + n) * (4 << Dstrd)
+ * with n being 0 for the submission-queue tail and 1 for the
+ * completion-queue head doorbell.
  */
 struct Nvme::Doorbell : public Genode::Mmio
 {
-	struct Sqtdbl : Register<0x00, 32>
-	{
-		struct Sqt : Bitfield< 0, 16> { }; /* submission queue tail */
-	};
+	enum { BASE = 0x1000, SQ_TAIL = 0, CQ_HEAD = 1 };
 
-	struct Cqhdbl : Register<0x04, 32>
+	struct Value : Register<0x00, 32>
 	{
-		struct Cqh : Bitfield< 0, 16> { }; /* submission queue tail */
+		struct Index : Bitfield< 0, 16> { }; /* queue tail or head */
 	};
 
 	Doorbell(addr_t const base)
@@ -345,6 +346,50 @@ struct Nvme::Sqe_create_sq : Nvme::Sqe
 };
 
 
+/*
+ * Delete submission or completion queue command
+ */
+struct Nvme::Sqe_delete_queue : Nvme::Sqe
+{
+	struct Cdw10 : Register<0x28, 32>
+	{
+		struct Qid : Bitfield< 0, 16> { }; /* queue identifier */
+	};
+
+	Sqe_delete_queue(addr_t const base) : Sqe(base) { }
+};
+
+
+/*
+ * Set features command
+ */
+struct Nvme::Sqe_set_features : Nvme::Sqe
+{
+	enum Fid {
+		NUMBER_OF_QUEUES     = 0x07,
+		INTERRUPT_COALESCING = 0x08,
+	};
+
+	struct Cdw10 : Register<0x28, 32>
+	{
+		struct Fid : Bitfield< 0, 8> { }; /* feature identifier */
+	};
+
+	struct Cdw11 : Register<0x2c, 32>
+	{
+		/* number of queues, 0-based values */
+		struct Nsqr : Bitfield< 0, 16> { }; /* submission queues requested */
+		struct Ncqr : Bitfield<16, 16> { }; /* completion queues requested */
+
+		/* interrupt coalescing */
+		struct Thr  : Bitfield< 0,  8> { }; /* aggregation threshold 0-based */
+		struct Time : Bitfield< 8,  8> { }; /* aggregation time in 100us */
+	};
+
+	Sqe_set_features(addr_t const base) : Sqe(base) { }
+};
+
+
 /*
  * I/O command
  */
@@ -593,22 +638,6 @@ struct Nvme::Controller : public Genode::Attached_mmio
 		struct Cqh : Bitfield< 0, 16> { }; /* completion queue tail */
 	};
 
-	/*
-	 * I/O submission doorbell
-	 */
-	struct Io_sdb : Register<0x1008, 32>
-	{
-		struct Sqt : Bitfield< 0, 16> { }; /* submission queue tail */
-	};
-
-	/*
-	 * I/O completion doorbell
-	 */
-	struct Io_cdb : Register<0x100C, 32>
-	{
-		struct Cqh : Bitfield< 0, 16> { }; /* completion queue tail */
-	};
-
 	/**********
 	 ** CODE **
 	 **********/
@@ -628,6 +657,12 @@ struct Nvme::Controller : public Genode::Attached_mmio
 
 	size_t _mps { 0 };
 
+	/* doorbell stride in bytes as log2 */
+	unsigned _doorbell_stride_log2 { 2 };
+
+	unsigned _io_queues { 0 };
+	uint32_t _io_entries { 0 };
+
 	Nvme::Cq _cq[NUM_QUEUES] { };
 	Nvme::Sq _sq[NUM_QUEUES] { };
 
@@ -655,6 +690,9 @@ struct Nvme::Controller : public Genode::Attached_mmio
 		QUERYNS_CID,
 		CREATE_IO_CQ_CID,
 		CREATE_IO_SQ_CID,
+		SET_FEATURES_CID,
+		DELETE_IO_SQ_CID,
+		DELETE_IO_CQ_CID,
 	};
 
 	Mem_address _nvme_query_ns[MAX_NS] { };
@@ -724,6 +762,23 @@ struct Nvme::Controller : public Genode::Attached_mmio
 
 		write<Cc::Iocqes>(log2((unsigned)CQE_LEN));
 		write<Cc::Iosqes>(log2((unsigned)SQE_LEN));
+
+		_doorbell_stride_log2 = 2 + read<Cap::Dstrd>();
+	}
+
+	/**
+	 * Write doorbell register
+	 *
+	 * \param qid    queue identifier
+	 * \param which  'Doorbell::SQ_TAIL' or 'Doorbell::CQ_HEAD'
+	 * \param value  new queue tail or head
+	 */
+	void _write_doorbell(uint16_t qid, unsigned which, uint32_t value)
+	{
+		addr_t const offset = Doorbell::BASE
+		                    + ((2*qid + which) << _doorbell_stride_log2);
+
+		Doorbell(base() + offset).write<Doorbell::Value::Index>(value);
 	}
 
 	/**
@@ -752,7 +807,7 @@ struct Nvme::Controller : public Genode::Attached_mmio
 	 */
 	bool _queue_full(Nvme::Sq const &sq, Nvme::Cq const &cq) const
 	{
-		return ((sq.tail + 1) & (MAX_IO_ENTRIES_MASK)) == cq.head;
+		return ((sq.tail + 1) % sq.max_entries) == cq.head;
 	}
 
 	/**
@@ -793,16 +848,15 @@ struct Nvme::Controller : public Genode::Attached_mmio
 	/**
 	 * Wait until admin command has finished
 	 *
-	 * \param num  number of attempts
-	 * \param cid  command identifier
+	 * \param num     number of attempts
+	 * \param cid     command identifier
+	 * \param result  command-specific dword 0 of the completion entry
 	 *
 	 * \return  returns true if attempt to wait was successfull, otherwise
 	 *          false is returned
 	 */
-	bool _wait_for_admin_cq(uint32_t num, uint16_t cid)
+	bool _wait_for_admin_cq(uint32_t num, uint16_t cid, uint32_t &result)
 	{
-		bool success = false;
-
 		for (uint32_t i = 0; i < num; i++) {
 			_delayer.usleep(100 * 1000);
 
@@ -812,14 +866,23 @@ struct Nvme::Controller : public Genode::Attached_mmio
 				continue;
 			}
 
-			_admin_cq.advance_head();
+			result = b.read<Nvme::Cqe::Dw0>();
+			bool const succeeded = Nvme::Cqe::succeeded(b);
 
-			success = true;
+			_admin_cq.advance_head();
 
 			write<Admin_cdb::Cqh>(_admin_cq.head);
+
+			return succeeded;
 		}
 
-		return success;
+		return false;
+	}
+
+	bool _wait_for_admin_cq(uint32_t num, uint16_t cid)
+	{
+		uint32_t result = 0;
+		return _wait_for_admin_cq(num, cid, result);
 	}
 
 	/**
@@ -945,12 +1008,12 @@ struct Nvme::Controller : public Genode::Attached_mmio
 	void _setup_io_cq(uint16_t id)
 	{
 		Nvme::Cq &cq = _cq[id];
-		if (!cq.valid()) { _setup_queue(cq, MAX_IO_ENTRIES, CQE_LEN); }
+		if (!cq.valid()) { _setup_queue(cq, _io_entries, CQE_LEN); }
 
 		Sqe_create_cq b(_admin_command(Opcode::CREATE_IO_CQ, 0, CREATE_IO_CQ_CID));
 		b.write<Nvme::Sqe::Prp1>(cq.pa);
 		b.write<Nvme::Sqe_create_cq::Cdw10::Qid>(id);
-		b.write<Nvme::Sqe_create_cq::Cdw10::Qsize>(MAX_IO_ENTRIES_MASK);
+		b.write<Nvme::Sqe_create_cq::Cdw10::Qsize>(_io_entries - 1);
 		b.write<Nvme::Sqe_create_cq::Cdw11::Pc>(1);
 		b.write<Nvme::Sqe_create_cq::Cdw11::En>(1);
 
@@ -973,12 +1036,12 @@ struct Nvme::Controller : public Genode::Attached_mmio
 	void _setup_io_sq(uint16_t id, uint16_t cqid)
 	{
 		Nvme::Sq &sq = _sq[id];
-		if (!sq.valid()) { _setup_queue(sq, MAX_IO_ENTRIES, SQE_LEN); }
+		if (!sq.valid()) { _setup_queue(sq, _io_entries, SQE_LEN); }
 
 		Sqe_create_sq b(_admin_command(Opcode::CREATE_IO_SQ, 0, CREATE_IO_SQ_CID));
 		b.write<Nvme::Sqe::Prp1>(sq.pa);
 		b.write<Nvme::Sqe_create_sq::Cdw10::Qid>(id);
-		b.write<Nvme::Sqe_create_sq::Cdw10::Qsize>(MAX_IO_ENTRIES_MASK);
+		b.write<Nvme::Sqe_create_sq::Cdw10::Qsize>(_io_entries - 1);
 		b.write<Nvme::Sqe_create_sq::Cdw11::Pc>(1);
 		b.write<Nvme::Sqe_create_sq::Cdw11::Qprio>(0b00); /* urgent for now */
 		b.write<Nvme::Sqe_create_sq::Cdw11::Cqid>(cqid);
@@ -991,6 +1054,72 @@ struct Nvme::Controller : public Genode::Attached_mmio
 		}
 	}
 
+	/**
+	 * Delete I/O submission or completion queue
+	 *
+	 * \param opc  'DELETE_IO_SQ' or 'DELETE_IO_CQ'
+	 * \param id   queue identifier
+	 *
+	 * \return  true if the controller deleted the queue
+	 */
+	bool _delete_io_queue(Opcode opc, uint16_t id)
+	{
+		uint16_t const cid = (opc == Opcode::DELETE_IO_SQ) ? DELETE_IO_SQ_CID
+		                                                   : DELETE_IO_CQ_CID;
+
+		Sqe_delete_queue b(_admin_command(opc, 0, cid));
+		b.write<Nvme::Sqe_delete_queue::Cdw10::Qid>(id);
+
+		write<Admin_sdb::Sqt>(_admin_sq.tail);
+
+		/* deleting a submission queue awaits the abort of its commands */
+		return _wait_for_admin_cq(50, cid);
+	}
+
+	/**
+	 * Issue set-features command
+	 *
+	 * \param fid     feature identifier
+	 * \param value   command dword 11
+	 * \param result  command-specific dword 0 of the completion entry
+	 *
+	 * \return  true if the controller accepted the feature
+	 */
+	bool _set_features(Sqe_set_features::Fid fid, uint32_t value,
+	                   uint32_t &result)
+	{
+		Sqe_set_features b(_admin_command(Opcode::SET_FEATURES, 0, SET_FEATURES_CID));
+		b.write<Nvme::Sqe_set_features::Cdw10::Fid>(fid);
+		b.write<Nvme::Sqe_set_features::Cdw11>(value);
+
+		write<Admin_sdb::Sqt>(_admin_sq.tail);
+
+		return _wait_for_admin_cq(10, SET_FEATURES_CID, result);
+	}
+
+	/**
+	 * Request number of I/O queue pairs from controller
+	 *
+	 * \return  number of queue pairs allocated by the controller
+	 */
+	unsigned _request_io_queues(unsigned num)
+	{
+		Sqe_set_features::Cdw11::access_t value = 0;
+		Sqe_set_features::Cdw11::Nsqr::set(value, num - 1);
+		Sqe_set_features::Cdw11::Ncqr::set(value, num - 1);
+
+		uint32_t result = 0;
+		if (!_set_features(Sqe_set_features::NUMBER_OF_QUEUES, value, result)) {
+			Genode::warning("could not set number of queues, use one queue");
+			return 1;
+		}
+
+		/* the controller reports the allocated queues 0-based */
+		unsigned const sq = Sqe_set_features::Cdw11::Nsqr::get(result) + 1;
+		unsigned const cq = Sqe_set_features::Cdw11::Ncqr::get(result) + 1;
+		return Genode::min(num, Genode::min(sq, cq));
+	}
+
 	/**
 	 * Constructor
 	 */
@@ -1044,59 +1173,160 @@ struct Nvme::Controller : public Genode::Attached_mmio
 	}
 
 	/**
-	 * Setup I/O queue
+	 * Setup I/O queue pairs
+	 *
+	 * The I/O queue pair n uses the queue identifier n + 1 for its
+	 * submission as well as its completion queue.
+	 *
+	 * \param num      number of queue pairs requested
+	 * \param entries  number of entries per queue
+	 *
+	 * \throw Initialization_failed() in case a queue could not be created
 	 */
-	void setup_io(uint16_t cid, uint16_t sid)
+	void setup_io(unsigned num, uint32_t entries)
 	{
-		_setup_io_cq(cid);
-		_setup_io_sq(sid, cid);
+		/* the controller limits the queue size, 'Mqes' is 0-based */
+		uint32_t const mqes = read<Cap::Mqes>() + 1;
+
+		_io_entries = Genode::max(2u, Genode::min(entries,
+		                          Genode::min(mqes, (uint32_t)MAX_IO_ENTRIES)));
+
+		_io_queues = _request_io_queues(Genode::max(1u,
+		                                Genode::min(num, (unsigned)MAX_IO_QUEUES)));
+
+		for (unsigned i = 1; i <= _io_queues; i++) {
+			_setup_io_cq(i);
+			_setup_io_sq(i, i);
+		}
 	}
 
 	/**
-	 * Get next free IO submission queue slot
+	 * Abort all outstanding I/O commands by re-creating the I/O queues
+	 *
+	 * The controller completes the deletion of a submission queue not
+	 * until the commands of the queue are completed or aborted. Hence,
+	 * it does not access the memory of these commands afterwards. No
+	 * completions are posted for the aborted commands.
+	 *
+	 * \return  false if a queue could not be deleted or re-created
 	 */
-	addr_t io_command(uint16_t id)
+	bool reset_io()
 	{
-		Nvme::Sq &sq = _sq[id];
-		Nvme::Cq &cq = _cq[id];
+		for (uint16_t i = 1; i <= _io_queues; i++) {
+			if (!_delete_io_queue(Opcode::DELETE_IO_SQ, i)
+			 || !_delete_io_queue(Opcode::DELETE_IO_CQ, i)) {
+				Genode::error("delete I/O queue ", i, " failed");
+				return false;
+			}
+		}
 
-		if (_queue_full(sq, cq)) { return 0ul; }
+		for (uint16_t i = 1; i <= _io_queues; i++) {
 
-		Sqe e(sq.next());
-		e.write<Nvme::Sqe::Cdw0::Cid>(sq.id++);
-		e.write<Nvme::Sqe::Nsid>(id);
-		return e.base();
+			/* stale entries must not match the phase of the new queue */
+			Nvme::Cq &cq = _cq[i];
+			Genode::memset((void *)cq.va, 0, cq.max_entries * CQE_LEN);
+			cq.head  = 0;
+			cq.phase = 1;
+
+			_sq[i].tail = 0;
+
+			try {
+				_setup_io_cq(i);
+				_setup_io_sq(i, i);
+			} catch (Initialization_failed) { return false; }
+		}
+		return true;
 	}
 
 	/**
-	 * Write current I/O submission queue tail
+	 * Disable controller, which stops the processing of all commands
+	 *
+	 * \return  false if the controller did not acknowledge the request
 	 */
-	void commit_io(uint16_t id)
+	bool disable()
 	{
-		Nvme::Sq &sq = _sq[id];
-		write<Io_sdb::Sqt>(sq.tail);
+		write<Intms>(~0u);
+		write<Cc::En>(0);
+
+		try { _wait_for_rdy(0); }
+		catch (...) { return false; }
+
+		return true;
 	}
 
 	/**
-	 * Flush cache
+	 * Configure interrupt coalescing
+	 *
+	 * \param threshold  minimal number of completions per interrupt
+	 * \param time_us    maximal delay of an interrupt in microseconds
 	 */
-	void flush_cache(uint16_t id)
+	void intr_coalescing(unsigned threshold, unsigned time_us)
 	{
-		(void)id;
+		Sqe_set_features::Cdw11::access_t value = 0;
+		Sqe_set_features::Cdw11::Thr::set(value,
+			Genode::min(Genode::max(threshold, 1u), 256u) - 1);
+		Sqe_set_features::Cdw11::Time::set(value,
+			Genode::min((time_us + 99) / 100, 255u));
+
+		uint32_t result = 0;
+		if (!_set_features(Sqe_set_features::INTERRUPT_COALESCING, value, result))
+			Genode::warning("interrupt coalescing not supported");
+	}
+
+	/**
+	 * Return number of I/O queue pairs
+	 */
+	unsigned io_queues() const { return _io_queues; }
+
+	/**
+	 * Return number of entries per I/O queue
+	 */
+	uint32_t io_entries() const { return _io_entries; }
+
+	/**
+	 * Get next free IO submission queue slot
+	 *
+	 * \param qid  identifier of the I/O queue
+	 * \param cid  command identifier
+	 */
+	addr_t io_command(uint16_t qid, uint16_t cid)
+	{
+		Nvme::Sq &sq = _sq[qid];
+		Nvme::Cq &cq = _cq[qid];
+
+		if (_queue_full(sq, cq)) { return 0ul; }
+
+		Sqe e(sq.next());
+		e.write<Nvme::Sqe::Cdw0::Cid>(cid);
+		e.write<Nvme::Sqe::Nsid>(IO_NSID);
+		return e.base();
+	}
+
+	/**
+	 * Write current I/O submission queue tail
+	 */
+	void commit_io(uint16_t qid)
+	{
+		_write_doorbell(qid, Doorbell::SQ_TAIL, _sq[qid].tail);
 	}
 
 	/**
 	 * Process every pending I/O completion
 	 *
+	 * The completion-queue head doorbell is written once after all
+	 * available entries were processed.
+	 *
 	 * \param func  function that is called on each completion
 	 */
 	template <typename FUNC>
-	void handle_io_completions(uint16_t id, FUNC const &func)
+	void handle_io_completions(uint16_t qid, FUNC const &func)
 	{
-		Nvme::Cq &cq = _cq[id];
+		Nvme::Cq &cq = _cq[qid];
 
 		if (!cq.valid()) { return; }
 
+		bool processed = false;
+
 		for (;;) {
 			Cqe e(cq.next());
 
@@ -1106,13 +1336,11 @@ struct Nvme::Controller : public Genode::Attached_mmio
 			func(e);
 
 			cq.advance_head();
-
-			/*
-			 * Instead of acknowledging the completions here,
-			 * we could handle them batch-wise after the loop.
-			 */
-			write<Io_cdb::Cqh>(cq.head);
+			processed = true;
 		}
+
+		if (processed)
+			_write_doorbell(qid, Doorbell::CQ_HEAD, cq.head);
 	}
 
 	/**
@@ -1191,7 +1419,7 @@ struct Nvme::Controller : public Genode::Attached_mmio
  ** Block driver **
  ******************/
 
-class Driver : public Block::Driver
+class Driver : Genode::Noncopyable
 {
 	public:
 
@@ -1201,13 +1429,13 @@ class Driver : public Block::Driver
 		bool _verbose_mem      { false };
 		bool _verbose_regs     { false };
 
+		using Response = Block::Request_stream::Response;
+
 	private:
 
 		Genode::Env       &_env;
 		Genode::Allocator &_alloc;
 
-		Genode::Signal_context_capability _announce_sigh;
-
 		Genode::Attached_rom_dataspace _config_rom { _env, "config" };
 
 		void _handle_config_update()
@@ -1261,110 +1489,164 @@ class Driver : public Block::Driver
 
 		Genode::Constructible<Nvme::Pci> _nvme_pci { };
 
-		struct Io_buffer
-		{
-			addr_t pa   { 0 };
-			addr_t va   { 0 };
-			size_t size { 0 };
+		/*
+		 * The packet-stream buffer of the Block session is allocated as
+		 * DMA memory. Hence, the controller transfers the payload of a
+		 * request directly from or to the buffer shared with the client.
+		 */
+		Genode::Ram_dataspace_capability _dma_buffer    { };
+		addr_t                           _dma_phys_base { 0 };
+		size_t                           _dma_size      { 0 };
 
-			bool valid() const { return size && pa && va; }
-			void invalidate() { Genode::memset(this, 0, sizeof(*this)); }
-		};
+		/*
+		 * Each command slot owns one PRP list that is large enough to
+		 * describe a request of 'MAX_IO_LEN' bytes.
+		 */
+		Genode::Ram_dataspace_capability _prp_list_ds { };
+		addr_t                           _prp_list_pa { 0 };
+		addr_t                           _prp_list_va { 0 };
 
-		template <unsigned ENTRIES, size_t MPS>
-		struct Io_buffer_mapper
+		void _setup_prp(Nvme::Sqe_io &b, uint16_t qid, uint16_t cid,
+		                addr_t const pa, size_t const len)
 		{
-			using Bitmap = Util::Bitmap<ENTRIES>;
-			Bitmap _bitmap { };
+			size_t const mps = _nvme_ctrlr->mps();
 
-			Util::Slots<Io_buffer, Nvme::MAX_IO_ENTRIES> _buffers { };
+			b.write<Nvme::Sqe::Prp1>(pa);
 
-			Genode::Ram_dataspace_capability _ds { };
-			addr_t _phys_addr { 0 };
-			addr_t _virt_addr { 0 };
+			/* the first entry covers the payload up to the next page boundary */
+			size_t const first = mps - (pa & (mps - 1));
+			if (len <= first) { return; }
 
-			Io_buffer_mapper(Genode::Ram_dataspace_capability ds,
-			                 addr_t phys, addr_t virt)
-			: _ds(ds), _phys_addr(phys), _virt_addr(virt) { }
+			addr_t const next  = pa + first;
+			size_t const pages = (len - first + mps - 1) / mps;
 
-			Io_buffer *alloc(size_t size)
-			{
-				Io_buffer *iob = _buffers.get();
-				if (!iob) { return nullptr; }
-
-				try {
-					size_t const bits  = size / MPS;
-					addr_t const start = _bitmap.alloc(bits);
-					iob->pa   = (start * MPS) + _phys_addr;
-					iob->va   = (start * MPS) + _virt_addr;
-					iob->size = size;
-				} catch (...) {
-					iob->invalidate();
-					return nullptr;
-				}
-				return iob;
+			/* payload will fit into 2 mps chunks */
+			if (pages == 1) {
+				b.write<Nvme::Sqe::Prp2>(next);
+				return;
+			}
+
+			/* payload needs list of mps chunks */
+			size_t const offset = ((qid - 1) * _nvme_ctrlr->io_entries() + cid)
+			                    * Nvme::PRP_LIST_SIZE;
+
+			uint64_t *list = (uint64_t*)(_prp_list_va + offset);
+			for (size_t i = 0; i < pages; i++) {
+				list[i] = next + i * mps;
 			}
+			b.write<Nvme::Sqe::Prp2>(_prp_list_pa + offset);
+		}
+
+		/**************
+		 ** Requests **
+		 **************/
 
-			void free(Io_buffer *iob)
+		struct Command_slot
+		{
+			enum State { FREE, PENDING, COMPLETE };
+
+			Block::Request request { };
+			State          state   { FREE };
+		};
+
+		struct Io_queue
+		{
+			Command_slot slots[Nvme::MAX_IO_ENTRIES] { };
+
+			/* stack of unused command identifiers */
+			uint16_t _cids[Nvme::MAX_IO_ENTRIES] { };
+			unsigned _cids_free { 0 };
+
+			bool doorbell_pending { false };
+
+			/*
+			 * One queue entry always stays unused to distinguish a full
+			 * from an empty queue.
+			 */
+			void init(unsigned entries)
 			{
-				if (iob) {
-					size_t const size = iob->size;
-					addr_t const start = (iob->pa - _phys_addr) / MPS;
-					_bitmap.free(start, size / MPS);
-					iob->invalidate();
+				_cids_free = 0;
+				for (unsigned cid = entries - 1; cid > 0; cid--) {
+					_cids[_cids_free++] = (uint16_t)(cid - 1);
 				}
 			}
+
+			unsigned free() const { return _cids_free; }
+
+			uint16_t alloc_cid() { return _cids[--_cids_free]; }
+
+			void release_cid(uint16_t cid) { _cids[_cids_free++] = cid; }
 		};
 
-		Genode::Constructible<Io_buffer_mapper<Nvme::DMA_DS_SIZE / Nvme::MPS,
-		                                       Nvme::MPS>> _io_mapper { };
+		Io_queue _queues[Nvme::MAX_IO_QUEUES] { };
+
+		/*
+		 * Completed commands in the order of their completion, encoded
+		 * as 'queue index << 16 | cid'
+		 */
+		enum { MAX_COMMANDS = Nvme::MAX_IO_QUEUES * Nvme::MAX_IO_ENTRIES };
 
-		Genode::Constructible<Io_buffer_mapper<Nvme::DMA_LIST_DS_SIZE / Nvme::MPS,
-		                                       Nvme::MPS>> _io_list_mapper { };
+		uint32_t _completed[MAX_COMMANDS] { };
+		unsigned _completed_head { 0 };
+		unsigned _completed_tail { 0 };
 
-		void _setup_large_request(addr_t           va,
-		                          Io_buffer const &iob,
-		                          size_t    const  num,
-		                          size_t    const  mps)
-		{
-			/* omit first page */
-			addr_t    pa = iob.pa + mps;
-			uint64_t *p  = (uint64_t*)va;
+		unsigned _requests_pending { 0 };
+		unsigned _writes_pending   { 0 };
 
-			for (size_t i = 0; i < num; i++) {
-				p[i]  = pa;
-				pa   += mps;
+		/* set if the controller had to be disabled to stop outstanding I/O */
+		bool _disabled { false };
+
+		/**
+		 * Forget all requests, called once the controller ceased to
+		 * process them
+		 */
+		void _reset_requests()
+		{
+			for (unsigned q = 0; q < _nvme_ctrlr->io_queues(); q++) {
+				for (Command_slot &slot : _queues[q].slots) { slot = Command_slot(); }
+				_queues[q].init(_nvme_ctrlr->io_entries());
+				_queues[q].doorbell_pending = false;
 			}
-		}
 
-		/**************
-		 ** Requests **
-		 **************/
+			_completed_head   = _completed_tail = 0;
+			_requests_pending = 0;
+			_writes_pending   = 0;
+		}
 
-		struct Request
+		bool _overlaps_pending(Block::Operation const &op, bool write)
 		{
-			uint32_t           id     { 0 };
-			Packet_descriptor  pd     {   };
-			char              *buffer { nullptr };
+			/* concurrent reads may overlap */
+			if (!write && !_writes_pending) { return false; }
 
-			Io_buffer *iob           { nullptr };
-			Io_buffer *large_request { nullptr };
+			Block::block_number_t const start = op.block_number;
+			Block::block_number_t const end   = start + op.count;
 
-			bool valid() const { return id != 0; }
+			unsigned const entries = _nvme_ctrlr->io_entries();
 
-			void invalidate()
-			{
-				id     = 0;
-				buffer = nullptr;
-				pd     = Packet_descriptor();
+			for (unsigned q = 0; q < _nvme_ctrlr->io_queues(); q++) {
+				for (unsigned cid = 0; cid < entries; cid++) {
 
-				iob           = nullptr;
-				large_request = nullptr;
-			}
-		};
+					Command_slot const &slot = _queues[q].slots[cid];
+					if (slot.state == Command_slot::FREE) { continue; }
+
+					Block::Operation const &other = slot.request.operation;
+					if (!write && other.type != Block::Operation::Type::WRITE) {
+						continue;
+					}
 
-		Util::Slots<Request, Nvme::MAX_IO_ENTRIES> _requests         {   };
-		size_t                                     _requests_pending { 0 };
+					Block::block_number_t const other_end =
+						other.block_number + other.count;
+
+					if (start < other_end && other.block_number < end) {
+						if (_verbose_checks) {
+							Genode::warning("overlap: ", op, " with ", other);
+						}
+						return true;
+					}
+				}
+			}
+			return false;
+		}
 
 		/*********************
 		 ** MMIO Controller **
@@ -1384,56 +1666,37 @@ class Driver : public Block::Driver
 
 		void _handle_completions()
 		{
-			_nvme_ctrlr->handle_io_completions(Nvme::IO_NSID, [&] (Nvme::Cqe const &b) {
+			unsigned const entries = _nvme_ctrlr->io_entries();
 
-				if (_verbose_io) { Nvme::Cqe::dump(b); }
+			for (uint16_t qid = 1; qid <= _nvme_ctrlr->io_queues(); qid++) {
 
-				uint32_t const id = Nvme::Cqe::request_id(b);
-
-				Request *r = _requests.lookup([&] (Request &r) {
-					if (r.id == id) { return true; }
-					return false;
-				});
-				if (!r) {
-					Genode::error("no pending request found for CQ entry");
-					Nvme::Cqe::dump(b);
-					return;
-				}
+				Io_queue &queue = _queues[qid - 1];
 
-				bool const succeeded = Nvme::Cqe::succeeded(b);
+				_nvme_ctrlr->handle_io_completions(qid, [&] (Nvme::Cqe const &b) {
 
-				Packet_descriptor pd = r->pd;
-				pd.succeeded(succeeded);
+					if (_verbose_io) { Nvme::Cqe::dump(b); }
 
-				Io_buffer *iob = r->iob;
+					uint16_t const cid = b.read<Nvme::Cqe::Cid>();
 
-				if (succeeded && pd.operation() == Packet_descriptor::READ) {
-					size_t const len = pd.block_count() * _info.block_size;
-					Genode::memcpy(r->buffer, (void*)iob->va, len);
-				}
-				_io_mapper->free(iob);
+					if (cid >= entries
+					 || queue.slots[cid].state != Command_slot::PENDING) {
+						Genode::error("no pending request found for CQ entry");
+						Nvme::Cqe::dump(b);
+						return;
+					}
 
-				if (r->large_request) {
-					_io_list_mapper->free(r->large_request);
-				}
+					Command_slot &slot = queue.slots[cid];
+					slot.request.success = Nvme::Cqe::succeeded(b);
+					slot.state           = Command_slot::COMPLETE;
 
-				r->invalidate();
-				--_requests_pending;
-				ack_packet(pd, succeeded);
-			});
-		}
+					_completed[_completed_tail++ % MAX_COMMANDS] =
+						((uint32_t)(qid - 1) << 16) | cid;
 
-		void _handle_intr()
-		{
-			_nvme_ctrlr->mask_intr();
-			_handle_completions();
-			_nvme_ctrlr->clear_intr();
-			_nvme_pci->ack_irq();
+					--_requests_pending;
+				});
+			}
 		}
 
-		Genode::Signal_handler<Driver> _intr_sigh {
-			_env.ep(), *this, &Driver::_handle_intr };
-
 		/***********
 		 ** Block **
 		 ***********/
@@ -1444,10 +1707,12 @@ class Driver : public Block::Driver
 
 		/**
 		 * Constructor
+		 *
+		 * \param irq_sigh  signal handler called on completion interrupts
 		 */
 		Driver(Genode::Env &env, Genode::Allocator &alloc,
-		       Genode::Signal_context_capability sigh)
-		: Block::Driver(env.ram()), _env(env), _alloc(alloc), _announce_sigh(sigh)
+		       Genode::Signal_context_capability irq_sigh)
+		: _env(env), _alloc(alloc)
 		{
 			_config_rom.sigh(_config_sigh);
 			_handle_config_update();
@@ -1477,7 +1742,6 @@ class Driver : public Block::Driver
 			_nvme_ctrlr->identify();
 
 			if (_verbose_identify) {
-				Genode::warning(_requests_pending);
 				_nvme_ctrlr->dump_identify();
 				_nvme_ctrlr->dump_nslist();
 			}
@@ -1486,46 +1750,44 @@ class Driver : public Block::Driver
 			 * Setup I/O
 			 */
 
-			{
-				Genode::Ram_dataspace_capability ds = _nvme_pci->alloc(Nvme::DMA_DS_SIZE);
-				if (!ds.valid()) {
-					Genode::error("could not allocate DMA backing store");
-					throw Nvme::Controller::Initialization_failed();
-				}
-				addr_t const phys_addr = Genode::Dataspace_client(ds).phys_addr();
-				addr_t const virt_addr = (addr_t)_env.rm().attach(ds);
-				_io_mapper.construct(ds, phys_addr, virt_addr);
+			Genode::Xml_node const config = _config_rom.xml();
 
-				if (_verbose_mem) {
-					Genode::log("DMA", " virt: [", Genode::Hex(virt_addr), ",",
-					                   Genode::Hex(virt_addr + Nvme::DMA_DS_SIZE), "]",
-					                   " phys: [", Genode::Hex(phys_addr), ",",
-					                   Genode::Hex(phys_addr + Nvme::DMA_DS_SIZE), "]");
-				}
+			_nvme_ctrlr->setup_io(config.attribute_value("io_queues", 4u),
+			                      config.attribute_value("io_queue_depth",
+			                                             (unsigned)Nvme::MAX_IO_ENTRIES / 2));
+
+			for (unsigned i = 0; i < _nvme_ctrlr->io_queues(); i++) {
+				_queues[i].init(_nvme_ctrlr->io_entries());
 			}
 
+			config.with_sub_node("interrupt_coalescing", [&] (Genode::Xml_node node) {
+				_nvme_ctrlr->intr_coalescing(node.attribute_value("threshold", 1u),
+				                             node.attribute_value("time_us",   0u));
+			});
+
 			{
-				Genode::Ram_dataspace_capability ds = _nvme_pci->alloc(Nvme::DMA_LIST_DS_SIZE);
-				if (!ds.valid()) {
+				size_t const size = _nvme_ctrlr->io_queues()
+				                  * _nvme_ctrlr->io_entries()
+				                  * Nvme::PRP_LIST_SIZE;
+
+				_prp_list_ds = _nvme_pci->alloc(size);
+				if (!_prp_list_ds.valid()) {
 					Genode::error("could not allocate DMA list-pages backing store");
 					throw Nvme::Controller::Initialization_failed();
 				}
-				addr_t const phys_addr = Genode::Dataspace_client(ds).phys_addr();
-				addr_t const virt_addr = (addr_t)_env.rm().attach(ds);
-				_io_list_mapper.construct(ds, phys_addr, virt_addr);
+				_prp_list_pa = Genode::Dataspace_client(_prp_list_ds).phys_addr();
+				_prp_list_va = (addr_t)_env.rm().attach(_prp_list_ds);
 
 				if (_verbose_mem) {
-					Genode::log("DMA list-pages", " virt: [", Genode::Hex(virt_addr), ",",
-					                   Genode::Hex(virt_addr + Nvme::DMA_DS_SIZE), "]",
-					                   " phys: [", Genode::Hex(phys_addr), ",",
-					                   Genode::Hex(phys_addr + Nvme::DMA_DS_SIZE), "]");
+					Genode::log("DMA list-pages", " virt: [", Genode::Hex(_prp_list_va), ",",
+					                   Genode::Hex(_prp_list_va + size), "]",
+					                   " phys: [", Genode::Hex(_prp_list_pa), ",",
+					                   Genode::Hex(_prp_list_pa + size), "]");
 				}
 			}
 
-			_nvme_ctrlr->setup_io(Nvme::IO_NSID, Nvme::IO_NSID);
-
 			/* from now on use interrupts */
-			_nvme_pci->sigh_irq(_intr_sigh);
+			_nvme_pci->sigh_irq(irq_sigh);
 			_nvme_ctrlr->clear_intr();
 
 			/*
@@ -1553,7 +1815,9 @@ class Driver : public Block::Driver
 
 			Genode::log("Block",                " "
 			            "size:",  _info.block_size,  " "
-			            "count:", _info.block_count);
+			            "count:", _info.block_count, " "
+			            "I/O queues:", _nvme_ctrlr->io_queues(), " "
+			            "depth:",      _nvme_ctrlr->io_entries());
 
 			/* generate Report if requested */
 			try {
@@ -1563,137 +1827,250 @@ class Driver : public Block::Driver
 					_report_namespaces();
 				}
 			} catch (...) { }
-
-			/* finally announce Block session */
-			Genode::Signal_transmitter(_announce_sigh).submit();
 		}
 
 		~Driver() { }
 
-		/*******************************
-		 **  Block::Driver interface  **
-		 *******************************/
+		Block::Session::Info info() const { return _info; }
 
-		Block::Session::Info info() const override { return _info; }
+		/**
+		 * Return true if the controller is unusable for new sessions
+		 */
+		bool disabled() const { return _disabled; }
 
-		void _io(bool write, Block::sector_t lba, size_t count,
-		         char *buffer, Packet_descriptor &pd)
+		/**
+		 * Allocate DMA-capable packet-stream buffer of the Block session
+		 *
+		 * \return  invalid capability if the allocation failed
+		 */
+		Genode::Ram_dataspace_capability alloc_dma_buffer(size_t size)
 		{
-			using namespace Genode;
+			Genode::Ram_dataspace_capability const ds = _nvme_pci->alloc(size);
+			if (!ds.valid()) {
+				Genode::error("could not allocate DMA buffer of ", size, " bytes");
+				return ds;
+			}
 
-			size_t const len = count * _info.block_size;
+			_dma_buffer    = ds;
+			_dma_phys_base = Genode::Dataspace_client(_dma_buffer).phys_addr();
+			_dma_size      = size;
 
-			if (_verbose_io) {
-				Genode::error(write ? "write" : "read", " "
-				              "lba:",           lba,    " "
-				              "count:",         count,  " "
-				              "buffer:", (void*)buffer, " "
-				              "len:",           len);
+			if (_verbose_mem) {
+				Genode::log("DMA buffer phys: [", Genode::Hex(_dma_phys_base), ",",
+				            Genode::Hex(_dma_phys_base + size), "]");
 			}
+			return _dma_buffer;
+		}
 
-			if (len > Nvme::MAX_IO_LEN) {
-				error("request too large (max:", (size_t)Nvme::MAX_IO_LEN, " bytes)");
-				throw Io_error();
+		/**
+		 * Release packet-stream buffer
+		 *
+		 * Commands still executed by the controller are awaited before
+		 * the buffer is handed back. Commands that do not complete in time
+		 * are aborted by re-creating the I/O queues. If even that fails,
+		 * the controller gets disabled. A buffer that the controller may
+		 * still access is never freed.
+		 */
+		void free_dma_buffer()
+		{
+			enum { MAX_ATTEMPTS = 1000, DELAY_US = 1000 };
+
+			for (unsigned i = 0; _requests_pending && i < MAX_ATTEMPTS; i++) {
+				_delayer.usleep(DELAY_US);
+				_handle_completions();
 			}
 
-			if (_requests_pending == (Nvme::MAX_IO_PENDING)) {
-				throw Request_congestion();
+			if (_requests_pending) {
+				Genode::warning(_requests_pending, " requests still pending, "
+				                "reset I/O queues");
+
+				if (!_nvme_ctrlr->reset_io()) {
+					Genode::error("could not reset I/O queues, disable controller");
+					_disabled = true;
+
+					if (!_nvme_ctrlr->disable()) {
+						Genode::error("controller not disabled, keep DMA buffer");
+						_dma_buffer = Genode::Ram_dataspace_capability();
+						return;
+					}
+				}
+			}
+
+			/* drop the results of the completed and aborted requests */
+			_reset_requests();
+
+			_nvme_pci->free(_dma_buffer);
+			_dma_buffer    = Genode::Ram_dataspace_capability();
+			_dma_phys_base = 0;
+			_dma_size      = 0;
+		}
+
+		/**
+		 * Submit block request to the controller
+		 *
+		 * The command is queued at the least occupied I/O queue. The
+		 * controller gets notified about new commands by 'commit_io'.
+		 */
+		Response submit(Block::Request const &request)
+		{
+			Block::Operation const &op = request.operation;
+
+			bool const write = op.type == Block::Operation::Type::WRITE;
+			bool const sync  = op.type == Block::Operation::Type::SYNC;
+
+			if (!write && !sync && op.type != Block::Operation::Type::READ) {
+				return Response::REJECTED;
 			}
 
-			Block::sector_t const lba_end = lba + count - 1;
-			auto overlap_check = [&] (Request &req) {
-				Block::sector_t const start = req.pd.block_number();
-				Block::sector_t const end   = start + req.pd.block_count() - 1;
-
-				bool const in_req    = (lba >= start && lba_end <= end);
-				bool const over_req  = (lba <= start && lba_end <= end) &&
-				                       (start >= lba && start <= lba_end);
-				bool const cross_req = (lba <= start && lba_end >= end);
-				bool const overlap   = (in_req || over_req || cross_req);
-
-				if (_verbose_checks && overlap) {
-					warning("overlap: ", "[", lba, ",", lba_end, ") with "
-					        "[", start,   ",", end, ")",
-					        " ", in_req, " ", over_req, " ", cross_req);
+			if (write && !_info.writeable) { return Response::REJECTED; }
+
+			size_t const len = op.count * _info.block_size;
+
+			if (!sync) {
+				if (_verbose_io) {
+					Genode::log(op, " offset:", request.offset, " len:", len);
+				}
+
+				if (len > Nvme::MAX_IO_LEN) {
+					Genode::error("request too large (max:", (size_t)Nvme::MAX_IO_LEN, " bytes)");
+					return Response::REJECTED;
 				}
-				return overlap;
-			};
-			if (_requests.for_each(overlap_check)) { throw Request_congestion(); }
 
-			Request *r = _requests.get();
-			if (!r) { throw Request_congestion(); }
+				bool const valid = op.count
+				                && op.block_number + op.count <= _info.block_count
+				                && request.offset >= 0
+				                && (size_t)request.offset + len <= _dma_size;
+				if (!valid) { return Response::REJECTED; }
 
-			size_t const mps       = _nvme_ctrlr->mps();
-			size_t const mps_len   = Genode::align_addr(len, Genode::log2(mps));
-			bool   const need_list = len > 2 * mps;
+				if (_overlaps_pending(op, write)) { return Response::RETRY; }
 
-			Io_buffer *iob = _io_mapper->alloc(mps_len);
-			if (!iob) { throw Request_congestion(); }
+			/* a flush only covers writes completed before its submission */
+			} else if (_writes_pending) {
+				return Response::RETRY;
+			}
 
-			if (need_list) {
-				r->large_request = _io_list_mapper->alloc(mps);
-				if (!r->large_request) {
-					_io_mapper->free(iob);
-					throw Request_congestion();
+			Io_queue *queue = nullptr;
+			uint16_t  qid   = 0;
+			for (unsigned i = 0; i < _nvme_ctrlr->io_queues(); i++) {
+				if (!queue || _queues[i].free() > queue->free()) {
+					queue = &_queues[i];
+					qid   = (uint16_t)(i + 1);
 				}
 			}
+			if (!queue || !queue->free()) { return Response::RETRY; }
 
-			if (write) { Genode::memcpy((void*)iob->va, buffer, len); }
+			uint16_t const cid = queue->alloc_cid();
 
-			Nvme::Sqe_io b(_nvme_ctrlr->io_command(Nvme::IO_NSID));
+			Nvme::Sqe_io b(_nvme_ctrlr->io_command(qid, cid));
 			if (!b.valid()) {
-				if (r->large_request) {
-					_io_list_mapper->free(r->large_request);
-				}
-				_io_mapper->free(iob);
-				throw Request_congestion();
+				queue->release_cid(cid);
+				return Response::RETRY;
 			}
 
-			addr_t const pa = iob->pa;
+			if (sync) {
+				b.write<Nvme::Sqe::Cdw0::Opc>(Nvme::Opcode::FLUSH);
+			} else {
+				Nvme::Opcode op_code = write ? Nvme::Opcode::WRITE : Nvme::Opcode::READ;
+				b.write<Nvme::Sqe::Cdw0::Opc>(op_code);
 
-			Nvme::Opcode op = write ? Nvme::Opcode::WRITE : Nvme::Opcode::READ;
-			b.write<Nvme::Sqe::Cdw0::Opc>(op);
-			b.write<Nvme::Sqe::Prp1>(pa);
+				_setup_prp(b, qid, cid, _dma_phys_base + request.offset, len);
 
-			/* payload will fit into 2 mps chunks */
-			if (len > mps && !r->large_request) {
-				b.write<Nvme::Sqe::Prp2>(pa + mps);
-			} else if (r->large_request) {
-				/* payload needs list of mps chunks */
-				Io_buffer &lr = *r->large_request;
-				_setup_large_request(lr.va,
-				                     *iob, (mps_len - mps)/mps, mps);
-				b.write<Nvme::Sqe::Prp2>(lr.pa);
+				b.write<Nvme::Sqe_io::Slba>(op.block_number);
+				b.write<Nvme::Sqe_io::Cdw12::Nlb>(op.count - 1); /* 0-base value */
 			}
 
-			b.write<Nvme::Sqe_io::Slba>(lba);
-			b.write<Nvme::Sqe_io::Cdw12::Nlb>(count - 1); /* 0-base value */
-
-			r->iob    = iob;
-			r->pd     = pd; /* must be a copy */
-			r->buffer = write ? nullptr : buffer;
-			r->id     = b.read<Nvme::Sqe_io::Cdw0::Cid>() | (Nvme::IO_NSID<<16);
+			Command_slot &slot = queue->slots[cid];
+			slot.request = request;
+			slot.state   = Command_slot::PENDING;
 
 			++_requests_pending;
-			_nvme_ctrlr->commit_io(Nvme::IO_NSID);
+			if (write) { ++_writes_pending; }
+
+			queue->doorbell_pending = true;
+			return Response::ACCEPTED;
+		}
+
+		/**
+		 * Notify controller about all commands submitted since the last call
+		 */
+		void commit_io()
+		{
+			for (unsigned i = 0; i < _nvme_ctrlr->io_queues(); i++) {
+				if (!_queues[i].doorbell_pending) { continue; }
+
+				_nvme_ctrlr->commit_io((uint16_t)(i + 1));
+				_queues[i].doorbell_pending = false;
+			}
 		}
 
-		void read(Block::sector_t lba, size_t count,
-		          char *buffer, Packet_descriptor &pd) override
+		/**
+		 * Handle completion interrupt
+		 */
+		void handle_intr()
 		{
-			_io(false, lba, count, buffer, pd);
+			_nvme_ctrlr->mask_intr();
+			_handle_completions();
+			_nvme_ctrlr->clear_intr();
+			_nvme_pci->ack_irq();
 		}
 
-		void write(Block::sector_t lba, size_t count,
-		           char const *buffer, Packet_descriptor &pd) override
+		/**
+		 * Apply 'fn' to the request completed first and release its slot
+		 */
+		template <typename FN>
+		void with_any_completed_job(FN const &fn)
 		{
-			if (!_info.writeable) {
-				throw Io_error();
+			if (_completed_head == _completed_tail) { return; }
+
+			uint32_t const v = _completed[_completed_head++ % MAX_COMMANDS];
+
+			Io_queue       &queue = _queues[v >> 16];
+			uint16_t const  cid   = v & 0xffffu;
+			Command_slot   &slot  = queue.slots[cid];
+
+			Block::Request const request = slot.request;
+
+			if (request.operation.type == Block::Operation::Type::WRITE) {
+				--_writes_pending;
 			}
-			_io(true, lba, count, const_cast<char*>(buffer), pd);
+
+			slot.state = Command_slot::FREE;
+			queue.release_cid(cid);
+
+			fn(request);
 		}
+};
+
 
-		void sync() override { _nvme_ctrlr->flush_cache(Nvme::IO_NSID); }
+/*******************
+ ** Block session **
+ *******************/
+
+struct Block_session_component : Genode::Rpc_object<Block::Session>,
+                                 private Block::Request_stream
+{
+	Genode::Entrypoint &_ep;
+
+	using Block::Request_stream::with_requests;
+	using Block::Request_stream::try_acknowledge;
+	using Block::Request_stream::wakeup_client_if_needed;
+
+	Block_session_component(Genode::Region_map               &rm,
+	                        Genode::Dataspace_capability      ds,
+	                        Genode::Entrypoint               &ep,
+	                        Genode::Signal_context_capability sigh,
+	                        Block::Session::Info              info)
+	:
+		Request_stream(rm, ds, ep, sigh, info), _ep(ep)
+	{
+		_ep.manage(*this);
+	}
+
+	~Block_session_component() { _ep.dissolve(*this); }
+
+	Info info() const override { return Request_stream::info(); }
+
+	Genode::Capability<Tx> tx_cap() override { return Request_stream::tx_cap(); }
 };
 
 
@@ -1701,44 +2078,125 @@ class Driver : public Block::Driver
  ** Main **
  **********/
 
-struct Main
+struct Main : Genode::Rpc_object<Genode::Typed_root<Block::Session>>
 {
 	Genode::Env  &_env;
 	Genode::Heap  _heap { _env.ram(), _env.rm() };
 
-	void _handle_announce()
+	Genode::Signal_handler<Main> _request_handler {
+		_env.ep(), *this, &Main::_handle_requests };
+
+	Genode::Signal_handler<Main> _irq_handler {
+		_env.ep(), *this, &Main::_handle_irq };
+
+	::Driver _driver { _env, _heap, _irq_handler };
+
+	Genode::Constructible<Block_session_component> _block_session { };
+
+	void _handle_irq()
 	{
-		_env.parent().announce(_env.ep().manage(_root));
+		_driver.handle_intr();
+		_handle_requests();
 	}
 
-	Genode::Signal_handler<Main> _announce_sigh {
-		_env.ep(), *this, &Main::_handle_announce };
+	void _handle_requests()
+	{
+		if (!_block_session.constructed()) { return; }
+
+		Block_session_component &block_session = *_block_session;
+
+		using Response = Block::Request_stream::Response;
+
+		bool const writeable = block_session.info().writeable;
+
+		for (;;) {
+
+			bool progress = false;
+
+			/* import new requests */
+			block_session.with_requests([&] (Block::Request request) {
 
-	struct Factory : Block::Driver_factory
+				if (!writeable
+				 && request.operation.type == Block::Operation::Type::WRITE) {
+					return Response::REJECTED;
+				}
+
+				Response const response = _driver.submit(request);
+				if (response == Response::ACCEPTED) { progress = true; }
+
+				return response;
+			});
+
+			/* notify controller once for all requests submitted */
+			_driver.commit_io();
+
+			/* acknowledge finished jobs */
+			block_session.try_acknowledge([&] (Block::Request_stream::Ack &ack) {
+
+				_driver.with_any_completed_job([&] (Block::Request request) {
+					ack.submit(request);
+					progress = true;
+				});
+			});
+
+			if (!progress) { break; }
+		}
+
+		block_session.wakeup_client_if_needed();
+	}
+
+	/********************
+	 ** Root interface **
+	 ********************/
+
+	Genode::Capability<Genode::Session>
+	session(Genode::Root::Session_args const &args,
+	        Genode::Affinity const &) override
 	{
-		Genode::Env       &_env;
-		Genode::Allocator &_alloc;
-		Genode::Signal_context_capability _sigh;
+		using namespace Genode;
 
-		Genode::Constructible<::Driver> _driver { };
+		if (_block_session.constructed()) { throw Service_denied(); }
 
-		Factory(Genode::Env &env, Genode::Allocator &alloc,
-		        Genode::Signal_context_capability sigh)
-		: _env(env), _alloc(alloc), _sigh(sigh)
-		{
-			_driver.construct(_env, _alloc, _sigh);
+		size_t const ds_size =
+			Arg_string::find_arg(args.string(), "tx_buf_size").ulong_value(0);
+
+		Ram_quota const ram_quota = ram_quota_from_args(args.string());
+
+		if (ds_size >= ram_quota.value) {
+			warning("communication buffer size exceeds session quota");
+			throw Insufficient_ram_quota();
 		}
 
-		~Factory() { _driver.destruct(); }
+		Block::Session::Info info = _driver.info();
+		info.writeable = info.writeable &&
+			Arg_string::find_arg(args.string(), "writeable").bool_value(true);
 
-		Block::Driver *create() override { return &*_driver; }
-		void destroy(Block::Driver *) override { }
-	};
+		if (_driver.disabled()) { throw Service_denied(); }
 
-	Factory     _factory { _env, _heap, _announce_sigh };
-	Block::Root _root    { _env.ep(), _heap, _env.rm(), _factory, true };
+		Ram_dataspace_capability ds = _driver.alloc_dma_buffer(ds_size);
+		if (!ds.valid()) { throw Service_denied(); }
 
-	Main(Genode::Env &env) : _env(env) { }
+		_block_session.construct(_env.rm(), ds, _env.ep(),
+		                         _request_handler, info);
+
+		return _block_session->cap();
+	}
+
+	void upgrade(Genode::Capability<Genode::Session>,
+	             Genode::Root::Upgrade_args const &) override { }
+
+	void close(Genode::Capability<Genode::Session>) override
+	{
+		if (!_block_session.constructed()) { return; }
+
+		_block_session.destruct();
+		_driver.free_dma_buffer();
+	}
+
+	Main(Genode::Env &env) : _env(env)
+	{
+		_env.parent().announce(_env.ep().manage(*this));
+	}
 };
 
 
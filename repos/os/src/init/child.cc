@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2010-2017 Genode Labs GmbH
+ * Copyright (C) 2010-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -25,6 +25,28 @@ void Init::Child::destroy_services()
 }
 
 
+bool Init::Child::_env_complete() const
+{
+	bool env_log_exists = false, env_binary_exists = false;
+	_child.for_each_session([&] (Session_state const &session) {
+		Parent::Client::Id const id = session.id_at_client();
+		env_log_exists    |= (id == Parent::Env::log());
+		env_binary_exists |= (id == Parent::Env::binary());
+	});
+
+	return env_binary_exists && env_log_exists;
+}
+
+
+bool Init::Child::apply_config_needed(Xml_node start_node) const
+{
+	if (_state == STATE_ABANDONED || _exited)
+		return false;
+
+	return !_env_complete() || start_node.differs_from(_start_node->xml());
+}
+
+
 Init::Child::Apply_config_result
 Init::Child::apply_config(Xml_node start_node)
 {
@@ -35,18 +57,9 @@ Init::Child::apply_config(Xml_node start_node)
 	 * If the child's environment is incomplete, restart it to attempt
 	 * the re-routing of its environment sessions.
 	 */
-	{
-		bool env_log_exists = false, env_binary_exists = false;
-		_child.for_each_session([&] (Session_state const &session) {
-			Parent::Client::Id const id = session.id_at_client();
-			env_log_exists    |= (id == Parent::Env::log());
-			env_binary_exists |= (id == Parent::Env::binary());
-		});
-
-		if (!env_binary_exists || !env_log_exists) {
-			abandon();
-			return MAY_HAVE_SIDE_EFFECTS;
-		}
+	if (!_env_complete()) {
+		abandon();
+		return MAY_HAVE_SIDE_EFFECTS;
 	}
 
 	bool provided_services_changed = false;
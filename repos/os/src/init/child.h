@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2010-2017 Genode Labs GmbH
+ * Copyright (C) 2010-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -391,6 +391,11 @@ class Init::Child : Child_policy, Routed_service::Wakeup
 			catch (Service_denied) { return false; }
 		}
 
+		/**
+		 * Return true if the log and binary sessions of the child exist
+		 */
+		bool _env_complete() const;
+
 		static Xml_node _provides_sub_node(Xml_node start_node)
 		{
 			return start_node.has_sub_node("provides")
@@ -547,6 +552,16 @@ class Init::Child : Child_policy, Routed_service::Wakeup
 		 */
 		Apply_config_result apply_config(Xml_node start_node);
 
+		/**
+		 * Return true if 'apply_config' may have an effect on the child
+		 *
+		 * This is the case if the start node differs from the one applied
+		 * most recently or if the child's environment is incomplete. The
+		 * check does not cover changes of the routing-relevant parts of the
+		 * config outside the start node.
+		 */
+		bool apply_config_needed(Xml_node start_node) const;
+
 		/* common code for upgrading RAM and caps */
 		template <typename QUOTA, typename LIMIT_ACCESSOR>
 		void _apply_resource_upgrade(QUOTA &, QUOTA, LIMIT_ACCESSOR const &);
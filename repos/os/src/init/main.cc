@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2010-2017 Genode Labs GmbH
+ * Copyright (C) 2010-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -20,6 +20,7 @@
 #include <alias.h>
 #include <server.h>
 #include <heartbeat.h>
+#include <start_nodes.h>
 
 namespace Init { struct Main; }
 
@@ -48,6 +49,39 @@ struct Init::Main : State_reporter::Producer,
 
 	unsigned _child_cnt = 0;
 
+	/*
+	 * Copy of the previously applied config
+	 *
+	 * It is used to detect changes outside the '<start>' nodes, which may
+	 * affect the routing of any child.
+	 */
+	Constructible<Buffered_xml> _prev_config { };
+
+	/*
+	 * Children created by the previous config update may provide services
+	 * to existing children. Hence, the routes of all children are validated
+	 * at the next config update.
+	 */
+	bool _children_created = false;
+
+	/*
+	 * Statistics of the most recent config update, reported if the
+	 * '<report>' node has the 'config_update' attribute set
+	 */
+	struct Config_update_info
+	{
+		uint64_t duration_us;
+		unsigned applied;  /* number of children the config was applied to */
+		unsigned skipped;  /* number of unaffected children */
+	};
+
+	Config_update_info _config_update_info { 0, 0, 0 };
+
+	/**
+	 * Return true if the configs differ in any sub node but '<start>' nodes
+	 */
+	static bool _global_config_differs(Xml_node old_config, Xml_node new_config);
+
 	static Ram_quota _preserved_ram_from_config(Xml_node config)
 	{
 		Number_of_bytes preserve { 40*sizeof(long)*1024 };
@@ -120,6 +154,13 @@ struct Init::Main : State_reporter::Producer,
 		if (detail.init_caps())
 			xml.node("caps", [&] () { generate_caps_info(xml, _env.pd()); });
 
+		if (detail.config_update())
+			xml.node("config_update", [&] () {
+				xml.attribute("duration_us", _config_update_info.duration_us);
+				xml.attribute("applied",     _config_update_info.applied);
+				xml.attribute("skipped",     _config_update_info.skipped);
+			});
+
 		if (detail.children())
 			_children.report_state(xml, detail);
 	}
@@ -147,8 +188,8 @@ struct Init::Main : State_reporter::Producer,
 
 	void _update_aliases_from_config();
 	void _update_parent_services_from_config();
-	void _abandon_obsolete_children();
-	void _update_children_config();
+	bool _abandon_obsolete_children(Start_nodes &);
+	void _update_children_config(Start_nodes &, bool all);
 	void _destroy_abandoned_parent_services();
 	void _handle_config();
 
@@ -245,24 +286,76 @@ void Init::Main::_update_aliases_from_config()
 }
 
 
-void Init::Main::_abandon_obsolete_children()
+bool Init::Main::_global_config_differs(Xml_node old_config, Xml_node new_config)
 {
+	/*
+	 * Cursor over the sub nodes of a config, skipping all '<start>' nodes
+	 */
+	struct Cursor
+	{
+		Constructible<Xml_node> node { };
+
+		void _skip_start_nodes(Xml_node n)
+		{
+			try {
+				while (n.has_type("start"))
+					n = n.next();
+
+				node.construct(n);
+			}
+			catch (Xml_node::Nonexistent_sub_node) { node.destruct(); }
+		}
+
+		Cursor(Xml_node config)
+		{
+			if (config.num_sub_nodes())
+				_skip_start_nodes(config.sub_node());
+		}
+
+		void advance()
+		{
+			try { _skip_start_nodes(node->next()); }
+			catch (Xml_node::Nonexistent_sub_node) { node.destruct(); }
+		}
+	};
+
+	Cursor old_cursor(old_config), new_cursor(new_config);
+
+	for (; old_cursor.node.constructed() && new_cursor.node.constructed();
+	       old_cursor.advance(), new_cursor.advance())
+		if (old_cursor.node->differs_from(*new_cursor.node))
+			return true;
+
+	return old_cursor.node.constructed() != new_cursor.node.constructed();
+}
+
+
+bool Init::Main::_abandon_obsolete_children(Start_nodes &start_nodes)
+{
+	bool any_abandoned = false;
+
 	_children.for_each_child([&] (Child &child) {
 
 		bool obsolete = true;
-		_config_xml.for_each_sub_node("start", [&] (Xml_node node) {
-			if (child.has_name   (node.attribute_value("name", Child_policy::Name()))
-			 && child.has_version(node.attribute_value("version", Child::Version())))
+		start_nodes.with_start_node(child.name(), [&] (Xml_node node) {
+			if (child.has_version(node.attribute_value("version", Child::Version())))
 				obsolete = false; });
 
-		if (obsolete)
+		if (obsolete && !child.abandoned()) {
 			child.abandon();
+			any_abandoned = true;
+		}
 	});
+
+	return any_abandoned;
 }
 
 
-void Init::Main::_update_children_config()
+void Init::Main::_update_children_config(Start_nodes &start_nodes, bool all)
 {
+	_config_update_info.applied = 0;
+	_config_update_info.skipped = 0;
+
 	for (;;) {
 
 		/*
@@ -270,26 +363,38 @@ void Init::Main::_update_children_config()
 		 * be routed or result in a different route. As each child may be a
 		 * service, an avalanche effect may occur. It stops if no update causes
 		 * a potential side effect in one iteration over all chilren.
+		 *
+		 * Unless 'all' is set, the config is applied only to the children
+		 * whose start node changed. Once a side effect occurs, the routes
+		 * of all children must be re-validated.
 		 */
 		bool side_effects = false;
 
-		_config_xml.for_each_sub_node("start", [&] (Xml_node node) {
+		_children.for_each_child([&] (Child &child) {
+
+			if (child.abandoned())
+				return;
 
-			Child_policy::Name const start_node_name =
-				node.attribute_value("name", Child_policy::Name());
+			start_nodes.with_start_node(child.name(), [&] (Xml_node node) {
 
-			_children.for_each_child([&] (Child &child) {
-				if (!child.abandoned() && child.name() == start_node_name) {
-					switch (child.apply_config(node)) {
-					case Child::NO_SIDE_EFFECTS: break;
-					case Child::MAY_HAVE_SIDE_EFFECTS: side_effects = true; break;
-					};
+				if (!all && !child.apply_config_needed(node)) {
+					_config_update_info.skipped++;
+					return;
 				}
+
+				_config_update_info.applied++;
+
+				switch (child.apply_config(node)) {
+				case Child::NO_SIDE_EFFECTS: break;
+				case Child::MAY_HAVE_SIDE_EFFECTS: side_effects = true; break;
+				};
 			});
 		});
 
 		if (!side_effects)
 			break;
+
+		all = true;
 	}
 }
 
@@ -306,6 +411,8 @@ void Init::Main::_handle_config()
 	_state_reporter.apply_config(_config_xml);
 	_heartbeat.apply_config(_config_xml);
 
+	uint64_t const update_start_us = _state_reporter.elapsed_us();
+
 	/* determine default route for resolving service requests */
 	try {
 		_default_route.construct(_heap, _config_xml.sub_node("default-route")); }
@@ -320,10 +427,25 @@ void Init::Main::_handle_config()
 	Prio_levels     const prio_levels    = prio_levels_from_xml(_config_xml);
 	Affinity::Space const affinity_space = affinity_space_from_xml(_config_xml);
 
+	/*
+	 * Routing-relevant changes outside the start nodes call for the
+	 * re-evaluation of all children.
+	 */
+	bool const global_config_changed = !_prev_config.constructed()
+	                                || _global_config_differs(_prev_config->xml(),
+	                                                          _config_xml);
+
+	Start_nodes start_nodes(_heap, _config_xml);
+
 	_update_aliases_from_config();
 	_update_parent_services_from_config();
-	_abandon_obsolete_children();
-	_update_children_config();
+
+	bool const children_abandoned = _abandon_obsolete_children(start_nodes);
+
+	_update_children_config(start_nodes, global_config_changed
+	                                   || children_abandoned
+	                                   || _children_created);
+	_children_created = false;
 
 	/* kill abandoned children */
 	_children.for_each_child([&] (Child &child) {
@@ -353,6 +475,16 @@ void Init::Main::_handle_config()
 	Ram_quota used_ram  { 0 };
 	Cap_quota used_caps { 0 };
 
+	/* determine the existing children of each start node */
+	_children.for_each_child([&] (Child const &child) {
+		start_nodes.with_entry(child.name(), [&] (Start_nodes::Entry &entry) {
+			if (child.abandoned())
+				entry.num_abandoned_children++;
+			else
+				entry.child_exists = true;
+		});
+	});
+
 	/* create new children */
 	try {
 		_config_xml.for_each_sub_node("start", [&] (Xml_node start_node) {
@@ -361,14 +493,12 @@ void Init::Main::_handle_config()
 
 			unsigned num_abandoned = 0;
 
-			_children.for_each_child([&] (Child const &child) {
-				if (child.name() == start_node.attribute_value("name", Child_policy::Name())) {
-					if (child.abandoned())
-						num_abandoned++;
-					else
-						exists = true;
-				}
-			});
+			Start_nodes::Name const name =
+				start_node.attribute_value("name", Start_nodes::Name());
+
+			start_nodes.with_entry(name, [&] (Start_nodes::Entry const &entry) {
+				exists        = entry.child_exists;
+				num_abandoned = entry.num_abandoned_children; });
 
 			/* skip start node if corresponding child already exists */
 			if (exists)
@@ -399,6 +529,10 @@ void Init::Main::_handle_config()
 					            _parent_services, _child_services);
 				_children.insert(&child);
 
+				start_nodes.with_entry(name, [&] (Start_nodes::Entry &entry) {
+					entry.child_exists = true; });
+
+				_children_created   = true;
 				update_state_report = true;
 
 				/* account for the start XML node buffered in the child */
@@ -463,6 +597,10 @@ void Init::Main::_handle_config()
 
 	_server.apply_config(_config_xml);
 
+	_prev_config.construct(_heap, _config_xml);
+
+	_config_update_info.duration_us = _state_reporter.elapsed_us() - update_start_us;
+
 	if (update_state_report)
 		_state_reporter.trigger_immediate_report_update();
 }
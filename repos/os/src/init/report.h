@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2017 Genode Labs GmbH
+ * Copyright (C) 2017-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -27,15 +27,16 @@ class Init::Report_detail : Genode::Noncopyable
 {
 	private:
 
-		bool _children     = false;
-		bool _ids          = false;
-		bool _requested    = false;
-		bool _provided     = false;
-		bool _session_args = false;
-		bool _child_ram    = false;
-		bool _child_caps   = false;
-		bool _init_ram     = false;
-		bool _init_caps    = false;
+		bool _children      = false;
+		bool _ids           = false;
+		bool _requested     = false;
+		bool _provided      = false;
+		bool _session_args  = false;
+		bool _child_ram     = false;
+		bool _child_caps    = false;
+		bool _init_ram      = false;
+		bool _init_caps     = false;
+		bool _config_update = false;
 
 	public:
 
@@ -43,26 +44,28 @@ class Init::Report_detail : Genode::Noncopyable
 
 		Report_detail(Genode::Xml_node report)
 		{
-			_children     = true;
-			_ids          = report.attribute_value("ids",          false);
-			_requested    = report.attribute_value("requested",    false);
-			_provided     = report.attribute_value("provided",     false);
-			_session_args = report.attribute_value("session_args", false);
-			_child_ram    = report.attribute_value("child_ram",    false);
-			_child_caps   = report.attribute_value("child_caps",   false);
-			_init_ram     = report.attribute_value("init_ram",     false);
-			_init_caps    = report.attribute_value("init_caps",    false);
+			_children      = true;
+			_ids           = report.attribute_value("ids",           false);
+			_requested     = report.attribute_value("requested",     false);
+			_provided      = report.attribute_value("provided",      false);
+			_session_args  = report.attribute_value("session_args",  false);
+			_child_ram     = report.attribute_value("child_ram",     false);
+			_child_caps    = report.attribute_value("child_caps",    false);
+			_init_ram      = report.attribute_value("init_ram",      false);
+			_init_caps     = report.attribute_value("init_caps",     false);
+			_config_update = report.attribute_value("config_update", false);
 		}
 
-		bool children()     const { return _children;     }
-		bool ids()          const { return _ids;          }
-		bool requested()    const { return _requested;    }
-		bool provided()     const { return _provided;     }
-		bool session_args() const { return _session_args; }
-		bool child_ram()    const { return _child_ram;    }
-		bool child_caps()   const { return _child_caps;   }
-		bool init_ram()     const { return _init_ram;     }
-		bool init_caps()    const { return _init_caps;    }
+		bool children()      const { return _children;      }
+		bool ids()           const { return _ids;           }
+		bool requested()     const { return _requested;     }
+		bool provided()      const { return _provided;      }
+		bool session_args()  const { return _session_args;  }
+		bool child_ram()     const { return _child_ram;     }
+		bool child_caps()    const { return _child_caps;    }
+		bool init_ram()      const { return _init_ram;      }
+		bool init_caps()     const { return _init_caps;     }
+		bool config_update() const { return _config_update; }
 };
 
 
@@ -0,0 +1,134 @@
+/*
+ * \brief  Lookup of the start nodes of the init configuration by name
+ * \author Norman Feske
+ * \date   2019-03-28
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _SRC__INIT__START_NODES_H_
+#define _SRC__INIT__START_NODES_H_
+
+/* Genode includes */
+#include <util/avl_tree.h>
+#include <util/xml_node.h>
+#include <base/child.h>
+
+/* local includes */
+#include <types.h>
+
+namespace Init { class Start_nodes; }
+
+
+/**
+ * Start nodes of one version of the config, looked up by name
+ *
+ * Matching each child against the list of start nodes costs a traversal of
+ * the config per child. With many children, the costs of a config update
+ * grow quadratically. The lookup is built by a single pass over the config.
+ * It refers to the config data without copying it.
+ *
+ * If the config contains multiple start nodes of the same name, only the
+ * first one is considered.
+ */
+class Init::Start_nodes : Noncopyable
+{
+	public:
+
+		typedef Child_policy::Name Name;
+
+		struct Entry : Avl_node<Entry>
+		{
+			Name     const name;
+			Xml_node const node;
+
+			/* state of the children named after the start node */
+			bool     child_exists           = false;
+			unsigned num_abandoned_children = 0;
+
+			Entry(Name const &name, Xml_node node) : name(name), node(node) { }
+
+			/**
+			 * Avl_node interface
+			 */
+			bool higher(Entry *e) {
+				return strcmp(e->name.string(), name.string()) > 0; }
+
+			Entry *find_by_name(Name const &n)
+			{
+				int const cmp = strcmp(n.string(), name.string());
+				if (cmp == 0) return this;
+
+				Entry *e = Avl_node<Entry>::child(cmp > 0);
+				return e ? e->find_by_name(n) : nullptr;
+			}
+		};
+
+	private:
+
+		Allocator &_alloc;
+
+		Avl_tree<Entry> _entries { };
+
+		Entry *_lookup(Name const &name)
+		{
+			Entry *first = _entries.first();
+			return first ? first->find_by_name(name) : nullptr;
+		}
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \throw Out_of_ram
+		 * \throw Out_of_caps
+		 */
+		Start_nodes(Allocator &alloc, Xml_node config) : _alloc(alloc)
+		{
+			config.for_each_sub_node("start", [&] (Xml_node node) {
+
+				Name const name = node.attribute_value("name", Name());
+				if (!name.valid() || _lookup(name))
+					return;
+
+				_entries.insert(new (_alloc) Entry(name, node));
+			});
+		}
+
+		~Start_nodes()
+		{
+			while (Entry *e = _entries.first()) {
+				_entries.remove(e);
+				destroy(_alloc, e);
+			}
+		}
+
+		/**
+		 * Call functor 'fn' with the 'Entry &' of the specified name
+		 *
+		 * If no start node of the name exists, 'fn' is not called.
+		 */
+		template <typename FN>
+		void with_entry(Name const &name, FN const &fn)
+		{
+			if (Entry *e = _lookup(name))
+				fn(*e);
+		}
+
+		/**
+		 * Call functor 'fn' with the start node of the specified name
+		 */
+		template <typename FN>
+		void with_start_node(Name const &name, FN const &fn)
+		{
+			with_entry(name, [&] (Entry const &e) { fn(e.node); });
+		}
+};
+
+#endif /* _SRC__INIT__START_NODES_H_ */
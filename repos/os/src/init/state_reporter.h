@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2017 Genode Labs GmbH
+ * Copyright (C) 2017-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -179,6 +179,18 @@ class Init::State_reporter : public Report_update_trigger
 			}
 		}
 
+		/**
+		 * Return time in microseconds, used to measure the latency of
+		 * config updates
+		 *
+		 * The time is only available if state reporting is enabled.
+		 * Otherwise, the method returns 0.
+		 */
+		uint64_t elapsed_us() const
+		{
+			return _timer.constructed() ? _timer->elapsed_us() : 0;
+		}
+
 		void trigger_report_update() override
 		{
 			if (!_scheduled && _timer.constructed() && _report_delay_ms) {
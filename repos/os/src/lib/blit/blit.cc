@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2007-2017 Genode Labs GmbH
+ * Copyright (C) 2007-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -13,6 +13,41 @@
 
 #include <blit/blit.h>
 #include <blit_helper.h>
+#include <simd_kernels.h>
+
+
+namespace Blit {
+
+	static Kernels const *selected_kernels = nullptr;
+
+	static Kernels const *kernels_for_isa(Blit_isa isa)
+	{
+		return isa == BLIT_ISA_GENERIC ? &generic_kernels : simd_kernels(isa);
+	}
+
+	/**
+	 * Return kernels in use, select the best supported variant at first use
+	 *
+	 * The selection is idempotent. Hence, concurrent first calls are benign.
+	 */
+	static Kernels const &kernels()
+	{
+		if (selected_kernels)
+			return *selected_kernels;
+
+		Blit_isa const preferred[] = { BLIT_ISA_AVX2, BLIT_ISA_SSE2, BLIT_ISA_NEON };
+
+		Kernels const *k = &generic_kernels;
+		for (Blit_isa isa : preferred) {
+			if (Kernels const *simd = simd_kernels(isa)) {
+				k = simd;
+				break;
+			}
+		}
+		selected_kernels = k;
+		return *k;
+	}
+}
 
 
 extern "C" void blit(void const *s, unsigned src_w,
@@ -27,6 +62,17 @@ extern "C" void blit(void const *s, unsigned src_w,
 	/* we support blitting only at a granularity of 16bit */
 	w &= ~1;
 
+	/* copy line by line using the SIMD kernel if available */
+	Blit::Kernels const &k = Blit::kernels();
+	if (k.copy) {
+		for (; h-- > 0; src += src_w, dst += dst_w)
+			k.copy(dst, src, w);
+
+		if (k.copy_done)
+			k.copy_done();
+		return;
+	}
+
 	/* copy unaligned column */
 	if (w && ((long)dst & 2)) {
 		copy_16bit_column(src, src_w, dst, dst_w, h);
@@ -54,3 +100,59 @@ extern "C" void blit(void const *s, unsigned src_w,
 	/* handle trailing row */
 	if (w >> 1) copy_16bit_column(src, src_w, dst, dst_w, h);
 }
+
+
+extern "C" void blit_fill_16(unsigned short *dst, unsigned short value, int n) {
+	Blit::kernels().fill_16(dst, value, n); }
+
+
+extern "C" void blit_fill_32(unsigned *dst, unsigned value, int n) {
+	Blit::kernels().fill_32(dst, value, n); }
+
+
+extern "C" void blit_blend_rgb565(unsigned short *dst, unsigned short const *src,
+                                  unsigned char const *alpha, int n) {
+	Blit::kernels().blend_rgb565(dst, src, alpha, n); }
+
+
+extern "C" void blit_avr_rgb565(unsigned short *dst, unsigned short const *src,
+                                unsigned short mix, int n) {
+	Blit::kernels().avr_rgb565(dst, src, mix, n); }
+
+
+extern "C" void blit_rgb888_to_rgb565(unsigned short *dst, unsigned const *src, int n) {
+	Blit::kernels().rgb888_to_rgb565(dst, src, n); }
+
+
+extern "C" void blit_rgb565_to_rgb888(unsigned *dst, unsigned short const *src, int n) {
+	Blit::kernels().rgb565_to_rgb888(dst, src, n); }
+
+
+extern "C" Blit_isa blit_isa() { return Blit::kernels().isa; }
+
+
+extern "C" bool blit_isa_supported(Blit_isa isa) {
+	return Blit::kernels_for_isa(isa) != nullptr; }
+
+
+extern "C" bool blit_select_isa(Blit_isa isa)
+{
+	Blit::Kernels const *k = Blit::kernels_for_isa(isa);
+	if (!k)
+		return false;
+
+	Blit::selected_kernels = k;
+	return true;
+}
+
+
+extern "C" char const *blit_isa_name(Blit_isa isa)
+{
+	switch (isa) {
+	case BLIT_ISA_GENERIC: return "generic";
+	case BLIT_ISA_SSE2:    return "SSE2";
+	case BLIT_ISA_AVX2:    return "AVX2";
+	case BLIT_ISA_NEON:    return "NEON";
+	}
+	return "unknown";
+}
@@ -0,0 +1,122 @@
+/*
+ * \brief  Pixel kernels of the blit library
+ * \author Norman Feske
+ * \date   2019-03-25
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _LIB__BLIT__KERNELS_H_
+#define _LIB__BLIT__KERNELS_H_
+
+#include <blit/blit.h>
+
+namespace Blit {
+
+	struct Kernels;
+
+	typedef unsigned short uint16;
+	typedef unsigned       uint32;
+}
+
+
+/**
+ * Set of kernels implemented for one instruction-set extension
+ *
+ * A null 'copy' function means that 'blit' uses its generic code path.
+ */
+struct Blit::Kernels
+{
+	Blit_isa isa;
+
+	void (*copy)            (char *dst, char const *src, int bytes);
+	void (*copy_done)       ();
+	void (*fill_16)         (uint16 *, uint16, int);
+	void (*fill_32)         (uint32 *, uint32, int);
+	void (*blend_rgb565)    (uint16 *, uint16 const *, unsigned char const *, int);
+	void (*avr_rgb565)      (uint16 *, uint16 const *, uint16, int);
+	void (*rgb888_to_rgb565)(uint16 *, uint32 const *, int);
+	void (*rgb565_to_rgb888)(uint32 *, uint16 const *, int);
+};
+
+
+/*
+ * Scalar versions of the kernels
+ *
+ * They are used by the generic kernel set and process the trailing pixels
+ * of the SIMD kernels.
+ */
+namespace Blit {
+
+	static inline void fill_16_scalar(uint16 *dst, uint16 value, int n)
+	{
+		for (; n-- > 0; dst++)
+			*dst = value;
+	}
+
+	static inline void fill_32_scalar(uint32 *dst, uint32 value, int n)
+	{
+		for (; n-- > 0; dst++)
+			*dst = value;
+	}
+
+	/**
+	 * Counterpart of 'Pixel_rgb565::blend'
+	 */
+	static inline uint16 blend_rgb565(uint16 pixel, int alpha)
+	{
+		return ((((alpha >> 3) * (pixel & 0xf81f)) >> 5) & 0xf81f)
+		     | ((( alpha       * (pixel & 0x07c0)) >> 8) & 0x07c0);
+	}
+
+	static inline void blend_rgb565_scalar(uint16 *dst, uint16 const *src,
+	                                       unsigned char const *alpha, int n)
+	{
+		for (; n-- > 0; dst++, src++, alpha++) {
+			int const a = *alpha + 1;
+			if (a > 1)
+				*dst = blend_rgb565(*dst, 264 - a) + blend_rgb565(*src, a);
+		}
+	}
+
+	static inline void avr_rgb565_scalar(uint16 *dst, uint16 const *src,
+	                                     uint16 mix, int n)
+	{
+		for (; n-- > 0; dst++, src++)
+			*dst = ((mix & 0xf7df) >> 1) + ((*src & 0xf7df) >> 1);
+	}
+
+	static inline uint16 rgb888_to_rgb565(uint32 p)
+	{
+		return ((p >> 8) & 0xf800) | ((p >> 5) & 0x07e0) | ((p >> 3) & 0x001f);
+	}
+
+	static inline void rgb888_to_rgb565_scalar(uint16 *dst, uint32 const *src, int n)
+	{
+		for (; n-- > 0; dst++, src++)
+			*dst = rgb888_to_rgb565(*src);
+	}
+
+	static inline uint32 rgb565_to_rgb888(uint16 p)
+	{
+		return ((p & 0xf800) << 8) | ((p & 0x07e0) << 5) | ((p & 0x001f) << 3);
+	}
+
+	static inline void rgb565_to_rgb888_scalar(uint32 *dst, uint16 const *src, int n)
+	{
+		for (; n-- > 0; dst++, src++)
+			*dst = rgb565_to_rgb888(*src);
+	}
+
+	static Kernels const generic_kernels = {
+		BLIT_ISA_GENERIC, nullptr, nullptr,
+		fill_16_scalar, fill_32_scalar, blend_rgb565_scalar, avr_rgb565_scalar,
+		rgb888_to_rgb565_scalar, rgb565_to_rgb888_scalar };
+}
+
+#endif /* _LIB__BLIT__KERNELS_H_ */
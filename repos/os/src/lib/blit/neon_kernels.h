@@ -0,0 +1,163 @@
+/*
+ * \brief  NEON pixel kernels
+ * \author Norman Feske
+ * \date   2019-03-25
+ *
+ * The kernels are written with GCC vector extensions, which the compiler
+ * maps to NEON instructions. Unlike x86, ARM offers no way to detect the
+ * presence of NEON from user level. Hence, the kernels are selected at
+ * compile time.
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _LIB__BLIT__NEON_KERNELS_H_
+#define _LIB__BLIT__NEON_KERNELS_H_
+
+/* local includes */
+#include "kernels.h"
+
+namespace Blit {
+
+	typedef uint16 v8u16 __attribute__((vector_size(16)));
+	typedef uint32 v4u32 __attribute__((vector_size(16)));
+
+	template <typename V>
+	static inline V load(void const *src)
+	{
+		V v;
+		__builtin_memcpy(&v, src, sizeof(v));
+		return v;
+	}
+
+	template <typename V>
+	static inline void store(void *dst, V v) { __builtin_memcpy(dst, &v, sizeof(v)); }
+
+	static void fill_16_neon(uint16 *dst, uint16 value, int n)
+	{
+		v8u16 const v = { value, value, value, value, value, value, value, value };
+		for (; n >= 8; n -= 8, dst += 8)
+			store(dst, v);
+		fill_16_scalar(dst, value, n);
+	}
+
+	static void fill_32_neon(uint32 *dst, uint32 value, int n)
+	{
+		v4u32 const v = { value, value, value, value };
+		for (; n >= 4; n -= 4, dst += 4)
+			store(dst, v);
+		fill_32_scalar(dst, value, n);
+	}
+
+	/**
+	 * Blend eight RGB565 pixels
+	 *
+	 * The channels are computed in separate 16-bit lanes, which yields the
+	 * same results as 'blend_rgb565' because no intermediate value exceeds
+	 * 16 bits.
+	 */
+	static inline v8u16 blend_8_neon(v8u16 d, v8u16 s, v8u16 a)
+	{
+		v8u16 const x2 = a + 1;
+		v8u16 const x1 = 264 - x2;
+		v8u16 const k2 = x2 >> 3;
+		v8u16 const k1 = x1 >> 3;
+
+		v8u16 const r = ((k1*(d >> 11)) >> 5) + ((k2*(s >> 11)) >> 5);
+		v8u16 const g = ((x1*((d >> 6) & 0x1f)) >> 8) + ((x2*((s >> 6) & 0x1f)) >> 8);
+		v8u16 const b = ((k1*(d & 0x1f)) >> 5) + ((k2*(s & 0x1f)) >> 5);
+
+		v8u16 const mixed = (r << 11) | (g << 6) | b;
+
+		/* keep destination pixels with zero alpha */
+		v8u16 const keep = (v8u16)(a == 0);
+		return (keep & d) | (~keep & mixed);
+	}
+
+	static void blend_rgb565_neon(uint16 *dst, uint16 const *src,
+	                              unsigned char const *alpha, int n)
+	{
+		for (; n >= 8; n -= 8, dst += 8, src += 8, alpha += 8) {
+
+			/* skip fully transparent blocks */
+			if (load<unsigned long long>(alpha) == 0)
+				continue;
+
+			v8u16 const a = { alpha[0], alpha[1], alpha[2], alpha[3],
+			                  alpha[4], alpha[5], alpha[6], alpha[7] };
+
+			store(dst, blend_8_neon(load<v8u16>(dst), load<v8u16>(src), a));
+		}
+		blend_rgb565_scalar(dst, src, alpha, n);
+	}
+
+	static void avr_rgb565_neon(uint16 *dst, uint16 const *src,
+	                            uint16 mix, int n)
+	{
+		uint16 const m = (mix & 0xf7df) >> 1;
+		v8u16  const mv = { m, m, m, m, m, m, m, m };
+
+		for (; n >= 8; n -= 8, dst += 8, src += 8)
+			store(dst, mv + ((load<v8u16>(src) & 0xf7df) >> 1));
+
+		avr_rgb565_scalar(dst, src, mix, n);
+	}
+
+	static inline v4u32 rgb888_to_rgb565_4_neon(v4u32 p)
+	{
+		return ((p >> 8) & 0xf800) | ((p >> 5) & 0x07e0) | ((p >> 3) & 0x001f);
+	}
+
+	static void rgb888_to_rgb565_neon(uint16 *dst, uint32 const *src, int n)
+	{
+		/* select the lower halves of the 32-bit lanes (little endian) */
+		v8u16 const narrow = { 0, 2, 4, 6, 8, 10, 12, 14 };
+
+		for (; n >= 8; n -= 8, dst += 8, src += 8) {
+			v4u32 const lo = rgb888_to_rgb565_4_neon(load<v4u32>(src));
+			v4u32 const hi = rgb888_to_rgb565_4_neon(load<v4u32>(src + 4));
+			store(dst, __builtin_shuffle((v8u16)lo, (v8u16)hi, narrow));
+		}
+		rgb888_to_rgb565_scalar(dst, src, n);
+	}
+
+	static inline v4u32 rgb565_to_rgb888_4_neon(v4u32 p)
+	{
+		return ((p & 0xf800) << 8) | ((p & 0x07e0) << 5) | ((p & 0x001f) << 3);
+	}
+
+	static void rgb565_to_rgb888_neon(uint32 *dst, uint16 const *src, int n)
+	{
+		/* interleave pixels with zeros to widen them to 32 bit (little endian) */
+		v8u16 const zero     = { };
+		v8u16 const widen_lo = { 0, 8, 1, 9, 2, 10, 3, 11 };
+		v8u16 const widen_hi = { 4, 12, 5, 13, 6, 14, 7, 15 };
+
+		for (; n >= 8; n -= 8, dst += 8, src += 8) {
+			v8u16 const p = load<v8u16>(src);
+			store(dst,     rgb565_to_rgb888_4_neon((v4u32)__builtin_shuffle(p, zero, widen_lo)));
+			store(dst + 4, rgb565_to_rgb888_4_neon((v4u32)__builtin_shuffle(p, zero, widen_hi)));
+		}
+		rgb565_to_rgb888_scalar(dst, src, n);
+	}
+
+	static Kernels const neon_kernels = {
+		BLIT_ISA_NEON, nullptr, nullptr,
+		fill_16_neon, fill_32_neon, blend_rgb565_neon, avr_rgb565_neon,
+		rgb888_to_rgb565_neon, rgb565_to_rgb888_neon };
+
+	/**
+	 * Return kernels for 'isa' or nullptr if not supported by the CPU
+	 */
+	static inline Kernels const *simd_kernels(Blit_isa isa)
+	{
+		return isa == BLIT_ISA_NEON ? &neon_kernels : nullptr;
+	}
+}
+
+#endif /* _LIB__BLIT__NEON_KERNELS_H_ */
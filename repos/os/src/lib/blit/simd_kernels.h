@@ -0,0 +1,24 @@
+/*
+ * \brief  Selection of SIMD pixel kernels for CPUs without SIMD support
+ * \author Norman Feske
+ * \date   2019-03-25
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _LIB__BLIT__SIMD_KERNELS_H_
+#define _LIB__BLIT__SIMD_KERNELS_H_
+
+#include "kernels.h"
+
+namespace Blit {
+
+	static inline Kernels const *simd_kernels(Blit_isa) { return nullptr; }
+}
+
+#endif /* _LIB__BLIT__SIMD_KERNELS_H_ */
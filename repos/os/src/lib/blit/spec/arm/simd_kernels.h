@@ -0,0 +1,37 @@
+/*
+ * \brief  Selection of SIMD pixel kernels for ARM
+ * \author Norman Feske
+ * \date   2019-03-25
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _LIB__BLIT__SPEC__ARM__SIMD_KERNELS_H_
+#define _LIB__BLIT__SPEC__ARM__SIMD_KERNELS_H_
+
+/*
+ * NEON is optional on 32-bit ARM, use the kernels only if the compiler
+ * targets a CPU with NEON.
+ */
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <neon_kernels.h>
+
+#else
+
+/* local includes */
+#include <kernels.h>
+
+namespace Blit {
+
+	static inline Kernels const *simd_kernels(Blit_isa) { return nullptr; }
+}
+
+#endif
+
+#endif /* _LIB__BLIT__SPEC__ARM__SIMD_KERNELS_H_ */
@@ -0,0 +1,20 @@
+/*
+ * \brief  Selection of SIMD pixel kernels for 64-bit ARM
+ * \author Norman Feske
+ * \date   2019-03-25
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _LIB__BLIT__SPEC__ARM_64__SIMD_KERNELS_H_
+#define _LIB__BLIT__SPEC__ARM_64__SIMD_KERNELS_H_
+
+/* NEON is mandatory on ARMv8 */
+#include <neon_kernels.h>
+
+#endif /* _LIB__BLIT__SPEC__ARM_64__SIMD_KERNELS_H_ */
@@ -0,0 +1,442 @@
+/*
+ * \brief  SSE2 and AVX2 pixel kernels
+ * \author Norman Feske
+ * \date   2019-03-25
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _LIB__BLIT__SPEC__X86__SIMD_KERNELS_H_
+#define _LIB__BLIT__SPEC__X86__SIMD_KERNELS_H_
+
+/*
+ * Prevent the intrinsics headers from including 'mm_malloc.h', which depends
+ * on the C library.
+ */
+#define _MM_MALLOC_H_INCLUDED
+#include <immintrin.h>
+
+/* Genode includes */
+#include <util/string.h>
+
+/* local includes */
+#include "kernels.h"
+
+#define BLIT_SSE2 __attribute__((target("sse2")))
+#define BLIT_AVX2 __attribute__((target("avx2")))
+
+
+/*******************
+ ** CPU detection **
+ *******************/
+
+namespace Blit {
+
+	static inline void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4])
+	{
+		asm volatile ("cpuid"
+		              : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+		              : "a" (leaf), "c" (subleaf));
+	}
+
+	static inline bool cpu_has_sse2()
+	{
+		unsigned regs[4];
+		cpuid(1, 0, regs);
+		return regs[3] & (1 << 26);
+	}
+
+	/**
+	 * Return true if the CPU supports AVX2 and the kernel saves the AVX state
+	 */
+	static inline bool cpu_has_avx2()
+	{
+		unsigned regs[4];
+		cpuid(0, 0, regs);
+		if (regs[0] < 7)
+			return false;
+
+		/* OSXSAVE and AVX */
+		cpuid(1, 0, regs);
+		enum { OSXSAVE = 1 << 27, AVX = 1 << 28 };
+		if ((regs[2] & (OSXSAVE | AVX)) != (OSXSAVE | AVX))
+			return false;
+
+		/* XMM and YMM state enabled in XCR0 */
+		unsigned xcr0_lo, xcr0_hi;
+		asm volatile ("xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+		if ((xcr0_lo & 6) != 6)
+			return false;
+
+		cpuid(7, 0, regs);
+		return regs[1] & (1 << 5);
+	}
+}
+
+
+/******************
+ ** SSE2 kernels **
+ ******************/
+
+namespace Blit {
+
+	/*
+	 * Copying uses non-temporal stores to avoid polluting the cache with
+	 * framebuffer content. Lines shorter than 'MIN_STREAM_BYTES' are copied
+	 * with 'memcpy'.
+	 */
+	enum { MIN_STREAM_BYTES = 128 };
+
+	BLIT_SSE2 static void copy_sse2(char *dst, char const *src, int bytes)
+	{
+		if (bytes < MIN_STREAM_BYTES) {
+			Genode::memcpy(dst, src, bytes);
+			return;
+		}
+
+		/* align destination to 16 bytes */
+		int const head = (16 - ((unsigned long)dst & 15)) & 15;
+		Genode::memcpy(dst, src, head);
+		dst += head; src += head; bytes -= head;
+
+		for (; bytes >= 64; bytes -= 64, dst += 64, src += 64) {
+			__m128i const v0 = _mm_loadu_si128((__m128i const *)(src +  0));
+			__m128i const v1 = _mm_loadu_si128((__m128i const *)(src + 16));
+			__m128i const v2 = _mm_loadu_si128((__m128i const *)(src + 32));
+			__m128i const v3 = _mm_loadu_si128((__m128i const *)(src + 48));
+			_mm_stream_si128((__m128i *)(dst +  0), v0);
+			_mm_stream_si128((__m128i *)(dst + 16), v1);
+			_mm_stream_si128((__m128i *)(dst + 32), v2);
+			_mm_stream_si128((__m128i *)(dst + 48), v3);
+		}
+		for (; bytes >= 16; bytes -= 16, dst += 16, src += 16)
+			_mm_stream_si128((__m128i *)dst, _mm_loadu_si128((__m128i const *)src));
+
+		Genode::memcpy(dst, src, bytes);
+	}
+
+	BLIT_SSE2 static void copy_done_sse2() { _mm_sfence(); }
+
+	BLIT_SSE2 static void fill_16_sse2(uint16 *dst, uint16 value, int n)
+	{
+		__m128i const v = _mm_set1_epi16(value);
+		for (; n >= 8; n -= 8, dst += 8)
+			_mm_storeu_si128((__m128i *)dst, v);
+		fill_16_scalar(dst, value, n);
+	}
+
+	BLIT_SSE2 static void fill_32_sse2(uint32 *dst, uint32 value, int n)
+	{
+		__m128i const v = _mm_set1_epi32(value);
+		for (; n >= 4; n -= 4, dst += 4)
+			_mm_storeu_si128((__m128i *)dst, v);
+		fill_32_scalar(dst, value, n);
+	}
+
+	/**
+	 * Blend eight RGB565 pixels
+	 *
+	 * The channels are computed in separate 16-bit lanes, which yields the
+	 * same results as 'blend_rgb565' because no intermediate value exceeds
+	 * 16 bits.
+	 */
+	BLIT_SSE2 static inline __m128i blend_8_sse2(__m128i d, __m128i s, __m128i a)
+	{
+		__m128i const mask_5 = _mm_set1_epi16(0x1f);
+
+		__m128i const x2 = _mm_add_epi16(a, _mm_set1_epi16(1));
+		__m128i const x1 = _mm_sub_epi16(_mm_set1_epi16(264), x2);
+		__m128i const k2 = _mm_srli_epi16(x2, 3);
+		__m128i const k1 = _mm_srli_epi16(x1, 3);
+
+		__m128i const r = _mm_add_epi16(
+			_mm_srli_epi16(_mm_mullo_epi16(k1, _mm_srli_epi16(d, 11)), 5),
+			_mm_srli_epi16(_mm_mullo_epi16(k2, _mm_srli_epi16(s, 11)), 5));
+
+		__m128i const g = _mm_add_epi16(
+			_mm_srli_epi16(_mm_mullo_epi16(x1, _mm_and_si128(_mm_srli_epi16(d, 6), mask_5)), 8),
+			_mm_srli_epi16(_mm_mullo_epi16(x2, _mm_and_si128(_mm_srli_epi16(s, 6), mask_5)), 8));
+
+		__m128i const b = _mm_add_epi16(
+			_mm_srli_epi16(_mm_mullo_epi16(k1, _mm_and_si128(d, mask_5)), 5),
+			_mm_srli_epi16(_mm_mullo_epi16(k2, _mm_and_si128(s, mask_5)), 5));
+
+		__m128i const mixed = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 11),
+		                                                _mm_slli_epi16(g, 6)), b);
+
+		/* keep destination pixels with zero alpha */
+		__m128i const keep = _mm_cmpeq_epi16(a, _mm_setzero_si128());
+		return _mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, mixed));
+	}
+
+	BLIT_SSE2 static void blend_rgb565_sse2(uint16 *dst, uint16 const *src,
+	                                        unsigned char const *alpha, int n)
+	{
+		for (; n >= 8; n -= 8, dst += 8, src += 8, alpha += 8) {
+
+			__m128i const a = _mm_unpacklo_epi8(_mm_loadl_epi64((__m128i const *)alpha),
+			                                    _mm_setzero_si128());
+
+			/* skip fully transparent blocks */
+			int const zero = _mm_movemask_epi8(_mm_cmpeq_epi16(a, _mm_setzero_si128()));
+			if (zero == 0xffff)
+				continue;
+
+			__m128i const s = _mm_loadu_si128((__m128i const *)src);
+			__m128i const d = _mm_loadu_si128((__m128i const *)dst);
+
+			_mm_storeu_si128((__m128i *)dst, blend_8_sse2(d, s, a));
+		}
+		blend_rgb565_scalar(dst, src, alpha, n);
+	}
+
+	BLIT_SSE2 static void avr_rgb565_sse2(uint16 *dst, uint16 const *src,
+	                                      uint16 mix, int n)
+	{
+		__m128i const mask = _mm_set1_epi16((short)0xf7df);
+		__m128i const m    = _mm_srli_epi16(_mm_and_si128(_mm_set1_epi16(mix), mask), 1);
+
+		for (; n >= 8; n -= 8, dst += 8, src += 8) {
+			__m128i const s = _mm_loadu_si128((__m128i const *)src);
+			_mm_storeu_si128((__m128i *)dst,
+			                 _mm_add_epi16(m, _mm_srli_epi16(_mm_and_si128(s, mask), 1)));
+		}
+		avr_rgb565_scalar(dst, src, mix, n);
+	}
+
+	BLIT_SSE2 static inline __m128i rgb888_to_rgb565_4_sse2(__m128i p)
+	{
+		__m128i const r = _mm_and_si128(_mm_srli_epi32(p, 8), _mm_set1_epi32(0xf800));
+		__m128i const g = _mm_and_si128(_mm_srli_epi32(p, 5), _mm_set1_epi32(0x07e0));
+		__m128i const b = _mm_and_si128(_mm_srli_epi32(p, 3), _mm_set1_epi32(0x001f));
+		__m128i const v = _mm_or_si128(_mm_or_si128(r, g), b);
+
+		/* sign-extend to let the signed saturation of 'packs' keep the value */
+		return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+	}
+
+	BLIT_SSE2 static void rgb888_to_rgb565_sse2(uint16 *dst, uint32 const *src, int n)
+	{
+		for (; n >= 8; n -= 8, dst += 8, src += 8) {
+			__m128i const lo = rgb888_to_rgb565_4_sse2(_mm_loadu_si128((__m128i const *)src));
+			__m128i const hi = rgb888_to_rgb565_4_sse2(_mm_loadu_si128((__m128i const *)(src + 4)));
+			_mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(lo, hi));
+		}
+		rgb888_to_rgb565_scalar(dst, src, n);
+	}
+
+	BLIT_SSE2 static inline __m128i rgb565_to_rgb888_4_sse2(__m128i p)
+	{
+		__m128i const r = _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xf800)), 8);
+		__m128i const g = _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0x07e0)), 5);
+		__m128i const b = _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0x001f)), 3);
+		return _mm_or_si128(_mm_or_si128(r, g), b);
+	}
+
+	BLIT_SSE2 static void rgb565_to_rgb888_sse2(uint32 *dst, uint16 const *src, int n)
+	{
+		for (; n >= 8; n -= 8, dst += 8, src += 8) {
+			__m128i const p = _mm_loadu_si128((__m128i const *)src);
+			__m128i const z = _mm_setzero_si128();
+			_mm_storeu_si128((__m128i *)dst,       rgb565_to_rgb888_4_sse2(_mm_unpacklo_epi16(p, z)));
+			_mm_storeu_si128((__m128i *)(dst + 4), rgb565_to_rgb888_4_sse2(_mm_unpackhi_epi16(p, z)));
+		}
+		rgb565_to_rgb888_scalar(dst, src, n);
+	}
+
+	static Kernels const sse2_kernels = {
+		BLIT_ISA_SSE2, copy_sse2, copy_done_sse2,
+		fill_16_sse2, fill_32_sse2, blend_rgb565_sse2, avr_rgb565_sse2,
+		rgb888_to_rgb565_sse2, rgb565_to_rgb888_sse2 };
+}
+
+
+/******************
+ ** AVX2 kernels **
+ ******************/
+
+namespace Blit {
+
+	BLIT_AVX2 static void copy_avx2(char *dst, char const *src, int bytes)
+	{
+		if (bytes < MIN_STREAM_BYTES) {
+			Genode::memcpy(dst, src, bytes);
+			return;
+		}
+
+		/* align destination to 32 bytes */
+		int const head = (32 - ((unsigned long)dst & 31)) & 31;
+		Genode::memcpy(dst, src, head);
+		dst += head; src += head; bytes -= head;
+
+		for (; bytes >= 128; bytes -= 128, dst += 128, src += 128) {
+			__m256i const v0 = _mm256_loadu_si256((__m256i const *)(src +  0));
+			__m256i const v1 = _mm256_loadu_si256((__m256i const *)(src + 32));
+			__m256i const v2 = _mm256_loadu_si256((__m256i const *)(src + 64));
+			__m256i const v3 = _mm256_loadu_si256((__m256i const *)(src + 96));
+			_mm256_stream_si256((__m256i *)(dst +  0), v0);
+			_mm256_stream_si256((__m256i *)(dst + 32), v1);
+			_mm256_stream_si256((__m256i *)(dst + 64), v2);
+			_mm256_stream_si256((__m256i *)(dst + 96), v3);
+		}
+		for (; bytes >= 32; bytes -= 32, dst += 32, src += 32)
+			_mm256_stream_si256((__m256i *)dst, _mm256_loadu_si256((__m256i const *)src));
+
+		Genode::memcpy(dst, src, bytes);
+	}
+
+	BLIT_AVX2 static void copy_done_avx2()
+	{
+		_mm_sfence();
+		_mm256_zeroupper();
+	}
+
+	BLIT_AVX2 static void fill_16_avx2(uint16 *dst, uint16 value, int n)
+	{
+		__m256i const v = _mm256_set1_epi16(value);
+		for (; n >= 16; n -= 16, dst += 16)
+			_mm256_storeu_si256((__m256i *)dst, v);
+		_mm256_zeroupper();
+		fill_16_scalar(dst, value, n);
+	}
+
+	BLIT_AVX2 static void fill_32_avx2(uint32 *dst, uint32 value, int n)
+	{
+		__m256i const v = _mm256_set1_epi32(value);
+		for (; n >= 8; n -= 8, dst += 8)
+			_mm256_storeu_si256((__m256i *)dst, v);
+		_mm256_zeroupper();
+		fill_32_scalar(dst, value, n);
+	}
+
+	/**
+	 * Blend sixteen RGB565 pixels, see 'blend_8_sse2'
+	 */
+	BLIT_AVX2 static inline __m256i blend_16_avx2(__m256i d, __m256i s, __m256i a)
+	{
+		__m256i const mask_5 = _mm256_set1_epi16(0x1f);
+
+		__m256i const x2 = _mm256_add_epi16(a, _mm256_set1_epi16(1));
+		__m256i const x1 = _mm256_sub_epi16(_mm256_set1_epi16(264), x2);
+		__m256i const k2 = _mm256_srli_epi16(x2, 3);
+		__m256i const k1 = _mm256_srli_epi16(x1, 3);
+
+		__m256i const r = _mm256_add_epi16(
+			_mm256_srli_epi16(_mm256_mullo_epi16(k1, _mm256_srli_epi16(d, 11)), 5),
+			_mm256_srli_epi16(_mm256_mullo_epi16(k2, _mm256_srli_epi16(s, 11)), 5));
+
+		__m256i const g = _mm256_add_epi16(
+			_mm256_srli_epi16(_mm256_mullo_epi16(x1, _mm256_and_si256(_mm256_srli_epi16(d, 6), mask_5)), 8),
+			_mm256_srli_epi16(_mm256_mullo_epi16(x2, _mm256_and_si256(_mm256_srli_epi16(s, 6), mask_5)), 8));
+
+		__m256i const b = _mm256_add_epi16(
+			_mm256_srli_epi16(_mm256_mullo_epi16(k1, _mm256_and_si256(d, mask_5)), 5),
+			_mm256_srli_epi16(_mm256_mullo_epi16(k2, _mm256_and_si256(s, mask_5)), 5));
+
+		__m256i const mixed = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi16(r, 11),
+		                                                      _mm256_slli_epi16(g, 6)), b);
+
+		__m256i const keep = _mm256_cmpeq_epi16(a, _mm256_setzero_si256());
+		return _mm256_blendv_epi8(mixed, d, keep);
+	}
+
+	BLIT_AVX2 static void blend_rgb565_avx2(uint16 *dst, uint16 const *src,
+	                                        unsigned char const *alpha, int n)
+	{
+		for (; n >= 16; n -= 16, dst += 16, src += 16, alpha += 16) {
+
+			__m128i const a8 = _mm_loadu_si128((__m128i const *)alpha);
+
+			/* skip fully transparent blocks */
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(a8, _mm_setzero_si128())) == 0xffff)
+				continue;
+
+			__m256i const a = _mm256_cvtepu8_epi16(a8);
+			__m256i const s = _mm256_loadu_si256((__m256i const *)src);
+			__m256i const d = _mm256_loadu_si256((__m256i const *)dst);
+
+			_mm256_storeu_si256((__m256i *)dst, blend_16_avx2(d, s, a));
+		}
+		_mm256_zeroupper();
+		blend_rgb565_scalar(dst, src, alpha, n);
+	}
+
+	BLIT_AVX2 static void avr_rgb565_avx2(uint16 *dst, uint16 const *src,
+	                                      uint16 mix, int n)
+	{
+		__m256i const mask = _mm256_set1_epi16((short)0xf7df);
+		__m256i const m    = _mm256_srli_epi16(_mm256_and_si256(_mm256_set1_epi16(mix), mask), 1);
+
+		for (; n >= 16; n -= 16, dst += 16, src += 16) {
+			__m256i const s = _mm256_loadu_si256((__m256i const *)src);
+			_mm256_storeu_si256((__m256i *)dst,
+			                    _mm256_add_epi16(m, _mm256_srli_epi16(_mm256_and_si256(s, mask), 1)));
+		}
+		_mm256_zeroupper();
+		avr_rgb565_scalar(dst, src, mix, n);
+	}
+
+	BLIT_AVX2 static inline __m256i rgb888_to_rgb565_8_avx2(__m256i p)
+	{
+		__m256i const r = _mm256_and_si256(_mm256_srli_epi32(p, 8), _mm256_set1_epi32(0xf800));
+		__m256i const g = _mm256_and_si256(_mm256_srli_epi32(p, 5), _mm256_set1_epi32(0x07e0));
+		__m256i const b = _mm256_and_si256(_mm256_srli_epi32(p, 3), _mm256_set1_epi32(0x001f));
+		return _mm256_or_si256(_mm256_or_si256(r, g), b);
+	}
+
+	BLIT_AVX2 static void rgb888_to_rgb565_avx2(uint16 *dst, uint32 const *src, int n)
+	{
+		for (; n >= 16; n -= 16, dst += 16, src += 16) {
+
+			__m256i const lo = rgb888_to_rgb565_8_avx2(_mm256_loadu_si256((__m256i const *)src));
+			__m256i const hi = rgb888_to_rgb565_8_avx2(_mm256_loadu_si256((__m256i const *)(src + 8)));
+
+			/* 'packus' operates per 128-bit lane, restore the pixel order */
+			__m256i const packed = _mm256_packus_epi32(lo, hi);
+			_mm256_storeu_si256((__m256i *)dst, _mm256_permute4x64_epi64(packed, 0xd8));
+		}
+		_mm256_zeroupper();
+		rgb888_to_rgb565_scalar(dst, src, n);
+	}
+
+	BLIT_AVX2 static void rgb565_to_rgb888_avx2(uint32 *dst, uint16 const *src, int n)
+	{
+		for (; n >= 8; n -= 8, dst += 8, src += 8) {
+			__m256i const p = _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const *)src));
+			__m256i const r = _mm256_slli_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0xf800)), 8);
+			__m256i const g = _mm256_slli_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0x07e0)), 5);
+			__m256i const b = _mm256_slli_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0x001f)), 3);
+			_mm256_storeu_si256((__m256i *)dst, _mm256_or_si256(_mm256_or_si256(r, g), b));
+		}
+		_mm256_zeroupper();
+		rgb565_to_rgb888_scalar(dst, src, n);
+	}
+
+	static Kernels const avx2_kernels = {
+		BLIT_ISA_AVX2, copy_avx2, copy_done_avx2,
+		fill_16_avx2, fill_32_avx2, blend_rgb565_avx2, avr_rgb565_avx2,
+		rgb888_to_rgb565_avx2, rgb565_to_rgb888_avx2 };
+}
+
+
+namespace Blit {
+
+	/**
+	 * Return kernels for 'isa' or nullptr if not supported by the CPU
+	 */
+	static inline Kernels const *simd_kernels(Blit_isa isa)
+	{
+		switch (isa) {
+		case BLIT_ISA_SSE2: return cpu_has_sse2() ? &sse2_kernels : nullptr;
+		case BLIT_ISA_AVX2: return cpu_has_avx2() ? &avx2_kernels : nullptr;
+		default:            return nullptr;
+		}
+	}
+}
+
+#endif /* _LIB__BLIT__SPEC__X86__SIMD_KERNELS_H_ */
@@ -34,6 +34,12 @@ void Icmp_packet::update_checksum(size_t data_sz)
 }
 
 
+void Icmp_packet::update_checksum(Internet_checksum_diff const &diff)
+{
+	_checksum = diff.apply_to(_checksum);
+}
+
+
 bool Icmp_packet::checksum_error(size_t data_sz) const
 {
 	return internet_checksum((uint16_t *)this, sizeof(Icmp_packet) + data_sz);
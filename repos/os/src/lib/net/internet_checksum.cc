@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2018 Genode Labs GmbH
+ * Copyright (C) 2018-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -18,25 +18,66 @@ using namespace Net;
 using namespace Genode;
 
 
+/*
+ * Accessors for words at arbitrary alignment
+ *
+ * Packet headers are not necessarily aligned to the word size. Accessing
+ * the data via packed structures lets the compiler choose the appropriate
+ * load instructions for the target architecture.
+ */
+struct Unaligned_uint16 { uint16_t value; } __attribute__((packed));
+struct Unaligned_uint32 { uint32_t value; } __attribute__((packed));
+
+static inline uint16_t _load_16(uint8_t const *data) {
+	return ((Unaligned_uint16 const *)data)->value; }
+
+static inline uint32_t _load_32(uint8_t const *data) {
+	return ((Unaligned_uint32 const *)data)->value; }
+
+
+static inline uint16_t _fold(uint64_t sum)
+{
+	while (uint64_t const sum_rsh = sum >> 16)
+		sum = (sum & 0xffff) + sum_rsh;
+
+	return sum;
+}
+
+
 uint16_t Net::internet_checksum(uint16_t const *addr,
                                 size_t          size,
                                 addr_t          init_sum)
 {
-	/* add up bytes in pairs */
-	addr_t sum = init_sum;
-	for (; size > 1; size -= 2)
-		sum += *addr++;
+	uint8_t const *data = (uint8_t const *)addr;
+
+	/*
+	 * Add up 32-bit words in a 64-bit accumulator
+	 *
+	 * Because 2^16 is congruent to 1 modulo 2^16 - 1, folding the sum of
+	 * 32-bit words yields the same one's complement sum as adding up the
+	 * 16-bit halves one at a time. The accumulator cannot overflow for data
+	 * smaller than 16 GiB. The main loop is unrolled to process 16 bytes
+	 * per iteration with independent additions.
+	 */
+	uint64_t sum = init_sum;
+	for (; size >= 16; size -= 16, data += 16)
+		sum += (uint64_t)_load_32(data)     + _load_32(data + 4) +
+		       (uint64_t)_load_32(data + 8) + _load_32(data + 12);
 
+	for (; size >= 4; size -= 4, data += 4)
+		sum += _load_32(data);
+
+	if (size >= 2) {
+		sum += _load_16(data);
+		size -= 2;
+		data += 2;
+	}
 	/* add left-over byte, if any */
 	if (size > 0)
-		sum += *(uint8_t *)addr;
-
-	/* fold sum to 16-bit value */
-	while (addr_t const sum_rsh = sum >> 16)
-		sum = (sum & 0xffff) + sum_rsh;
+		sum += *data;
 
-	/* return one's complement */
-	return ~sum;
+	/* return one's complement of the folded sum */
+	return ~_fold(sum);
 }
 
 
@@ -62,3 +103,33 @@ uint16_t Net::internet_checksum_pseudo_ip(uint16_t        const *ip_data,
 	/* add up IP data bytes */
 	return internet_checksum(ip_data, ip_data_sz, sum);
 }
+
+
+/****************************
+ ** Internet_checksum_diff **
+ ****************************/
+
+void Internet_checksum_diff::add_up_diff(void   const *new_data,
+                                         void   const *old_data,
+                                         size_t        size)
+{
+	uint8_t const *new_bytes = (uint8_t const *)new_data;
+	uint8_t const *old_bytes = (uint8_t const *)old_data;
+
+	/* add up the one's complement of the old words and the new words */
+	for (size_t i = 0; i + 1 < size; i += 2)
+		_value += (uint16_t)~_load_16(old_bytes + i) + _load_16(new_bytes + i);
+}
+
+
+void Internet_checksum_diff::add_up_diff(Internet_checksum_diff const &diff)
+{
+	_value += diff._value;
+}
+
+
+uint16_t Internet_checksum_diff::apply_to(uint16_t checksum) const
+{
+	/* HC' = ~(~HC + ~m + m') */
+	return ~_fold((uint16_t)~checksum + _value);
+}
@@ -142,6 +142,12 @@ void Ipv4_packet::update_checksum()
 }
 
 
+void Ipv4_packet::update_checksum(Internet_checksum_diff const &diff)
+{
+	_checksum = diff.apply_to(_checksum);
+}
+
+
 bool Ipv4_packet::checksum_error() const
 {
 	return internet_checksum((uint16_t *)this, sizeof(Ipv4_packet));
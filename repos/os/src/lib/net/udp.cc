@@ -41,6 +41,19 @@ void Net::Udp_packet::update_checksum(Ipv4_address ip_src,
 }
 
 
+void Net::Udp_packet::update_checksum(Internet_checksum_diff const &diff)
+{
+	if (!_checksum)
+		return;
+
+	_checksum = diff.apply_to(_checksum);
+
+	/* a computed checksum of zero is transmitted as all ones (RFC 768) */
+	if (!_checksum)
+		_checksum = 0xffff;
+}
+
+
 bool Net::Udp_packet::checksum_error(Ipv4_address ip_src,
                                      Ipv4_address ip_dst) const
 {
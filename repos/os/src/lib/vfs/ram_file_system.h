@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2015-2018 Genode Labs GmbH
+ * Copyright (C) 2015-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -14,11 +14,14 @@
 #ifndef _INCLUDE__VFS__RAM_FILE_SYSTEM_H_
 #define _INCLUDE__VFS__RAM_FILE_SYSTEM_H_
 
-#include <ram_fs/chunk.h>
-#include <ram_fs/param.h>
+#include <ram_fs/extent.h>
 #include <vfs/file_system.h>
 #include <dataspace/client.h>
 #include <util/avl_tree.h>
+#include <util/reconstructible.h>
+#include <base/registry.h>
+#include <region_map/client.h>
+#include <rm_session/connection.h>
 
 namespace Vfs { class Ram_file_system; }
 
@@ -26,18 +29,19 @@ namespace Vfs_ram {
 
 	using namespace Genode;
 	using namespace Vfs;
-	using namespace Ram_fs;
-	using File_system::Chunk;
-	using File_system::Chunk_index;
+	using File_system::Extent_map;
 
 	struct Io_handle;
 	struct Watch_handle;
+	struct Exported_dataspace;
 
 	class Node;
 	class File;
 	class Symlink;
 	class Directory;
 
+	typedef Registered<Exported_dataspace> Registered_export;
+
 	enum { MAX_NAME_LEN = 128 };
 
 	typedef Genode::Allocator::Out_of_memory Out_of_memory;
@@ -232,26 +236,100 @@ class Vfs_ram::Node : private Genode::Avl_node<Node>, private Genode::Lock
 };
 
 
+/**
+ * Copy of the content of a file handed out by 'Ram_file_system::dataspace'
+ *
+ * All requests for the dataspace of an unmodified file share the same copy,
+ * which makes repeated requests for read-mostly files, e.g., by a ROM
+ * service, cheap. Once the file gets modified or destroyed, the copy is
+ * detached from the file and freed when released by its last user.
+ *
+ * The users do not obtain the RAM dataspace of the copy but a managed
+ * dataspace that contains the copy as read-only attachment. So no user can
+ * modify the content seen by the other users.
+ */
+struct Vfs_ram::Exported_dataspace : Genode::Noncopyable
+{
+	Ram_allocator                  &ram;
+	Rm_session                     &rm;
+	Ram_dataspace_capability const  ram_cap;
+	Capability<Region_map>   const  view;
+
+	/* read-only view handed out to the users */
+	Dataspace_capability cap { };
+
+	unsigned users    = 0;
+	bool     detached = false;
+
+	/**
+	 * Constructor
+	 *
+	 * \throw Out_of_ram
+	 * \throw Out_of_caps
+	 * \throw Region_map::Region_conflict
+	 */
+	Exported_dataspace(Ram_allocator &ram, Rm_session &rm,
+	                   Ram_dataspace_capability ram_cap)
+	:
+		ram(ram), rm(rm), ram_cap(ram_cap),
+		view(rm.create(Dataspace_client(ram_cap).size()))
+	{
+		enum { OFFSET = 0, LOCAL_ADDR = false, EXEC = false, WRITE = false };
+
+		try {
+			Region_map_client map(view);
+			map.attach(ram_cap, 0, OFFSET, LOCAL_ADDR, (addr_t)0, EXEC, WRITE);
+			cap = map.dataspace();
+		}
+		catch (...) { rm.destroy(view); throw; }
+	}
+
+	virtual ~Exported_dataspace()
+	{
+		rm.destroy(view);
+		ram.free(ram_cap);
+	}
+};
+
+
 class Vfs_ram::File : public Vfs_ram::Node
 {
 	private:
 
-		typedef Chunk      <num_level_3_entries()>                Chunk_level_3;
-		typedef Chunk_index<num_level_2_entries(), Chunk_level_3> Chunk_level_2;
-		typedef Chunk_index<num_level_1_entries(), Chunk_level_2> Chunk_level_1;
-		typedef Chunk_index<num_level_0_entries(), Chunk_level_1> Chunk_level_0;
+		Allocator         &_alloc;
+		Extent_map         _extents;
+		file_size          _length = 0;
+		Registered_export *_export = nullptr;
 
-		Chunk_level_0 _chunk;
-		file_size     _length = 0;
+		/**
+		 * Detach exported dataspace, which no longer reflects the content
+		 */
+		void _detach_export()
+		{
+			if (!_export)
+				return;
+
+			_export->detached = true;
+			if (!_export->users)
+				destroy(_alloc, _export);
+
+			_export = nullptr;
+		}
 
 	public:
 
 		File(char const *name, Allocator &alloc)
-		: Node(name), _chunk(alloc, 0) { }
+		: Node(name), _alloc(alloc), _extents(alloc) { }
+
+		~File() { _detach_export(); }
+
+		Registered_export *exported() const { return _export; }
+
+		void exported(Registered_export &e) { _export = &e; }
 
 		size_t read(char *dst, size_t len, file_size seek_offset) override
 		{
-			file_size const chunk_used_size = _chunk.used_size();
+			file_size const chunk_used_size = _extents.used_size();
 
 			if (seek_offset >= _length)
 				return 0;
@@ -260,7 +338,7 @@ class Vfs_ram::File : public Vfs_ram::Node
 			 * Constrain read transaction to available chunk data
 			 *
 			 * Note that 'chunk_used_size' may be lower than '_length'
-			 * because 'Chunk' may have truncated tailing zeros.
+			 * because the file may have been extended via 'truncate'.
 			 */
 			if (seek_offset + len >= _length)
 				len = _length - seek_offset;
@@ -274,7 +352,7 @@ class Vfs_ram::File : public Vfs_ram::Node
 					read_len = 0;
 			}
 
-			_chunk.read(dst, read_len, seek_offset);
+			_extents.read(dst, read_len, seek_offset);
 
 			/* add zero padding if needed */
 			if (read_len < len)
@@ -295,18 +373,17 @@ class Vfs_ram::File : public Vfs_ram::Node
 		size_t write(char const *src, size_t len, file_size seek_offset) override
 		{
 			if (seek_offset == (file_size)(~0))
-				seek_offset = _chunk.used_size();
+				seek_offset = _extents.used_size();
 
-			if (seek_offset + len >= Chunk_level_0::SIZE)
-				len = Chunk_level_0::SIZE - (seek_offset + len);
+			_detach_export();
 
-			try { _chunk.write(src, len, (size_t)seek_offset); }
+			try { _extents.write(src, len, seek_offset); }
 			catch (Out_of_memory) { return 0; }
 
 			/*
-			 * Keep track of file length. We cannot use 'chunk.used_size()'
-			 * as file length because trailing zeros may by represented
-			 * by zero chunks, which do not contribute to 'used_size()'.
+			 * Keep track of file length. We cannot use 'used_size()'
+			 * as file length because the file may have been extended by
+			 * 'truncate' without writing data.
 			 */
 			_length = max(_length, seek_offset + len);
 
@@ -317,8 +394,10 @@ class Vfs_ram::File : public Vfs_ram::Node
 
 		void truncate(file_size size) override
 		{
-			if (size < _chunk.used_size())
-				_chunk.truncate(size);
+			_detach_export();
+
+			if (size < _extents.used_size())
+				_extents.truncate(size);
 
 			_length = size;
 		}
@@ -481,8 +560,42 @@ class Vfs::Ram_file_system : public Vfs::File_system
 		friend class Genode::List<Vfs_ram::Watch_handle>;
 
 		Vfs::Env           &_env;
+
+		Genode::Registry<Vfs_ram::Registered_export> _exports { };
 		Vfs_ram::Directory  _root = { "" };
 
+		/*
+		 * RM session for the read-only views of exported dataspaces,
+		 * opened not before the first dataspace is requested
+		 */
+		Genode::Constructible<Genode::Rm_connection> _rm_connection { };
+
+		bool _rm_unavailable = false;
+
+		/**
+		 * Return RM session, or nullptr if no RM session is available
+		 */
+		Genode::Rm_session *_rm_session()
+		{
+			using namespace Genode;
+
+			if (!_rm_connection.constructed() && !_rm_unavailable) {
+				try { _rm_connection.construct(_env.env()); }
+				catch (Service_denied)         { }
+				catch (Insufficient_ram_quota) { }
+				catch (Insufficient_cap_quota) { }
+				catch (Out_of_ram)             { }
+				catch (Out_of_caps)            { }
+
+				if (!_rm_connection.constructed()) {
+					warning("RM session unavailable, handing out private "
+					        "copies of file content");
+					_rm_unavailable = true;
+				}
+			}
+			return _rm_connection.constructed() ? &*_rm_connection : nullptr;
+		}
+
 		Vfs_ram::Node *lookup(char const *path, bool return_parent = false)
 		{
 			using namespace Vfs_ram;
@@ -885,6 +998,12 @@ class Vfs::Ram_file_system : public Vfs::File_system
 			File *file = dynamic_cast<File *>(node);
 			if (!file) return ds_cap;
 
+			/* share the copy of the unmodified file content */
+			if (Registered_export *e = file->exported()) {
+				e->users++;
+				return e->cap;
+			}
+
 			size_t len = file->length();
 
 			char *local_addr = nullptr;
@@ -900,12 +1019,51 @@ class Vfs::Ram_file_system : public Vfs::File_system
 				_env.env().ram().free(ds_cap);
 				return Dataspace_capability();
 			}
+
+			/*
+			 * Share the copy via a read-only view. Without a view, the
+			 * caller obtains the copy as its private dataspace.
+			 */
+			Rm_session *rm = _rm_session();
+			if (!rm)
+				return ds_cap;
+
+			try {
+				Registered_export &e = *new (_env.alloc())
+					Registered_export(_exports, _env.env().ram(), *rm, ds_cap);
+
+				e.users++;
+				file->exported(e);
+				return e.cap;
+			}
+			catch (Out_of_memory)               { }
+			catch (Out_of_caps)                 { }
+			catch (Region_map::Region_conflict) { }
+
 			return ds_cap;
 		}
 
-		void release(char const *, Dataspace_capability ds_cap) override {
-			_env.env().ram().free(
-				static_cap_cast<Genode::Ram_dataspace>(ds_cap)); }
+		void release(char const *, Dataspace_capability ds_cap) override
+		{
+			using namespace Vfs_ram;
+
+			bool exported = false;
+			_exports.for_each([&] (Registered_export &e) {
+				if (exported || !(e.cap == ds_cap))
+					return;
+
+				exported = true;
+				if (e.users)
+					e.users--;
+
+				if (!e.users && e.detached)
+					destroy(_env.alloc(), &e);
+			});
+
+			if (!exported)
+				_env.env().ram().free(
+					static_cap_cast<Genode::Ram_dataspace>(ds_cap));
+		}
 
 
 		Watch_result watch(char const      *path,
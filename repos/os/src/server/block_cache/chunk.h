@@ -185,14 +185,32 @@ namespace Cache {
 					throw Range_incomplete(base_offset(), SIZE);
 			}
 
+			/**
+			 * Hand over dirty chunk for writing back to the backend device
+			 *
+			 * The chunk stays dirty until its content got copied into a
+			 * write request to the backend device, which is signalled via
+			 * 'mark_clean'.
+			 */
 			void sync(size_t len, offset_t seek_offset)
 			{
-				if (_writes > 1) {
+				if (_writes > 1)
 					POLICY::sync(this, (char*)_data);
-					_writes = 1;
-				}
 			}
 
+			bool dirty() const { return _writes > 1; }
+
+			/**
+			 * Mark chunk as written back
+			 *
+			 * A write to the chunk after this point, e.g., while the write
+			 * request is still in flight, makes the chunk dirty again. So
+			 * the modification is written back by a later sync.
+			 */
+			void mark_clean() { if (_writes > 1) _writes = 1; }
+
+			char const *data() const { return _data; }
+
 			void alloc(size_t len, offset_t seek_offset) { }
 
 			void truncate(size_t size)
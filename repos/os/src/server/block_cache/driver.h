@@ -16,7 +16,7 @@
 #include <block/component.h>
 #include <os/packet_allocator.h>
 
-#include "chunk.h"
+#include "policy.h"
 
 /**
  * Cache driver used by the generic block driver framework
@@ -37,11 +37,12 @@ class Driver : public Block::Driver
 			Block::Packet_descriptor srv;
 			Block::Packet_descriptor cli;
 			char * const             buffer;
+			unsigned long const      epoch; /* epoch of the client request */
 
 			Request(Block::Packet_descriptor &s,
 			        Block::Packet_descriptor &c,
 			        char * const              b)
-				: srv(s), cli(c), buffer(b) {}
+				: srv(s), cli(c), buffer(b), epoch(POLICY::epoch()) {}
 
 			/*
 			 * \return true when the given response packet matches
@@ -75,6 +76,15 @@ class Driver : public Block::Driver
 		};
 
 
+		/*
+		 * The given policy class is extended by a synchronization routine,
+		 * used by the cache chunk structure
+		 */
+		struct Policy : POLICY {
+			static void sync(const typename POLICY::Element *e, char *src); };
+
+	public:
+
 		/**
 		 * Write failed exception at a specific device offset,
 		 * can be triggered whenever the backend device is not ready
@@ -87,19 +97,10 @@ class Driver : public Block::Driver
 			Write_failed(Cache::offset_t o) : off(o) {}
 		};
 
-
-		/*
-		 * The given policy class is extended by a synchronization routine,
-		 * used by the cache chunk structure
-		 */
-		struct Policy : POLICY {
-			static void sync(const typename POLICY::Element *e, char *src); };
-
-	public:
-
 		enum {
 			SLAB_SZ = Block::Session::TX_QUEUE_SIZE*sizeof(Request),
-			CACHE_BLK_SIZE = 4096
+			CACHE_BLK_SIZE = 4096,
+			MAX_WRITE_BATCH = 64 /* maximum cache blocks per write request */
 		};
 
 		/**
@@ -114,6 +115,60 @@ class Driver : public Block::Driver
 
 	private:
 
+		/**
+		 * Adjacent dirty chunks that are written back by one request
+		 */
+		class Write_batch
+		{
+			private:
+
+				Chunk_level_4 *_chunks[MAX_WRITE_BATCH] { };
+				unsigned       _count { 0 };
+				unsigned const _limit;
+
+				Cache::offset_t _end() const {
+					return _chunks[0]->base_offset() + _count*CACHE_BLK_SIZE; }
+
+			public:
+
+				Write_batch(unsigned limit)
+				: _limit(Genode::max(1U, Genode::min(limit, (unsigned)MAX_WRITE_BATCH))) { }
+
+				bool empty() const { return _count == 0; }
+
+				Cache::offset_t base()  const { return _chunks[0]->base_offset(); }
+				Cache::size_t   bytes() const { return _count*CACHE_BLK_SIZE; }
+
+				bool contains(Cache::offset_t off) const {
+					return !empty() && off >= base() && off < _end(); }
+
+				/**
+				 * Append chunk to the batch
+				 *
+				 * \return false if the chunk is not adjacent to the batch
+				 *         or the batch is full
+				 */
+				bool append(Chunk_level_4 &chunk)
+				{
+					if (!empty() && (_count == _limit ||
+					                 chunk.base_offset() != _end()))
+						return false;
+
+					_chunks[_count++] = &chunk;
+					return true;
+				}
+
+				template <typename FN>
+				void for_each(FN const &fn)
+				{
+					for (unsigned i = 0; i < _count; i++)
+						fn(*_chunks[i]);
+				}
+
+				void reset() { _count = 0; }
+		};
+
+
 		Genode::Env                      &_env;
 		Genode::Tslab<Request, SLAB_SZ>   _r_slab;    /* slab for requests  */
 		Genode::List<Request>             _r_list;    /* list of requests   */
@@ -121,10 +176,14 @@ class Driver : public Block::Driver
 		Block::Connection<>               _blk;       /* backend device     */
 		Block::Session::Info        const _info;      /* block-device info  */
 		Chunk_level_0                     _cache;     /* chunk hierarchy    */
+		Write_batch                       _write_batch;
 		Genode::Io_signal_handler<Driver> _source_ack;
 		Genode::Io_signal_handler<Driver> _source_submit;
 		Genode::Io_signal_handler<Driver> _yield;
 
+		/* index of the last chunk touched by the previous client request */
+		Cache::offset_t _last_chunk { ~(Cache::offset_t)0 };
+
 		Driver(Driver const&);            /* singleton pattern */
 		Driver& operator=(Driver const&); /* singleton pattern */
 
@@ -157,11 +216,11 @@ class Driver : public Block::Driver
 		{
 			try {
 			if (r->cli.operation() == Block::Packet_descriptor::READ)
-				read(r->cli.block_number(), r->cli.block_count(),
-				     r->buffer, r->cli);
-			else
-				write(r->cli.block_number(), r->cli.block_count(),
+				_read(r->cli.block_number(), r->cli.block_count(),
 				      r->buffer, r->cli);
+			else
+				_write(r->cli.block_number(), r->cli.block_count(),
+				       r->buffer, r->cli);
 			} catch(Block::Driver::Request_congestion) {
 				Genode::warning("cli (", r->cli.block_number(), " ",
 				                         r->cli.block_count(), ") "
@@ -178,6 +237,21 @@ class Driver : public Block::Driver
 			while (_blk.tx()->ack_avail()) {
 				Block::Packet_descriptor p = _blk.tx()->get_acked_packet();
 
+				/*
+				 * Account the accesses of a reply to the epoch of the
+				 * client request that caused the backend request. Otherwise,
+				 * populating and copying a chunk would count as references
+				 * by different requests.
+				 */
+				unsigned long const epoch = POLICY::epoch();
+
+				for (Request *r = _r_list.first(); r; r = r->next()) {
+					if (r->match(p)) {
+						POLICY::epoch(r->epoch);
+						break;
+					}
+				}
+
 				/* when reading, write result into cache */
 				if (p.operation() == Block::Packet_descriptor::READ)
 					_cache.write(_blk.tx()->packet_content(p),
@@ -189,12 +263,15 @@ class Driver : public Block::Driver
 				     r_to_handle = r) {
 					r = r->next();
 					if (r_to_handle->match(p)) {
+						POLICY::epoch(r_to_handle->epoch);
 						_handle_reply(p, r_to_handle);
 						_r_list.remove(r_to_handle);
 						Genode::destroy(&_r_slab, r_to_handle);
 					}
 				}
 
+				POLICY::epoch(epoch);
+
 				_blk.tx()->release_packet(p);
 			}
 		}
@@ -202,7 +279,48 @@ class Driver : public Block::Driver
 		/*
 		 * Handle that the backend device is ready to receive again
 		 */
-		void _ready_to_submit() { }
+		void _ready_to_submit() { _submit_write_batch(); }
+
+		/*
+		 * Write back the pending batch of dirty chunks
+		 *
+		 * \return false if the backend device is not ready to proceed
+		 */
+		bool _submit_write_batch()
+		{
+			if (_write_batch.empty())
+				return true;
+
+			if (!_blk.tx()->ready_to_submit())
+				return false;
+
+			try {
+				Block::Packet_descriptor
+					p(_blk.alloc_packet(_write_batch.bytes()),
+					  Block::Packet_descriptor::WRITE,
+					  _write_batch.base()  / _info.block_size,
+					  _write_batch.bytes() / _info.block_size);
+
+				/*
+				 * The packet holds a copy of the chunks. Hence, the chunks
+				 * are clean from now on. Writes issued while the request is
+				 * in flight dirty the chunks again.
+				 */
+				char *dst = _blk.tx()->packet_content(p);
+				_write_batch.for_each([&] (Chunk_level_4 &chunk) {
+					Genode::memcpy(dst, chunk.data(), CACHE_BLK_SIZE);
+					dst += CACHE_BLK_SIZE;
+					chunk.mark_clean();
+				});
+
+				_blk.tx()->submit_packet(p);
+			} catch(Block::Session::Tx::Source::Packet_alloc_failed) {
+				return false;
+			}
+
+			_write_batch.reset();
+			return true;
+		}
 
 		/*
 		 * Setup a request to the backend device
@@ -280,6 +398,30 @@ class Driver : public Block::Driver
 					_env.ep().wait_and_dispatch_one_io_signal();
 				}
 			}
+
+			/* write back the trailing batch */
+			while (!_submit_write_batch())
+				_env.ep().wait_and_dispatch_one_io_signal();
+		}
+
+		/*
+		 * Advance the epoch of the replacement policy for a client request
+		 *
+		 * A request that continues at the chunk where the previous request
+		 * ended stays in the epoch of the previous request. Hence, sequential
+		 * requests smaller than a chunk account as a single reference of the
+		 * chunk instead of promoting it as repeatedly used.
+		 */
+		void _next_epoch(Block::sector_t block_number, Genode::size_t block_count)
+		{
+			Cache::offset_t const first = block_number * _info.block_size;
+			Cache::offset_t const end   = (block_number + Genode::max(block_count, 1UL))
+			                            * _info.block_size;
+
+			if (first / CACHE_BLK_SIZE != _last_chunk)
+				POLICY::next_epoch();
+
+			_last_chunk = (end - 1) / CACHE_BLK_SIZE;
 		}
 
 		/*
@@ -323,14 +465,65 @@ class Driver : public Block::Driver
 			_env.parent().yield_response();
 		}
 
+		/*
+		 * Read blocks from the cache, fetch missing chunks from the device
+		 */
+		void _read(Block::sector_t           block_number,
+		           Genode::size_t            block_count,
+		           char*                     buffer,
+		           Block::Packet_descriptor &packet)
+		{
+			if (!_stat(block_number, block_count, buffer, packet))
+				return;
+
+			_cache.read(buffer,
+			            block_count *_info.block_size,
+			            block_number*_info.block_size);
+
+			ack_packet(packet);
+		}
+
+
+		/*
+		 * Write blocks to the cache
+		 */
+		void _write(Block::sector_t           block_number,
+		            Genode::size_t            block_count,
+		            const char *              buffer,
+		            Block::Packet_descriptor &packet)
+		{
+			if (!_info.writeable)
+				throw Io_error();
+
+			_cache.alloc(block_count  * _info.block_size,
+			             block_number * _info.block_size);
+
+			if ((block_number % _cache_blk_mod()) &&
+			    !_stat(block_number, 1, const_cast<char* const>(buffer), packet))
+				return;
+
+			if (((block_number+block_count) % _cache_blk_mod())
+				&& !_stat(block_number+block_count-1, 1,
+				          const_cast<char* const>(buffer), packet))
+				return;
+
+			_cache.write(buffer,
+			             block_count  * _info.block_size,
+			             block_number * _info.block_size);
+
+			ack_packet(packet);
+		}
+
 	public:
 
 		/*
 		 * Constructor
 		 *
-		 * \param ep  server entrypoint
+		 * \param ep           server entrypoint
+		 * \param write_batch  maximum number of cache blocks written back
+		 *                     by one request to the backend device
 		 */
-		Driver(Genode::Env &env, Genode::Heap &heap)
+		Driver(Genode::Env &env, Genode::Heap &heap, unsigned write_batch)
 		: Block::Driver(env.ram()),
 		  _env(env),
 		  _r_slab(&heap),
@@ -338,6 +531,7 @@ class Driver : public Block::Driver
 		  _blk(_env, &_alloc, Block::Session::TX_QUEUE_SIZE*CACHE_BLK_SIZE),
 		  _info(_blk.info()),
 		  _cache(heap, 0),
+		  _write_batch(write_batch),
 		  _source_ack(env.ep(), *this, &Driver::_ack_avail),
 		  _source_submit(env.ep(), *this, &Driver::_ready_to_submit),
 		  _yield(env.ep(), *this, &Driver::_parent_yield)
@@ -368,6 +562,62 @@ class Driver : public Block::Driver
 		Block::Session_client* blk()    { return &_blk;   }
 		Genode::size_t         blk_sz() { return _info.block_size; }
 
+		/**
+		 * Queue dirty chunk for writing back to the backend device
+		 *
+		 * Adjacent chunks are coalesced into one multi-block request.
+		 */
+		void write_back(Chunk_level_4 &chunk)
+		{
+			if (_write_batch.contains(chunk.base_offset()) ||
+			    _write_batch.append(chunk))
+				return;
+
+			if (!_submit_write_batch())
+				throw Write_failed(chunk.base_offset());
+
+			_write_batch.append(chunk);
+		}
+
+		/**
+		 * Evict clean chunks in the order determined by the policy
+		 *
+		 * Dirty eviction candidates are written back and become evictable
+		 * once the write back was submitted.
+		 *
+		 * \param size  number of bytes to free, or 0 to free all
+		 */
+		void evict(Cache::size_t size)
+		{
+			Cache::Replacement_policy &policy = POLICY::policy();
+
+			Cache::size_t freed     = 0;
+			bool          congested = false;
+
+			typename POLICY::Element *next = nullptr;
+			for (typename POLICY::Element *e = policy.first_victim();
+			     e && ((size == 0) || (freed < size)); e = next) {
+
+				next = policy.next_victim(*e);
+
+				Chunk_level_4 &chunk = *static_cast<Chunk_level_4 *>(e);
+				if (chunk.dirty()) {
+					if (!congested) {
+						try { chunk.sync(CACHE_BLK_SIZE, chunk.base_offset()); }
+						catch (Write_failed) { congested = true; }
+					}
+					continue;
+				}
+
+				chunk.free(CACHE_BLK_SIZE, chunk.base_offset());
+				freed += sizeof(Chunk_level_4);
+			}
+
+			_submit_write_batch();
+
+			if (freed < size) throw Block::Driver::Request_congestion();
+		}
+
 
 		/****************************
 		 ** Block-driver interface **
@@ -380,14 +630,8 @@ class Driver : public Block::Driver
 		          char*                     buffer,
 		          Block::Packet_descriptor &packet)
 		{
-			if (!_stat(block_number, block_count, buffer, packet))
-				return;
-
-			_cache.read(buffer,
-			            block_count *_info.block_size,
-			            block_number*_info.block_size);
-
-			ack_packet(packet);
+			_next_epoch(block_number, block_count);
+			_read(block_number, block_count, buffer, packet);
 		}
 
 		void write(Block::sector_t           block_number,
@@ -395,26 +639,8 @@ class Driver : public Block::Driver
 		           const char *              buffer,
 		           Block::Packet_descriptor &packet)
 		{
-			if (!_info.writeable)
-				throw Io_error();
-
-			_cache.alloc(block_count  * _info.block_size,
-			             block_number * _info.block_size);
-
-			if ((block_number % _cache_blk_mod()) &&
-			    !_stat(block_number, 1, const_cast<char* const>(buffer), packet))
-				return;
-
-			if (((block_number+block_count) % _cache_blk_mod())
-				&& !_stat(block_number+block_count-1, 1,
-				          const_cast<char* const>(buffer), packet))
-				return;
-
-			_cache.write(buffer,
-			             block_count  * _info.block_size,
-			             block_number * _info.block_size);
-
-			ack_packet(packet);
+			_next_epoch(block_number, block_count);
+			_write(block_number, block_count, buffer, packet);
 		}
 
 		void sync() { _sync(); }
@@ -5,21 +5,37 @@
  */
 
 /*
- * Copyright (C) 2013-2017 Genode Labs GmbH
+ * Copyright (C) 2013-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
  */
 
-#include <util/list.h>
+#ifndef _LRU_H_
+#define _LRU_H_
 
-#include "chunk.h"
+#include "policy.h"
 
-struct Lru_policy
+struct Lru_policy : Cache::Replacement_policy
 {
-	class Element : public Genode::List<Element>::Element {};
+	Queue _lru { };  /* head is the least-recently used element */
 
-	static void read(const Element  *e);
-	static void write(const Element *e);
-	static void flush(Cache::size_t size = 0);
+	Lru_policy() { }
+
+
+	/****************************************
+	 ** Cache::Replacement_policy interface **
+	 ****************************************/
+
+	void access(Element const &e) override;
+
+	Element *first_victim() override { return _lru.head(); }
+
+	Element *next_victim(Element const &e) override { return Queue::next(e); }
+
+	unsigned long count() const override { return _lru.count(); }
+
+	char const *name() const override { return "lru"; }
 };
+
+#endif /* _LRU_H_ */
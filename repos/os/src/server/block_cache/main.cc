@@ -12,12 +12,13 @@
  */
 
 #include <base/component.h>
+#include <base/attached_rom_dataspace.h>
 
 #include "lru.h"
+#include "two_queue.h"
 #include "driver.h"
 
-using Policy = Lru_policy;
-static Driver<Policy> * driver = nullptr;
+static Driver<Cache_policy> * driver = nullptr;
 
 
 /**
@@ -26,22 +27,19 @@ static Driver<Policy> * driver = nullptr;
 template <typename POLICY>
 void Driver<POLICY>::Policy::sync(const typename POLICY::Element *e, char *dst)
 {
-	Cache::offset_t off =
-		static_cast<const Driver<POLICY>::Chunk_level_4*>(e)->base_offset();
-
-	if (!driver) throw Write_failed(off);
-
-	if (!driver->blk()->tx()->ready_to_submit())
-		throw Write_failed(off);
-	try {
-		Block::Packet_descriptor
-			p(driver->blk()->alloc_packet(Driver::CACHE_BLK_SIZE),
-		      Block::Packet_descriptor::WRITE, off / driver->blk_sz(),
-		      Driver::CACHE_BLK_SIZE / driver->blk_sz());
-		driver->blk()->tx()->submit_packet(p);
-	} catch(Block::Session::Tx::Source::Packet_alloc_failed) {
-		throw Write_failed(off);
-	}
+	typedef typename Driver<POLICY>::Chunk_level_4 Chunk;
+
+	Chunk &chunk = *const_cast<Chunk *>(static_cast<Chunk const *>(e));
+
+	if (!driver) throw Write_failed(chunk.base_offset());
+
+	driver->write_back(chunk);
+}
+
+
+void Cache_policy::flush(Cache::size_t size)
+{
+	if (driver) driver->evict(size);
 }
 
 
@@ -50,32 +48,70 @@ struct Main
 	template <typename T>
 	struct Factory : Block::Driver_factory
 	{
-		Genode::Env  &env;
-		Genode::Heap &heap;
+		Genode::Env    &env;
+		Genode::Heap   &heap;
+		unsigned const  write_batch;
 
-		Factory(Genode::Env &env, Genode::Heap &heap) : env(env), heap(heap) {}
+		Factory(Genode::Env &env, Genode::Heap &heap, unsigned write_batch)
+		: env(env), heap(heap), write_batch(write_batch) {}
 
 		Block::Driver *create()
 		{
-			driver = new (&heap) ::Driver<T>(env, heap);
+			driver = new (&heap) ::Driver<T>(env, heap, write_batch);
 			return driver;
 		}
 
-		void destroy(Block::Driver *driver) {
-			Genode::destroy(&heap, static_cast<::Driver<T>*>(driver)); }
+		void destroy(Block::Driver *d)
+		{
+			Genode::destroy(&heap, static_cast<::Driver<T>*>(d));
+			driver = nullptr;
+		}
 	};
 
 	void resource_handler() { }
 
 	Genode::Env                 &env;
 	Genode::Heap                 heap    { env.ram(), env.rm()     };
-	Factory<Lru_policy>          factory { env, heap               };
+	Genode::Attached_rom_dataspace config { env, "config" };
+
+	unsigned _configured_a1_percent()
+	{
+		unsigned const percent = config.xml().attribute_value("a1_percent", 25U);
+		if (percent <= 100)
+			return percent;
+
+		Genode::warning("invalid a1_percent ", percent, ", using 25");
+		return 25;
+	}
+
+	Lru_policy       lru       { };
+	Two_queue_policy two_queue { _configured_a1_percent() };
+
+	Factory<Cache_policy>        factory { env, heap,
+		config.xml().attribute_value("write_batch", 16U) };
 	Block::Root                  root    { env.ep(), heap, env.rm(), factory, true };
 	Genode::Signal_handler<Main> resource_dispatcher {
 		env.ep(), *this, &Main::resource_handler };
 
+	Cache::Replacement_policy &_configured_policy()
+	{
+		typedef Genode::String<8> Name;
+		Name const name = config.xml().attribute_value("policy", Name("lru"));
+
+		if (name == "2q")
+			return two_queue;
+
+		if (name != "lru")
+			Genode::warning("unknown replacement policy '", name, "', using lru");
+
+		return lru;
+	}
+
 	Main(Genode::Env &env) : env(env)
 	{
+		Cache_policy::select(_configured_policy());
+		Genode::log("using ", Cache_policy::policy().name(), " replacement policy");
+
 		env.parent().announce(env.ep().manage(root));
 		env.parent().resource_avail_sigh(resource_dispatcher);
 	}
@@ -0,0 +1,28 @@
+/*
+ * \brief  Selection of the cache replacement strategy
+ * \author Stefan Kalkowski
+ * \date   2019-03-04
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#include "lru.h"
+
+static Cache::Replacement_policy *selected_policy = nullptr;
+
+
+Cache::Replacement_policy &Cache_policy::policy()
+{
+	static Lru_policy default_policy;
+
+	return selected_policy ? *selected_policy : default_policy;
+}
+
+
+void Cache_policy::select(Cache::Replacement_policy &policy) {
+	selected_policy = &policy; }
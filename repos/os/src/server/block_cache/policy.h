@@ -0,0 +1,207 @@
+/*
+ * \brief  Interface of cache replacement strategies
+ * \author Stefan Kalkowski
+ * \date   2013-12-05
+ */
+
+/*
+ * Copyright (C) 2013-2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _POLICY_H_
+#define _POLICY_H_
+
+/* Genode includes */
+#include <util/interface.h>
+#include <util/noncopyable.h>
+
+#include "chunk.h"
+
+namespace Cache {
+
+	class Replacement_policy;
+}
+
+
+/**
+ * Replacement strategy used to select cache chunks for eviction
+ *
+ * All operations of a policy are O(1). The elements are kept in intrusive
+ * doubly-linked queues, which are ordered from the next eviction candidate
+ * (head) to the most recently used element (tail).
+ */
+class Cache::Replacement_policy : Genode::Interface
+{
+	public:
+
+		class Queue;
+
+		class Element : Genode::Noncopyable
+		{
+			private:
+
+				friend class Queue;
+				friend class Replacement_policy;
+
+				/*
+				 * The members are mutable because chunks propagate read
+				 * accesses via const pointers.
+				 */
+				mutable Element       *_prev  { nullptr };
+				mutable Element       *_next  { nullptr };
+				mutable Queue         *_queue { nullptr };
+				mutable unsigned long  _epoch { 0 };
+
+			public:
+
+				Element() { }
+
+				~Element() { if (_queue) _queue->remove(*this); }
+
+				/**
+				 * Return queue the element is currently enqueued in
+				 */
+				Queue *queue() const { return _queue; }
+		};
+
+		class Queue : Genode::Noncopyable
+		{
+			private:
+
+				Element       *_head  { nullptr };
+				Element       *_tail  { nullptr };
+				unsigned long  _count { 0 };
+
+			public:
+
+				void enqueue(Element const &e)
+				{
+					if (e._queue) e._queue->remove(e);
+
+					e._prev  = _tail;
+					e._next  = nullptr;
+					e._queue = this;
+
+					if (_tail) _tail->_next = const_cast<Element *>(&e);
+					else       _head        = const_cast<Element *>(&e);
+
+					_tail = const_cast<Element *>(&e);
+					_count++;
+				}
+
+				void remove(Element const &e)
+				{
+					if (e._queue != this) return;
+
+					if (e._prev) e._prev->_next = e._next;
+					else         _head          = e._next;
+
+					if (e._next) e._next->_prev = e._prev;
+					else         _tail          = e._prev;
+
+					e._prev = e._next = nullptr;
+					e._queue = nullptr;
+					_count--;
+				}
+
+				Element *head() const { return _head; }
+
+				static Element *next(Element const &e) { return e._next; }
+
+				unsigned long count() const { return _count; }
+		};
+
+		/**
+		 * Age of the request currently processed by the cache
+		 *
+		 * Accesses of the same epoch (e.g., populating a chunk from the
+		 * backend device followed by copying it to the client) are
+		 * accounted as a single reference. The driver advances the epoch
+		 * only for client requests that do not continue at the chunk where
+		 * the previous request ended.
+		 */
+		static unsigned long &current_epoch()
+		{
+			static unsigned long epoch = 0;
+			return epoch;
+		}
+
+		static bool same_epoch(Element const &e) {
+			return e._epoch == current_epoch(); }
+
+		static void update_epoch(Element const &e) {
+			e._epoch = current_epoch(); }
+
+		/**
+		 * Account a read or write access to element 'e'
+		 *
+		 * Elements not yet known to the policy get inserted.
+		 */
+		virtual void access(Element const &e) = 0;
+
+		/**
+		 * Return first element to evict, or nullptr if the policy is empty
+		 */
+		virtual Element *first_victim() = 0;
+
+		/**
+		 * Return eviction candidate that follows 'e'
+		 *
+		 * The iteration order is determined at the time of calling
+		 * 'first_victim'. The returned element stays valid if 'e' gets
+		 * destructed after calling this function.
+		 */
+		virtual Element *next_victim(Element const &e) = 0;
+
+		/**
+		 * Return number of elements managed by the policy
+		 */
+		virtual unsigned long count() const = 0;
+
+		virtual char const *name() const = 0;
+};
+
+
+/**
+ * Adapter of the selected replacement policy to the chunk structure
+ *
+ * The chunk structure expects the policy as static interface. The actual
+ * strategy is selected once at startup via 'Cache_policy::select'.
+ */
+struct Cache_policy
+{
+	typedef Cache::Replacement_policy::Element Element;
+
+	static Cache::Replacement_policy &policy();
+
+	static void select(Cache::Replacement_policy &policy);
+
+	/**
+	 * Mark begin of a new, uncorrelated client request
+	 */
+	static void next_epoch() { Cache::Replacement_policy::current_epoch()++; }
+
+	static unsigned long epoch() { return Cache::Replacement_policy::current_epoch(); }
+
+	/**
+	 * Account subsequent accesses to the given epoch
+	 *
+	 * Used for completing a request in the epoch it was issued in.
+	 */
+	static void epoch(unsigned long e) { Cache::Replacement_policy::current_epoch() = e; }
+
+	static void read(const Element  *e) { policy().access(*e); }
+	static void write(const Element *e) { policy().access(*e); }
+
+	/**
+	 * Evict at least 'size' bytes of clean chunks from the cache
+	 *
+	 * If 'size' is zero, all clean chunks get evicted.
+	 */
+	static void flush(Cache::size_t size = 0);
+};
+
+#endif /* _POLICY_H_ */
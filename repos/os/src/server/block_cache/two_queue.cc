@@ -0,0 +1,60 @@
+/*
+ * \brief  Scan-resistant 2Q cache replacement strategy
+ * \author Stefan Kalkowski
+ * \date   2019-03-04
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#include "two_queue.h"
+
+
+void Two_queue_policy::access(Element const &e)
+{
+	Queue * const q = e.queue();
+
+	/* hit in 'Am', move element to the most-recently used end */
+	if (q == &_am) {
+		if (Queue::next(e))
+			_am.enqueue(e);
+		return;
+	}
+
+	/* repeated reference by another request promotes the element */
+	if (q == &_a1) {
+		if (!same_epoch(e))
+			_am.enqueue(e);
+		return;
+	}
+
+	/* first reference */
+	update_epoch(e);
+	_a1.enqueue(e);
+}
+
+
+Cache::Replacement_policy::Element *Two_queue_policy::first_victim()
+{
+	_first = (_a1_exceeded() || !_am.count()) ? &_a1 : &_am;
+
+	return _first->head() ? _first->head() : _other(*_first).head();
+}
+
+
+Cache::Replacement_policy::Element *
+Two_queue_policy::next_victim(Element const &e)
+{
+	if (Queue::next(e))
+		return Queue::next(e);
+
+	/* continue with the other queue after reaching the end of the first */
+	if (e.queue() == _first)
+		return _other(*_first).head();
+
+	return nullptr;
+}
@@ -0,0 +1,72 @@
+/*
+ * \brief  Scan-resistant 2Q cache replacement strategy
+ * \author Stefan Kalkowski
+ * \date   2019-03-04
+ *
+ * The strategy follows the simplified 2Q algorithm by Johnson and Shasha.
+ * Chunks referenced by a single request only enter the 'A1' FIFO. They get
+ * promoted to the 'Am' LRU queue not until they are referenced by another
+ * request. Hence, a sequential scan passes through 'A1' only and leaves the
+ * hot chunks in 'Am' untouched.
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _TWO_QUEUE_H_
+#define _TWO_QUEUE_H_
+
+#include "policy.h"
+
+class Two_queue_policy : public Cache::Replacement_policy
+{
+	private:
+
+		Queue _a1 { };  /* chunks referenced once, FIFO order */
+		Queue _am { };  /* chunks referenced repeatedly, LRU order */
+
+		unsigned const _a1_percent;
+
+		/* queue evicted first by the current victim iteration */
+		Queue *_first { &_a1 };
+
+		Queue &_other(Queue const &q) { return (&q == &_a1) ? _am : _a1; }
+
+		/**
+		 * Return true if 'A1' exceeds its share of the cache
+		 */
+		bool _a1_exceeded() const {
+			return _a1.count()*100 > count()*_a1_percent; }
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param a1_percent  share of the cache in percent used for chunks
+		 *                    that got referenced only once
+		 */
+		Two_queue_policy(unsigned a1_percent) : _a1_percent(a1_percent) { }
+
+
+		/****************************************
+		 ** Cache::Replacement_policy interface **
+		 ****************************************/
+
+		void access(Element const &e) override;
+
+		Element *first_victim() override;
+
+		Element *next_victim(Element const &e) override;
+
+		unsigned long count() const override {
+			return _a1.count() + _am.count(); }
+
+		char const *name() const override { return "2q"; }
+};
+
+#endif /* _TWO_QUEUE_H_ */
@@ -15,6 +15,7 @@
 #include <net/tcp.h>
 #include <net/udp.h>
 #include <net/icmp.h>
+#include <net/internet_checksum.h>
 #include <net/arp.h>
 #include <base/quota_guard.h>
 
@@ -134,31 +135,6 @@ static void _link_packet(L3_protocol  const  prot,
 }
 
 
-static void _update_checksum(L3_protocol   const prot,
-                             void         *const prot_base,
-                             size_t        const prot_size,
-                             Ipv4_address  const src,
-                             Ipv4_address  const dst,
-                             size_t        const ip_size)
-{
-	switch (prot) {
-	case L3_protocol::TCP:
-		((Tcp_packet *)prot_base)->update_checksum(src, dst, prot_size);
-		return;
-	case L3_protocol::UDP:
-		((Udp_packet *)prot_base)->update_checksum(src, dst);
-		return;
-	case L3_protocol::ICMP:
-		{
-			Icmp_packet &icmp = *(Icmp_packet *)prot_base;
-			icmp.update_checksum(ip_size - sizeof(Ipv4_packet) -
-			                               sizeof(Icmp_packet));
-			return;
-		}
-	default: throw Interface::Bad_transport_protocol(); }
-}
-
-
 static Port _dst_port(L3_protocol const prot, void *const prot_base)
 {
 	switch (prot) {
@@ -203,6 +179,49 @@ static void _src_port(L3_protocol  const prot,
 }
 
 
+static void _add_up_port_diff(Internet_checksum_diff &diff,
+                              Port              const new_port,
+                              Port              const old_port)
+{
+	Genode::uint16_t const new_be = host_to_big_endian(new_port.value);
+	Genode::uint16_t const old_be = host_to_big_endian(old_port.value);
+	diff.add_up_diff(&new_be, &old_be, sizeof(new_be));
+}
+
+
+/**
+ * Update IP and transport checksums after rewriting addresses and ports
+ *
+ * Instead of re-computing the checksums over the whole packet, only the
+ * difference to the original identity of the packet is applied to the
+ * checksums (RFC 1624).
+ */
+static void _update_checksums(Link_side_id const &old_id,
+                              Ipv4_packet        &ip,
+                              L3_protocol  const  prot,
+                              void        *const  prot_base)
+{
+	Internet_checksum_diff ip_diff;
+	ip_diff.add_up_diff(ip.src().addr, old_id.src_ip.addr, Ipv4_packet::ADDR_LEN);
+	ip_diff.add_up_diff(ip.dst().addr, old_id.dst_ip.addr, Ipv4_packet::ADDR_LEN);
+
+	/* ICMP uses the query ID as port and has no pseudo header */
+	Internet_checksum_diff prot_diff;
+	_add_up_port_diff(prot_diff, _src_port(prot, prot_base), old_id.src_port);
+	if (prot != L3_protocol::ICMP) {
+		_add_up_port_diff(prot_diff, _dst_port(prot, prot_base), old_id.dst_port);
+		prot_diff.add_up_diff(ip_diff);
+	}
+	switch (prot) {
+	case L3_protocol::TCP:  ((Tcp_packet *)prot_base)->update_checksum(prot_diff);  break;
+	case L3_protocol::UDP:  ((Udp_packet *)prot_base)->update_checksum(prot_diff);  break;
+	case L3_protocol::ICMP: ((Icmp_packet *)prot_base)->update_checksum(prot_diff); break;
+	default: throw Interface::Bad_transport_protocol(); }
+
+	ip.update_checksum(ip_diff);
+}
+
+
 static void *_prot_base(L3_protocol const  prot,
                         Size_guard        &size_guard,
                         Ipv4_packet       &ip)
@@ -273,16 +292,11 @@ void Interface::_destroy_link(Link &link)
 }
 
 
-void Interface::_pass_prot(Ethernet_frame       &eth,
-                           Size_guard           &size_guard,
-                           Ipv4_packet          &ip,
-                           L3_protocol    const  prot,
-                           void          *const  prot_base,
-                           size_t         const  prot_size)
+void Interface::_pass_prot(Ethernet_frame &eth,
+                           Size_guard     &size_guard)
 {
 	eth.src(_router_mac);
-	_update_checksum(prot, prot_base, prot_size, ip.src(), ip.dst(), ip.total_length());
-	_pass_ip(eth, size_guard, ip);
+	send(eth, size_guard);
 }
 
 
@@ -444,7 +458,7 @@ Interface::_new_link(L3_protocol             const  protocol,
 		try {
 			new (_alloc)
 				Tcp_link { *this, local, remote_port_alloc, remote_domain,
-				           remote, _timer, _config(), protocol, _tcp_stats };
+				           remote, _link_timeouts, _config(), protocol, _tcp_stats };
 		}
 		catch (Out_of_ram)  { throw Free_resources_and_retry_handle_eth(L3_protocol::TCP); }
 		catch (Out_of_caps) { throw Free_resources_and_retry_handle_eth(L3_protocol::TCP); }
@@ -454,7 +468,7 @@ Interface::_new_link(L3_protocol             const  protocol,
 		try {
 			new (_alloc)
 				Udp_link { *this, local, remote_port_alloc, remote_domain,
-				           remote, _timer, _config(), protocol, _udp_stats };
+				           remote, _link_timeouts, _config(), protocol, _udp_stats };
 		}
 		catch (Out_of_ram)  { throw Free_resources_and_retry_handle_eth(L3_protocol::UDP); }
 		catch (Out_of_caps) { throw Free_resources_and_retry_handle_eth(L3_protocol::UDP); }
@@ -464,7 +478,7 @@ Interface::_new_link(L3_protocol             const  protocol,
 		try {
 			new (_alloc)
 				Icmp_link { *this, local, remote_port_alloc, remote_domain,
-				            remote, _timer, _config(), protocol, _icmp_stats };
+				            remote, _link_timeouts, _config(), protocol, _icmp_stats };
 		}
 		catch (Out_of_ram)  { throw Free_resources_and_retry_handle_eth(L3_protocol::ICMP); }
 		catch (Out_of_caps) { throw Free_resources_and_retry_handle_eth(L3_protocol::ICMP); }
@@ -530,7 +544,6 @@ void Interface::_nat_link_and_pass(Ethernet_frame        &eth,
                                    Ipv4_packet           &ip,
                                    L3_protocol     const  prot,
                                    void           *const  prot_base,
-                                   size_t          const  prot_size,
                                    Link_side_id    const &local_id,
                                    Domain                &local_domain,
                                    Domain                &remote_domain)
@@ -550,8 +563,9 @@ void Interface::_nat_link_and_pass(Ethernet_frame        &eth,
 		Link_side_id const remote_id = { ip.dst(), _dst_port(prot, prot_base),
 		                                 ip.src(), _src_port(prot, prot_base) };
 		_new_link(prot, local_id, remote_port_alloc, remote_domain, remote_id);
+		_update_checksums(local_id, ip, prot, prot_base);
 		remote_domain.interfaces().for_each([&] (Interface &interface) {
-			interface._pass_prot(eth, size_guard, ip, prot, prot_base, prot_size);
+			interface._pass_prot(eth, size_guard);
 		});
 	} catch (Port_allocator_guard::Out_of_indices) {
 		switch (prot) {
@@ -906,7 +920,6 @@ void Interface::_handle_icmp_query(Ethernet_frame          &eth,
                                    Packet_descriptor const &pkt,
                                    L3_protocol              prot,
                                    void                    *prot_base,
-                                   size_t                   prot_size,
                                    Domain                  &local_domain)
 {
 	Link_side_id const local_id = { ip.src(), _src_port(prot, prot_base),
@@ -928,14 +941,15 @@ void Interface::_handle_icmp_query(Ethernet_frame          &eth,
 		ip.dst(remote_side.src_ip());
 		_src_port(prot, prot_base, remote_side.dst_port());
 		_dst_port(prot, prot_base, remote_side.src_port());
+		_update_checksums(local_id, ip, prot, prot_base);
 
 		remote_domain.interfaces().for_each([&] (Interface &interface) {
-			interface._pass_prot(eth, size_guard, ip, prot, prot_base, prot_size);
+			interface._pass_prot(eth, size_guard);
 		});
 		_link_packet(prot, prot_base, link, client);
 		return;
 	}
-	catch (Link_side_tree::No_match) { }
+	catch (Link_side_table::No_match) { }
 
 	/* try to route via ICMP rules */
 	try {
@@ -947,8 +961,8 @@ void Interface::_handle_icmp_query(Ethernet_frame          &eth,
 
 		Domain &remote_domain = rule.domain();
 		_adapt_eth(eth, local_id.dst_ip, pkt, remote_domain);
-		_nat_link_and_pass(eth, size_guard, ip, prot, prot_base, prot_size,
-		                   local_id, local_domain, remote_domain);
+		_nat_link_and_pass(eth, size_guard, ip, prot, prot_base, local_id,
+		                   local_domain, remote_domain);
 
 		return;
 	}
@@ -1016,7 +1030,7 @@ void Interface::_handle_icmp_error(Ethernet_frame          &eth,
 			_link_packet(embed_prot, embed_prot_base, link, client); }
 	}
 	/* drop packet if there is no matching link */
-	catch (Link_side_tree::No_match) {
+	catch (Link_side_table::No_match) {
 		throw Drop_packet("no link that matches packet embedded in ICMP error"); }
 }
 
@@ -1050,7 +1064,7 @@ void Interface::_handle_icmp(Ethernet_frame            &eth,
 	/* try to act as ICMP router */
 	switch (icmp.type()) {
 	case Icmp_packet::Type::ECHO_REPLY:
-	case Icmp_packet::Type::ECHO_REQUEST:    _handle_icmp_query(eth, size_guard, ip, pkt, prot, prot_base, prot_size, local_domain); break;
+	case Icmp_packet::Type::ECHO_REQUEST:    _handle_icmp_query(eth, size_guard, ip, pkt, prot, prot_base, local_domain); break;
 	case Icmp_packet::Type::DST_UNREACHABLE: _handle_icmp_error(eth, size_guard, ip, pkt, local_domain, icmp, prot_size); break;
 	default: Drop_packet("unhandled type in ICMP"); }
 }
@@ -1128,14 +1142,15 @@ void Interface::_handle_ip(Ethernet_frame          &eth,
 			ip.dst(remote_side.src_ip());
 			_src_port(prot, prot_base, remote_side.dst_port());
 			_dst_port(prot, prot_base, remote_side.src_port());
+			_update_checksums(local_id, ip, prot, prot_base);
 
 			remote_domain.interfaces().for_each([&] (Interface &interface) {
-				interface._pass_prot(eth, size_guard, ip, prot, prot_base, prot_size);
+				interface._pass_prot(eth, size_guard);
 			});
 			_link_packet(prot, prot_base, link, client);
 			return;
 		}
-		catch (Link_side_tree::No_match) { }
+		catch (Link_side_table::No_match) { }
 
 		/* try to route via forward rules */
 		if (local_id.dst_ip == local_intf.address) {
@@ -1154,7 +1169,7 @@ void Interface::_handle_ip(Ethernet_frame          &eth,
 					_dst_port(prot, prot_base, rule.to_port());
 				}
 				_nat_link_and_pass(eth, size_guard, ip, prot, prot_base,
-				                   prot_size, local_id, local_domain, remote_domain);
+				                   local_id, local_domain, remote_domain);
 				return;
 			}
 			catch (Forward_rule_tree::No_match) { }
@@ -1173,8 +1188,8 @@ void Interface::_handle_ip(Ethernet_frame          &eth,
 			}
 			Domain &remote_domain = permit_rule.domain();
 			_adapt_eth(eth, local_id.dst_ip, pkt, remote_domain);
-			_nat_link_and_pass(eth, size_guard, ip, prot, prot_base, prot_size,
-			                   local_id, local_domain, remote_domain);
+			_nat_link_and_pass(eth, size_guard, ip, prot, prot_base, local_id,
+			                   local_domain, remote_domain);
 			return;
 		}
 		catch (Transport_rule_list::No_match) { }
@@ -39,9 +39,15 @@ bool Link_side_id::operator == (Link_side_id const &id) const
 }
 
 
-bool Link_side_id::operator > (Link_side_id const &id) const
+uint32_t Link_side_id::hash() const
 {
-	return memcmp(id.data_base(), data_base(), data_size()) > 0;
+	/* FNV-1a */
+	uint32_t       hash = 2166136261U;
+	uint8_t const *byte = (uint8_t const *)data_base();
+	for (size_t i = 0; i < data_size(); i++) {
+		hash = (hash ^ byte[i]) * 16777619U; }
+
+	return hash;
 }
 
 
@@ -53,7 +59,7 @@ Link_side::Link_side(Domain             &domain,
                      Link_side_id const &id,
                      Link               &link)
 :
-	_domain(domain), _id(id), _link(link)
+	_domain(domain), _id(id), _hash(id.hash()), _link(link)
 {
 	if (link.config().verbose()) {
 		log("[", domain, "] new ", l3_protocol_name(link.protocol()),
@@ -62,44 +68,97 @@ Link_side::Link_side(Domain             &domain,
 }
 
 
-Link_side const &Link_side::find_by_id(Link_side_id const &id) const
+void Link_side::print(Output &output) const
 {
-	if (id == _id) {
-		return *this; }
+	Genode::print(output, "src ", src_ip(), ":", src_port(),
+	                     " dst ", dst_ip(), ":", dst_port());
+}
 
-	bool const side = id > _id;
-	Link_side *const link_side = Avl_node<Link_side>::child(side);
-	if (!link_side) {
-		throw Link_side_tree::No_match(); }
 
-	return link_side->find_by_id(id);
+bool Link_side::is_client() const
+{
+	return this == &_link.client();
 }
 
 
-void Link_side::print(Output &output) const
+/*********************
+ ** Link_side_table **
+ *********************/
+
+Link_side_table::~Link_side_table()
 {
-	Genode::print(output, "src ", src_ip(), ":", src_port(),
-	                     " dst ", dst_ip(), ":", dst_port());
+	if (_buckets != _initial_buckets) {
+		_alloc.free(_buckets, _num_buckets * sizeof(Link_side *)); }
 }
 
 
-bool Link_side::is_client() const
+void Link_side_table::_grow()
 {
-	return this == &_link.client();
+	size_t const num_buckets = _num_buckets << 1;
+	Link_side **buckets = nullptr;
+	try {
+		if (!_alloc.alloc(num_buckets * sizeof(Link_side *), &buckets)) {
+			return; }
+	}
+	catch (Out_of_ram)  { return; }
+	catch (Out_of_caps) { return; }
+
+	for (size_t i = 0; i < num_buckets; i++) {
+		buckets[i] = nullptr; }
+
+	/* re-hash all link sides into the new bucket array */
+	for (size_t i = 0; i < _num_buckets; i++) {
+		while (Link_side *side = _buckets[i]) {
+			_buckets[i] = side->_next_in_bucket;
+			Link_side *&bucket = buckets[side->_hash & (num_buckets - 1)];
+			side->_next_in_bucket = bucket;
+			bucket = side;
+		}
+	}
+	if (_buckets != _initial_buckets) {
+		_alloc.free(_buckets, _num_buckets * sizeof(Link_side *)); }
+
+	_buckets     = buckets;
+	_num_buckets = num_buckets;
 }
 
 
-/********************
- ** Link_side_tree **
- ********************/
+void Link_side_table::insert(Link_side *side)
+{
+	if (_count >= _num_buckets * MAX_CHAIN_LENGTH) {
+		_grow(); }
+
+	Link_side *&bucket = _bucket(side->_hash);
+	side->_next_in_bucket = bucket;
+	bucket = side;
+	_count++;
+}
+
 
-Link_side const &Link_side_tree::find_by_id(Link_side_id const &id) const
+void Link_side_table::remove(Link_side *side)
 {
-	Link_side *const link_side = first();
-	if (!link_side) {
-		throw No_match(); }
+	for (Link_side **curr = &_bucket(side->_hash); *curr;
+	     curr = &(*curr)->_next_in_bucket)
+	{
+		if (*curr != side) {
+			continue; }
+
+		*curr = side->_next_in_bucket;
+		side->_next_in_bucket = nullptr;
+		_count--;
+		return;
+	}
+}
 
-	return link_side->find_by_id(id);
+
+Link_side const &Link_side_table::find_by_id(Link_side_id const &id) const
+{
+	uint32_t const hash = id.hash();
+	for (Link_side *side = _bucket(hash); side; side = side->_next_in_bucket) {
+		if (side->_hash == hash && side->_id == id) {
+			return *side; }
+	}
+	throw No_match();
 }
 
 
@@ -118,7 +177,7 @@ Link::Link(Interface                     &cln_interface,
            Pointer<Port_allocator_guard>  srv_port_alloc,
            Domain                        &srv_domain,
            Link_side_id            const &srv_id,
-           Timer::Connection             &timer,
+           Timeout_wheel                 &timeouts,
            Configuration                 &config,
            L3_protocol             const  protocol,
            Microseconds            const  dissolve_timeout,
@@ -127,7 +186,7 @@ Link::Link(Interface                     &cln_interface,
 	_config(config),
 	_client_interface(cln_interface),
 	_server_port_alloc(srv_port_alloc),
-	_dissolve_timeout(timer, *this, &Link::_handle_dissolve_timeout),
+	_dissolve_timeout(timeouts, *this, &Link::_handle_dissolve_timeout),
 	_dissolve_timeout_us(dissolve_timeout),
 	_protocol(protocol),
 	_client(cln_interface.domain(), cln_id, *this),
@@ -228,12 +287,12 @@ Tcp_link::Tcp_link(Interface                     &cln_interface,
                    Pointer<Port_allocator_guard>  srv_port_alloc,
                    Domain                        &srv_domain,
                    Link_side_id            const &srv_id,
-                   Timer::Connection             &timer,
+                   Timeout_wheel                 &timeouts,
                    Configuration                 &config,
                    L3_protocol             const  protocol,
                    Interface_link_stats          &stats)
 :
-	Link(cln_interface, cln_id, srv_port_alloc, srv_domain, srv_id, timer,
+	Link(cln_interface, cln_id, srv_port_alloc, srv_domain, srv_id, timeouts,
 	     config, protocol, config.tcp_idle_timeout(), stats)
 { }
 
@@ -309,12 +368,12 @@ Udp_link::Udp_link(Interface                     &cln_interface,
                    Pointer<Port_allocator_guard>  srv_port_alloc,
                    Domain                        &srv_domain,
                    Link_side_id            const &srv_id,
-                   Timer::Connection             &timer,
+                   Timeout_wheel                 &timeouts,
                    Configuration                 &config,
                    L3_protocol             const  protocol,
                    Interface_link_stats          &stats)
 :
-	Link(cln_interface, cln_id, srv_port_alloc, srv_domain, srv_id, timer,
+	Link(cln_interface, cln_id, srv_port_alloc, srv_domain, srv_id, timeouts,
 	     config, protocol, config.udp_idle_timeout(), stats)
 { }
 
@@ -340,12 +399,12 @@ Icmp_link::Icmp_link(Interface                     &cln_interface,
                      Pointer<Port_allocator_guard>  srv_port_alloc,
                      Domain                        &srv_domain,
                      Link_side_id            const &srv_id,
-                     Timer::Connection             &timer,
+                     Timeout_wheel                 &timeouts,
                      Configuration                 &config,
                      L3_protocol             const  protocol,
                      Interface_link_stats          &stats)
 :
-	Link(cln_interface, cln_id, srv_port_alloc, srv_domain, srv_id, timer,
+	Link(cln_interface, cln_id, srv_port_alloc, srv_domain, srv_id, timeouts,
 	     config, protocol, config.icmp_idle_timeout(), stats)
 { }
 
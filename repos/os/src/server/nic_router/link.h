@@ -31,9 +31,7 @@
 #define _LINK_H_
 
 /* Genode includes */
-#include <timer_session/connection.h>
-#include <util/avl_tree.h>
-#include <util/list.h>
+#include <base/allocator.h>
 #include <net/ipv4.h>
 #include <net/port.h>
 
@@ -42,6 +40,7 @@
 #include <reference.h>
 #include <pointer.h>
 #include <l3_protocol.h>
+#include <timeout_wheel.h>
 
 namespace Net {
 
@@ -53,9 +52,9 @@ namespace Net {
 	class  Interface;
 	class  Link_side_id;
 	class  Link_side;
-	class  Link_side_tree;
+	class  Link_side_table;
 	class  Link;
-	struct Link_list : List<Link> { };
+	struct Link_list : Doubly_linked_list<Link> { };
 	class  Tcp_link;
 	class  Udp_link;
 	class  Icmp_link;
@@ -73,27 +72,30 @@ struct Net::Link_side_id
 
 	void *data_base() const { return (void *)&src_ip; }
 
+	Genode::uint32_t hash() const;
+
 
 	/************************
 	 ** Standard operators **
 	 ************************/
 
 	bool operator == (Link_side_id const &id) const;
-
-	bool operator > (Link_side_id const &id) const;
 }
 __attribute__((__packed__));
 
 
-class Net::Link_side : public Genode::Avl_node<Link_side>
+class Net::Link_side
 {
 	friend class Link;
+	friend class Link_side_table;
 
 	private:
 
-		Reference<Domain>   _domain;
-		Link_side_id const  _id;
-		Link               &_link;
+		Reference<Domain>       _domain;
+		Link_side_id     const  _id;
+		Genode::uint32_t const  _hash;
+		Link                   &_link;
+		Link_side              *_next_in_bucket { nullptr };
 
 	public:
 
@@ -101,18 +103,9 @@ class Net::Link_side : public Genode::Avl_node<Link_side>
 		          Link_side_id const &id,
 		          Link               &link);
 
-		Link_side const &find_by_id(Link_side_id const &id) const;
-
 		bool is_client() const;
 
 
-		/**************
-		 ** Avl_node **
-		 **************/
-
-		bool higher(Link_side *side) { return side->_id > _id; }
-
-
 		/*********
 		 ** Log **
 		 *********/
@@ -133,11 +126,52 @@ class Net::Link_side : public Genode::Avl_node<Link_side>
 };
 
 
-struct Net::Link_side_tree : Genode::Avl_tree<Link_side>
+/**
+ * Hash table of the link sides of a domain, keyed by the link-side ID
+ *
+ * The table starts with a small bucket array embedded in the object and
+ * doubles the number of buckets whenever the average chain length exceeds
+ * two. If the allocation of a bigger bucket array fails, the table keeps
+ * working with longer chains.
+ */
+class Net::Link_side_table
 {
-	struct No_match : Genode::Exception { };
+	public:
+
+		struct No_match : Genode::Exception { };
+
+	private:
 
-	Link_side const &find_by_id(Link_side_id const &id) const;
+		enum { INITIAL_NUM_BUCKETS = 64, MAX_CHAIN_LENGTH = 2 };
+
+		Genode::Allocator  &_alloc;
+		Link_side          *_initial_buckets[INITIAL_NUM_BUCKETS] { };
+		Link_side         **_buckets     { _initial_buckets };
+		Genode::size_t      _num_buckets { INITIAL_NUM_BUCKETS };
+		Genode::size_t      _count       { 0 };
+
+		/*
+		 * Noncopyable
+		 */
+		Link_side_table(Link_side_table const &);
+		Link_side_table &operator = (Link_side_table const &);
+
+		Link_side *&_bucket(Genode::uint32_t hash) const {
+			return _buckets[hash & (_num_buckets - 1)]; }
+
+		void _grow();
+
+	public:
+
+		Link_side_table(Genode::Allocator &alloc) : _alloc(alloc) { }
+
+		~Link_side_table();
+
+		void insert(Link_side *side);
+
+		void remove(Link_side *side);
+
+		Link_side const &find_by_id(Link_side_id const &id) const;
 };
 
 
@@ -148,7 +182,7 @@ class Net::Link : public Link_list::Element
 		Reference<Configuration>       _config;
 		Interface                     &_client_interface;
 		Pointer<Port_allocator_guard>  _server_port_alloc;
-		Timer::One_shot_timeout<Link>  _dissolve_timeout;
+		Wheel_timeout<Link>            _dissolve_timeout;
 		Genode::Microseconds           _dissolve_timeout_us;
 		L3_protocol             const  _protocol;
 		Link_side                      _client;
@@ -170,7 +204,7 @@ class Net::Link : public Link_list::Element
 		     Pointer<Port_allocator_guard>        srv_port_alloc,
 		     Domain                              &srv_domain,
 		     Link_side_id                  const &srv_id,
-		     Timer::Connection                   &timer,
+		     Timeout_wheel                       &timeouts,
 		     Configuration                       &config,
 		     L3_protocol                   const  protocol,
 		     Genode::Microseconds          const  dissolve_timeout,
@@ -234,7 +268,7 @@ class Net::Tcp_link : public Link
 		         Pointer<Port_allocator_guard>  srv_port_alloc,
 		         Domain                        &srv_domain,
 		         Link_side_id            const &srv_id,
-		         Timer::Connection             &timer,
+		         Timeout_wheel                 &timeouts,
 		         Configuration                 &config,
 		         L3_protocol             const  protocol,
 		         Interface_link_stats          &stats);
@@ -252,7 +286,7 @@ struct Net::Udp_link : Link
 	         Pointer<Port_allocator_guard>  srv_port_alloc,
 	         Domain                        &srv_domain,
 	         Link_side_id            const &srv_id,
-	         Timer::Connection             &timer,
+	         Timeout_wheel                 &timeouts,
 	         Configuration                 &config,
 	         L3_protocol             const  protocol,
 	         Interface_link_stats          &stats);
@@ -270,7 +304,7 @@ struct Net::Icmp_link : Link
 	          Pointer<Port_allocator_guard>  srv_port_alloc,
 	          Domain                        &srv_domain,
 	          Link_side_id            const &srv_id,
-	          Timer::Connection             &timer,
+	          Timeout_wheel                 &timeouts,
 	          Configuration                 &config,
 	          L3_protocol             const  protocol,
 	          Interface_link_stats          &stats);
@@ -18,7 +18,11 @@
 #include <util/list.h>
 #include <base/allocator.h>
 
-namespace Net { template <typename> class List; }
+namespace Net {
+
+	template <typename> class List;
+	template <typename> class Doubly_linked_list;
+}
 
 
 template <typename LT>
@@ -46,4 +50,74 @@ struct Net::List : Genode::List<LT>
 	}
 };
 
+
+/**
+ * List that supports the removal of arbitrary elements in constant time
+ */
+template <typename LT>
+class Net::Doubly_linked_list
+{
+	public:
+
+		class Element
+		{
+			friend class Doubly_linked_list;
+
+			private:
+
+				LT *_prev { nullptr };
+				LT *_next { nullptr };
+
+			public:
+
+				LT *next() const { return _next; }
+		};
+
+	private:
+
+		LT *_first { nullptr };
+
+		static Element &_elem(LT &lt) { return static_cast<Element &>(lt); }
+
+	public:
+
+		LT *first() const { return _first; }
+
+		/**
+		 * Insert element at the front of the list
+		 */
+		void insert(LT *lt)
+		{
+			_elem(*lt)._prev = nullptr;
+			_elem(*lt)._next = _first;
+			if (_first) {
+				_elem(*_first)._prev = lt; }
+
+			_first = lt;
+		}
+
+		void remove(LT *lt)
+		{
+			Element &elem = _elem(*lt);
+			if (elem._prev) { _elem(*elem._prev)._next = elem._next; }
+			else            { _first                   = elem._next; }
+
+			if (elem._next) { _elem(*elem._next)._prev = elem._prev; }
+
+			elem._prev = nullptr;
+			elem._next = nullptr;
+		}
+
+		template <typename FUNC>
+		void for_each(FUNC && functor)
+		{
+			for (LT *elem = _first; elem; )
+			{
+				LT *const next = _elem(*elem)._next;
+				functor(*elem);
+				elem = next;
+			}
+		}
+};
+
 #endif /* _LIST_H_ */
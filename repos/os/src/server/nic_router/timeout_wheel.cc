@@ -0,0 +1,113 @@
+/*
+ * \brief  Timing wheel for the idle timeouts of a large number of links
+ * \author Martin Stein
+ * \date   2019-03-11
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* local includes */
+#include <timeout_wheel.h>
+
+using namespace Net;
+using namespace Genode;
+
+
+static uint64_t tick_of(Duration duration, uint64_t tick_us)
+{
+	return duration.trunc_to_plain_us().value / tick_us;
+}
+
+
+Timeout_wheel::Timeout_wheel(Timer::Connection &timer)
+:
+	_timer(timer), _tick_timeout(timer, *this, &Timeout_wheel::_handle_tick)
+{ }
+
+
+void Timeout_wheel::_link(Timeout &timeout)
+{
+	/* a slot can't be visited more than one wheel revolution in advance */
+	timeout._slot_tick = min(timeout._deadline, _tick + NUM_SLOTS - 1);
+
+	Timeout *&head = _slot(timeout._slot_tick);
+	timeout._prev      = nullptr;
+	timeout._next      = head;
+	timeout._scheduled = true;
+	if (head) {
+		head->_prev = &timeout; }
+
+	head = &timeout;
+
+	if (!_count++ && !_tick_timeout.scheduled()) {
+		_tick_timeout.schedule(Microseconds(TICK_US)); }
+}
+
+
+void Timeout_wheel::_unlink(Timeout &timeout)
+{
+	if (!timeout._scheduled) {
+		return; }
+
+	if (timeout._prev) { timeout._prev->_next       = timeout._next; }
+	else               { _slot(timeout._slot_tick) = timeout._next; }
+
+	if (timeout._next) {
+		timeout._next->_prev = timeout._prev; }
+
+	timeout._prev      = nullptr;
+	timeout._next      = nullptr;
+	timeout._scheduled = false;
+	_count--;
+}
+
+
+void Timeout_wheel::_schedule(Timeout &timeout, Microseconds duration)
+{
+	/* if the wheel was idle, our notion of the current tick is outdated */
+	if (!_count) {
+		_tick = tick_of(_timer.curr_time(), TICK_US); }
+
+	uint64_t const ticks = (duration.value + TICK_US - 1) / TICK_US;
+	timeout._deadline = _tick + max(ticks, (uint64_t)1);
+
+	/*
+	 * If the current slot of the timeout is not due before the new deadline,
+	 * the timeout gets moved lazily when visiting the slot.
+	 */
+	if (timeout._scheduled && timeout._slot_tick <= timeout._deadline) {
+		return; }
+
+	_unlink(timeout);
+	_link(timeout);
+}
+
+
+void Timeout_wheel::_handle_tick(Duration curr_time)
+{
+	uint64_t const now = tick_of(curr_time, TICK_US);
+
+	/* visit each slot at most once even if we missed many ticks */
+	if (now > _tick + NUM_SLOTS) {
+		_tick = now - NUM_SLOTS; }
+
+	while (_tick < now) {
+		_tick++;
+		while (Timeout *timeout = _slot(_tick)) {
+
+			_unlink(*timeout);
+			if (timeout->_deadline > _tick) {
+				_link(*timeout);
+				continue;
+			}
+			timeout->_expired(curr_time);
+		}
+	}
+	if (_count) {
+		_tick_timeout.schedule(Microseconds(TICK_US)); }
+}
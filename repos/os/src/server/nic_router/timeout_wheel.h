@@ -0,0 +1,123 @@
+/*
+ * \brief  Timing wheel for the idle timeouts of a large number of links
+ * \author Martin Stein
+ * \date   2019-03-11
+ *
+ * Each link refreshes its idle timeout with every packet. Scheduling a
+ * 'Timer::One_shot_timeout' for each link would thus result in a sorted
+ * insertion into the alarm list of the timeout framework per packet. The
+ * timing wheel, in contrast, schedules timeouts with a coarse granularity in
+ * constant time and merely stores the new deadline if a timeout gets
+ * deferred. Deferred timeouts are moved to the right slot not until their
+ * current slot is due.
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _TIMEOUT_WHEEL_H_
+#define _TIMEOUT_WHEEL_H_
+
+/* Genode includes */
+#include <timer_session/connection.h>
+#include <util/noncopyable.h>
+
+namespace Net {
+
+	class Timeout_wheel;
+	template <typename> class Wheel_timeout;
+}
+
+
+class Net::Timeout_wheel : Genode::Noncopyable
+{
+	public:
+
+		class Timeout : Genode::Noncopyable
+		{
+			friend class Timeout_wheel;
+
+			private:
+
+				Timeout_wheel    &_wheel;
+				Timeout          *_prev      { nullptr };
+				Timeout          *_next      { nullptr };
+				bool              _scheduled { false };
+				Genode::uint64_t  _deadline  { 0 };  /* tick of expiration */
+				Genode::uint64_t  _slot_tick { 0 };  /* tick of slot visit */
+
+			protected:
+
+				virtual void _expired(Genode::Duration curr_time) = 0;
+
+			public:
+
+				Timeout(Timeout_wheel &wheel) : _wheel(wheel) { }
+
+				virtual ~Timeout() { discard(); }
+
+				void schedule(Genode::Microseconds duration) {
+					_wheel._schedule(*this, duration); }
+
+				void discard() { _wheel._unlink(*this); }
+
+				bool scheduled() const { return _scheduled; }
+		};
+
+	private:
+
+		enum { TICK_US = 100 * 1000, NUM_SLOTS = 512 };
+
+		Timer::Connection                      &_timer;
+		Timer::One_shot_timeout<Timeout_wheel>  _tick_timeout;
+		Timeout                                *_slots[NUM_SLOTS] { };
+		Genode::uint64_t                        _tick  { 0 };  /* last visited tick */
+		unsigned long                           _count { 0 };
+
+		Timeout *&_slot(Genode::uint64_t tick) { return _slots[tick % NUM_SLOTS]; }
+
+		void _link(Timeout &timeout);
+
+		void _unlink(Timeout &timeout);
+
+		void _schedule(Timeout &timeout, Genode::Microseconds duration);
+
+		void _handle_tick(Genode::Duration curr_time);
+
+	public:
+
+		Timeout_wheel(Timer::Connection &timer);
+};
+
+
+/**
+ * Wheel timeout that is linked to a custom handler
+ */
+template <typename HANDLER>
+class Net::Wheel_timeout : public Timeout_wheel::Timeout
+{
+	private:
+
+		typedef void (HANDLER::*Handler_method)(Genode::Duration);
+
+		HANDLER              &_object;
+		Handler_method const  _method;
+
+		void _expired(Genode::Duration curr_time) override {
+			(_object.*_method)(curr_time); }
+
+	public:
+
+		Wheel_timeout(Timeout_wheel  &wheel,
+		              HANDLER        &object,
+		              Handler_method  method)
+		:
+			Timeout(wheel), _object(object), _method(method)
+		{ }
+};
+
+#endif /* _TIMEOUT_WHEEL_H_ */
@@ -57,6 +57,8 @@ struct Nitpicker::Background : private Texture_base, View_component
 
 		canvas.draw_box(view_rect, color);
 	}
+
+	Rect opaque_area() const override { return abs_geometry(); }
 };
 
 #endif /* _BACKGROUND_H_ */
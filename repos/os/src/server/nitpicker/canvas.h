@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2013-2017 Genode Labs GmbH
+ * Copyright (C) 2013-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -17,6 +17,7 @@
 #include <nitpicker_gfx/box_painter.h>
 #include <nitpicker_gfx/text_painter.h>
 #include <nitpicker_gfx/texture_painter.h>
+#include <base/lock.h>
 
 /* local includes */
 #include "types.h"
@@ -97,6 +98,13 @@ class Nitpicker::Canvas : public Canvas_base, public Surface_base::Flusher
 		void draw_text(Point pos, Font const &font,
 		               Color color, char const *string) override
 		{
+			/*
+			 * The font renders glyphs into a buffer shared by the canvases
+			 * of all compositor threads.
+			 */
+			static Lock lock;
+			Lock::Guard guard(lock);
+
 			Text_painter::paint(_surface, Text_painter::Position(pos.x(), pos.y()),
 			                    font, color, string);
 		}
@@ -0,0 +1,307 @@
+/*
+ * \brief  Tile-based compositing on a pool of worker threads
+ * \author Norman Feske
+ * \date   2019-03-22
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _COMPOSITOR_H_
+#define _COMPOSITOR_H_
+
+/* Genode includes */
+#include <util/noncopyable.h>
+#include <base/thread.h>
+#include <base/semaphore.h>
+#include <base/lock.h>
+#include <trace/timestamp.h>
+
+/* local includes */
+#include "canvas.h"
+#include "view_component.h"
+
+namespace Nitpicker { class Compositor; }
+
+
+/**
+ * Compositor that splits the dirty area of the screen into tiles
+ *
+ * The tiles are aligned to a grid of 'tile_size' pixels. They are drawn
+ * by the entrypoint and the configured number of worker threads in parallel.
+ * Each thread draws via its own canvas because a canvas holds the clipping
+ * state. Since tiles never overlap, the threads access disjoint pixels of
+ * the screen.
+ *
+ * The drawing of a frame is accounted in CPU-specific timestamp units. If
+ * the 'statistics' interval is configured, the compositor logs the frame
+ * timing every 'statistics' frames.
+ */
+class Nitpicker::Compositor : Noncopyable
+{
+	public:
+
+		enum { MAX_WORKERS = 16, DEFAULT_TILE_SIZE = 128, MIN_TILE_SIZE = 16 };
+
+		/**
+		 * Interface for drawing one tile
+		 */
+		struct Tile_painter : Interface
+		{
+			virtual void paint(Canvas_base &, Rect tile) = 0;
+		};
+
+	private:
+
+		class Worker : public Thread
+		{
+			private:
+
+				Compositor     &_compositor;
+				Canvas_base    *_canvas = nullptr;
+				Semaphore       _start { };
+
+				void entry() override
+				{
+					for (;;) {
+						_start.down();
+						_compositor._paint_tiles(*_canvas);
+						_compositor._done.up();
+					}
+				}
+
+			public:
+
+				Worker(Env &env, Compositor &compositor, Location location)
+				:
+					Thread(env, Name("compositor"), 8*1024*sizeof(addr_t),
+					       location, Weight(), env.cpu()),
+					_compositor(compositor)
+				{ }
+
+				void canvas(Canvas_base &canvas) { _canvas = &canvas; }
+
+				void wakeup() { _start.up(); }
+		};
+
+		/*
+		 * Work queue of the current frame
+		 *
+		 * The work is distributed in units of grid cells that cover the
+		 * compound of all dirty rectangles. Each cell is drawn by a single
+		 * thread. So even if dirty rectangles overlap, no pixel is drawn by
+		 * two threads at the same time.
+		 */
+		enum { MAX_RECTS = 3 };
+
+		Lock          _lock { };
+		Rect          _rects[MAX_RECTS];
+		unsigned      _num_rects    = 0;
+		Rect          _compound     { };
+		Point         _cell_pos     { };
+		int           _tile_size    = DEFAULT_TILE_SIZE;
+		Tile_painter *_painter      = nullptr;
+		Semaphore     _done { };
+
+		Allocator &_alloc;
+
+		unsigned const _num_workers;
+
+		Worker *_workers[MAX_WORKERS] { };
+
+		/*
+		 * Frame statistics
+		 */
+		unsigned         _statistics_frames = 0;
+		unsigned         _frames            = 0;
+		unsigned long    _drawn_tiles       = 0;
+		Trace::Timestamp _cycles            = 0;
+		Trace::Timestamp _max_cycles        = 0;
+
+		/**
+		 * Return grid-aligned coordinate of the cell containing 'v'
+		 */
+		int _align(int v) const
+		{
+			int const aligned = (v / _tile_size) * _tile_size;
+			return aligned > v ? aligned - _tile_size : aligned;
+		}
+
+		/**
+		 * Fetch next grid cell of the current frame
+		 *
+		 * \return false if no cell is left
+		 */
+		bool _next_cell(Rect &cell)
+		{
+			Lock::Guard guard(_lock);
+
+			if (_cell_pos.y() > _compound.y2())
+				return false;
+
+			cell = Rect(_cell_pos, Area(_tile_size, _tile_size));
+
+			_cell_pos = (_cell_pos.x() + _tile_size <= _compound.x2())
+			          ? Point(_cell_pos.x() + _tile_size, _cell_pos.y())
+			          : Point(_align(_compound.x1()), _cell_pos.y() + _tile_size);
+			return true;
+		}
+
+		void _paint_tiles(Canvas_base &canvas)
+		{
+			unsigned long drawn_tiles = 0;
+
+			for (Rect cell; _next_cell(cell); ) {
+
+				bool drawn = false;
+				for (unsigned i = 0; i < _num_rects; i++) {
+
+					Rect const tile = Rect::intersect(cell, _rects[i]);
+					if (!tile.valid())
+						continue;
+
+					_painter->paint(canvas, tile);
+					drawn = true;
+				}
+
+				if (drawn)
+					drawn_tiles++;
+			}
+
+			Lock::Guard guard(_lock);
+			_drawn_tiles += drawn_tiles;
+		}
+
+		void _account_frame(Trace::Timestamp cycles)
+		{
+			_frames++;
+			_cycles     += cycles;
+			_max_cycles  = max(_max_cycles, cycles);
+
+			if (!_statistics_frames || _frames < _statistics_frames)
+				return;
+
+			log("compositor: frames=", _frames, " "
+			    "avg cycles/frame=", _cycles/_frames, " "
+			    "max cycles/frame=", _max_cycles, " "
+			    "tiles/frame=", _drawn_tiles/_frames, " "
+			    "workers=", _num_workers);
+
+			_frames = 0; _cycles = 0; _max_cycles = 0; _drawn_tiles = 0;
+		}
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param config  '<compositor>' configuration node, the number of
+		 *                'workers' is evaluated at construction time only
+		 */
+		Compositor(Env &env, Allocator &alloc, Xml_node config)
+		:
+			_alloc(alloc),
+			_num_workers(min(config.attribute_value("workers", 0U),
+			                 (unsigned)MAX_WORKERS))
+		{
+			Affinity::Space cpus = env.cpu().affinity_space();
+
+			for (unsigned i = 0; i < _num_workers; i++) {
+				_workers[i] = new (_alloc)
+					Worker(env, *this, cpus.location_of_index((i + 1) % cpus.total()));
+				_workers[i]->start();
+			}
+
+			apply_config(config);
+		}
+
+		~Compositor()
+		{
+			for (unsigned i = 0; i < _num_workers; i++)
+				destroy(_alloc, _workers[i]);
+		}
+
+		void apply_config(Xml_node config)
+		{
+			_tile_size = max((int)MIN_TILE_SIZE,
+			                 (int)config.attribute_value("tile_size",
+			                                             (unsigned)DEFAULT_TILE_SIZE));
+
+			_statistics_frames = config.attribute_value("statistics", 0U);
+		}
+
+		unsigned num_workers() const { return _num_workers; }
+
+		int tile_size() const { return _tile_size; }
+
+		/**
+		 * Assign canvas used by the worker with the specified index
+		 *
+		 * The canvases must refer to the same pixel buffer as the screen
+		 * canvas passed to 'compose'.
+		 */
+		void worker_canvas(unsigned index, Canvas_base &canvas)
+		{
+			if (index < _num_workers)
+				_workers[index]->canvas(canvas);
+		}
+
+		/**
+		 * Draw the dirty area tile by tile and reset the dirty area
+		 *
+		 * \param fn  functor taking a 'Canvas_base &' and a tile 'Rect'
+		 *            as arguments, it is called concurrently by the
+		 *            entrypoint and the worker threads
+		 */
+		template <typename FN>
+		void compose(Canvas_base &screen, Dirty_rect &dirty,
+		             FN const &fn)
+		{
+			struct Painter : Tile_painter
+			{
+				FN const &fn;
+
+				Painter(FN const &fn) : fn(fn) { }
+
+				void paint(Canvas_base &canvas, Rect tile) override {
+					fn(canvas, tile); }
+
+			} painter(fn);
+
+			Trace::Timestamp const start = Trace::timestamp();
+
+			_num_rects = 0;
+			dirty.flush([&] (Rect const &rect) {
+				_compound = _num_rects ? Rect::compound(_compound, rect) : rect;
+
+				if (_num_rects < MAX_RECTS)
+					_rects[_num_rects++] = rect;
+				else
+					_rects[MAX_RECTS - 1] = Rect::compound(_rects[MAX_RECTS - 1], rect);
+			});
+
+			if (!_num_rects)
+				return;
+
+			_cell_pos = Point(_align(_compound.x1()), _align(_compound.y1()));
+			_painter  = &painter;
+
+			for (unsigned i = 0; i < _num_workers; i++)
+				_workers[i]->wakeup();
+
+			_paint_tiles(screen);
+
+			for (unsigned i = 0; i < _num_workers; i++)
+				_done.down();
+
+			_painter = nullptr;
+
+			_account_frame(Trace::timestamp() - start);
+		}
+};
+
+#endif /* _COMPOSITOR_H_ */
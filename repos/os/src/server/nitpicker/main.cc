@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2006-2017 Genode Labs GmbH
+ * Copyright (C) 2006-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -31,6 +31,7 @@
 #include "clip_guard.h"
 #include "pointer_origin.h"
 #include "domain_registry.h"
+#include "compositor.h"
 
 namespace Nitpicker {
 	template <typename> class Root;
@@ -233,11 +234,25 @@ struct Nitpicker::Main : Focus_updater
 
 		Area size = screen.size();
 
+		/*
+		 * Canvases of the compositor's worker threads, referring to the
+		 * same pixels as 'screen'
+		 */
+		Constructible<Canvas<PT> > worker_screen[Compositor::MAX_WORKERS] { };
+
 		/**
 		 * Constructor
 		 */
 		Framebuffer_screen(Region_map &rm, Framebuffer::Session &fb)
 		: framebuffer(fb), fb_ds(rm, framebuffer.dataspace()) { }
+
+		void assign_worker_canvases(Compositor &compositor)
+		{
+			for (unsigned i = 0; i < compositor.num_workers(); i++) {
+				worker_screen[i].construct(fb_ds.local_addr<PT>(), size);
+				compositor.worker_canvas(i, *worker_screen[i]);
+			}
+		}
 	};
 
 	Reconstructible<Framebuffer_screen> _fb_screen = { _env.rm(), _framebuffer };
@@ -296,6 +311,14 @@ struct Nitpicker::Main : Focus_updater
 
 	Attached_rom_dataspace _config_rom { _env, "config" };
 
+	static Xml_node _compositor_config(Xml_node config)
+	{
+		return config.has_sub_node("compositor") ? config.sub_node("compositor")
+		                                         : Xml_node("<compositor/>");
+	}
+
+	Compositor _compositor { _env, _sliced_heap, _compositor_config(_config_rom.xml()) };
+
 	Constructible<Attached_rom_dataspace> _focus_rom { };
 
 	Tff_font::Static_glyph_buffer<4096> _glyph_buffer { };
@@ -374,13 +397,15 @@ struct Nitpicker::Main : Focus_updater
 	 */
 	void _draw_and_flush()
 	{
-		_view_stack.draw(_fb_screen->screen, _font).flush([&] (Rect const &rect) {
+		_view_stack.draw(_compositor, _fb_screen->screen, _font).flush([&] (Rect const &rect) {
 			_framebuffer.refresh(rect.x1(), rect.y1(),
 			                     rect.w(),  rect.h()); });
 	}
 
 	Main(Env &env) : _env(env)
 	{
+		_fb_screen->assign_worker_canvases(_compositor);
+
 		_view_stack.default_background(_builtin_background);
 		_view_stack.stack(_pointer_origin);
 		_view_stack.geometry(_pointer_origin, Rect(_user_state.pointer_pos(), Area()));
@@ -480,7 +505,7 @@ void Nitpicker::Main::_handle_input()
 		_view_stack.geometry(_pointer_origin, Rect(_user_state.pointer_pos(), Area()));
 
 	/* perform redraw and flush pixels to the framebuffer */
-	_view_stack.draw(_fb_screen->screen, _font).flush([&] (Rect const &rect) {
+	_view_stack.draw(_compositor, _fb_screen->screen, _font).flush([&] (Rect const &rect) {
 		_framebuffer.refresh(rect.x1(), rect.y1(),
 		                     rect.w(),  rect.h()); });
 
@@ -553,6 +578,10 @@ void Nitpicker::Main::_handle_config()
 	configure_reporter(config, _clicked_reporter);
 	configure_reporter(config, _displays_reporter);
 
+	/* update tile size and statistics of the compositor */
+	_compositor.apply_config(_compositor_config(config));
+	_view_stack.tile_size(_compositor.tile_size());
+
 	/* update domain registry and session policies */
 	for (Session_component *s = _session_list.first(); s; s = s->next())
 		s->reset_domain();
@@ -616,6 +645,7 @@ void Nitpicker::Main::_handle_fb_mode()
 {
 	/* reconstruct framebuffer screen and menu bar */
 	_fb_screen.construct(_env.rm(), _framebuffer);
+	_fb_screen->assign_worker_canvases(_compositor);
 
 	/* let the view stack use the new size */
 	_view_stack.size(Area(_fb_screen->mode.width(), _fb_screen->mode.height()));
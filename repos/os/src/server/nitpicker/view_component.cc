@@ -143,6 +143,24 @@ void View_component::draw(Canvas_base &canvas, Font const &font, Focus const &fo
 }
 
 
+Nitpicker::Rect View_component::opaque_area() const
+{
+	if (transparent())
+		return Rect();
+
+	Rect const view_rect = abs_geometry();
+
+	/* views without texture are filled with black */
+	Texture_base const *texture = _owner.texture();
+	if (!texture)
+		return view_rect;
+
+	/* the texture may not cover the whole view */
+	return Rect::intersect(view_rect, Rect(view_rect.p1() + _buffer_off,
+	                                       texture->size()));
+}
+
+
 void View_component::apply_origin_policy(View_component &pointer_origin)
 {
 	if (owner().origin_pointer() && !has_parent(pointer_origin))
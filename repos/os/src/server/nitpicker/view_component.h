@@ -216,6 +216,13 @@ class Nitpicker::View_component : private Same_buffer_list_elem,
 		 */
 		virtual void draw(Canvas_base &, Font const &, Focus const &) const;
 
+		/**
+		 * Return screen area that is completely painted by the view
+		 *
+		 * Views behind this area are invisible.
+		 */
+		virtual Rect opaque_area() const;
+
 		/**
 		 * Set view title
 		 */
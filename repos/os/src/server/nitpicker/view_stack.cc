@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2006-2017 Genode Labs GmbH
+ * Copyright (C) 2006-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -40,6 +40,93 @@ VIEW *View_stack::_next_view(VIEW &view) const
 }
 
 
+/**
+ * Return true if 'outer' completely contains 'inner'
+ */
+static inline bool contains(Nitpicker::Rect const &outer, Nitpicker::Rect const &inner)
+{
+	return outer.valid() && inner.valid()
+	    && outer.x1() <= inner.x1() && outer.x2() >= inner.x2()
+	    && outer.y1() <= inner.y1() && outer.y2() >= inner.y2();
+}
+
+
+template <typename FN>
+void View_stack::_for_each_visible_part(View_component const &view, Rect rect,
+                                        FN const &fn) const
+{
+	if (!rect.valid())
+		return;
+
+	/* collect the opaque areas of the views in front of 'view' */
+	enum { MAX_OCCLUDERS = 16 };
+	Rect     occluders[MAX_OCCLUDERS];
+	unsigned num_occluders = 0;
+	bool     covered       = false;
+
+	View_component const *v = _first_view();
+	for (; v && v != &view; v = _next_view(*v)) {
+
+		Rect const opaque = Rect::intersect(v->opaque_area(), rect);
+		if (!opaque.valid())
+			continue;
+
+		covered |= contains(opaque, rect);
+
+		if (num_occluders < MAX_OCCLUDERS)
+			occluders[num_occluders++] = opaque;
+	}
+
+	/* view is not part of the visible view stack, be conservative */
+	if (v != &view) {
+		fn(rect);
+		return;
+	}
+
+	if (covered)
+		return;
+
+	if (!num_occluders) {
+		fn(rect);
+		return;
+	}
+
+	auto tile_covered = [&] (Rect const &tile) {
+		for (unsigned i = 0; i < num_occluders; i++)
+			if (contains(occluders[i], tile))
+				return true;
+		return false;
+	};
+
+	auto aligned = [&] (int v) {
+		int const a = (v / _tile_size) * _tile_size;
+		return a > v ? a - _tile_size : a; };
+
+	/* report horizontal runs of tiles that are not completely covered */
+	for (int y = aligned(rect.y1()); y <= rect.y2(); y += _tile_size) {
+
+		Rect run { };
+		for (int x = aligned(rect.x1()); x <= rect.x2(); x += _tile_size) {
+
+			Rect const tile = Rect::intersect(rect, Rect(Point(x, y),
+			                                             Area(_tile_size, _tile_size)));
+			if (!tile_covered(tile)) {
+				run = run.valid() ? Rect::compound(run, tile) : tile;
+				continue;
+			}
+
+			if (run.valid())
+				fn(run);
+
+			run = Rect();
+		}
+
+		if (run.valid())
+			fn(run);
+	}
+}
+
+
 Nitpicker::Rect View_stack::_outline(View_component const &view) const
 {
 	Rect const rect = view.abs_geometry();
@@ -213,8 +300,10 @@ void View_stack::refresh_view(View_component &view, Rect const rect)
 	/* rectangle constrained to view geometry */
 	Rect const view_rect = Rect::intersect(rect, _outline(view));
 
-	for (View_component *v = _first_view(); v; v = v->view_stack_next())
-		_mark_view_as_dirty(*v, view_rect);
+	/* skip parts that are hidden behind opaque views */
+	_for_each_visible_part(view, view_rect, [&] (Rect const &visible) {
+		for (View_component *v = _first_view(); v; v = v->view_stack_next())
+			_mark_view_as_dirty(*v, visible); });
 
 	view.for_each_child([&] (View_component &child) { refresh_view(child, rect); });
 }
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2006-2017 Genode Labs GmbH
+ * Copyright (C) 2006-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -17,6 +17,7 @@
 #include "view_component.h"
 #include "session_component.h"
 #include "canvas.h"
+#include "compositor.h"
 
 namespace Nitpicker { class View_stack; }
 
@@ -30,6 +31,7 @@ class Nitpicker::View_stack
 		List<View_stack_elem>  _views { };
 		View_component        *_default_background = nullptr;
 		Dirty_rect mutable     _dirty_rect { };
+		int                    _tile_size = Compositor::DEFAULT_TILE_SIZE;
 
 		/**
 		 * Return outline geometry of a view
@@ -78,6 +80,16 @@ class Nitpicker::View_stack
 		template <typename VIEW>
 		VIEW *_next_view(VIEW &view) const;
 
+		/**
+		 * Call 'fn' for each part of 'rect' that is not hidden behind
+		 * opaque views in front of 'view'
+		 *
+		 * The visibility is determined at the granularity of tiles.
+		 */
+		template <typename FN>
+		void _for_each_visible_part(View_component const &view, Rect rect,
+		                            FN const &fn) const;
+
 		/**
 		 * Schedule 'rect' to be redrawn
 		 */
@@ -117,15 +129,24 @@ class Nitpicker::View_stack
 		 */
 		void draw_rec(Canvas_base &, Font const &, View_component const *, Rect) const;
 
+		/**
+		 * Define size of the tiles used for tracking hidden screen areas
+		 */
+		void tile_size(int size) { _tile_size = size; }
+
 		/**
 		 * Draw dirty areas
+		 *
+		 * The dirty areas are drawn tile by tile, possibly by multiple
+		 * threads. Hence, 'draw_rec' must not modify the view stack.
 		 */
-		Dirty_rect draw(Canvas_base &canvas, Font const &font) const
+		Dirty_rect draw(Compositor &compositor, Canvas_base &canvas,
+		                Font const &font) const
 		{
 			Dirty_rect result = _dirty_rect;
 
-			_dirty_rect.flush([&] (Rect const &rect) {
-				draw_rec(canvas, font, _first_view(), rect); });
+			compositor.compose(canvas, _dirty_rect, [&] (Canvas_base &canvas, Rect tile) {
+				draw_rec(canvas, font, _first_view(), tile); });
 
 			return result;
 		}
@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2012-2017 Genode Labs GmbH
+ * Copyright (C) 2012-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -19,14 +19,12 @@
 #include <base/allocator.h>
 
 /* local includes */
-#include <ram_fs/chunk.h>
-#include <ram_fs/param.h>
+#include <ram_fs/extent.h>
 #include "node.h"
 
 namespace Ram_fs
 {
-	using File_system::Chunk;
-	using File_system::Chunk_index;
+	using File_system::Extent_map;
 	using File_system::file_size_t;
 	using File_system::SEEK_TAIL;
 	class File;
@@ -37,23 +35,18 @@ class Ram_fs::File : public Node
 {
 	private:
 
-		typedef Chunk      <num_level_3_entries()>                Chunk_level_3;
-		typedef Chunk_index<num_level_2_entries(), Chunk_level_3> Chunk_level_2;
-		typedef Chunk_index<num_level_1_entries(), Chunk_level_2> Chunk_level_1;
-		typedef Chunk_index<num_level_0_entries(), Chunk_level_1> Chunk_level_0;
-
-		Chunk_level_0 _chunk;
+		Extent_map _extents;
 
 		file_size_t _length;
 
 	public:
 
 		File(Allocator &alloc, char const *name)
-		: _chunk(alloc, 0), _length(0) { Node::name(name); }
+		: _extents(alloc), _length(0) { Node::name(name); }
 
 		size_t read(char *dst, size_t len, seek_off_t seek_offset) override
 		{
-			file_size_t const chunk_used_size = _chunk.used_size();
+			file_size_t const chunk_used_size = _extents.used_size();
 
 			if (seek_offset == SEEK_TAIL)
 				seek_offset = (len < _length) ? (_length - len) : 0;
@@ -64,7 +57,7 @@ class Ram_fs::File : public Node
 			 * Constrain read transaction to available chunk data
 			 *
 			 * Note that 'chunk_used_size' may be lower than '_length'
-			 * because 'Chunk' may have truncated tailing zeros.
+			 * because the file may have been extended via 'truncate'.
 			 */
 			if (seek_offset + len >= _length)
 				len = _length - seek_offset;
@@ -78,7 +71,7 @@ class Ram_fs::File : public Node
 					read_len = 0;
 			}
 
-			_chunk.read(dst, read_len, seek_offset);
+			_extents.read(dst, read_len, seek_offset);
 
 			/* add zero padding if needed */
 			if (read_len < len)
@@ -92,17 +85,12 @@ class Ram_fs::File : public Node
 			if (seek_offset == SEEK_TAIL)
 				seek_offset = _length;
 
-			if (seek_offset + len >= Chunk_level_0::SIZE) {
-				len = (Chunk_level_0::SIZE-1) - seek_offset;
-				Genode::error(name(), ": size limit ", (long)Chunk_level_0::SIZE, " reached");
-			}
-
-			_chunk.write(src, len, (size_t)seek_offset);
+			_extents.write(src, len, seek_offset);
 
 			/*
-			 * Keep track of file length. We cannot use 'chunk.used_size()'
-			 * as file length because trailing zeros may by represented
-			 * by zero chunks, which do not contribute to 'used_size()'.
+			 * Keep track of file length. We cannot use 'used_size()'
+			 * as file length because the file may have been extended by
+			 * 'truncate' without writing data.
 			 */
 			_length = max(_length, seek_offset + len);
 
@@ -121,8 +109,8 @@ class Ram_fs::File : public Node
 
 		void truncate(file_size_t size) override
 		{
-			if (size < _chunk.used_size())
-				_chunk.truncate(size);
+			if (size < _extents.used_size())
+				_extents.truncate(size);
 
 			_length = size;
 
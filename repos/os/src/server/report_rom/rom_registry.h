@@ -5,7 +5,7 @@
  */
 
 /*
- * Copyright (C) 2014-2017 Genode Labs GmbH
+ * Copyright (C) 2014-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -17,20 +17,45 @@
 /* Genode includes */
 #include <report_rom/rom_registry.h>
 #include <os/session_policy.h>
+#include <rm_session/connection.h>
 
 namespace Rom { struct Registry; }
 
 
-struct Rom::Registry : Registry_for_reader, Registry_for_writer, Genode::Noncopyable
+struct Rom::Registry : Registry_for_reader, Registry_for_writer,
+                       Buffer_view_factory, Genode::Noncopyable
 {
 	private:
 
+		Genode::Env                    &_env;
 		Genode::Allocator              &_md_alloc;
 		Genode::Ram_allocator          &_ram;
 		Genode::Region_map             &_rm;
 		Genode::Attached_rom_dataspace &_config_rom;
 
-		Module_list _modules { };
+		/*
+		 * RM session for the read-only views of the buffers mapped in
+		 * shared mode, opened not before a shared ROM session is used
+		 */
+		Genode::Constructible<Genode::Rm_connection> _rm_connection { };
+
+		/*
+		 * Modules are kept in a hash table indexed by their names. So the
+		 * lookup costs do not grow with the number of modules.
+		 */
+		enum { NUM_BUCKETS = 256 };
+
+		Module_list _buckets[NUM_BUCKETS] { };
+
+		Module_list &_bucket(Module::Name const &name)
+		{
+			/* FNV-1a hash of the module name */
+			unsigned hash = 2166136261u;
+			for (char const *s = name.string(); *s; s++)
+				hash = (hash ^ (unsigned char)*s) * 16777619u;
+
+			return _buckets[hash % NUM_BUCKETS];
+		}
 
 		struct Read_write_policy : Module::Read_policy, Module::Write_policy
 		{
@@ -62,7 +87,9 @@ struct Rom::Registry : Registry_for_reader, Registry_for_writer, Genode::Noncopy
 
 		Module &_lookup(Module::Name const name)
 		{
-			for (Module *m = _modules.first(); m; m = m->next())
+			Module_list &bucket = _bucket(name);
+
+			for (Module *m = bucket.first(); m; m = m->next())
 				if (m->_has_name(name))
 					return *m;
 
@@ -72,9 +99,10 @@ struct Rom::Registry : Registry_for_reader, Registry_for_writer, Genode::Noncopy
 			/* XXX if we run out of memory, the server will abort */
 
 			Module * const module = new (&_md_alloc)
-				Module(_ram, _rm, name, _read_write_policy, _read_write_policy);
+				Module(_ram, _rm, _md_alloc, name,
+				       _read_write_policy, _read_write_policy, this);
 
-			_modules.insert(module);
+			bucket.insert(module);
 			return *module;
 		}
 
@@ -83,7 +111,7 @@ struct Rom::Registry : Registry_for_reader, Registry_for_writer, Genode::Noncopy
 			if (module._in_use())
 				return;
 
-			_modules.remove(&module);
+			_bucket(module.name()).remove(&module);
 			Genode::destroy(&_md_alloc, const_cast<Module *>(&module));
 		}
 
@@ -133,13 +161,37 @@ struct Rom::Registry : Registry_for_reader, Registry_for_writer, Genode::Noncopy
 
 	public:
 
-		Registry(Genode::Allocator &md_alloc,
-		         Genode::Ram_allocator &ram, Genode::Region_map &rm,
+		Registry(Genode::Env &env, Genode::Allocator &md_alloc,
 		         Genode::Attached_rom_dataspace &config_rom)
 		:
-			_md_alloc(md_alloc), _ram(ram), _rm(rm), _config_rom(config_rom)
+			_env(env), _md_alloc(md_alloc), _ram(env.ram()), _rm(env.rm()),
+			_config_rom(config_rom)
 		{ }
 
+		/**
+		 * Buffer_view_factory interface
+		 */
+		Genode::Rm_session *rm_session() override
+		{
+			using namespace Genode;
+
+			if (!_rm_connection.constructed()) {
+				try { _rm_connection.construct(_env); }
+				catch (Service_denied)          { }
+				catch (Insufficient_ram_quota)  { }
+				catch (Insufficient_cap_quota)  { }
+				catch (Out_of_ram)              { }
+				catch (Out_of_caps)             { }
+
+				if (!_rm_connection.constructed()) {
+					warning("RM session unavailable, falling back to private "
+					        "copies for shared ROM sessions");
+					return nullptr;
+				}
+			}
+			return &*_rm_connection;
+		}
+
 		Module &lookup(Writer &writer, Module::Name const &name) override
 		{
 			Module &module = _lookup(writer, name);
@@ -170,6 +222,21 @@ struct Rom::Registry : Registry_for_reader, Registry_for_writer, Genode::Noncopy
 		{
 			return _release(reader, static_cast<Module &>(module));
 		}
+
+		bool shared(Module::Name const &rom_label) override
+		{
+			using namespace Genode;
+
+			_config_rom.update();
+
+			try {
+				Session_policy policy(rom_label, _config_rom.xml());
+				return policy.attribute_value("shared", false);
+			}
+			catch (Session_policy::No_policy_defined) { }
+
+			return false;
+		}
 };
 
 #endif /* _ROM_REGISTRY_H_ */
@@ -116,6 +116,9 @@ class Vfs_server::Session_component : private Session_resources,
 
 		bool const _writable;
 
+		/* number of closed nodes that still await the ack of packets */
+		unsigned _num_closing_nodes = 0;
+
 
 		/****************************
 		 ** Handle to node mapping **
@@ -186,6 +189,11 @@ class Vfs_server::Session_component : private Session_resources,
 
 			try {
 				_apply(packet.handle(), [&] (Io_node &node) {
+
+					/* the client already closed the handle */
+					if (node.closing())
+						return;
+
 					handle_invalid = false;
 					result = node.process_packet(packet);
 				});
@@ -248,6 +256,9 @@ class Vfs_server::Session_component : private Session_resources,
 		 */
 		void _process_packets()
 		{
+			/* the client made room in the acknowledgement queue */
+			_destroy_closed_nodes();
+
 			bool done = process_packets();
 
 			if (done && enqueued()) {
@@ -294,6 +305,33 @@ class Vfs_server::Session_component : private Session_resources,
 				destroy(_alloc, &node);
 		}
 
+		/**
+		 * Destroy closed nodes once their queued packets are acknowledged
+		 */
+		void _destroy_closed_nodes()
+		{
+			while (_num_closing_nodes) {
+
+				Node_space::Id id { ~0UL };
+				bool found = false;
+
+				_node_space.for_each<Node>([&] (Node &node) {
+					Io_node *io_node = dynamic_cast<Io_node *>(&node);
+					if (!found && io_node && io_node->closing()
+					 && io_node->release_queued_packets()) {
+						id    = node.id();
+						found = true;
+					}
+				});
+
+				if (!found)
+					return;
+
+				_node_space.apply<Node>(id, [&] (Node &node) { _close(node); });
+				_num_closing_nodes--;
+			}
+		}
+
 	public:
 
 		/**
@@ -475,7 +513,25 @@ class Vfs_server::Session_component : private Session_resources,
 			 */
 			process_packets();
 
+			_destroy_closed_nodes();
+
 			try { _apply_node(handle, [&] (Node &node) {
+
+				Io_node *io_node = dynamic_cast<Io_node *>(&node);
+
+				/* already closed, packets still await their ack */
+				if (io_node && io_node->closing())
+					return;
+
+				/*
+				 * Defer the destruction until all queued packets are
+				 * returned to the client, see '_process_packets'
+				 */
+				if (io_node && !io_node->release_queued_packets()) {
+					_num_closing_nodes++;
+					return;
+				}
+
 				_close(node); }); }
 			catch (::File_system::Invalid_handle) { }
 		}
@@ -629,13 +685,14 @@ class Vfs_server::Root : public Genode::Root_component<Session_component>
 
 					/* empty the pending nodes and process */
 					pending_nodes.dequeue_all([&] (Node &node) {
-						if (node.process_io()) {
+						Node::Io_state const state = node.process_io();
+
+						/* packets were processed, freeing per-handle queue space */
+						if (state != Node::Io_state::STALLED)
 							handle_progress = true;
-						} else {
-							if (!node.enqueued()) {
-								retry.enqueue(node);
-							}
-						}
+
+						if (state != Node::Io_state::IDLE && !node.enqueued())
+							retry.enqueue(node);
 					});
 
 					/* requeue the unprocessed nodes in order */
@@ -135,13 +135,22 @@ class Vfs_server::Node : public  ::File_system::Node_base,
 
 		char const *path() const { return _path.base(); }
 
+		/**
+		 * Result of processing the pending activity of a node
+		 */
+		enum class Io_state {
+			IDLE,     /* no packets pending */
+			PROGRESS, /* packets were processed but some remain pending */
+			STALLED   /* no packet could be processed */
+		};
+
 		/**
 		 * Process pending activity, called by post-signal hook
 		 *
-		 * Default implementation is to return true so that the
+		 * Default implementation is to return 'IDLE' so that the
 		 * node is removed from the pending handle queue.
 		 */
-		virtual bool process_io() { return true; }
+		virtual Io_state process_io() { return Io_state::IDLE; }
 
 		/**
 		 * Print for debugging
@@ -170,16 +179,56 @@ class Vfs_server::Io_node : public Vfs_server::Node,
 
 		Mode const _mode;
 
-		bool _packet_queued = false;
 		bool _packet_op_pending = false;
 
+		/* node was closed by the client but packets await their ack */
+		bool _closing = false;
+
+		/**
+		 * Packets that have been removed from the packet stream
+		 *
+		 * The queue allows a client to submit multiple requests per
+		 * handle without blocking the packet stream of the session.
+		 * The packets are processed in order. Writes are passed to the
+		 * VFS plugin back-to-back, which enables plugins that
+		 * forward requests asynchronously (e.g., fs, block) to keep
+		 * multiple writes in flight. The VFS read interface permits only
+		 * one outstanding read per handle.
+		 */
+		struct Packet_queue
+		{
+			enum { CAPACITY = ::File_system::Session::TX_QUEUE_SIZE };
+
+			Packet_descriptor _packets[CAPACITY] { };
+
+			unsigned _head  = 0;
+			unsigned _count = 0;
+
+			bool empty() const { return _count == 0; }
+			bool full()  const { return _count == CAPACITY; }
+
+			Packet_descriptor &head() { return _packets[_head]; }
+
+			void enqueue(Packet_descriptor const &packet)
+			{
+				_packets[(_head + _count) % CAPACITY] = packet;
+				_count++;
+			}
+
+			void dequeue()
+			{
+				_packets[_head] = Packet_descriptor();
+				_head = (_head + 1) % CAPACITY;
+				_count--;
+			}
+		} _queue { };
+
 	protected:
 
 		Vfs::Vfs_handle &_handle;
 
 		/**
-		 * Packets that have been removed from the
-		 * packet stream are transfered here
+		 * Packet at the head of the queue that is currently processed
 		 */
 		Packet_descriptor _packet { };
 
@@ -269,7 +318,7 @@ class Vfs_server::Io_node : public Vfs_server::Node,
 		void _drop_packet()
 		{
 			_packet = Packet_descriptor();
-			_packet_queued = false;
+			_queue.dequeue();
 		}
 
 		inline
@@ -278,7 +327,7 @@ class Vfs_server::Io_node : public Vfs_server::Node,
 			_packet.length(count);
 			_stream.acknowledge_packet(_packet);
 			_packet = Packet_descriptor();
-			_packet_queued = false;
+			_queue.dequeue();
 		}
 
 		/**
@@ -321,35 +370,14 @@ class Vfs_server::Io_node : public Vfs_server::Node,
 		virtual bool  _read() = 0;
 		virtual bool _write() = 0;
 
-	public:
-
-		Io_node(Node_space &space, char const *node_path, Mode node_mode,
-		        Node_queue &response_queue, Packet_stream &stream,
-		        Vfs_handle &handle)
-		: Node(space, node_path, response_queue, stream),
-		  _mode(node_mode), _handle(handle)
-		{
-			_handle.handler(this);
-		}
-
-		virtual ~Io_node()
-		{
-			_handle.handler(nullptr);
-			_handle.close();
-		}
-
-		using Node_space::Element::id;
-
 		/**
-		 * Process the packet that is queued at this handle
+		 * Process the packet at the head of the queue
 		 *
-		 * Return true if the node was processed and is now idle.
+		 * Return true if the packet was removed from the queue.
 		 */
-		bool process_io() override
+		bool _process_head()
 		{
-			if (!_packet_queued) return true;
-			if (!_stream.ready_to_ack())
-				return false;
+			_packet = _queue.head();
 
 			bool result = true;
 
@@ -384,23 +412,102 @@ class Vfs_server::Io_node : public Vfs_server::Node,
 			return result;
 		}
 
+	public:
+
+		Io_node(Node_space &space, char const *node_path, Mode node_mode,
+		        Node_queue &response_queue, Packet_stream &stream,
+		        Vfs_handle &handle)
+		: Node(space, node_path, response_queue, stream),
+		  _mode(node_mode), _handle(handle)
+		{
+			_handle.handler(this);
+		}
+
+		/*
+		 * A node is destructed not before its queued packets are returned
+		 * to the client (see 'release_queued_packets'), except at the
+		 * destruction of the session, which takes the packet stream with
+		 * it.
+		 */
+		virtual ~Io_node()
+		{
+			_handle.handler(nullptr);
+			_handle.close();
+		}
+
+		using Node_space::Element::id;
+
+		/**
+		 * Return packets that were not processed to the client
+		 *
+		 * Called when the client closes the node. The node must not be
+		 * destructed before all queued packets are acknowledged because
+		 * the client would lose the packets from its packet allocator.
+		 *
+		 * \return  true if no packet is queued anymore, false if the
+		 *          acknowledgement queue is full
+		 */
+		bool release_queued_packets()
+		{
+			_closing = true;
+
+			while (!_queue.empty() && _stream.ready_to_ack()) {
+				_packet = _queue.head();
+				_ack_packet(0);
+			}
+
+			return _queue.empty();
+		}
+
+		bool closing() const { return _closing; }
+
+		/**
+		 * Process the packets that are queued at this handle
+		 */
+		Io_state process_io() override
+		{
+			if (_closing)
+				return release_queued_packets() ? Io_state::IDLE
+				                                : Io_state::STALLED;
+
+			bool progress = false;
+
+			while (!_queue.empty()) {
+
+				if (!_stream.ready_to_ack() || !_process_head())
+					return progress ? Io_state::PROGRESS : Io_state::STALLED;
+
+				progress = true;
+			}
+
+			return Io_state::IDLE;
+		}
+
 		/**
 		 * Process a packet by queuing it locally or sending
-		 * an immediate response. Return false if no progress
-		 * can be made.
+		 * an immediate response. Return false if the packet
+		 * cannot be queued.
 		 *
 		 * Called by packet stream signal handler
 		 */
 		bool process_packet(Packet_descriptor const &packet)
 		{
-			/* attempt to clear any pending packet */
-			if (!process_io())
+			/* attempt to make room for the packet */
+			if (_queue.full())
+				process_io();
+
+			if (_queue.full())
 				return false;
 
-			/* otherwise store the packet locally and process */
-			_packet = packet;
-			_packet_queued = true;
-			process_io();
+			_queue.enqueue(packet);
+
+			/*
+			 * Packets that cannot be completed right away are
+			 * processed by the post-signal hook
+			 */
+			if (process_io() != Io_state::IDLE && !enqueued())
+				_response_queue.enqueue(*this);
+
 			return true;
 		}
 
@@ -483,7 +590,7 @@ class Vfs_server::Watch_node final : public Vfs_server::Node,
 		void watch_response() override
 		{
 			/* send a packet immediately otherwise defer */
-			if (!process_io() && !enqueued())
+			if (process_io() != Io_state::IDLE && !enqueued())
 				_response_queue.enqueue(*this);
 		}
 
@@ -495,9 +602,9 @@ class Vfs_server::Watch_node final : public Vfs_server::Node,
 		/**
 		 * Called by global I/O progress handler
 		 */
-		bool process_io() override
+		Io_state process_io() override
 		{
-			if (!_stream.ready_to_ack()) return false;
+			if (!_stream.ready_to_ack()) return Io_state::STALLED;
 
 			Packet_descriptor packet(Packet_descriptor(),
 			                         Node_handle { id().value },
@@ -505,7 +612,7 @@ class Vfs_server::Watch_node final : public Vfs_server::Node,
 			                         0, 0);
 			packet.succeeded(true);
 			_stream.acknowledge_packet(packet);
-			return true;
+			return Io_state::IDLE;
 		}
 };
 
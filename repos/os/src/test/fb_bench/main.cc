@@ -6,7 +6,7 @@
  */
 
 /*
- * Copyright (C) 2012-2017 Genode Labs GmbH
+ * Copyright (C) 2012-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -128,12 +128,105 @@ struct Unaligned_blit_test : Test
 	}
 };
 
+struct Kernel_test : Test
+{
+	static constexpr char const *brief = "pixel kernels of the blit library";
+
+	enum { KERNEL_DURATION_MS = 250 };
+
+	unsigned char *alpha = nullptr;
+
+	/**
+	 * Execute 'fn' repeatedly and log the throughput
+	 *
+	 * \param fn  functor returning the number of bytes written
+	 */
+	template <typename FN>
+	void measure(Blit_isa isa, char const *kernel, FN const &fn)
+	{
+		unsigned long  kib      = 0;
+		uint64_t const start_ms = timer.elapsed_ms();
+		while (timer.elapsed_ms() - start_ms < KERNEL_DURATION_MS)
+			kib += fn() / 1024;
+
+		uint64_t const end_ms = timer.elapsed_ms();
+		log(blit_isa_name(isa), " ", kernel, ": ",
+		    kib / (end_ms - start_ms), " MiB/sec");
+	}
+
+	void measure_kernels(Blit_isa isa)
+	{
+		size_t   const size   = fb_ds.size();
+		unsigned const w      = fb_mode.width() * fb_mode.bytes_per_pixel();
+		unsigned const h      = fb_mode.height();
+		int      const n_16   = size / sizeof(uint16_t);
+		int      const n_32   = size / sizeof(uint32_t);
+		uint16_t      *dst_16 = (uint16_t *)buf[0];
+		uint32_t      *dst_32 = (uint32_t *)buf[0];
+		uint16_t      *src_16 = (uint16_t *)buf[1];
+		uint32_t      *src_32 = (uint32_t *)buf[1];
+
+		measure(isa, "blit RAM to FB", [&] () {
+			blit(buf[1], w, fb_ds.local_addr<char>(), w, w, h);
+			return w*h; });
+
+		measure(isa, "blit RAM to RAM", [&] () {
+			blit(buf[1], w, buf[0], w, w, h);
+			return w*h; });
+
+		measure(isa, "fill_16", [&] () {
+			blit_fill_16(dst_16, 0x1234, n_16);
+			return size; });
+
+		measure(isa, "fill_32", [&] () {
+			blit_fill_32(dst_32, 0x123456, n_32);
+			return size; });
+
+		measure(isa, "blend_rgb565", [&] () {
+			blit_blend_rgb565(dst_16, src_16, alpha, n_16);
+			return size; });
+
+		measure(isa, "avr_rgb565", [&] () {
+			blit_avr_rgb565(dst_16, src_16, 0x1234, n_16);
+			return size; });
+
+		/* the conversions are accounted by the size of the RGB888 buffer */
+		measure(isa, "rgb888_to_rgb565", [&] () {
+			blit_rgb888_to_rgb565(dst_16, src_32, n_32);
+			return size; });
+
+		measure(isa, "rgb565_to_rgb888", [&] () {
+			blit_rgb565_to_rgb888(dst_32, src_16, n_32);
+			return size; });
+	}
+
+	Kernel_test(Env &env, int id) : Test(env, id, brief)
+	{
+		size_t const num_alpha = fb_ds.size() / sizeof(uint16_t);
+		if (!heap.alloc(num_alpha, (void **)&alpha)) {
+			env.parent().exit(-1); }
+
+		/* alpha values with fully transparent and fully opaque spans */
+		for (size_t i = 0; i < num_alpha; i++)
+			alpha[i] = (i / 64) % 4 ? (unsigned char)(i*7) : 0;
+
+		Blit_isa const default_isa = blit_isa();
+
+		for (unsigned isa = BLIT_ISA_GENERIC; isa <= BLIT_ISA_MAX; isa++)
+			if (blit_select_isa((Blit_isa)isa))
+				measure_kernels((Blit_isa)isa);
+
+		blit_select_isa(default_isa);
+	}
+};
+
 struct Main
 {
 	Constructible<Bytewise_ram_test>   test_1 { };
 	Constructible<Bytewise_fb_test>    test_2 { };
 	Constructible<Blit_test>           test_3 { };
 	Constructible<Unaligned_blit_test> test_4 { };
+	Constructible<Kernel_test>         test_5 { };
 
 	Main(Env &env)
 	{
@@ -142,6 +235,7 @@ struct Main
 		test_2.construct(env, 2); test_2.destruct();
 		test_3.construct(env, 3); test_3.destruct();
 		test_4.construct(env, 4); test_4.destruct();
+		test_5.construct(env, 5); test_5.destruct();
 		log("--- Framebuffer benchmark finished ---");
 	}
 };
@@ -2,10 +2,14 @@
  * \brief  File_system packet processing test
  * \author Emery Hemingway
  * \date   2018-07-03
+ *
+ * If configured with 'bench="yes"', the component measures the read
+ * throughput of the file-system server with an increasing number of packets
+ * in flight per handle.
  */
 
 /*
- * Copyright (C) 2018 Genode Labs GmbH
+ * Copyright (C) 2018-2019 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
@@ -17,23 +21,120 @@
 #include <base/heap.h>
 #include <base/allocator_avl.h>
 #include <base/component.h>
+#include <util/reconstructible.h>
 #include <base/sleep.h>
+#include <timer_session/connection.h>
 
 namespace Fs_packet {
 	using namespace Genode;
 	using namespace File_system;
+	struct Bench;
 	struct Main;
 };
 
+
+/**
+ * Throughput benchmark for increasing queue depths
+ */
+struct Fs_packet::Bench
+{
+	enum { MAX_DEPTH = File_system::Session::TX_QUEUE_SIZE };
+
+	Env                              &env;
+	File_system::Session::Tx::Source &pkt_tx;
+	File_handle const                 file_handle;
+	size_t const                      pkt_size;
+	unsigned long const               total;
+
+	Timer::Connection timer { env };
+
+	unsigned      depth     = 1;
+	unsigned      in_flight = 0;
+	unsigned long submitted = 0;
+	unsigned long acked     = 0;
+	unsigned long bytes     = 0;
+	uint64_t      start_us  = 0;
+
+	uint64_t now_us() { return timer.curr_time().trunc_to_plain_us().value; }
+
+	void submit()
+	{
+		while (in_flight < depth && submitted < total && pkt_tx.ready_to_submit()) {
+			File_system::Packet_descriptor pkt(
+				pkt_tx.alloc_packet(pkt_size), file_handle,
+				File_system::Packet_descriptor::READ, pkt_size, 0);
+			pkt_tx.submit_packet(pkt);
+			in_flight++;
+			submitted++;
+		}
+	}
+
+	void start()
+	{
+		submitted = acked = bytes = 0;
+		start_us  = now_us();
+		submit();
+	}
+
+	void finish_depth()
+	{
+		uint64_t const duration_us = max(now_us() - start_us, (uint64_t)1);
+
+		log("depth=", depth, " packet_size=", pkt_size, " "
+		    "packets/s=", (acked*1000*1000)/duration_us, " "
+		    "KiB/s=", (bytes*1000*1000/1024)/duration_us);
+
+		depth *= 2;
+		if (depth > MAX_DEPTH) {
+			log("--- benchmark finished ---");
+			env.parent().exit(0);
+			sleep_forever();
+		}
+		start();
+	}
+
+	void handle_ack()
+	{
+		while (pkt_tx.ack_avail()) {
+			auto pkt = pkt_tx.get_acked_packet();
+			if (pkt.succeeded())
+				bytes += pkt.length();
+			pkt_tx.release_packet(pkt);
+			in_flight--;
+			acked++;
+		}
+
+		if (acked == total)
+			finish_depth();
+		else
+			submit();
+	}
+
+	Bench(Env &env, File_system::Session::Tx::Source &pkt_tx,
+	      File_handle file_handle, size_t pkt_size, unsigned long total)
+	:
+		env(env), pkt_tx(pkt_tx), file_handle(file_handle),
+		pkt_size(pkt_size), total(total)
+	{ }
+};
+
+
 struct Fs_packet::Main
 {
 	Genode::Env &env;
 
 	Attached_rom_dataspace config_rom { env, "config" };
 
+	bool const bench_mode = config_rom.xml().attribute_value("bench", false);
+
+	size_t const bench_pkt_size =
+		config_rom.xml().attribute_value("packet_size", (size_t)(4<<10));
+
 	Heap heap { env.pd(), env.rm() };
 	Allocator_avl avl_alloc { &heap };
-	File_system::Connection fs { env, avl_alloc, "", "/", false, 4<<10 };
+	File_system::Connection fs { env, avl_alloc, "", "/", false,
+	                             bench_mode ? 2*Bench::MAX_DEPTH*bench_pkt_size
+	                                        : 4<<10 };
 	File_system::Session::Tx::Source &pkt_tx { *fs.tx() };
 
 	Dir_handle dir_handle { fs.dir("/", false) };
@@ -43,8 +144,15 @@ struct Fs_packet::Main
 
 	int pkt_count = config_rom.xml().attribute_value("count", 1U << 10);
 
+	Constructible<Bench> bench { };
+
 	void handle_ack()
 	{
+		if (bench.constructed()) {
+			bench->handle_ack();
+			return;
+		}
+
 		while (pkt_tx.ack_avail()) {
 			auto pkt = pkt_tx.get_acked_packet();
 			--pkt_count;
@@ -65,6 +173,13 @@ struct Fs_packet::Main
 	{
 		fs.sigh_ack_avail(ack_handler);
 
+		if (bench_mode) {
+			bench.construct(env, pkt_tx, file_handle, bench_pkt_size,
+			                (unsigned long)pkt_count);
+			bench->start();
+			return;
+		}
+
 		/**********************
 		 ** Stuff the buffer **
 		 **********************/
@@ -0,0 +1,222 @@
+/*
+ * \brief  Test and benchmark of the Internet Checksum implementation
+ * \author Martin Stein
+ * \date   2019-03-08
+ *
+ * The test compares the results of the optimized checksum with a plain
+ * 16-bit reference implementation for various data sizes and validates
+ * incremental checksum updates against the full re-computation. Afterwards,
+ * it measures the throughput of both implementations and of incremental
+ * updates in a NAT-like rewrite scenario.
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/attached_rom_dataspace.h>
+#include <timer_session/connection.h>
+#include <net/internet_checksum.h>
+
+namespace Test {
+
+	using namespace Genode;
+	using namespace Net;
+
+	struct Main;
+
+	enum { BUF_SIZE = 2048, MAX_SIZE = 1600, NAT_PACKET_SIZE = 1500 };
+}
+
+
+struct Test::Main
+{
+	Env &_env;
+
+	Attached_rom_dataspace _config { _env, "config" };
+
+	Timer::Connection _timer { _env };
+
+	unsigned long const _rounds =
+		_config.xml().attribute_value("rounds", 100000UL);
+
+	uint16_t _buf[BUF_SIZE / sizeof(uint16_t)];
+
+	uint32_t _seed = 0x12345678;
+
+	unsigned _errors = 0;
+
+	uint32_t _random()
+	{
+		/* xorshift32 */
+		_seed ^= _seed << 13;
+		_seed ^= _seed >> 17;
+		_seed ^= _seed << 5;
+		return _seed;
+	}
+
+	void _randomize()
+	{
+		for (uint16_t &word : _buf)
+			word = (uint16_t)_random();
+	}
+
+	uint64_t _now_us() { return _timer.curr_time().trunc_to_plain_us().value; }
+
+	/**
+	 * Straight-forward RFC 1071 implementation used as reference
+	 */
+	static uint16_t _reference(uint16_t const *addr, size_t size,
+	                           addr_t init_sum)
+	{
+		addr_t sum = init_sum;
+		for (; size > 1; size -= 2)
+			sum += *addr++;
+
+		if (size > 0)
+			sum += *(uint8_t *)addr;
+
+		while (addr_t const sum_rsh = sum >> 16)
+			sum = (sum & 0xffff) + sum_rsh;
+
+		return ~sum;
+	}
+
+	void _test_checksum()
+	{
+		for (size_t size = 0; size <= MAX_SIZE; size++) {
+			for (size_t offset = 0; offset < 8; offset += 2) {
+
+				_randomize();
+				uint16_t const *data     = _buf + offset / sizeof(uint16_t);
+				addr_t   const  init_sum = _random() & 0x3ffff;
+
+				uint16_t const expected = _reference(data, size, init_sum);
+				uint16_t const result   = internet_checksum(data, size, init_sum);
+				if (result == expected)
+					continue;
+
+				error("checksum mismatch: size=", size, " offset=", offset,
+				      " result=", Hex(result), " expected=", Hex(expected));
+				_errors++;
+			}
+		}
+	}
+
+	void _test_checksum_diff()
+	{
+		enum { SIZE = 64, CHECKSUM_WORD = 5 };
+
+		for (unsigned i = 0; i < 10000; i++) {
+
+			_randomize();
+			_buf[CHECKSUM_WORD] = 0;
+			_buf[CHECKSUM_WORD] = internet_checksum(_buf, SIZE);
+
+			/* modify up to four words at random positions */
+			Internet_checksum_diff diff;
+			for (unsigned j = _random() % 5; j > 0; j--) {
+
+				unsigned const idx = _random() % (SIZE / sizeof(uint16_t));
+				if (idx == CHECKSUM_WORD)
+					continue;
+
+				uint16_t const old_word = _buf[idx];
+				_buf[idx] = (uint16_t)_random();
+				diff.add_up_diff(&_buf[idx], &old_word, sizeof(old_word));
+			}
+			_buf[CHECKSUM_WORD] = diff.apply_to(_buf[CHECKSUM_WORD]);
+
+			/* the checksum over data that includes a valid checksum is zero */
+			if (!internet_checksum(_buf, SIZE))
+				continue;
+
+			error("incremental checksum update failed in round ", i);
+			_errors++;
+		}
+	}
+
+	template <typename FN>
+	void _measure(char const *name, size_t bytes, FN const &fn)
+	{
+		uint64_t const start_us = _now_us();
+
+		uint16_t volatile sink = 0;
+		for (unsigned long i = 0; i < _rounds; i++)
+			sink = sink + fn();
+
+		uint64_t const duration_us = max(_now_us() - start_us, (uint64_t)1);
+
+		log(name, ": ", _rounds, " rounds, ", duration_us, " us, ",
+		    (_rounds * 1000 * 1000) / duration_us, " ops/s",
+		    bytes ? ", MiB/s=" : "",
+		    bytes ? (_rounds * bytes) / duration_us * 1000 * 1000 / (1024 * 1024) : 0);
+	}
+
+	void _benchmark()
+	{
+		_randomize();
+
+		static size_t const sizes[] = { 64, 576, 1500 };
+		for (size_t size : sizes) {
+			log("data size ", size);
+			_measure("  reference", size, [&] () {
+				return _reference(_buf, size, 0); });
+			_measure("  optimized", size, [&] () {
+				return internet_checksum(_buf, size); });
+		}
+
+		/*
+		 * Rewrite source address and port of a packet and update its
+		 * checksum, once by re-computation and once incrementally
+		 */
+		enum { ADDR_WORD = 6, PORT_WORD = 10, CHECKSUM_WORD = 13 };
+		log("NAT rewrite of ", (size_t)NAT_PACKET_SIZE, "-byte packet");
+
+		_measure("  full re-computation", 0, [&] () {
+			_buf[ADDR_WORD]++;
+			_buf[PORT_WORD]++;
+			_buf[CHECKSUM_WORD] = 0;
+			_buf[CHECKSUM_WORD] = internet_checksum(_buf, NAT_PACKET_SIZE);
+			return _buf[CHECKSUM_WORD];
+		});
+		_measure("  incremental update", 0, [&] () {
+			uint16_t const old_addr = _buf[ADDR_WORD]++;
+			uint16_t const old_port = _buf[PORT_WORD]++;
+			Internet_checksum_diff diff;
+			diff.add_up_diff(&_buf[ADDR_WORD], &old_addr, sizeof(old_addr));
+			diff.add_up_diff(&_buf[PORT_WORD], &old_port, sizeof(old_port));
+			_buf[CHECKSUM_WORD] = diff.apply_to(_buf[CHECKSUM_WORD]);
+			return _buf[CHECKSUM_WORD];
+		});
+		if (internet_checksum(_buf, NAT_PACKET_SIZE)) {
+			error("checksum invalid after incremental updates");
+			_errors++;
+		}
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		log("--- Internet Checksum test started ---");
+
+		_test_checksum();
+		_test_checksum_diff();
+		_benchmark();
+
+		if (_errors) {
+			error(_errors, " errors");
+			_env.parent().exit(-1);
+			return;
+		}
+		log("--- Internet Checksum test finished ---");
+		_env.parent().exit(0);
+	}
+};
+
+
+void Component::construct(Genode::Env &env) { static Test::Main main(env); }
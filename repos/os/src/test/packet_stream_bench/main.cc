@@ -0,0 +1,285 @@
+/*
+ * \brief  Benchmark of per-packet versus batched packet-stream transfers
+ * \author Norman Feske
+ * \date   2019-03-06
+ *
+ * Source and sink of a packet stream are co-located in this component. Both
+ * sides are driven by the signals of the packet-stream protocol. For each
+ * session type, the benchmark transfers a fixed number of packets using the
+ * per-packet API and the batch API with different batch sizes, and reports
+ * the achieved packet rate and the number of signals per packet.
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/heap.h>
+#include <base/allocator_avl.h>
+#include <base/attached_ram_dataspace.h>
+#include <base/attached_rom_dataspace.h>
+#include <timer_session/connection.h>
+#include <nic_session/nic_session.h>
+#include <block_session/block_session.h>
+#include <file_system_session/file_system_session.h>
+
+namespace Test {
+
+	using namespace Genode;
+
+	struct Bench_base;
+	template <typename> struct Bench;
+	struct Main;
+
+	enum { MAX_BATCH = 64, PACKET_SIZE = 64, BUFFER_SIZE = 256*1024 };
+}
+
+
+struct Test::Bench_base : Interface
+{
+	virtual bool finished() const = 0;
+
+	virtual void start() = 0;
+};
+
+
+template <typename POLICY>
+struct Test::Bench : Bench_base
+{
+	typedef Packet_stream_source<POLICY>       Source;
+	typedef Packet_stream_sink<POLICY>         Sink;
+	typedef typename POLICY::Packet_descriptor Packet;
+
+	Env                      &_env;
+	Timer::Connection        &_timer;
+	char const * const        _session;
+	unsigned const            _batch;
+	unsigned long const       _total;
+	Signal_context_capability _finished_sigh;
+
+	Attached_ram_dataspace _ds { _env.ram(), _env.rm(), BUFFER_SIZE };
+	Allocator_avl          _packet_alloc;
+
+	Source _source { _ds.cap(), _env.rm(), _packet_alloc };
+	Sink   _sink   { _ds.cap(), _env.rm() };
+
+	Signal_handler<Bench> _source_handler {
+		_env.ep(), *this, &Bench::_handle_source };
+
+	Signal_handler<Bench> _sink_handler {
+		_env.ep(), *this, &Bench::_handle_sink };
+
+	unsigned long _submitted   = 0;
+	unsigned long _acked       = 0;
+	unsigned long _signals     = 0;
+	unsigned long _activations = 0;
+	uint64_t      _start_us    = 0;
+	bool          _finished    = false;
+
+	uint64_t _now_us() { return _timer.curr_time().trunc_to_plain_us().value; }
+
+	void _finish()
+	{
+		uint64_t const duration_us = max(_now_us() - _start_us, (uint64_t)1);
+
+		log(_session, ": batch=", _batch, " "
+		    "packets/s=", (_total*1000*1000)/duration_us, " "
+		    "signals/1000 packets=", (_signals*1000)/_total, " "
+		    "activations/1000 packets=", (_activations*1000)/_total);
+
+		_finished = true;
+		Signal_transmitter(_finished_sigh).submit();
+	}
+
+	void _handle_source()
+	{
+		if (_finished)
+			return;
+
+		_activations++;
+
+		Packet packets[MAX_BATCH];
+
+		/* release acknowledged packets */
+		for (;;) {
+			unsigned n = 0;
+			if (_batch > 1)
+				n = _source.try_get_acked_packets(packets, _batch);
+			else if (_source.ack_avail())
+				packets[n++] = _source.try_get_acked_packet();
+
+			if (!n)
+				break;
+
+			for (unsigned i = 0; i < n; i++)
+				_source.release_packet(packets[i]);
+
+			_acked += n;
+		}
+
+		/* submit new packets */
+		while (_submitted < _total) {
+
+			unsigned n = 0;
+			for (; n < _batch && _submitted + n < _total; n++) {
+				try { packets[n] = _source.alloc_packet(PACKET_SIZE); }
+				catch (typename Source::Packet_alloc_failed) { break; }
+			}
+
+			unsigned const sent = (_batch > 1)
+			                    ? _source.try_submit_packets(packets, n)
+			                    : (n && _source.try_submit_packet(packets[0]));
+
+			for (unsigned i = sent; i < n; i++)
+				_source.release_packet(packets[i]);
+
+			_submitted += sent;
+
+			if (_source.wakeup())
+				_signals++;
+
+			if (!n || sent < n)
+				break;
+		}
+
+		if (_source.wakeup())
+			_signals++;
+
+		if (_acked == _total)
+			_finish();
+	}
+
+	void _handle_sink()
+	{
+		if (_finished)
+			return;
+
+		_activations++;
+
+		Packet packets[MAX_BATCH];
+
+		for (;;) {
+			unsigned const max_packets = min(_batch, _sink.ack_slots_free());
+
+			unsigned n = 0;
+			if (_batch > 1)
+				n = _sink.try_get_packets(packets, max_packets);
+			else if (max_packets && _sink.packet_avail())
+				packets[n++] = _sink.try_get_packet();
+
+			if (!n)
+				break;
+
+			unsigned const acked = (_batch > 1)
+			                     ? _sink.try_ack_packets(packets, n)
+			                     : _sink.try_ack_packet(packets[0]);
+
+			if (acked < n)
+				error(_session, ": unexpected congestion of ack queue");
+
+			if (_sink.wakeup())
+				_signals++;
+		}
+
+		if (_sink.wakeup())
+			_signals++;
+	}
+
+	Bench(Env &env, Allocator &alloc, Timer::Connection &timer,
+	      char const *session, unsigned batch, unsigned long total,
+	      Signal_context_capability finished_sigh)
+	:
+		_env(env), _timer(timer), _session(session),
+		_batch(min(batch, (unsigned)MAX_BATCH)), _total(total),
+		_finished_sigh(finished_sigh), _packet_alloc(&alloc)
+	{
+		_source.register_sigh_packet_avail(_sink_handler);
+		_source.register_sigh_ready_to_ack(_sink_handler);
+		_sink.register_sigh_ack_avail(_source_handler);
+		_sink.register_sigh_ready_to_submit(_source_handler);
+	}
+
+	bool finished() const override { return _finished; }
+
+	void start() override
+	{
+		_start_us = _now_us();
+		_handle_source();
+	}
+};
+
+
+struct Test::Main
+{
+	Env &_env;
+
+	Heap _heap { _env.ram(), _env.rm() };
+
+	Attached_rom_dataspace _config { _env, "config" };
+
+	Timer::Connection _timer { _env };
+
+	unsigned long const _packets =
+		_config.xml().attribute_value("packets", 1000000UL);
+
+	Signal_handler<Main> _next_handler { _env.ep(), *this, &Main::_next };
+
+	Bench_base *_bench = nullptr;
+	unsigned    _index = 0;
+
+	template <typename POLICY>
+	Bench_base *_create(char const *session, unsigned batch)
+	{
+		return new (_heap) Bench<POLICY>(_env, _heap, _timer, session, batch,
+		                                 _packets, _next_handler);
+	}
+
+	Bench_base *_create(unsigned index)
+	{
+		static unsigned const batches[] = { 1, 8, 32, MAX_BATCH };
+		enum { NUM_BATCHES = sizeof(batches)/sizeof(batches[0]) };
+
+		unsigned const batch = batches[index % NUM_BATCHES];
+
+		switch (index / NUM_BATCHES) {
+		case 0: return _create<Nic::Session::Policy>           ("nic",   batch);
+		case 1: return _create<Block::Session::Tx_policy>      ("block", batch);
+		case 2: return _create<File_system::Session::Tx_policy>("fs",    batch);
+		}
+		return nullptr;
+	}
+
+	void _next()
+	{
+		if (_bench) {
+			if (!_bench->finished())
+				return;
+
+			destroy(_heap, _bench);
+		}
+
+		_bench = _create(_index++);
+
+		if (!_bench) {
+			log("--- packet-stream benchmark finished ---");
+			_env.parent().exit(0);
+			return;
+		}
+
+		_bench->start();
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		log("--- packet-stream benchmark started (", _packets, " packets) ---");
+		_next();
+	}
+};
+
+
+void Component::construct(Genode::Env &env) { static Test::Main main(env); }
@@ -0,0 +1,3 @@
+TARGET = test-packet_stream_bench
+SRC_CC = main.cc
+LIBS   = base
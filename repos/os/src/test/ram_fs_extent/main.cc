@@ -0,0 +1,157 @@
+/*
+ * \brief  Unit test for RAM fs extent data structure
+ * \author Norman Feske
+ * \date   2019-03-12
+ *
+ * The test applies a random sequence of write, read, and truncate operations
+ * to an extent map and compares the results with a plain reference buffer.
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/heap.h>
+#include <base/component.h>
+#include <base/attached_ram_dataspace.h>
+#include <ram_fs/extent.h>
+
+using namespace File_system;
+using namespace Genode;
+
+
+struct Allocator_tracer : Allocator
+{
+	size_t     sum { 0 };
+	Allocator &wrapped;
+
+	Allocator_tracer(Allocator &wrapped) : wrapped(wrapped) { }
+
+	bool alloc(size_t size, void **out_addr) override
+	{
+		bool const result = wrapped.alloc(size, out_addr);
+		if (result)
+			sum += size;
+		return result;
+	}
+
+	void free(void *addr, size_t size) override
+	{
+		sum -= size;
+		wrapped.free(addr, size);
+	}
+
+	size_t overhead(size_t size) const override { return wrapped.overhead(size); }
+	bool   need_size_for_free()  const override { return true; }
+};
+
+
+struct Main
+{
+	enum { FILE_SIZE = 16*1024*1024, MAX_LEN = 64*1024, NUM_OPS = 20000 };
+
+	Env              &env;
+	Heap              heap  { env.ram(), env.rm() };
+	Allocator_tracer  alloc { heap };
+
+	Attached_ram_dataspace reference { env.ram(), env.rm(), FILE_SIZE };
+	Attached_ram_dataspace buffer    { env.ram(), env.rm(), MAX_LEN };
+
+	size_t   length = 0;
+	uint64_t seed   = 0x1234567;
+
+	size_t random(size_t limit)
+	{
+		seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+		return limit ? (size_t)(seed >> 33) % limit : 0;
+	}
+
+	/*
+	 * Cluster offsets in a few areas of the file to produce extents
+	 * that neighbour each other as well as holes
+	 */
+	size_t random_offset()
+	{
+		size_t const area = random(8)*(FILE_SIZE/8);
+		return area + random(FILE_SIZE/64);
+	}
+
+	void check(Extent_map const &map, size_t offset, size_t len)
+	{
+		char * const ref = reference.local_addr<char>();
+		char * const buf = buffer.local_addr<char>();
+
+		map.read(buf, len, offset);
+
+		for (size_t i = 0; i < len; i++)
+			if (ref[offset + i] != buf[i]) {
+				error("mismatch at offset ", offset + i);
+				throw -1;
+			}
+	}
+
+	Main(Env &env) : env(env)
+	{
+		log("--- RAM filesystem extent test ---");
+
+		char * const ref = reference.local_addr<char>();
+		char * const buf = buffer.local_addr<char>();
+
+		{
+			Extent_map map(alloc);
+
+			for (unsigned i = 0; i < NUM_OPS; i++) {
+
+				size_t const offset = random_offset();
+				size_t const len    = 1 + random(MAX_LEN - 1);
+
+				switch (random(8)) {
+				case 0:
+					{
+						size_t const size = random_offset();
+						map.truncate(size);
+						if (size < length) {
+							memset(ref + size, 0, length - size);
+							length = size;
+						}
+						break;
+					}
+				case 1:
+				case 2:
+					check(map, offset, len);
+					break;
+				default:
+					for (size_t j = 0; j < len; j++)
+						buf[j] = (char)random(256);
+
+					map.write(buf, len, offset);
+					memcpy(ref + offset, buf, len);
+					length = max(length, offset + len);
+				}
+
+				if (map.used_size() != length) {
+					error("unexpected used size ", map.used_size(),
+					      " expected ", length);
+					throw -2;
+				}
+			}
+
+			check(map, 0, MAX_LEN);
+			log("extents allocated: ", map.allocated(), " bytes for ",
+			    length, " bytes of file content");
+		}
+
+		if (alloc.sum) {
+			error("leaked ", alloc.sum, " bytes");
+			throw -3;
+		}
+
+		log("--- RAM filesystem extent test finished ---");
+	}
+};
+
+void Component::construct(Env &env) { static Main main(env); }
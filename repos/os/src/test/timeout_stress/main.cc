@@ -0,0 +1,189 @@
+/*
+ * \brief  Stress test for the timeout framework
+ * \author Martin Stein
+ * \date   2019-03-18
+ *
+ * The test schedules a large number of one-shot timeouts with pseudo-random
+ * durations at one timer connection, re-schedules and discards a part of
+ * them, and checks that each remaining timeout triggers exactly once and not
+ * before its deadline. It reports the time needed to schedule all timeouts
+ * as well as the maximum delay of the triggered timeouts.
+ */
+
+/*
+ * Copyright (C) 2019 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/heap.h>
+#include <base/attached_rom_dataspace.h>
+#include <timer_session/connection.h>
+
+namespace Test {
+
+	using namespace Genode;
+
+	struct Slot;
+	struct Main;
+}
+
+
+struct Test::Slot : Timeout::Handler
+{
+	struct Main &main;
+	Timeout      timeout;
+	uint64_t     deadline_us { 0 };
+	bool         expected    { false };
+
+	Slot(Main &main, Timeout_scheduler &scheduler)
+	: main(main), timeout(scheduler) { }
+
+	void handle_timeout(Duration curr_time) override;
+};
+
+
+struct Test::Main
+{
+	Env &env;
+
+	Heap heap { env.ram(), env.rm() };
+
+	Attached_rom_dataspace config { env, "config" };
+
+	Timer::Connection timer { env };
+
+	unsigned const num_timeouts =
+		config.xml().attribute_value("timeouts", 100000u);
+
+	uint64_t const max_duration_us =
+		config.xml().attribute_value("max_duration_ms", 2000UL) * 1000;
+
+	/* tolerated deviation of the interpolated time of the timer connection */
+	uint64_t const max_early_us =
+		config.xml().attribute_value("max_early_us", 1000UL);
+
+	Slot **slots = nullptr;
+
+	unsigned long pending   = 0;
+	unsigned long triggered = 0;
+	unsigned long errors    = 0;
+	uint64_t      max_delay_us = 0;
+	uint64_t      sum_delay_us = 0;
+
+	unsigned seed = 0x1f2e3d4c;
+
+	unsigned random()
+	{
+		seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+		return seed;
+	}
+
+	uint64_t now_us() { return timer.curr_time().trunc_to_plain_us().value; }
+
+	void schedule(Slot &slot)
+	{
+		uint64_t const duration_us = 1000 + random() % max_duration_us;
+
+		if (!slot.expected)
+			pending++;
+
+		slot.deadline_us = now_us() + duration_us;
+		slot.expected    = true;
+		slot.timeout.schedule_one_shot(Microseconds(duration_us), slot);
+	}
+
+	void discard(Slot &slot)
+	{
+		if (slot.expected)
+			pending--;
+
+		slot.expected = false;
+		slot.timeout.discard();
+	}
+
+	void finish()
+	{
+		log("triggered ", triggered, " timeouts, ",
+		    "max delay ", max_delay_us, " us, ",
+		    "average delay ", triggered ? sum_delay_us / triggered : 0, " us");
+
+		if (errors) {
+			error("test failed because of ", errors, " error(s)");
+			env.parent().exit(-1);
+			return;
+		}
+		log("--- timeout stress test finished ---");
+		env.parent().exit(0);
+	}
+
+	void handle_timeout(Slot &slot, Duration curr_time)
+	{
+		uint64_t const time_us = curr_time.trunc_to_plain_us().value;
+
+		if (!slot.expected) {
+			error("unexpected timeout");
+			errors++;
+			return;
+		}
+
+		if (time_us + max_early_us < slot.deadline_us) {
+			error("timeout triggered ", slot.deadline_us - time_us, " us early");
+			errors++;
+		}
+
+		uint64_t const delay_us = time_us > slot.deadline_us
+		                        ? time_us - slot.deadline_us : 0;
+
+		max_delay_us  = max(max_delay_us, delay_us);
+		sum_delay_us += delay_us;
+
+		slot.expected = false;
+		triggered++;
+
+		if (--pending == 0)
+			finish();
+	}
+
+	Main(Env &env) : env(env)
+	{
+		log("--- timeout stress test started (", num_timeouts, " timeouts) ---");
+
+		slots = new (heap) Slot *[num_timeouts];
+		for (unsigned i = 0; i < num_timeouts; i++)
+			slots[i] = new (heap) Slot(*this, timer);
+
+		/* schedule all timeouts */
+		uint64_t const start_us = now_us();
+
+		for (unsigned i = 0; i < num_timeouts; i++)
+			schedule(*slots[i]);
+
+		uint64_t const scheduled_us = now_us();
+
+		log("scheduled ", num_timeouts, " timeouts in ",
+		    scheduled_us - start_us, " us");
+
+		/* re-schedule every fourth and discard every eighth timeout */
+		for (unsigned i = 0; i < num_timeouts; i++) {
+			if (i % 8 == 0)      discard(*slots[i]);
+			else if (i % 4 == 0) schedule(*slots[i]);
+		}
+
+		log("re-scheduled and discarded ", num_timeouts / 4, " timeouts in ",
+		    now_us() - scheduled_us, " us");
+
+		if (!pending)
+			finish();
+	}
+};
+
+
+void Test::Slot::handle_timeout(Duration curr_time) {
+	main.handle_timeout(*this, curr_time); }
+
+
+void Component::construct(Genode::Env &env) { static Test::Main main(env); }